@@ -0,0 +1,168 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * gr_opus_sweep: runs codec_sweep from the command line and prints the
+ * results as a table, optionally writing them as CSV too.
+ */
+
+#include <gnuradio/gr_opus/codec_sweep.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void usage(const char* argv0)
+{
+    std::fprintf(stderr,
+                 "usage: %s [options]\n"
+                 "  --rate HZ              corpus sample rate (48000)\n"
+                 "  --seconds S            corpus length per signal (10)\n"
+                 "  --bitrates A,B,...     bitrates in b/s (24000)\n"
+                 "  --complexity A,B,...   encoder complexities 0-10 (10)\n"
+                 "  --frame-ms A,B,...     frame durations in ms (20)\n"
+                 "  --applications A,...   voip, audio, lowdelay (audio)\n"
+                 "  --dred A,B,...         DRED durations in 10 ms units (0)\n"
+                 "  --csv FILE             also write the results as CSV\n",
+                 argv0);
+}
+
+std::vector<std::string> split(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::vector<int> split_int(const std::string& list)
+{
+    std::vector<int> values;
+    for (const std::string& item : split(list)) {
+        values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+std::vector<double> split_double(const std::string& list)
+{
+    std::vector<double> values;
+    for (const std::string& item : split(list)) {
+        values.push_back(std::atof(item.c_str()));
+    }
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int rate = 48000;
+    double seconds = 10.0;
+    std::string bitrates, complexities, frame_ms, applications, dred, csv;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--rate") {
+            rate = std::atoi(value.c_str());
+        } else if (arg == "--seconds") {
+            seconds = std::atof(value.c_str());
+        } else if (arg == "--bitrates") {
+            bitrates = value;
+        } else if (arg == "--complexity") {
+            complexities = value;
+        } else if (arg == "--frame-ms") {
+            frame_ms = value;
+        } else if (arg == "--applications") {
+            applications = value;
+        } else if (arg == "--dred") {
+            dred = value;
+        } else if (arg == "--csv") {
+            csv = value;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        gr::gr_opus::codec_sweep sweep(rate, seconds);
+        if (!bitrates.empty()) {
+            sweep.set_bitrates(split_int(bitrates));
+        }
+        if (!complexities.empty()) {
+            sweep.set_complexities(split_int(complexities));
+        }
+        if (!frame_ms.empty()) {
+            sweep.set_frame_durations(split_double(frame_ms));
+        }
+        if (!applications.empty()) {
+            sweep.set_applications(split(applications));
+        }
+        if (!dred.empty()) {
+            sweep.set_dred_frames(split_int(dred));
+        }
+
+        std::fprintf(stderr, "Running %zu configurations on 2 signals...\n", sweep.num_configs());
+        std::vector<gr::gr_opus::codec_sweep::point> points = sweep.run();
+
+        std::printf("%-7s %-8s %6s %7s %3s %4s %10s %10s %7s %7s %7s\n", "signal", "app", "ms", "bitrate", "cx",
+                    "dred", "enc ns", "dec ns", "bytes", "LSD dB", "SNR dB");
+        for (const auto& p : points) {
+            std::printf("%-7s %-8s %6.1f %7d %3d %4d %10.0f %10.0f %7.1f %7.2f %7.2f%s\n", p.signal.c_str(),
+                        p.application.c_str(), p.frame_ms, p.bitrate, p.complexity, p.dred_frames, p.encode_ns,
+                        p.decode_ns, p.packet_bytes, p.lsd_db, p.seg_snr_db, p.pareto ? " *" : "");
+        }
+        std::printf("* Pareto-optimal: no cheaper configuration has a lower LSD\n");
+
+        if (!csv.empty()) {
+            std::ofstream out(csv);
+            if (!out) {
+                std::fprintf(stderr, "Cannot write %s\n", csv.c_str());
+                return 1;
+            }
+            out << gr::gr_opus::codec_sweep::to_csv(points);
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "gr_opus_sweep: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
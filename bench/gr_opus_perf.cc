@@ -0,0 +1,537 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * gr_opus_perf: benchmark kernels for the codec hot paths on fixed,
+ * seeded inputs. Each kernel reports thread CPU time and operator new
+ * calls per frame; --json writes them for tests/perf_check.py to compare
+ * with the committed baseline.
+ */
+
+#include "mono_detector.h"
+#include "ogg_opus.h"
+#include "output_batcher.h"
+#include "pcm_convert.h"
+#include "post_processor.h"
+#include "signal_classifier.h"
+#include <opus/opus.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> g_allocations(0);
+
+void* counted_alloc(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size > 0 ? size : 1);
+}
+
+} // namespace
+
+// Every allocation through operator new in the process, the library's
+// included, is counted.
+void* operator new(size_t size)
+{
+    if (void* p = counted_alloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size); }
+void* operator new(size_t size, std::align_val_t align)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t a = static_cast<size_t>(align);
+    if (void* p = std::aligned_alloc(a, (std::max<size_t>(size, 1) + a - 1) / a * a)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+using namespace gr::gr_opus;
+
+const double pi = 3.14159265358979323846;
+
+class splitmix
+{
+public:
+    explicit splitmix(uint64_t seed) : d_state(seed) {}
+    uint64_t next()
+    {
+        uint64_t z = (d_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    double noise() { return static_cast<double>(next() >> 11) * (2.0 / 9007199254740992.0) - 1.0; }
+
+private:
+    uint64_t d_state;
+};
+
+// Two seconds of a gliding harmonic tone over noise, interleaved, looped by
+// the kernels.
+std::vector<float> test_signal(int rate, int channels)
+{
+    const size_t frames = static_cast<size_t>(rate) * 2;
+    std::vector<float> pcm(frames * channels);
+    splitmix rng(1);
+    double phase = 0.0;
+    for (size_t n = 0; n < frames; ++n) {
+        const double t = static_cast<double>(n) / rate;
+        phase += 2 * pi * (150.0 + 50.0 * std::sin(2 * pi * 0.7 * t)) / rate;
+        double tone = 0.0;
+        for (int k = 1; k <= 6; ++k) {
+            tone += std::sin(k * phase) / k;
+        }
+        for (int c = 0; c < channels; ++c) {
+            pcm[n * channels + c] = static_cast<float>(0.3 * tone + 0.05 * rng.noise());
+        }
+    }
+    return pcm;
+}
+
+std::vector<std::vector<unsigned char>> encode_packets(int rate, int channels, int bitrate, int count)
+{
+    int error = OPUS_OK;
+    std::unique_ptr<OpusEncoder, void (*)(OpusEncoder*)> enc(
+        opus_encoder_create(rate, channels, OPUS_APPLICATION_AUDIO, &error), opus_encoder_destroy);
+    if (error != OPUS_OK) {
+        throw std::runtime_error("Failed to create Opus encoder: " + std::string(opus_strerror(error)));
+    }
+    opus_encoder_ctl(enc.get(), OPUS_SET_BITRATE(bitrate));
+    const int frame_size = rate / 50;
+    const std::vector<float> pcm = test_signal(rate, channels);
+    const size_t frames = pcm.size() / (frame_size * channels);
+    std::vector<std::vector<unsigned char>> packets;
+    unsigned char packet[4000];
+    for (int i = 0; i < count; ++i) {
+        int len = opus_encode_float(enc.get(), pcm.data() + (i % frames) * frame_size * channels, frame_size, packet,
+                                    sizeof(packet));
+        if (len < 0) {
+            throw std::runtime_error("Opus encoding failed: " + std::string(opus_strerror(len)));
+        }
+        packets.emplace_back(packet, packet + len);
+    }
+    return packets;
+}
+
+// A kernel does its setup in the constructor; run() is what is measured.
+class kernel
+{
+public:
+    virtual ~kernel() {}
+    virtual void run(int frames) = 0;
+};
+
+// opus_encoder's frame path: the library's int16 conversion, then opus_encode.
+class encode_kernel : public kernel
+{
+public:
+    encode_kernel(int rate, int channels, int bitrate, int application)
+        : d_enc(nullptr, opus_encoder_destroy), d_channels(channels), d_frame_size(rate / 50),
+          d_pcm(test_signal(rate, channels)), d_int16(d_frame_size * channels), d_next(0)
+    {
+        int error = OPUS_OK;
+        d_enc.reset(opus_encoder_create(rate, channels, application, &error));
+        if (error != OPUS_OK) {
+            throw std::runtime_error("Failed to create Opus encoder: " + std::string(opus_strerror(error)));
+        }
+        opus_encoder_ctl(d_enc.get(), OPUS_SET_BITRATE(bitrate));
+    }
+
+    void run(int frames) override
+    {
+        const size_t frame_samples = static_cast<size_t>(d_frame_size) * d_channels;
+        for (int f = 0; f < frames; ++f) {
+            if (d_next + frame_samples > d_pcm.size()) {
+                d_next = 0;
+            }
+            float_to_int16(d_pcm.data() + d_next, d_int16.data(), frame_samples);
+            opus_encode(d_enc.get(), d_int16.data(), d_frame_size, d_packet, sizeof(d_packet));
+            d_next += frame_samples;
+        }
+    }
+
+private:
+    std::unique_ptr<OpusEncoder, void (*)(OpusEncoder*)> d_enc;
+    const int d_channels;
+    const int d_frame_size;
+    std::vector<float> d_pcm;
+    std::vector<opus_int16> d_int16;
+    size_t d_next;
+    unsigned char d_packet[4000];
+};
+
+// opus_decoder's frame path: opus_decode (or concealment) and the output
+// stage with gain, soft limiter and metering on.
+class decode_kernel : public kernel
+{
+public:
+    decode_kernel(int rate, int channels, int bitrate, bool conceal)
+        : d_dec(nullptr, opus_decoder_destroy), d_channels(channels), d_frame_size(rate / 50), d_conceal(conceal),
+          d_packets(encode_packets(rate, channels, bitrate, 100)), d_pcm(d_frame_size * channels),
+          d_out(d_frame_size * channels), d_next(0)
+    {
+        int error = OPUS_OK;
+        d_dec.reset(opus_decoder_create(rate, channels, &error));
+        if (error != OPUS_OK) {
+            throw std::runtime_error("Failed to create Opus decoder: " + std::string(opus_strerror(error)));
+        }
+        d_post.reset(rate * channels);
+        d_post.set_gain_db(3.0);
+        d_post.set_soft_limit(true);
+        d_post.set_metering(true);
+    }
+
+    void run(int frames) override
+    {
+        for (int f = 0; f < frames; ++f) {
+            const std::vector<unsigned char>& packet = d_packets[d_next];
+            d_next = (d_next + 1) % d_packets.size();
+            // Concealment runs on every other frame so the decoder keeps
+            // real history to extrapolate from.
+            int samples = d_conceal && f % 2 == 1
+                ? opus_decode(d_dec.get(), nullptr, 0, d_pcm.data(), d_frame_size, 0)
+                : opus_decode(d_dec.get(), packet.data(), static_cast<opus_int32>(packet.size()), d_pcm.data(),
+                              d_frame_size, 0);
+            if (samples > 0) {
+                d_post.process(d_pcm.data(), d_out.data(), samples * d_channels);
+            }
+        }
+    }
+
+private:
+    std::unique_ptr<OpusDecoder, void (*)(OpusDecoder*)> d_dec;
+    const int d_channels;
+    const int d_frame_size;
+    const bool d_conceal;
+    std::vector<std::vector<unsigned char>> d_packets;
+    std::vector<opus_int16> d_pcm;
+    std::vector<float> d_out;
+    post_processor d_post;
+    size_t d_next;
+};
+
+class classify_kernel : public kernel
+{
+public:
+    explicit classify_kernel(int rate) : d_frame_size(rate / 50), d_pcm(test_signal(rate, 1)), d_next(0)
+    {
+        d_classifier.reset(rate, 20.0);
+    }
+
+    void run(int frames) override
+    {
+        for (int f = 0; f < frames; ++f) {
+            if (d_next + d_frame_size > d_pcm.size()) {
+                d_next = 0;
+            }
+            d_classifier.update(d_pcm.data() + d_next, d_frame_size, 1);
+            d_next += d_frame_size;
+        }
+    }
+
+private:
+    const int d_frame_size;
+    std::vector<float> d_pcm;
+    signal_classifier d_classifier;
+    size_t d_next;
+};
+
+// opus_encoder's mono collapse detector on a dual-mono stereo feed.
+class mono_detect_kernel : public kernel
+{
+public:
+    explicit mono_detect_kernel(int rate) : d_frame_size(rate / 50), d_pcm(test_signal(rate, 2)), d_next(0)
+    {
+        d_detector.reset(25, 30.0);
+    }
+
+    void run(int frames) override
+    {
+        const size_t frame_samples = static_cast<size_t>(d_frame_size) * 2;
+        for (int f = 0; f < frames; ++f) {
+            if (d_next + frame_samples > d_pcm.size()) {
+                d_next = 0;
+            }
+            d_detector.update(d_pcm.data() + d_next, d_frame_size);
+            d_next += frame_samples;
+        }
+    }
+
+private:
+    const int d_frame_size;
+    std::vector<float> d_pcm;
+    mono_detector d_detector;
+    size_t d_next;
+};
+
+// opus_ogg_demux's parsing: pages of 50-100 byte packets fed in 4 KiB
+// reads. One frame is one packet.
+class ogg_kernel : public kernel
+{
+public:
+    ogg_kernel() : d_next(0)
+    {
+        ogg_page_builder builder(1);
+        splitmix rng(3);
+        std::vector<unsigned char> packet;
+        for (int i = 0; i < 2000; ++i) {
+            packet.resize(50 + rng.next() % 51);
+            for (unsigned char& byte : packet) {
+                byte = static_cast<unsigned char>(rng.next());
+            }
+            if (!builder.fits(packet.size()) || builder.pending_packets() == 50) {
+                builder.flush(d_stream, false, false);
+            }
+            builder.add_packet(packet.data(), packet.size(), (i + 1) * 960);
+        }
+        builder.flush(d_stream, false, true);
+    }
+
+    void run(int frames) override
+    {
+        int packets = 0;
+        while (packets < frames) {
+            if (d_next == d_stream.size()) {
+                d_next = 0;
+            }
+            size_t n = std::min<size_t>(4096, d_stream.size() - d_next);
+            d_parser.push(d_stream.data() + d_next, n);
+            d_next += n;
+            while (d_parser.next(d_page)) {
+                packets += static_cast<int>(d_page.packets.size());
+            }
+        }
+    }
+
+private:
+    std::vector<unsigned char> d_stream;
+    size_t d_next;
+    ogg_stream_parser d_parser;
+    ogg_page d_page;
+};
+
+// Packet staging between the codec and the output buffer, with unit
+// recording on as for packet_len tags.
+class batcher_kernel : public kernel
+{
+public:
+    batcher_kernel() : d_batcher(false), d_out(4096)
+    {
+        d_batcher.set_record_units(true);
+        for (int i = 0; i < 160; ++i) {
+            d_packet[i] = static_cast<unsigned char>(i);
+        }
+    }
+
+    void run(int frames) override
+    {
+        for (int f = 0; f < frames; ++f) {
+            d_batcher.push(d_packet, 60 + f % 100);
+            if (f % 4 == 3) {
+                d_batcher.emit(d_out.data(), d_out.size());
+                d_batcher.clear_emitted_units();
+            }
+        }
+    }
+
+private:
+    output_batcher<unsigned char> d_batcher;
+    std::vector<unsigned char> d_out;
+    unsigned char d_packet[160];
+};
+
+struct kernel_def {
+    const char* name;
+    std::unique_ptr<kernel> (*make)();
+};
+
+const kernel_def kernels[] = {
+    { "encode_voip_16k_mono",
+      [] { return std::unique_ptr<kernel>(new encode_kernel(16000, 1, 16000, OPUS_APPLICATION_VOIP)); } },
+    { "encode_audio_48k_stereo",
+      [] { return std::unique_ptr<kernel>(new encode_kernel(48000, 2, 96000, OPUS_APPLICATION_AUDIO)); } },
+    { "decode_48k_mono", [] { return std::unique_ptr<kernel>(new decode_kernel(48000, 1, 32000, false)); } },
+    { "decode_conceal_48k_mono", [] { return std::unique_ptr<kernel>(new decode_kernel(48000, 1, 32000, true)); } },
+    { "classify_48k_mono", [] { return std::unique_ptr<kernel>(new classify_kernel(48000)); } },
+    { "mono_detect_48k_stereo", [] { return std::unique_ptr<kernel>(new mono_detect_kernel(48000)); } },
+    { "ogg_parse", [] { return std::unique_ptr<kernel>(new ogg_kernel()); } },
+    { "output_batcher", [] { return std::unique_ptr<kernel>(new batcher_kernel()); } },
+};
+
+struct result {
+    std::string name;
+    double ns_per_frame;
+    double allocs_per_frame;
+};
+
+uint64_t thread_cpu_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// Median CPU time over the repeats; allocations from the worst repeat.
+result measure(const kernel_def& def, int frames, int repeats)
+{
+    std::unique_ptr<kernel> k = def.make();
+    k->run(std::max(1, frames / 10));
+
+    std::vector<double> ns(repeats);
+    uint64_t allocations = 0;
+    for (int r = 0; r < repeats; ++r) {
+        const uint64_t before = g_allocations.load();
+        const uint64_t start = thread_cpu_ns();
+        k->run(frames);
+        ns[r] = static_cast<double>(thread_cpu_ns() - start) / frames;
+        allocations = std::max(allocations, g_allocations.load() - before);
+    }
+    std::sort(ns.begin(), ns.end());
+    return { def.name, ns[repeats / 2], static_cast<double>(allocations) / frames };
+}
+
+std::vector<std::string> split(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+void usage(const char* argv0)
+{
+    std::fprintf(stderr,
+                 "usage: %s [options]\n"
+                 "  --frames N          frames per measured run (2000)\n"
+                 "  --repeat N          measured runs per kernel; the median is kept (5)\n"
+                 "  --kernels A,B,...   run only these kernels\n"
+                 "  --list              print the kernel names and exit\n"
+                 "  --json FILE         also write the results as JSON\n",
+                 argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int frames = 2000;
+    int repeats = 5;
+    std::string only, json;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage(argv[0]);
+            return 0;
+        }
+        if (arg == "--list") {
+            for (const kernel_def& def : kernels) {
+                std::printf("%s\n", def.name);
+            }
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--frames") {
+            frames = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--repeat") {
+            repeats = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--kernels") {
+            only = value;
+        } else if (arg == "--json") {
+            json = value;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    const std::vector<std::string> selected = split(only);
+    std::vector<result> results;
+    try {
+        for (const kernel_def& def : kernels) {
+            if (!selected.empty() && std::find(selected.begin(), selected.end(), def.name) == selected.end()) {
+                continue;
+            }
+            results.push_back(measure(def, frames, repeats));
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "gr_opus_perf: %s\n", e.what());
+        return 1;
+    }
+
+    std::printf("%-26s %12s %12s\n", "kernel", "ns/frame", "allocs/frame");
+    for (const result& r : results) {
+        std::printf("%-26s %12.0f %12.3f\n", r.name.c_str(), r.ns_per_frame, r.allocs_per_frame);
+    }
+
+    if (!json.empty()) {
+        std::ofstream out(json);
+        if (!out) {
+            std::fprintf(stderr, "Cannot write %s\n", json.c_str());
+            return 1;
+        }
+        out << "{\n  \"frames\": " << frames << ",\n  \"repeat\": " << repeats << ",\n  \"kernels\": {";
+        for (size_t i = 0; i < results.size(); ++i) {
+            out << (i > 0 ? "," : "") << "\n    \"" << results[i].name << "\": {\"ns_per_frame\": "
+                << results[i].ns_per_frame << ", \"allocs_per_frame\": " << results[i].allocs_per_frame << "}";
+        }
+        out << "\n  }\n}\n";
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_CODEC_SWEEP_H
+#define INCLUDED_GR_OPUS_CODEC_SWEEP_H
+
+#include <gnuradio/gr_opus/api.h>
+#include <string>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Offline encoder settings sweep for picking configurations against a CPU
+ * budget. Every combination of the configured axes is run over a built-in
+ * corpus of synthetic speech-like and music-like signals, so no audio files
+ * are needed. Combinations run in parallel on the shared codec pool; the
+ * codec time of each is measured in thread CPU time, so results do not
+ * depend on how busy the other cores are.
+ */
+class GR_OPUS_API codec_sweep
+{
+public:
+    struct point {
+        std::string signal;
+        int bitrate;
+        int complexity;
+        double frame_ms;
+        std::string application;
+        int dred_frames;      // DRED redundancy in 10 ms units, 0 = off
+        double encode_ns;     // per frame
+        double decode_ns;     // per frame
+        double packet_bytes;  // mean
+        double lsd_db;        // log-spectral distance to the input, lower is better
+        double seg_snr_db;    // segmental SNR to the input
+        bool pareto;          // no point for this signal is both cheaper and better
+    };
+
+    // The corpus is seconds long per signal, mono at sample_rate.
+    codec_sweep(int sample_rate = 48000, double seconds = 10.0);
+
+    // Axes of the sweep; each defaults to a single typical value (24 kb/s,
+    // complexity 10, 20 ms, "audio", no DRED). Invalid values throw.
+    void set_bitrates(const std::vector<int>& bitrates);
+    void set_complexities(const std::vector<int>& complexities);
+    void set_frame_durations(const std::vector<double>& frame_ms);
+    void set_applications(const std::vector<std::string>& applications);
+    void set_dred_frames(const std::vector<int>& dred_frames);
+
+    size_t num_configs() const;
+
+    // Runs the whole sweep and blocks until it is done. Pareto flags are
+    // over encode + decode time against lsd_db, per signal.
+    std::vector<point> run() const;
+
+    // One header line and one line per point.
+    static std::string to_csv(const std::vector<point>& points);
+
+private:
+    int d_sample_rate;
+    double d_seconds;
+    std::vector<int> d_bitrates;
+    std::vector<int> d_complexities;
+    std::vector<double> d_frame_ms;
+    std::vector<std::string> d_applications;
+    std::vector<int> d_dred_frames;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_CODEC_SWEEP_H */
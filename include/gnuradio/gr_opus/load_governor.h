@@ -0,0 +1,53 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_LOAD_GOVERNOR_H
+#define INCLUDED_GR_OPUS_LOAD_GOVERNOR_H
+
+#include <gnuradio/gr_opus/api.h>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Process-wide CPU budget for gr-opus codec work. Every encoder and decoder
+ * reports the time it spends in the codec. While the total exceeds the
+ * budget, the governor sheds quality one priority class at a time, lowest
+ * class first (see set_load_priority() on the blocks), and restores it as
+ * load drops. Emergency channels are never shed.
+ */
+class GR_OPUS_API load_governor
+{
+public:
+    // Budget in CPU cores (e.g. 3.5); 0 (default) disables shedding and
+    // restores every channel.
+    static void set_core_budget(double cores);
+    static double core_budget();
+
+    // Codec time in cores over the most recent measurement interval.
+    static double codec_load();
+    // Registered encoder and decoder instances.
+    static int channels();
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_LOAD_GOVERNOR_H */
@@ -0,0 +1,80 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_CHANNEL_SIM_H
+#define INCLUDED_GR_OPUS_OPUS_CHANNEL_SIM_H
+
+#include <gnuradio/block.h>
+#include <gnuradio/gr_opus/api.h>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Impaired packet channel for measuring loss recovery. Every impairment is
+ * drawn from one generator seeded at construction, so the same seed,
+ * settings and input always give the same output. Each delivered packet
+ * carries a "packet_len" tag; packets that went missing just before it are
+ * counted in a "packet_lost" tag (long) on the same byte, which
+ * opus_decoder::set_packet_tags turns into recovered frames.
+ */
+class GR_OPUS_API opus_channel_sim : virtual public gr::block
+{
+public:
+    typedef std::shared_ptr<opus_channel_sim> sptr;
+
+    // Packets are framed every packet_size bytes or, with packet_size 0, by
+    // "packet_len" tags. With no impairments set the channel is clean.
+    static sptr make(long seed, int packet_size = 0);
+
+    // Gilbert-Elliott burst loss: a good/bad state stepped once per packet
+    // with the given transition probabilities, losing packets with
+    // probability loss_good or loss_bad in each state. The long-run loss
+    // rate is (p_good_to_bad * loss_bad + p_bad_to_good * loss_good) /
+    // (p_good_to_bad + p_bad_to_good); p_bad_to_good = 1 - p_good_to_bad
+    // gives independent losses.
+    virtual void set_burst_loss(double p_good_to_bad, double p_bad_to_good, double loss_good = 0.0, double loss_bad = 1.0) = 0;
+    // Delay variation: each packet is delayed by an exponentially distributed
+    // time with mean jitter_ms. One that is delayed by more than
+    // playout_delay_ms misses its playout deadline and is counted late and
+    // lost, as behind a jitter buffer of that depth.
+    virtual void set_jitter(double jitter_ms, double playout_delay_ms) = 0;
+    // Probability that a packet is delivered after its successor. A packet
+    // still waiting for a successor when the input ends is delivered then.
+    virtual void set_reordering(double probability) = 0;
+    // Probability that a packet is delivered twice.
+    virtual void set_duplication(double probability) = 0;
+    // Independent bit flips in delivered payloads (lengths are kept).
+    virtual void set_bit_error_rate(double ber) = 0;
+
+    virtual long packets_in() const = 0;
+    virtual long packets_delivered() const = 0;
+    // Dropped by the loss model, and dropped for missing the playout deadline.
+    virtual long packets_lost() const = 0;
+    virtual long packets_late() const = 0;
+    virtual long packets_reordered() const = 0;
+    virtual long packets_duplicated() const = 0;
+    virtual long bits_flipped() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_CHANNEL_SIM_H */
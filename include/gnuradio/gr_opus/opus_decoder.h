@@ -21,18 +21,137 @@
 #ifndef INCLUDED_GR_OPUS_OPUS_DECODER_H
 #define INCLUDED_GR_OPUS_OPUS_DECODER_H
 
-#include <gnuradio/sync_block.h>
+#include <gnuradio/block.h>
 #include <gnuradio/gr_opus/api.h>
 
 namespace gr {
 namespace gr_opus {
 
-class GR_OPUS_API opus_decoder : virtual public gr::sync_block
+class GR_OPUS_API opus_decoder : virtual public gr::block
 {
 public:
     typedef std::shared_ptr<opus_decoder> sptr;
 
-    static sptr make(int sample_rate, int channels, int packet_size, const std::string& dnn_blob_path = "");
+    // sample_rate and channels set the output format, not the stream's:
+    // libopus decodes any stream straight to them, so a 48 kHz stereo
+    // stream can be decoded to 16 kHz mono at a fraction of the cost of a
+    // full decode followed by downmix and resampler blocks.
+    //
+    // With defer_init the Opus and DRED states are created on the shared
+    // codec pool in the background and joined in start(), so many blocks
+    // initialise in parallel.
+    static sptr make(int sample_rate, int channels, int packet_size, const std::string& dnn_blob_path = "", bool defer_init = false);
+
+    // Opus Custom decoder counterpart of opus_encoder::make_custom. Custom
+    // packets carry no framing, so packet_size must be the encoder's fixed
+    // packet size.
+    static sptr make_custom(int sample_rate, int channels, int frame_size, int packet_size);
+
+    // Offload packet decoding to the process-wide codec pool (fixed
+    // packet_size only; auto-detect mode always decodes inline).
+    virtual void set_shared_pool(bool enable, int queue_depth = 4) = 0;
+    virtual bool shared_pool() const = 0;
+
+    // Upper bound on packets decoded per work() call (0 = unbounded).
+    virtual void set_max_frames_per_work(int frames) = 0;
+    virtual int max_frames_per_work() const = 0;
+    // Hold decoded audio back until this many frames can be emitted together.
+    virtual void set_min_frames_per_emit(int frames) = 0;
+    virtual int min_frames_per_emit() const = 0;
+    // Publish a telemetry dict on the "telemetry" port every N frames (0 = off).
+    virtual void set_telemetry_interval(int frames) = 0;
+
+    // Real-time mode, as opus_encoder::set_realtime: buffers preallocated,
+    // faulted in and mlocked, optional SCHED_FIFO for the work() thread and
+    // the shared codec pool, page faults inside work() in telemetry.
+    virtual void set_realtime(bool enable, int priority = 0) = 0;
+    virtual bool realtime() const = 0;
+
+    // Switch output format before the next packet, re-initialising the
+    // existing codec state in place. The first sample of the new format is
+    // tagged "opus_format". The same request can be sent as a dict
+    // {sample_rate, channels} to the "reconfig" port.
+    virtual void set_format(int sample_rate, int channels) = 0;
+
+    // What to do once the packet backlog reaches its limit (1 MiB):
+    // "drop_oldest" (default) or "drop_newest" discard whole packets, and
+    // "backpressure" stops consuming input so upstream stalls. Without a
+    // fixed packet_size there are no known packet boundaries, so dropping
+    // discards the whole backlog (or the whole new input) instead.
+    virtual void set_overload_policy(const std::string& policy) = 0;
+    virtual std::string overload_policy() const = 0;
+
+    // With packet_size 0, frame packets at the "packet_len" tags written by
+    // opus_encoder::set_packet_tags instead of searching for boundaries.
+    // A "packet_lost" tag (long n) on a packet's first byte says n packets
+    // went missing just before it; each is replaced by one frame of audio
+    // recovered as set by set_loss_recovery, so output timing is kept.
+    // Overload always holds input back in this mode.
+    virtual void set_packet_tags(bool enable) = 0;
+    virtual bool packet_tags() const = 0;
+
+    // How frames signalled lost are recovered: "plc" (default) runs packet
+    // loss concealment, "fec" rebuilds the frame just before the next
+    // packet from that packet's in-band FEC data (see
+    // opus_encoder::set_inband_fec), and "dred" rebuilds as many as the next
+    // packet's DRED data covers (libopus with DRED only). Frames a mode
+    // cannot recover fall back to PLC.
+    virtual void set_loss_recovery(const std::string& mode) = 0;
+    virtual std::string loss_recovery() const = 0;
+
+    // Output stage, run in the same pass that converts each decoded frame
+    // to float, in place of separate gain, limiter, meter and squelch
+    // blocks. Settings take effect at the next frame.
+    //
+    // Gain in dB (-60 to +40) applied before the limiter.
+    virtual void set_output_gain(double gain_db) = 0;
+    virtual double output_gain() const = 0;
+    // Replace the hard clamp at full scale with a soft limiter: linear up
+    // to -1 dBFS, then bending smoothly towards full scale.
+    virtual void set_soft_limiter(bool enable) = 0;
+    virtual bool soft_limiter() const = 0;
+    // Mute the output while the level (after gain) stays below
+    // threshold_dbfs, holding the gate open for hang_ms after the last loud
+    // frame. The gate fades over one frame.
+    virtual void set_squelch(bool enable, double threshold_dbfs = -50.0, int hang_ms = 200) = 0;
+    virtual bool squelch() const = 0;
+    // Publish the output peak and RMS level (dBFS) in telemetry as
+    // level_peak_dbfs and level_rms_dbfs.
+    virtual void set_level_meter(bool enable) = 0;
+    virtual bool level_meter() const = 0;
+
+    // Packet size in use: packet_size when fixed, otherwise the length auto
+    // mode has locked onto after a run of equal packets (0 while searching).
+    virtual int detected_packet_size() const = 0;
+
+    // Channel count coded in the most recent packet (0 before the first),
+    // for checking what a decode-to-mono profile is folding down.
+    virtual int stream_channels() const = 0;
+
+    // Decoder complexity 0-10, or -1 (default) to keep the libopus default.
+    // From libopus 1.5 it selects the decoder-side neural features built
+    // into the library: deep PLC from 5, LACE enhancement at 6 and NoLACE
+    // from 7. Older libopus ignores it (telemetry reports
+    // complexity_supported = false).
+    virtual void set_complexity(int complexity) = 0;
+    virtual int complexity() const = 0;
+
+    // Governor: while the measured decode time exceeds max_load of the
+    // frame duration, drop the effective complexity one feature step at a
+    // time (NoLACE, LACE, deep PLC, off); step back up once the load falls
+    // below a quarter of max_load.
+    virtual void set_complexity_governor(bool enable, double max_load = 0.5) = 0;
+    virtual int effective_complexity() const = 0;
+
+    // Priority class under the process-wide load governor (see
+    // load_governor.h): "emergency", "high", "normal" (default) or "low".
+    // Under overload the lowest class is shed first, one level at a time:
+    // reduced complexity, minimal complexity with DRED recovery off, then muted (input is
+    // consumed and discarded). Emergency channels are never shed.
+    virtual void set_load_priority(const std::string& priority) = 0;
+    virtual std::string load_priority() const = 0;
+    // Current shed level: 0 full quality ... 3 muted.
+    virtual int load_shed_level() const = 0;
 };
 
 } // namespace gr_opus
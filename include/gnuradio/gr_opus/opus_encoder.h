@@ -21,18 +21,122 @@
 #ifndef INCLUDED_GR_OPUS_OPUS_ENCODER_H
 #define INCLUDED_GR_OPUS_OPUS_ENCODER_H
 
-#include <gnuradio/sync_block.h>
+#include <gnuradio/block.h>
 #include <gnuradio/gr_opus/api.h>
 
 namespace gr {
 namespace gr_opus {
 
-class GR_OPUS_API opus_encoder : virtual public gr::sync_block
+class GR_OPUS_API opus_encoder : virtual public gr::block
 {
 public:
     typedef std::shared_ptr<opus_encoder> sptr;
 
-    static sptr make(int sample_rate, int channels, int bitrate, const std::string& application, bool enable_fargan_voice = false, const std::string& dnn_blob_path = "");
+    // With defer_init the Opus state is created on the shared codec pool in the
+    // background and joined in start(), so many blocks initialise in parallel.
+    static sptr make(int sample_rate, int channels, int bitrate, const std::string& application, bool enable_fargan_voice = false, const std::string& dnn_blob_path = "", bool defer_init = false);
+
+    // Opus Custom (CELT-only, constant bitrate) encoder for sample rates of
+    // 8..96 kHz and frame sizes of 40..1024 samples. Packets are not
+    // decodable by standard Opus decoders; pair with opus_decoder::make_custom.
+    // Throws if libopus was built without custom modes.
+    static sptr make_custom(int sample_rate, int channels, int bitrate, int frame_size);
+
+    // Offload frame encoding to the process-wide codec pool. Packets come
+    // back in order; at most queue_depth frames are in flight per block.
+    virtual void set_shared_pool(bool enable, int queue_depth = 4) = 0;
+    virtual bool shared_pool() const = 0;
+
+    // Upper bound on frames encoded per work() call (0 = unbounded).
+    virtual void set_max_frames_per_work(int frames) = 0;
+    virtual int max_frames_per_work() const = 0;
+    // Hold packets back until this many can be emitted in one output burst.
+    virtual void set_min_frames_per_emit(int frames) = 0;
+    virtual int min_frames_per_emit() const = 0;
+    // Publish a telemetry dict on the "telemetry" port every N frames (0 = off).
+    virtual void set_telemetry_interval(int frames) = 0;
+
+    // Tag the first byte of every packet with "packet_len" (long), so
+    // downstream blocks can frame VBR packets without guessing.
+    virtual void set_packet_tags(bool enable) = 0;
+    virtual bool packet_tags() const = 0;
+
+    // Discontinuous transmission: once the input has been inactive for a
+    // short while, frames are sent as 1-2 byte packets, with an occasional
+    // comfort-noise update. opus_multi_recorder uses these to index talk
+    // spurts. Throws for Opus Custom encoders.
+    virtual void set_dtx(bool enable) = 0;
+    virtual bool dtx() const = 0;
+
+    // In-band forward error correction: SILK and hybrid frames carry a
+    // low-bitrate copy of the previous frame, sized for the expected loss
+    // rate (0-100 %), which opus_decoder recovers with loss_recovery "fec".
+    // CELT-only frames (high bitrates, application "lowdelay") carry none.
+    // Throws for Opus Custom encoders.
+    virtual void set_inband_fec(bool enable, int expected_loss_percent = 10) = 0;
+    virtual bool inband_fec() const = 0;
+
+    // Classify the input before encoding and steer libopus with it: speech
+    // sets OPUS_SIGNAL_VOICE and music OPUS_SIGNAL_MUSIC, and the maximum
+    // bandwidth follows the highest band that carries energy. Narrowband
+    // voice then encodes as cheap SILK-only frames instead of paying for
+    // hybrid or CELT coding of empty bands. Decisions are held for at least
+    // half a second; the bandwidth widens at once when new content appears.
+    // Disabling restores OPUS_AUTO and full band. Throws for Opus Custom
+    // encoders.
+    virtual void set_signal_classifier(bool enable) = 0;
+    virtual bool signal_classifier_enabled() const = 0;
+
+    // Stereo inputs whose channels are effectively identical (side signal
+    // threshold_db or more below the mid for half a second) are coded as
+    // mono with OPUS_SET_FORCE_CHANNELS(1); coding returns to stereo on the
+    // first frame where the channels diverge. Streams stay stereo for the
+    // decoder. Has no effect on mono inputs. Throws for Opus Custom
+    // encoders.
+    virtual void set_mono_collapse(bool enable, double threshold_db = 30.0) = 0;
+    virtual bool mono_collapse() const = 0;
+    // Seconds of stereo input coded as mono and as stereo so far.
+    virtual double collapsed_seconds() const = 0;
+    virtual double stereo_seconds() const = 0;
+
+    // Real-time mode. Every buffer the block uses while running (sample
+    // backlog, output staging, scratch, pool slots and the codec state) is
+    // preallocated to its limit, faulted in and mlocked, and the stack of
+    // the thread calling work() is faulted in, so no page fault happens
+    // mid-stream. With priority 1-99 that thread, and the shared codec pool
+    // workers, also run under SCHED_FIFO at that priority, with each pool
+    // worker pinned to one CPU. Whatever the system refuses (RLIMIT_MEMLOCK,
+    // missing CAP_SYS_NICE) is skipped; telemetry shows what took effect,
+    // along with the page faults taken inside work(). Disabling it restores
+    // normal scheduling, for the pool once no other block still asks for it.
+    virtual void set_realtime(bool enable, int priority = 0) = 0;
+    virtual bool realtime() const = 0;
+
+    // Switch input format at the next frame boundary, re-initialising the
+    // existing codec state in place. Buffered samples of the old format are
+    // flushed first (a trailing partial frame is padded with silence) and the
+    // first byte of the new format is tagged "opus_format". The same request
+    // can be sent as a dict {sample_rate, channels} to the "reconfig" port.
+    virtual void set_format(int sample_rate, int channels) = 0;
+
+    // What to do once the input backlog reaches its limit (10 s of audio):
+    // "drop_oldest" (default) or "drop_newest" discard whole frames,
+    // "backpressure" stops consuming input so upstream stalls, and
+    // "degrade_bitrate" steps bitrate and complexity down while the backlog
+    // is above half the limit, dropping the oldest frames only at the limit.
+    // Not available for Opus Custom encoders, whose packet size is fixed.
+    virtual void set_overload_policy(const std::string& policy) = 0;
+    virtual std::string overload_policy() const = 0;
+
+    // Priority class under the process-wide load governor (see
+    // load_governor.h): "emergency", "high", "normal" (default) or "low".
+    // Under overload the lowest class is shed first, one level at a time:
+    // reduced complexity, minimal complexity with DRED off, then muted (input is
+    // consumed and discarded). Emergency channels are never shed.
+    virtual void set_load_priority(const std::string& priority) = 0;
+    virtual std::string load_priority() const = 0;
+    // Current shed level: 0 full quality ... 3 muted.
+    virtual int load_shed_level() const = 0;
 };
 
 } // namespace gr_opus
@@ -0,0 +1,64 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_ENCODER_BANK_H
+#define INCLUDED_GR_OPUS_OPUS_ENCODER_BANK_H
+
+#include <gnuradio/block.h>
+#include <gnuradio/gr_opus/api.h>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Encoder for a bank of identically configured mono channels: one float
+ * input and one byte output per channel, 20 ms frames. The pending frames
+ * of every channel are staged in one structure-of-arrays block, so a single
+ * sweep converts and clamps all of them, and each channel's encoder then
+ * runs over its own contiguous frames. Per-channel work outside libopus is
+ * paid once per work() call rather than once per frame. Packets match
+ * opus_encoder byte for byte and each carries a "packet_len" tag.
+ */
+class GR_OPUS_API opus_encoder_bank : virtual public gr::block
+{
+public:
+    typedef std::shared_ptr<opus_encoder_bank> sptr;
+
+    static sptr make(int num_channels, int sample_rate, int bitrate, const std::string& application);
+
+    // Applied to every channel at the next work() call.
+    virtual void set_bitrate(int bitrate) = 0;
+    virtual int bitrate() const = 0;
+    // Frames per channel staged in one work() call (1 to 50, default 8).
+    virtual void set_max_frames_per_work(int frames) = 0;
+    virtual int max_frames_per_work() const = 0;
+
+    virtual int num_channels() const = 0;
+    virtual long frames_encoded() const = 0;
+    virtual long encode_errors() const = 0;
+    // Share of work() time spent outside opus_encode since the start.
+    virtual double overhead_fraction() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_ENCODER_BANK_H */
@@ -0,0 +1,78 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_MULTI_RECORDER_H
+#define INCLUDED_GR_OPUS_OPUS_MULTI_RECORDER_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_opus/api.h>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Records many Opus packet streams to Ogg Opus files, one file series per
+ * input. Pages are built in work() and handed to a single writer thread
+ * that batches them into large writes, so the flowgraph never waits on
+ * the disk. Each input's files are rotated by audio time and by size and
+ * carry a seek index alongside.
+ */
+class GR_OPUS_API opus_multi_recorder : virtual public gr::sync_block
+{
+public:
+    typedef std::shared_ptr<opus_multi_recorder> sptr;
+
+    // Input i is written to <directory>/<prefix>_ch<i>_<segment>.opus with
+    // a "<granule> <byte offset>" line per page in the matching .idx file,
+    // and a "<start granule> <end granule>" line per talk spurt in .spurts.
+    // Packets of 2 bytes or less (DTX, see opus_encoder::set_dtx) count as
+    // silence; a spurt ends after 300 ms of them.
+    // sample_rate and channels describe the coded streams. Packets are
+    // framed every packet_size bytes or, with packet_size 0, by the
+    // "packet_len" tags of opus_encoder::set_packet_tags. A segment ends
+    // after segment_seconds of audio or segment_bytes of file, whichever
+    // comes first (<= 0 disables that limit). If more than
+    // max_queued_bytes are waiting for the disk, new pages are dropped.
+    static sptr make(int num_inputs,
+                     const std::string& directory,
+                     const std::string& prefix,
+                     int sample_rate,
+                     int channels,
+                     int packet_size = 0,
+                     double segment_seconds = 3600.0,
+                     long segment_bytes = 0,
+                     long max_queued_bytes = 64 * 1024 * 1024);
+
+    // Ends every open segment at the next work() call.
+    virtual void rotate() = 0;
+
+    virtual long segments_completed() const = 0;
+    virtual long spurts_indexed() const = 0;
+    virtual long bytes_written() const = 0;
+    virtual long pages_dropped() const = 0;
+    virtual long write_errors() const = 0;
+    virtual long queued_bytes() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_MULTI_RECORDER_H */
@@ -0,0 +1,67 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_OGG_DEMUX_H
+#define INCLUDED_GR_OPUS_OPUS_OGG_DEMUX_H
+
+#include <gnuradio/block.h>
+#include <gnuradio/gr_opus/api.h>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Ogg Opus demuxer for live byte streams (Icecast relays, pipes). Pages are
+ * parsed incrementally, each checked against its CRC; after garbage or a
+ * damaged page the parser resyncs on the next "OggS" capture pattern.
+ * Audio packets leave back to back, each with a "packet_len" tag (long)
+ * for opus_decoder::set_packet_tags and a "packet_time" tag (double):
+ * its start in seconds of stream time, from the page granule positions
+ * with the pre-skip removed. After missing pages, the first packet also
+ * carries a "packet_lost" tag with the number of packets the granule gap
+ * accounts for, so the decoder conceals them. Header packets are consumed,
+ * and chained streams (a new OpusHead) are followed.
+ */
+class GR_OPUS_API opus_ogg_demux : virtual public gr::block
+{
+public:
+    typedef std::shared_ptr<opus_ogg_demux> sptr;
+
+    static sptr make();
+
+    // From the OpusHead of the current logical stream; 0 until one is seen.
+    virtual int channels() const = 0;
+    virtual int pre_skip() const = 0;
+    // Start of the last packet emitted, as in its "packet_time" tag.
+    virtual double stream_time() const = 0;
+
+    virtual long pages() const = 0;
+    virtual long packets() const = 0;
+    virtual long streams() const = 0;
+    virtual long crc_errors() const = 0;
+    virtual long bytes_skipped() const = 0;
+    // Pages missing from the sequence of the current stream.
+    virtual long pages_lost() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_OGG_DEMUX_H */
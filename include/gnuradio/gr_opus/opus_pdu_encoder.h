@@ -0,0 +1,84 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_PDU_ENCODER_H
+#define INCLUDED_GR_OPUS_OPUS_PDU_ENCODER_H
+
+#include <gnuradio/block.h>
+#include <gnuradio/gr_opus/api.h>
+#include <string>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Message-only Opus encoder for bursty sources. PDUs of interleaved f32
+ * samples arrive on "in" in any length; samples are framed in a ring that
+ * keeps frame alignment from one PDU to the next, and the packets of each
+ * burst leave on "out" as a single PDU. No stream buffers or tags are
+ * involved.
+ *
+ * A PDU ends its burst unless its metadata sets "burst_end" to false. The
+ * output PDU carries the burst's packets back to back in a u8vector; its
+ * metadata is the metadata of the PDU that ended the burst plus
+ * {burst, packet_lengths (s32vector), sample_rate, channels,
+ * padded_samples}.
+ */
+class GR_OPUS_API opus_pdu_encoder : virtual public gr::block
+{
+public:
+    typedef std::shared_ptr<opus_pdu_encoder> sptr;
+
+    // frame_ms is one of the Opus durations 2.5 to 120 ms.
+    static sptr make(int sample_rate, int channels, int bitrate, const std::string& application = "audio", double frame_ms = 20.0);
+
+    // The PDU path on the calling thread: appends samples to the current
+    // burst and, when burst_end is set, returns its packets back to back
+    // (empty otherwise). Lengths are in last_packet_lengths().
+    virtual std::vector<unsigned char> encode_burst(const std::vector<float>& samples, bool burst_end = true) = 0;
+    virtual std::vector<int> last_packet_lengths() const = 0;
+
+    // At burst end, pad the trailing partial frame with silence and encode
+    // it (default). When disabled it stays in the ring and leads the next
+    // burst, for continuous audio that is merely delivered in bursts.
+    virtual void set_flush(bool enable) = 0;
+    virtual bool flush() const = 0;
+    // Pad every packet to bytes with opus_packet_pad so a modem sees
+    // fixed-size frames; 0 disables. Larger packets are left as they are
+    // and counted in oversize_packets().
+    virtual void set_packet_padding(int bytes) = 0;
+    virtual int packet_padding() const = 0;
+    virtual void set_bitrate(int bitrate) = 0;
+    virtual int bitrate() const = 0;
+
+    virtual long bursts() const = 0;
+    virtual long packets() const = 0;
+    // Silence appended by trailing-frame flushes.
+    virtual long padded_samples() const = 0;
+    virtual long oversize_packets() const = 0;
+    // PDUs on "in" that were not a pair with an f32vector payload.
+    virtual long invalid_pdus() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_PDU_ENCODER_H */
@@ -0,0 +1,67 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_REPLAY_BUFFER_H
+#define INCLUDED_GR_OPUS_OPUS_REPLAY_BUFFER_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_opus/api.h>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Instant-replay sink. Keeps the most recent Opus packets of a stream in a
+ * fixed-size arena ring instead of PCM (20x or more smaller) and decodes any
+ * past window on demand with a fresh decoder, so the live decoder is never
+ * touched.
+ */
+class GR_OPUS_API opus_replay_buffer : virtual public gr::sync_block
+{
+public:
+    typedef std::shared_ptr<opus_replay_buffer> sptr;
+
+    // sample_rate and channels are the replay output format. Packets are
+    // framed every packet_size bytes or, with packet_size 0, by the
+    // "packet_len" tags of opus_encoder::set_packet_tags. The arena holds
+    // history_seconds of packets at up to max_bitrate; older packets are
+    // overwritten.
+    static sptr make(int sample_rate, int channels, int packet_size, double history_seconds, int max_bitrate = 128000);
+
+    // Queue a decode of duration seconds starting seconds_ago before the
+    // newest packet. It runs on the shared codec pool and the result is
+    // published on the "replay" port as a PDU: metadata {id, start_sample,
+    // sample_rate, channels} and interleaved f32 samples. Returns the id.
+    // A dict {seconds_ago, duration} on the "request" port does the same.
+    virtual long request_replay(double seconds_ago, double duration) = 0;
+    // The same decode on the calling thread; returns interleaved samples.
+    virtual std::vector<float> replay(double seconds_ago, double duration) = 0;
+
+    // Seconds of audio currently held, and arena usage.
+    virtual double history_available() const = 0;
+    virtual size_t arena_bytes() const = 0;
+    virtual size_t packets_stored() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_REPLAY_BUFFER_H */
@@ -0,0 +1,58 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_SHM_SINK_H
+#define INCLUDED_GR_OPUS_OPUS_SHM_SINK_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_opus/api.h>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Publishes decoded PCM to a lock-free ring in /dev/shm for consumers
+ * outside the flowgraph (see shm_ring.h for the layout and a reader).
+ * Writing never waits for readers; readers that fall a full ring behind
+ * are counted here and skip ahead on their side.
+ */
+class GR_OPUS_API opus_shm_sink : virtual public gr::sync_block
+{
+public:
+    typedef std::shared_ptr<opus_shm_sink> sptr;
+
+    // Input is interleaved float PCM, e.g. an opus_decoder output. Every
+    // frame_samples samples per channel are published as one slot with a
+    // sequence number, stream position and wall-clock timestamp. The ring
+    // /dev/shm/<name> is created (replacing any stale one) and removed again
+    // when the block is destroyed.
+    static sptr make(const std::string& name, int sample_rate, int channels, int frame_samples = 960, int slot_count = 256);
+
+    virtual long frames_published() const = 0;
+    // Registered readers, and how many times a reader was found lapped.
+    virtual int readers() const = 0;
+    virtual long reader_overruns() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_SHM_SINK_H */
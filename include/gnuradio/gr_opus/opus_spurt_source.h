@@ -0,0 +1,58 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_SPURT_SOURCE_H
+#define INCLUDED_GR_OPUS_OPUS_SPURT_SOURCE_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_opus/api.h>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Plays back only the talk spurts of an opus_multi_recorder segment. The
+ * .spurts sidecar lists them and the .idx seek index locates their pages,
+ * so the silence between spurts is neither read nor decoded.
+ */
+class GR_OPUS_API opus_spurt_source : virtual public gr::sync_block
+{
+public:
+    typedef std::shared_ptr<opus_spurt_source> sptr;
+
+    // path is the .opus file; its .spurts and .idx sidecars are optional
+    // (without .spurts the whole file is one spurt, without .idx spurts are
+    // found by reading pages in order). Output is interleaved float PCM at
+    // sample_rate/channels. The first sample of every spurt is tagged
+    // "spurt_start" with its position in the recording, in samples at
+    // sample_rate. The stream ends after the last spurt.
+    static sptr make(const std::string& path, int sample_rate, int channels);
+
+    virtual long num_spurts() const = 0;
+    // Total duration of the indexed spurts.
+    virtual double spurt_seconds() const = 0;
+    virtual long spurts_played() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_SPURT_SOURCE_H */
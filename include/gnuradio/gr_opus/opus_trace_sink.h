@@ -0,0 +1,57 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_TRACE_SINK_H
+#define INCLUDED_GR_OPUS_OPUS_TRACE_SINK_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_opus/api.h>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Captures an Opus packet stream with arrival times to a compact trace
+ * file, for replay through opus_trace_source. "packet_lost" counts are
+ * kept with the packet they precede. Arrival times are read once per
+ * work() call, so packets delivered in the same buffer share a timestamp.
+ * Disk writes happen on a background thread; if it falls behind, packets
+ * are dropped from the trace and counted rather than stalling the
+ * flowgraph.
+ */
+class GR_OPUS_API opus_trace_sink : virtual public gr::sync_block
+{
+public:
+    typedef std::shared_ptr<opus_trace_sink> sptr;
+
+    // sample_rate and channels are stored for the replaying decoder.
+    // Packets are framed every packet_size bytes or, with packet_size 0,
+    // by "packet_len" tags. The file is created (truncated) at once.
+    static sptr make(const std::string& path, int sample_rate, int channels, int packet_size = 0);
+
+    virtual long packets_captured() const = 0;
+    virtual long packets_dropped() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_TRACE_SINK_H */
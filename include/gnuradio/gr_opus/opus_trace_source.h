@@ -0,0 +1,62 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_TRACE_SOURCE_H
+#define INCLUDED_GR_OPUS_OPUS_TRACE_SOURCE_H
+
+#include <gnuradio/sync_block.h>
+#include <gnuradio/gr_opus/api.h>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Replays a trace written by opus_trace_sink as a byte stream of Opus
+ * packets, each tagged "packet_len" on its first byte (plus "packet_lost"
+ * where the capture saw one), so that field traffic can be rerun through
+ * any build of the decoder.
+ */
+class GR_OPUS_API opus_trace_source : virtual public gr::sync_block
+{
+public:
+    typedef std::shared_ptr<opus_trace_source> sptr;
+
+    // With realtime, each packet is released at its captured arrival time
+    // (relative to the first work() call); otherwise as fast as the
+    // flowgraph takes them. With repeat, the trace loops, shifted by its
+    // own duration each time.
+    static sptr make(const std::string& path, bool realtime = true, bool repeat = false);
+
+    // Stream format recorded by the capture, for configuring the decoder.
+    virtual int sample_rate() const = 0;
+    virtual int channels() const = 0;
+
+    virtual long num_packets() const = 0;
+    virtual double duration_seconds() const = 0;
+    virtual long packets_replayed() const = 0;
+    // Realtime mode: how far behind schedule the worst packet was released.
+    virtual double max_lateness_ms() const = 0;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_TRACE_SOURCE_H */
@@ -0,0 +1,247 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_SHM_RING_H
+#define INCLUDED_GR_OPUS_SHM_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Layout of the shared-memory PCM ring written by opus_shm_sink, and a
+ * header-only reader for consumers outside GNU Radio (link with -lrt on
+ * older glibc). The file /dev/shm/<name> holds a shm_ring_header, then
+ * max_readers shm_ring_reader_entry records, then slot_count slots of
+ * slot_bytes each: a shm_ring_slot followed by frame_samples * channels
+ * interleaved floats. All integers are native-endian.
+ *
+ * One writer, any number of readers, no locks. A slot is a seqlock: the
+ * writer stores seq_begin, the samples, then seq_end; a reader that finds
+ * seq_end == seq before reading and seq_begin == seq after has an intact
+ * frame. The writer never waits; a reader that falls more than slot_count
+ * frames behind is lapped and must skip ahead.
+ */
+
+namespace gr {
+namespace gr_opus {
+
+static const char shm_ring_magic[8] = { 'G', 'R', 'O', 'P', 'U', 'S', 'P', 'R' };
+static const uint32_t shm_ring_version = 1;
+static const uint32_t shm_ring_max_readers = 16;
+
+struct shm_ring_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t frame_samples; // per channel, per slot
+    uint32_t slot_count;
+    uint32_t slot_bytes;
+    uint32_t max_readers;
+    uint32_t writer_pid;
+    std::atomic<uint64_t> write_seq; // newest published frame, 0 = none yet
+    std::atomic<uint32_t> closed;    // set when the writer goes away
+    uint32_t reserved[7];
+};
+
+struct shm_ring_reader_entry {
+    std::atomic<uint32_t> pid; // 0 = free
+    uint32_t reserved;
+    std::atomic<uint64_t> read_seq; // last frame this reader finished with
+};
+
+struct shm_ring_slot {
+    std::atomic<uint64_t> seq_begin;
+    uint64_t sample_offset;   // stream position of the first sample, per channel
+    uint64_t timestamp_ns;    // CLOCK_REALTIME when the frame was published
+    uint32_t samples;         // per channel, <= frame_samples
+    uint32_t reserved;
+    std::atomic<uint64_t> seq_end;
+};
+
+// The layout is an interface to other processes and languages.
+static_assert(sizeof(shm_ring_header) == 80, "shm_ring_header layout changed");
+static_assert(sizeof(shm_ring_reader_entry) == 16, "shm_ring_reader_entry layout changed");
+static_assert(sizeof(shm_ring_slot) == 40, "shm_ring_slot layout changed");
+
+inline size_t shm_ring_slot_bytes(int channels, int frame_samples)
+{
+    size_t bytes = sizeof(shm_ring_slot) + sizeof(float) * channels * frame_samples;
+    return (bytes + 63) & ~size_t(63);
+}
+
+inline size_t shm_ring_size(int channels, int frame_samples, int slot_count)
+{
+    return sizeof(shm_ring_header) + sizeof(shm_ring_reader_entry) * shm_ring_max_readers +
+           shm_ring_slot_bytes(channels, frame_samples) * slot_count;
+}
+
+inline shm_ring_slot* shm_ring_slot_at(void* base, uint64_t seq)
+{
+    shm_ring_header* h = static_cast<shm_ring_header*>(base);
+    char* slots = static_cast<char*>(base) + sizeof(shm_ring_header) +
+                  sizeof(shm_ring_reader_entry) * h->max_readers;
+    return reinterpret_cast<shm_ring_slot*>(slots + (seq % h->slot_count) * h->slot_bytes);
+}
+
+/*
+ * Reads frames in order without copying. next() exposes the samples of
+ * the following frame in place; release() then confirms they were not
+ * overwritten while in use and moves on.
+ */
+class shm_ring_reader
+{
+public:
+    enum status { FRAME, NO_FRAME, LAPPED, WRITER_CLOSED };
+
+    // Starts at the newest frame. Throws if the ring does not exist or is
+    // not a gr-opus ring.
+    explicit shm_ring_reader(const std::string& name) : d_base(nullptr), d_size(0), d_entry(nullptr), d_lost(0)
+    {
+        int fd = shm_open(("/" + name).c_str(), O_RDWR, 0);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open shared-memory ring: " + name);
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(shm_ring_header)) {
+            d_size = static_cast<size_t>(st.st_size);
+            void* base = mmap(nullptr, d_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            d_base = base == MAP_FAILED ? nullptr : base;
+        }
+        close(fd);
+        if (d_base == nullptr || std::memcmp(header()->magic, shm_ring_magic, 8) != 0 ||
+            header()->version != shm_ring_version) {
+            unmap();
+            throw std::runtime_error("Not a gr-opus shared-memory ring: " + name);
+        }
+
+        // Register so the writer can report us when we fall behind.
+        shm_ring_reader_entry* entries = reinterpret_cast<shm_ring_reader_entry*>(header() + 1);
+        for (uint32_t i = 0; i < header()->max_readers && d_entry == nullptr; ++i) {
+            uint32_t expected = 0;
+            if (entries[i].pid.compare_exchange_strong(expected, static_cast<uint32_t>(getpid()))) {
+                d_entry = &entries[i];
+            }
+        }
+        d_seq = header()->write_seq.load(std::memory_order_acquire);
+        if (d_entry) {
+            d_entry->read_seq.store(d_seq, std::memory_order_release);
+        }
+    }
+
+    ~shm_ring_reader()
+    {
+        if (d_entry) {
+            d_entry->pid.store(0, std::memory_order_release);
+        }
+        unmap();
+    }
+
+    shm_ring_reader(const shm_ring_reader&) = delete;
+    shm_ring_reader& operator=(const shm_ring_reader&) = delete;
+
+    const shm_ring_header& info() const { return *header(); }
+
+    // On FRAME, samples points at slot->samples * channels interleaved floats.
+    status next(const shm_ring_slot*& slot, const float*& samples)
+    {
+        const uint64_t want = d_seq + 1;
+        const uint64_t newest = header()->write_seq.load(std::memory_order_acquire);
+        if (newest < want) {
+            return header()->closed.load(std::memory_order_acquire) ? WRITER_CLOSED : NO_FRAME;
+        }
+        if (newest - want >= header()->slot_count) {
+            skip_to(newest);
+            return LAPPED;
+        }
+        shm_ring_slot* s = shm_ring_slot_at(d_base, want);
+        if (s->seq_end.load(std::memory_order_acquire) != want) {
+            skip_to(newest);
+            return LAPPED;
+        }
+        slot = s;
+        samples = reinterpret_cast<const float*>(s + 1);
+        return FRAME;
+    }
+
+    // False if the frame from next() was overwritten while it was in use.
+    bool release()
+    {
+        const uint64_t want = d_seq + 1;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool intact = shm_ring_slot_at(d_base, want)->seq_begin.load(std::memory_order_relaxed) == want;
+        if (!intact) {
+            skip_to(header()->write_seq.load(std::memory_order_acquire));
+            return false;
+        }
+        d_seq = want;
+        if (d_entry) {
+            d_entry->read_seq.store(d_seq, std::memory_order_release);
+        }
+        return true;
+    }
+
+    uint64_t sequence() const { return d_seq; }
+    // Frames skipped because this reader was lapped.
+    uint64_t lost_frames() const { return d_lost; }
+
+private:
+    shm_ring_header* header() const { return static_cast<shm_ring_header*>(d_base); }
+
+    void skip_to(uint64_t newest)
+    {
+        // Resume half a ring behind the writer to leave some slack.
+        uint64_t resume = newest > header()->slot_count / 2 ? newest - header()->slot_count / 2 : 0;
+        if (resume > d_seq) {
+            d_lost += resume - d_seq;
+            d_seq = resume;
+        }
+        if (d_entry) {
+            d_entry->read_seq.store(d_seq, std::memory_order_release);
+        }
+    }
+
+    void unmap()
+    {
+        if (d_base) {
+            munmap(d_base, d_size);
+            d_base = nullptr;
+        }
+    }
+
+    void* d_base;
+    size_t d_size;
+    shm_ring_reader_entry* d_entry;
+    uint64_t d_seq;
+    uint64_t d_lost;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_SHM_RING_H */
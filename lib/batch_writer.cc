@@ -0,0 +1,224 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "batch_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+const std::chrono::milliseconds tail_age(1000);
+
+} // namespace
+
+batch_writer::batch_writer(size_t max_queued_bytes, size_t chunk_bytes)
+    : d_max_queued_bytes(max_queued_bytes),
+      d_chunk_bytes(std::max<size_t>(1, chunk_bytes)),
+      d_queued_bytes(0),
+      d_shutdown(false),
+      d_next_handle(0),
+      d_bytes_written(0),
+      d_write_errors(0)
+{
+    d_thread = std::thread(&batch_writer::run, this);
+#ifdef __linux__
+    pthread_setname_np(d_thread.native_handle(), "gr_opus_writer");
+#endif
+}
+
+batch_writer::~batch_writer()
+{
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_shutdown = true;
+    }
+    d_cv.notify_all();
+    d_thread.join();
+}
+
+int batch_writer::open(const std::string& path)
+{
+    int handle = d_next_handle++;
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_ops.push_back({ op::OPEN, handle, path, {}, false });
+    }
+    d_cv.notify_one();
+    return handle;
+}
+
+bool batch_writer::write(int handle, std::vector<unsigned char> data)
+{
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        if (d_queued_bytes + data.size() > d_max_queued_bytes) {
+            return false;
+        }
+        d_queued_bytes += data.size();
+        d_ops.push_back({ op::WRITE, handle, std::string(), std::move(data), false });
+    }
+    d_cv.notify_one();
+    return true;
+}
+
+void batch_writer::close(int handle, bool sync)
+{
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_ops.push_back({ op::CLOSE, handle, std::string(), {}, sync });
+    }
+    d_cv.notify_one();
+}
+
+size_t batch_writer::queued_bytes() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return d_queued_bytes;
+}
+
+void batch_writer::run()
+{
+    std::deque<op> batch;
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(d_mutex);
+            d_cv.wait_for(lock, tail_age / 2, [this] { return d_shutdown || !d_ops.empty(); });
+            batch.swap(d_ops);
+            stopping = d_shutdown;
+        }
+
+        // Everything that arrived since the last wake is staged first, so
+        // each file sees one write per pass however many pages it got.
+        for (op& o : batch) {
+            apply(o);
+        }
+        size_t taken = 0;
+        for (const op& o : batch) {
+            taken += o.data.size();
+        }
+        batch.clear();
+        {
+            std::lock_guard<std::mutex> lock(d_mutex);
+            d_queued_bytes -= taken;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (auto& entry : d_files) {
+            file_state& f = entry.second;
+            write_out(f, !f.staged.empty() && now - f.staged_since >= tail_age);
+        }
+
+        if (stopping) {
+            std::lock_guard<std::mutex> lock(d_mutex);
+            if (d_ops.empty()) {
+                break;
+            }
+        }
+    }
+
+    for (auto& entry : d_files) {
+        write_out(entry.second, true);
+        if (entry.second.fd >= 0) {
+            ::close(entry.second.fd);
+        }
+    }
+    d_files.clear();
+}
+
+void batch_writer::apply(op& o)
+{
+    if (o.kind == op::OPEN) {
+        int fd = ::open(o.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            d_write_errors++;
+        }
+        d_files[o.handle] = { fd, {}, std::chrono::steady_clock::now() };
+        return;
+    }
+
+    auto it = d_files.find(o.handle);
+    if (it == d_files.end()) {
+        d_write_errors++;
+        return;
+    }
+    file_state& f = it->second;
+    if (o.kind == op::WRITE) {
+        if (f.staged.empty()) {
+            f.staged_since = std::chrono::steady_clock::now();
+        }
+        f.staged.insert(f.staged.end(), o.data.begin(), o.data.end());
+        return;
+    }
+
+    write_out(f, true);
+    if (f.fd >= 0) {
+        if (o.sync) {
+            fdatasync(f.fd);
+        }
+        ::close(f.fd);
+    }
+    d_files.erase(it);
+}
+
+void batch_writer::write_out(file_state& f, bool all)
+{
+    size_t n = all ? f.staged.size() : f.staged.size() / d_chunk_bytes * d_chunk_bytes;
+    if (n == 0) {
+        return;
+    }
+    if (f.fd < 0) {
+        f.staged.clear();
+        return;
+    }
+
+    size_t done = 0;
+    while (done < n) {
+        ssize_t rc = ::write(f.fd, f.staged.data() + done, n - done);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            d_write_errors++;
+            break;
+        }
+        done += static_cast<size_t>(rc);
+    }
+    d_bytes_written += done;
+    // A failed write drops the rest of this chunk rather than retrying forever.
+    f.staged.erase(f.staged.begin(), f.staged.begin() + n);
+    f.staged_since = std::chrono::steady_clock::now();
+}
+
+} // namespace gr_opus
+} // namespace gr
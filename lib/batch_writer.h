@@ -0,0 +1,100 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_BATCH_WRITER_H
+#define INCLUDED_GR_OPUS_BATCH_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Owns all file I/O for a set of output files on one background thread.
+ * Callers only queue operations, so they never wait on the disk. Data is
+ * staged per file and written in multiples of chunk_bytes; a partial tail
+ * goes out once it is older than a second, or when the file is closed.
+ * Closing with sync runs fdatasync on the writer thread, one file at a time.
+ */
+class batch_writer
+{
+public:
+    explicit batch_writer(size_t max_queued_bytes, size_t chunk_bytes = 64 * 1024);
+    // Drains everything queued, then closes any file still open.
+    ~batch_writer();
+
+    // Returns a handle at once; the file is created (truncated) on the writer thread.
+    int open(const std::string& path);
+    // False, without queuing, when max_queued_bytes are already waiting.
+    bool write(int handle, std::vector<unsigned char> data);
+    void close(int handle, bool sync);
+
+    size_t queued_bytes() const;
+    uint64_t bytes_written() const { return d_bytes_written.load(std::memory_order_relaxed); }
+    uint64_t write_errors() const { return d_write_errors.load(std::memory_order_relaxed); }
+
+private:
+    struct op {
+        enum kind_t { OPEN, WRITE, CLOSE } kind;
+        int handle;
+        std::string path;
+        std::vector<unsigned char> data;
+        bool sync;
+    };
+
+    struct file_state {
+        int fd;
+        std::vector<unsigned char> staged;
+        std::chrono::steady_clock::time_point staged_since;
+    };
+
+    void run();
+    void apply(op& o);
+    void write_out(file_state& f, bool all);
+
+    const size_t d_max_queued_bytes;
+    const size_t d_chunk_bytes;
+
+    mutable std::mutex d_mutex;
+    std::condition_variable d_cv;
+    std::deque<op> d_ops;
+    size_t d_queued_bytes;
+    bool d_shutdown;
+
+    std::map<int, file_state> d_files; // writer thread only
+    std::atomic<int> d_next_handle;
+    std::atomic<uint64_t> d_bytes_written;
+    std::atomic<uint64_t> d_write_errors;
+    std::thread d_thread;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_BATCH_WRITER_H */
@@ -0,0 +1,154 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "channel_model.h"
+#include <cmath>
+
+namespace gr {
+namespace gr_opus {
+
+channel_model::channel_model(uint64_t seed)
+    : d_rng(seed),
+      d_bad_state(false),
+      d_lost_run(0),
+      d_holding(false),
+      d_held_lost(0),
+      d_packets_in(0),
+      d_packets_delivered(0),
+      d_packets_lost(0),
+      d_packets_late(0),
+      d_packets_reordered(0),
+      d_packets_duplicated(0),
+      d_bits_flipped(0)
+{
+}
+
+double channel_model::uniform()
+{
+    // splitmix64: the same sequence on every platform and standard library,
+    // unlike the <random> distributions.
+    uint64_t z = (d_rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void channel_model::flip_bits(unsigned char* data, size_t len, double ber)
+{
+    if (ber <= 0.0) {
+        return;
+    }
+    // Jump straight from one error to the next (geometric gaps).
+    const size_t bits = len * 8;
+    const double log_keep = ber < 1.0 ? std::log1p(-ber) : 0.0;
+    size_t bit = 0;
+    for (;;) {
+        if (ber < 1.0) {
+            double gap = std::floor(std::log1p(-uniform()) / log_keep);
+            if (gap >= static_cast<double>(bits - bit)) {
+                return;
+            }
+            bit += static_cast<size_t>(gap);
+        }
+        if (bit >= bits) {
+            return;
+        }
+        data[bit / 8] ^= static_cast<unsigned char>(1u << (bit % 8));
+        d_bits_flipped++;
+        bit++;
+    }
+}
+
+void channel_model::deliver_packet(const deliver_t& deliver, const unsigned char* packet, size_t len, long lost)
+{
+    d_packets_delivered++;
+    deliver(packet, len, lost);
+}
+
+void channel_model::on_packet(const params& p, const unsigned char* packet, int len, const deliver_t& deliver)
+{
+    d_packets_in++;
+
+    if (d_bad_state) {
+        d_bad_state = uniform() >= p.p_bad_to_good;
+    } else {
+        d_bad_state = uniform() < p.p_good_to_bad;
+    }
+    if (uniform() < (d_bad_state ? p.loss_bad : p.loss_good)) {
+        d_packets_lost++;
+        d_lost_run++;
+        return;
+    }
+    if (p.jitter_ms > 0.0) {
+        double delay_ms = -p.jitter_ms * std::log1p(-uniform());
+        if (delay_ms > p.playout_delay_ms) {
+            d_packets_late++;
+            d_packets_lost++;
+            d_lost_run++;
+            return;
+        }
+    }
+
+    d_scratch.assign(packet, packet + len);
+    flip_bits(d_scratch.data(), d_scratch.size(), p.ber);
+    long lost = d_lost_run;
+    d_lost_run = 0;
+
+    if (!d_holding && p.reorder > 0.0 && uniform() < p.reorder) {
+        d_held.swap(d_scratch);
+        d_held_lost = lost;
+        d_holding = true;
+        return;
+    }
+    bool duplicate = p.duplicate > 0.0 && uniform() < p.duplicate;
+    if (d_holding) {
+        // Losses ahead of the held packet are reported ahead of the
+        // successor that overtakes it.
+        lost += d_held_lost;
+    }
+    deliver_packet(deliver, d_scratch.data(), d_scratch.size(), lost);
+    if (duplicate) {
+        deliver_packet(deliver, d_scratch.data(), d_scratch.size(), 0);
+        d_packets_duplicated++;
+    }
+    if (d_holding) {
+        deliver_packet(deliver, d_held.data(), d_held.size(), 0);
+        d_holding = false;
+        d_packets_reordered++;
+    }
+}
+
+void channel_model::flush(const deliver_t& deliver)
+{
+    if (!d_holding) {
+        return;
+    }
+    // Nothing is left to overtake it, so it goes out in order.
+    d_holding = false;
+    deliver_packet(deliver, d_held.data(), d_held.size(), d_held_lost);
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,102 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_CHANNEL_MODEL_H
+#define INCLUDED_GR_OPUS_CHANNEL_MODEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Packet channel behind opus_channel_sim: Gilbert-Elliott burst loss,
+ * exponential jitter against a playout deadline, single-step reordering,
+ * duplication and bit errors. Every draw comes from one splitmix64
+ * generator, so a seed gives the same channel on every platform.
+ */
+class channel_model
+{
+public:
+    struct params {
+        double p_good_to_bad;
+        double p_bad_to_good;
+        double loss_good;
+        double loss_bad;
+        double jitter_ms;
+        double playout_delay_ms;
+        double reorder;
+        double duplicate;
+        double ber;
+    };
+
+    // Called for each delivered packet, in delivery order, with the number
+    // of packets lost since the previous delivery.
+    typedef std::function<void(const unsigned char* packet, size_t len, long lost)> deliver_t;
+
+    explicit channel_model(uint64_t seed);
+
+    // A perfect channel.
+    static params clean() { return { 0.0, 1.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 0.0 }; }
+
+    void on_packet(const params& p, const unsigned char* packet, int len, const deliver_t& deliver);
+    // At end of stream: delivers a packet still waiting to be overtaken.
+    void flush(const deliver_t& deliver);
+    bool holding() const { return d_holding; }
+
+    // Uniform on [0, 1).
+    double uniform();
+
+    long packets_in() const { return d_packets_in.load(); }
+    long packets_delivered() const { return d_packets_delivered.load(); }
+    long packets_lost() const { return d_packets_lost.load(); }
+    long packets_late() const { return d_packets_late.load(); }
+    long packets_reordered() const { return d_packets_reordered.load(); }
+    long packets_duplicated() const { return d_packets_duplicated.load(); }
+    long bits_flipped() const { return d_bits_flipped.load(); }
+
+private:
+    void flip_bits(unsigned char* data, size_t len, double ber);
+    void deliver_packet(const deliver_t& deliver, const unsigned char* packet, size_t len, long lost);
+
+    uint64_t d_rng;
+    bool d_bad_state;
+    long d_lost_run;
+    std::vector<unsigned char> d_scratch;
+    std::vector<unsigned char> d_held; // packet delayed behind its successor
+    bool d_holding;
+    long d_held_lost;
+
+    std::atomic<long> d_packets_in;
+    std::atomic<long> d_packets_delivered;
+    std::atomic<long> d_packets_lost;
+    std::atomic<long> d_packets_late;
+    std::atomic<long> d_packets_reordered;
+    std::atomic<long> d_packets_duplicated;
+    std::atomic<long> d_bits_flipped;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_CHANNEL_MODEL_H */
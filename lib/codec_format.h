@@ -0,0 +1,107 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_CODEC_FORMAT_H
+#define INCLUDED_GR_OPUS_CODEC_FORMAT_H
+
+#include <opus/opus.h>
+#include <pmt/pmt.h>
+#include <stdexcept>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+inline bool valid_opus_format(int sample_rate, int channels)
+{
+    return (sample_rate == 8000 || sample_rate == 12000 || sample_rate == 16000 ||
+            sample_rate == 24000 || sample_rate == 48000) &&
+           (channels == 1 || channels == 2);
+}
+
+inline void check_opus_format(int sample_rate, int channels)
+{
+    if (!valid_opus_format(sample_rate, channels)) {
+        throw std::runtime_error("Unsupported Opus format: " + std::to_string(sample_rate) + " Hz, " +
+                                 std::to_string(channels) + " channel(s)");
+    }
+}
+
+// Opus Custom limits (celt/modes.c): 8..96 kHz, even frames of 40..1024
+// samples lasting at least 1 ms.
+inline bool valid_custom_format(int sample_rate, int channels, int frame_size)
+{
+    return sample_rate >= 8000 && sample_rate <= 96000 && (channels == 1 || channels == 2) &&
+           frame_size >= 40 && frame_size <= 1024 && frame_size % 2 == 0 &&
+           static_cast<long>(frame_size) * 1000 >= sample_rate;
+}
+
+inline void check_custom_format(int sample_rate, int channels, int frame_size)
+{
+    if (!valid_custom_format(sample_rate, channels, frame_size)) {
+        throw std::runtime_error("Unsupported Opus Custom format: " + std::to_string(sample_rate) + " Hz, " +
+                                 std::to_string(channels) + " channel(s), " + std::to_string(frame_size) +
+                                 "-sample frames");
+    }
+}
+
+// "voip", "audio" or "lowdelay"; throws on anything else.
+inline int opus_application_from_string(const std::string& application)
+{
+    if (application == "voip") {
+        return OPUS_APPLICATION_VOIP;
+    } else if (application == "audio") {
+        return OPUS_APPLICATION_AUDIO;
+    } else if (application == "lowdelay") {
+        return OPUS_APPLICATION_RESTRICTED_LOWDELAY;
+    }
+    throw std::runtime_error("Unknown Opus application: " + application);
+}
+
+// Reads a {sample_rate, channels} dict from the "reconfig" port. Missing
+// keys keep the current value; returns false if the message is not a dict.
+inline bool parse_format_msg(const pmt::pmt_t& msg, int& sample_rate, int& channels)
+{
+    if (!pmt::is_dict(msg)) {
+        return false;
+    }
+    pmt::pmt_t rate = pmt::dict_ref(msg, pmt::mp("sample_rate"), pmt::PMT_NIL);
+    pmt::pmt_t chans = pmt::dict_ref(msg, pmt::mp("channels"), pmt::PMT_NIL);
+    if (pmt::is_integer(rate)) {
+        sample_rate = static_cast<int>(pmt::to_long(rate));
+    }
+    if (pmt::is_integer(chans)) {
+        channels = static_cast<int>(pmt::to_long(chans));
+    }
+    return true;
+}
+
+inline pmt::pmt_t format_tag_value(int sample_rate, int channels)
+{
+    pmt::pmt_t dict = pmt::make_dict();
+    dict = pmt::dict_add(dict, pmt::mp("sample_rate"), pmt::from_long(sample_rate));
+    dict = pmt::dict_add(dict, pmt::mp("channels"), pmt::from_long(channels));
+    return dict;
+}
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_CODEC_FORMAT_H */
@@ -0,0 +1,502 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/gr_opus/codec_sweep.h>
+#include "codec_format.h"
+#include "codec_thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <opus/opus.h>
+#include <sstream>
+#include <stdexcept>
+#include <time.h>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+const double pi = 3.14159265358979323846;
+
+// Analysis frame for the quality metrics, independent of the codec frame.
+const double analysis_ms = 20.0;
+const int analysis_bands = 24;
+// Largest Opus frame; a packet carries one per 20 ms of audio.
+const int max_frame_bytes = 1275;
+// Loss rate the encoder is told to expect when DRED is on. libopus sizes
+// the DRED payload from it and sends none at the default of 0 %.
+const int dred_loss_percent = 20;
+
+struct corpus_signal {
+    std::string name;
+    std::vector<float> pcm;
+};
+
+class splitmix {
+public:
+    explicit splitmix(uint64_t seed) : d_state(seed) {}
+    double uniform()
+    {
+        uint64_t z = (d_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        return static_cast<double>(z >> 11) * (1.0 / 9007199254740992.0);
+    }
+    double noise() { return 2.0 * uniform() - 1.0; }
+
+private:
+    uint64_t d_state;
+};
+
+// Voiced harmonics on a moving pitch shaped by three moving formants, a
+// syllable-rate envelope, fricative noise between syllables and a pause
+// every three seconds.
+std::vector<float> speech_like(int rate, size_t samples)
+{
+    std::vector<float> pcm(samples);
+    splitmix rng(1);
+    const double nyquist = std::min(0.45 * rate, 8000.0);
+    double phase = 0.0;
+    double fricative = 0.0;
+    for (size_t n = 0; n < samples; ++n) {
+        const double t = static_cast<double>(n) / rate;
+        const double f0 = 120.0 + 60.0 * std::sin(2 * pi * 0.5 * t) + 20.0 * std::sin(2 * pi * 2.3 * t);
+        phase += 2 * pi * f0 / rate;
+        const double formants[3] = { 500.0 + 200.0 * std::sin(2 * pi * 1.1 * t),
+                                     1500.0 + 600.0 * std::sin(2 * pi * 0.8 * t + 1.0),
+                                     2500.0 + 300.0 * std::sin(2 * pi * 0.4 * t) };
+        double voiced = 0.0;
+        for (int k = 1; k * f0 < nyquist; ++k) {
+            double gain = 0.02;
+            for (double f : formants) {
+                double d = (k * f0 - f) / 150.0;
+                gain += std::exp(-d * d);
+            }
+            voiced += gain / k * std::sin(k * phase);
+        }
+        const double syllable = std::sin(2 * pi * 3.7 * t + 0.5 * std::sin(2 * pi * 0.3 * t));
+        const double envelope = std::pow(std::max(0.0, syllable), 0.6);
+        // First difference of white noise: a crude high-passed hiss.
+        double noise = rng.noise();
+        double hiss = noise - fricative;
+        fricative = noise;
+        double unvoiced = syllable < -0.6 ? 0.15 * hiss : 0.0;
+        double pause = std::fmod(t, 3.0) > 2.6 ? 0.0 : 1.0;
+        pcm[n] = static_cast<float>(pause * (0.12 * envelope * voiced + unvoiced));
+    }
+    return pcm;
+}
+
+// A four-chord progression with a bass line, note attacks and a noise
+// hi-hat on every beat.
+std::vector<float> music_like(int rate, size_t samples)
+{
+    static const double chords[4][3] = {
+        { 261.63, 329.63, 392.00 }, { 220.00, 261.63, 329.63 },
+        { 174.61, 220.00, 261.63 }, { 196.00, 246.94, 293.66 },
+    };
+    std::vector<float> pcm(samples);
+    splitmix rng(2);
+    const double nyquist = 0.45 * rate;
+    const double beat = 0.25;
+    for (size_t n = 0; n < samples; ++n) {
+        const double t = static_cast<double>(n) / rate;
+        const int chord = static_cast<int>(t / 2.0) % 4;
+        const double since_chord = std::fmod(t, 2.0);
+        const double since_beat = std::fmod(t, beat);
+        double tone = 0.0;
+        for (double f : chords[chord]) {
+            for (int k = 1; k <= 8 && k * f < nyquist; ++k) {
+                tone += std::pow(k, -1.2) * std::sin(2 * pi * k * f * t);
+            }
+        }
+        tone *= 0.6 + 0.4 * std::exp(-since_chord * 3.0);
+        const double bass_f = chords[chord][0] / 2.0;
+        double bass = std::sin(2 * pi * bass_f * t) + 0.3 * std::sin(4 * pi * bass_f * t);
+        bass *= std::exp(-since_beat * 6.0);
+        double hat = rng.noise() * std::exp(-since_beat / 0.03);
+        pcm[n] = static_cast<float>(0.06 * tone + 0.15 * bass + 0.05 * hat);
+    }
+    return pcm;
+}
+
+void fft(std::vector<std::complex<double>>& x)
+{
+    const size_t n = x.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(x[i], x[j]);
+        }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const std::complex<double> step = std::polar(1.0, -2 * pi / len);
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<double> w(1.0);
+            for (size_t k = 0; k < len / 2; ++k) {
+                std::complex<double> u = x[i + k];
+                std::complex<double> v = x[i + k + len / 2] * w;
+                x[i + k] = u + v;
+                x[i + k + len / 2] = u - v;
+                w *= step;
+            }
+        }
+    }
+}
+
+// Log-spectral distance over log-spaced bands and segmental SNR, averaged
+// over analysis frames where the reference is not silent.
+void quality(const float* ref, const float* test, size_t samples, int rate, double& lsd_db, double& seg_snr_db)
+{
+    const size_t frame = static_cast<size_t>(rate * analysis_ms / 1000.0);
+    size_t nfft = 1;
+    while (nfft < frame) {
+        nfft <<= 1;
+    }
+    std::vector<size_t> edges(analysis_bands + 1);
+    const double lo = 100.0, hi = std::min(20000.0, 0.5 * rate);
+    for (int b = 0; b <= analysis_bands; ++b) {
+        double f = lo * std::pow(hi / lo, static_cast<double>(b) / analysis_bands);
+        edges[b] = std::min(nfft / 2, static_cast<size_t>(f * nfft / rate));
+    }
+    std::vector<double> window(frame);
+    for (size_t i = 0; i < frame; ++i) {
+        window[i] = 0.5 - 0.5 * std::cos(2 * pi * (i + 0.5) / frame);
+    }
+
+    std::vector<std::complex<double>> a(nfft), b(nfft);
+    double lsd_sum = 0.0, snr_sum = 0.0;
+    size_t active = 0;
+    for (size_t start = 0; start + frame <= samples; start += frame) {
+        double energy = 0.0, error = 0.0;
+        for (size_t i = 0; i < frame; ++i) {
+            double r = ref[start + i], d = test[start + i];
+            energy += r * r;
+            error += (r - d) * (r - d);
+        }
+        if (energy < 1e-5 * frame) {
+            continue;
+        }
+        std::fill(a.begin(), a.end(), 0.0);
+        std::fill(b.begin(), b.end(), 0.0);
+        for (size_t i = 0; i < frame; ++i) {
+            a[i] = ref[start + i] * window[i];
+            b[i] = test[start + i] * window[i];
+        }
+        fft(a);
+        fft(b);
+        double sum = 0.0;
+        int bands = 0;
+        for (int band = 0; band < analysis_bands; ++band) {
+            if (edges[band + 1] <= edges[band]) {
+                continue;
+            }
+            double ea = 1e-9, eb = 1e-9;
+            for (size_t k = edges[band]; k < edges[band + 1]; ++k) {
+                ea += std::norm(a[k]);
+                eb += std::norm(b[k]);
+            }
+            double d = 10.0 * std::log10(ea / eb);
+            sum += d * d;
+            bands++;
+        }
+        lsd_sum += bands > 0 ? std::sqrt(sum / bands) : 0.0;
+        snr_sum += std::max(-10.0, std::min(35.0, 10.0 * std::log10(energy / std::max(error, 1e-12))));
+        active++;
+    }
+    lsd_db = active > 0 ? lsd_sum / active : 0.0;
+    seg_snr_db = active > 0 ? snr_sum / active : 0.0;
+}
+
+uint64_t thread_cpu_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void measure(codec_sweep::point& p, const std::vector<float>& input, int rate)
+{
+    const int frame_size = static_cast<int>(std::lround(rate * p.frame_ms / 1000.0));
+    const size_t frames = input.size() / frame_size;
+
+    int error = OPUS_OK;
+    std::unique_ptr<OpusEncoder, void (*)(OpusEncoder*)> enc(
+        opus_encoder_create(rate, 1, opus_application_from_string(p.application), &error), opus_encoder_destroy);
+    if (error != OPUS_OK || !enc) {
+        throw std::runtime_error("Failed to create Opus encoder: " + std::string(opus_strerror(error)));
+    }
+    opus_encoder_ctl(enc.get(), OPUS_SET_BITRATE(p.bitrate));
+    opus_encoder_ctl(enc.get(), OPUS_SET_COMPLEXITY(p.complexity));
+#ifdef OPUS_HAVE_DRED
+    if (p.dred_frames > 0) {
+        error = opus_encoder_ctl(enc.get(), OPUS_SET_DRED_DURATION(p.dred_frames));
+        if (error != OPUS_OK) {
+            throw std::runtime_error("Failed to set Opus DRED duration: " + std::string(opus_strerror(error)));
+        }
+        opus_encoder_ctl(enc.get(), OPUS_SET_PACKET_LOSS_PERC(dred_loss_percent));
+    }
+#endif
+    opus_int32 lookahead = 0;
+    opus_encoder_ctl(enc.get(), OPUS_GET_LOOKAHEAD(&lookahead));
+
+    std::unique_ptr<OpusDecoder, void (*)(OpusDecoder*)> dec(opus_decoder_create(rate, 1, &error), opus_decoder_destroy);
+    if (error != OPUS_OK || !dec) {
+        throw std::runtime_error("Failed to create Opus decoder: " + std::string(opus_strerror(error)));
+    }
+
+    // Packets are stored back to back; only the scratch buffer is sized for
+    // the worst case.
+    const int max_packet_bytes = max_frame_bytes * std::max(1, static_cast<int>(std::ceil(p.frame_ms / 20.0)));
+    std::vector<unsigned char> scratch(max_packet_bytes);
+    std::vector<unsigned char> packets;
+    packets.reserve(frames * static_cast<size_t>(p.bitrate / 8.0 * p.frame_ms / 1000.0 * 1.5));
+    std::vector<size_t> offsets(frames);
+    std::vector<int> lengths(frames);
+    uint64_t start = thread_cpu_ns();
+    for (size_t f = 0; f < frames; ++f) {
+        lengths[f] = opus_encode_float(enc.get(), input.data() + f * frame_size, frame_size, scratch.data(),
+                                       max_packet_bytes);
+        if (lengths[f] < 0) {
+            throw std::runtime_error("Opus encode failed: " + std::string(opus_strerror(lengths[f])));
+        }
+        offsets[f] = packets.size();
+        packets.insert(packets.end(), scratch.begin(), scratch.begin() + lengths[f]);
+    }
+    uint64_t encode_ns = thread_cpu_ns() - start;
+
+    std::vector<float> output(frames * frame_size);
+    start = thread_cpu_ns();
+    for (size_t f = 0; f < frames; ++f) {
+        int samples = opus_decode_float(dec.get(), packets.data() + offsets[f], lengths[f],
+                                        output.data() + f * frame_size, frame_size, 0);
+        if (samples < 0) {
+            throw std::runtime_error("Opus decode failed: " + std::string(opus_strerror(samples)));
+        }
+    }
+    uint64_t decode_ns = thread_cpu_ns() - start;
+
+    double bytes = 0.0;
+    for (int len : lengths) {
+        bytes += len;
+    }
+    p.encode_ns = frames > 0 ? static_cast<double>(encode_ns) / frames : 0.0;
+    p.decode_ns = frames > 0 ? static_cast<double>(decode_ns) / frames : 0.0;
+    p.packet_bytes = frames > 0 ? bytes / frames : 0.0;
+
+    // The decoded stream lags the input by the encoder lookahead.
+    size_t compared = output.size() > static_cast<size_t>(lookahead) ? output.size() - lookahead : 0;
+    quality(input.data(), output.data() + lookahead, compared, rate, p.lsd_db, p.seg_snr_db);
+}
+
+void mark_pareto(std::vector<codec_sweep::point>& points)
+{
+    for (codec_sweep::point& p : points) {
+        const double cost = p.encode_ns + p.decode_ns;
+        p.pareto = true;
+        for (const codec_sweep::point& q : points) {
+            if (&q == &p || q.signal != p.signal) {
+                continue;
+            }
+            const double q_cost = q.encode_ns + q.decode_ns;
+            if (q_cost <= cost && q.lsd_db <= p.lsd_db && (q_cost < cost || q.lsd_db < p.lsd_db)) {
+                p.pareto = false;
+                break;
+            }
+        }
+    }
+}
+
+} // namespace
+
+codec_sweep::codec_sweep(int sample_rate, double seconds)
+    : d_sample_rate(sample_rate),
+      d_seconds(seconds),
+      d_bitrates{ 24000 },
+      d_complexities{ 10 },
+      d_frame_ms{ 20.0 },
+      d_applications{ "audio" },
+      d_dred_frames{ 0 }
+{
+    check_opus_format(sample_rate, 1);
+    if (!(seconds >= 0.5 && seconds <= 600.0)) {
+        throw std::runtime_error("Sweep corpus length must be 0.5-600 s");
+    }
+}
+
+void codec_sweep::set_bitrates(const std::vector<int>& bitrates)
+{
+    for (int bitrate : bitrates) {
+        if (bitrate < 6000 || bitrate > 510000) {
+            throw std::runtime_error("Bitrate must be 6000-510000 b/s: " + std::to_string(bitrate));
+        }
+    }
+    if (bitrates.empty()) {
+        throw std::runtime_error("Sweep needs at least one bitrate");
+    }
+    d_bitrates = bitrates;
+}
+
+void codec_sweep::set_complexities(const std::vector<int>& complexities)
+{
+    for (int complexity : complexities) {
+        if (complexity < 0 || complexity > 10) {
+            throw std::runtime_error("Complexity must be 0-10: " + std::to_string(complexity));
+        }
+    }
+    if (complexities.empty()) {
+        throw std::runtime_error("Sweep needs at least one complexity");
+    }
+    d_complexities = complexities;
+}
+
+void codec_sweep::set_frame_durations(const std::vector<double>& frame_ms)
+{
+    static const double valid[] = { 2.5, 5.0, 10.0, 20.0, 40.0, 60.0, 80.0, 100.0, 120.0 };
+    for (double ms : frame_ms) {
+        if (std::find(std::begin(valid), std::end(valid), ms) == std::end(valid)) {
+            throw std::runtime_error("Unsupported Opus frame duration: " + std::to_string(ms) + " ms");
+        }
+    }
+    if (frame_ms.empty()) {
+        throw std::runtime_error("Sweep needs at least one frame duration");
+    }
+    d_frame_ms = frame_ms;
+}
+
+void codec_sweep::set_applications(const std::vector<std::string>& applications)
+{
+    for (const std::string& application : applications) {
+        opus_application_from_string(application);
+    }
+    if (applications.empty()) {
+        throw std::runtime_error("Sweep needs at least one application");
+    }
+    d_applications = applications;
+}
+
+void codec_sweep::set_dred_frames(const std::vector<int>& dred_frames)
+{
+    for (int frames : dred_frames) {
+        if (frames < 0 || frames > 100) {
+            throw std::runtime_error("DRED duration must be 0-100 (10 ms units): " + std::to_string(frames));
+        }
+#ifndef OPUS_HAVE_DRED
+        if (frames > 0) {
+            throw std::runtime_error("libopus was built without DRED");
+        }
+#endif
+    }
+    if (dred_frames.empty()) {
+        throw std::runtime_error("Sweep needs at least one DRED setting");
+    }
+    d_dred_frames = dred_frames;
+}
+
+size_t codec_sweep::num_configs() const
+{
+    return d_bitrates.size() * d_complexities.size() * d_frame_ms.size() * d_applications.size() *
+           d_dred_frames.size();
+}
+
+std::vector<codec_sweep::point> codec_sweep::run() const
+{
+    const size_t samples = static_cast<size_t>(d_seconds * d_sample_rate);
+    std::vector<corpus_signal> corpus;
+    corpus.push_back({ "speech", speech_like(d_sample_rate, samples) });
+    corpus.push_back({ "music", music_like(d_sample_rate, samples) });
+
+    std::vector<point> points;
+    points.reserve(corpus.size() * num_configs());
+    for (size_t s = 0; s < corpus.size(); ++s) {
+        for (const std::string& application : d_applications) {
+            for (double frame_ms : d_frame_ms) {
+                for (int bitrate : d_bitrates) {
+                    for (int complexity : d_complexities) {
+                        for (int dred : d_dred_frames) {
+                            points.push_back({ corpus[s].name, bitrate, complexity, frame_ms, application, dred,
+                                               0.0, 0.0, 0.0, 0.0, 0.0, false });
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // One strand per point, so every pool worker stays busy; each job only
+    // touches its own point.
+    const size_t per_signal = num_configs();
+    std::vector<std::shared_ptr<codec_strand>> strands;
+    std::vector<std::exception_ptr> errors(points.size());
+    strands.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        const std::vector<float>& input = corpus[i / per_signal].pcm;
+        std::shared_ptr<codec_strand> strand = codec_thread_pool::instance().make_strand(1);
+        strand->try_submit([&points, &errors, &input, i, this] {
+            try {
+                measure(points[i], input, d_sample_rate);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+        strands.push_back(strand);
+    }
+    for (auto& strand : strands) {
+        strand->wait_idle();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    mark_pareto(points);
+    return points;
+}
+
+std::string codec_sweep::to_csv(const std::vector<point>& points)
+{
+    std::ostringstream out;
+    out << "signal,application,frame_ms,bitrate,complexity,dred_frames,"
+           "encode_ns,decode_ns,packet_bytes,lsd_db,seg_snr_db,pareto\n";
+    for (const point& p : points) {
+        out << p.signal << ',' << p.application << ',' << p.frame_ms << ',' << p.bitrate << ',' << p.complexity
+            << ',' << p.dred_frames << ',' << static_cast<long>(p.encode_ns) << ','
+            << static_cast<long>(p.decode_ns) << ',' << p.packet_bytes << ',' << p.lsd_db << ','
+            << p.seg_snr_db << ',' << (p.pareto ? 1 : 0) << '\n';
+    }
+    return out.str();
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,437 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "codec_thread_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// Jobs a worker runs from one strand before moving it to the back of its
+// queue, so a busy block cannot starve the others on the same worker.
+const size_t strand_batch_jobs = 4;
+
+std::vector<int> parse_cpulist(const std::string& list)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::atoi(range.substr(0, dash).c_str());
+        int last = (dash == std::string::npos) ? first : std::atoi(range.substr(dash + 1).c_str());
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> allowed_cpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        unsigned int n = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int cpu = 0; cpu < n; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+// Maps every CPU to its NUMA node id; CPUs without sysfs topology land on node 0.
+std::map<int, int> read_cpu_nodes()
+{
+    std::map<int, int> cpu_node;
+    for (int node = 0; node < 1024; ++node) {
+        std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!f) {
+            if (node > 0 && cpu_node.empty()) {
+                break;
+            }
+            continue;
+        }
+        std::string list;
+        std::getline(f, list);
+        for (int cpu : parse_cpulist(list)) {
+            cpu_node[cpu] = node;
+        }
+    }
+    return cpu_node;
+}
+
+} // namespace
+
+codec_strand::codec_strand(codec_thread_pool& pool, size_t max_depth, int home_node)
+    : d_pool(pool),
+      d_max_depth(std::max<size_t>(1, max_depth)),
+      d_home_node(home_node),
+      d_pending(0),
+      d_scheduled(false)
+{
+}
+
+codec_strand::~codec_strand() {}
+
+bool codec_strand::try_submit(job_t job)
+{
+    bool need_schedule;
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        if (d_pending >= d_max_depth) {
+            return false;
+        }
+        d_jobs.push_back(std::move(job));
+        d_pending++;
+        need_schedule = !d_scheduled;
+        d_scheduled = true;
+    }
+    if (need_schedule) {
+        d_pool.schedule(shared_from_this(), d_pool.d_next_worker.fetch_add(1, std::memory_order_relaxed));
+    }
+    return true;
+}
+
+void codec_strand::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    d_idle_cv.wait(lock, [this] { return d_pending == 0 && !d_scheduled; });
+}
+
+size_t codec_strand::pending() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return d_pending;
+}
+
+bool codec_strand::run_batch(size_t max_jobs)
+{
+    for (size_t n = 0; n < max_jobs; ++n) {
+        job_t job;
+        {
+            std::lock_guard<std::mutex> lock(d_mutex);
+            if (d_jobs.empty()) {
+                d_scheduled = false;
+                d_idle_cv.notify_all();
+                return false;
+            }
+            job = std::move(d_jobs.front());
+            d_jobs.pop_front();
+        }
+        try {
+            job();
+        } catch (...) {
+            d_pool.d_jobs_failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        d_pool.d_jobs_executed.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_pending--;
+    }
+
+    std::lock_guard<std::mutex> lock(d_mutex);
+    if (d_jobs.empty()) {
+        d_scheduled = false;
+        d_idle_cv.notify_all();
+        return false;
+    }
+    return true;
+}
+
+codec_thread_pool& codec_thread_pool::instance()
+{
+    // Intentionally leaked: blocks held by Python may outlive static
+    // destruction, and their strands must still find a live pool.
+    static codec_thread_pool* pool = new codec_thread_pool();
+    return *pool;
+}
+
+codec_thread_pool::codec_thread_pool()
+    : d_queued(0), d_next_worker(0), d_jobs_executed(0), d_steals(0), d_jobs_failed(0), d_shutdown(false), d_rt_priority(0), d_rt_workers(0)
+{
+    std::vector<int> cpus = allowed_cpus();
+    std::map<int, int> cpu_node = read_cpu_nodes();
+
+    // Compact the node ids that actually have CPUs in our affinity mask.
+    std::map<int, std::vector<int>> node_cpus;
+    for (int cpu : cpus) {
+        auto it = cpu_node.find(cpu);
+        node_cpus[it == cpu_node.end() ? 0 : it->second].push_back(cpu);
+    }
+
+    size_t max_threads = cpus.size();
+    const char* env = std::getenv("GR_OPUS_POOL_THREADS");
+    if (env != nullptr && std::atoi(env) > 0) {
+        max_threads = static_cast<size_t>(std::atoi(env));
+    }
+
+    int max_cpu = *std::max_element(cpus.begin(), cpus.end());
+    d_cpu_node.assign(max_cpu + 1, 0);
+    d_node_workers.resize(node_cpus.size());
+
+    int node_index = 0;
+    std::vector<std::pair<int, std::vector<int>>> nodes;
+    for (auto& entry : node_cpus) {
+        for (int cpu : entry.second) {
+            d_cpu_node[cpu] = node_index;
+        }
+        nodes.emplace_back(node_index++, entry.second);
+    }
+
+    // Hand out workers round-robin over nodes so a thread cap still spreads
+    // the pool across every node.
+    std::vector<size_t> used(nodes.size(), 0);
+    while (d_workers.size() < max_threads) {
+        bool added = false;
+        for (size_t n = 0; n < nodes.size() && d_workers.size() < max_threads; ++n) {
+            if (used[n] >= nodes[n].second.size() && max_threads <= cpus.size()) {
+                continue;
+            }
+            std::unique_ptr<worker> w(new worker());
+            w->node = nodes[n].first;
+            w->cpus = nodes[n].second;
+            d_node_workers[n].push_back(d_workers.size());
+            d_workers.push_back(std::move(w));
+            used[n]++;
+            added = true;
+        }
+        if (!added) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < d_workers.size(); ++i) {
+        d_workers[i]->thread = std::thread(&codec_thread_pool::worker_loop, this, i);
+#ifdef __linux__
+        pthread_t handle = d_workers[i]->thread.native_handle();
+        pthread_setname_np(handle, "gr_opus_codec");
+        if (d_node_workers.size() > 1) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : d_workers[i]->cpus) {
+                CPU_SET(cpu, &set);
+            }
+            pthread_setaffinity_np(handle, sizeof(set), &set);
+        }
+#endif
+    }
+}
+
+codec_thread_pool::~codec_thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(d_sleep_mutex);
+        d_shutdown = true;
+    }
+    d_sleep_cv.notify_all();
+    for (auto& w : d_workers) {
+        if (w->thread.joinable()) {
+            w->thread.join();
+        }
+    }
+}
+
+int codec_thread_pool::current_node() const
+{
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if (cpu >= 0 && static_cast<size_t>(cpu) < d_cpu_node.size()) {
+        return d_cpu_node[cpu];
+    }
+#endif
+    return 0;
+}
+
+size_t codec_thread_pool::set_realtime(int priority)
+{
+    std::lock_guard<std::mutex> lock(d_rt_mutex);
+    d_rt_requests.insert(priority);
+    if (priority > d_rt_priority.load()) {
+        apply_realtime(priority);
+    }
+    return d_rt_workers;
+}
+
+void codec_thread_pool::release_realtime(int priority)
+{
+    std::lock_guard<std::mutex> lock(d_rt_mutex);
+    auto it = d_rt_requests.find(priority);
+    if (it == d_rt_requests.end()) {
+        return;
+    }
+    d_rt_requests.erase(it);
+    const int highest = d_rt_requests.empty() ? 0 : *d_rt_requests.rbegin();
+    if (highest < d_rt_priority.load()) {
+        apply_realtime(highest);
+    }
+}
+
+// Caller holds d_rt_mutex. Priority 0 undoes real-time mode. A worker is
+// pinned only once it runs under SCHED_FIFO; one the system refuses is left
+// as it was.
+void codec_thread_pool::apply_realtime(int priority)
+{
+#ifdef __linux__
+    size_t applied = 0;
+    for (const std::vector<size_t>& node : d_node_workers) {
+        for (size_t i = 0; i < node.size(); ++i) {
+            worker& w = *d_workers[node[i]];
+            pthread_t handle = w.thread.native_handle();
+            sched_param param;
+            param.sched_priority = priority;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (priority > 0) {
+                if (pthread_setschedparam(handle, SCHED_FIFO, &param) != 0) {
+                    continue;
+                }
+                CPU_SET(w.cpus[i % w.cpus.size()], &set);
+                applied++;
+            } else {
+                pthread_setschedparam(handle, SCHED_OTHER, &param);
+                for (int cpu : w.cpus) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            pthread_setaffinity_np(handle, sizeof(set), &set);
+        }
+    }
+    if (priority > 0 && applied == 0) {
+        return;
+    }
+    d_rt_priority.store(priority);
+    d_rt_workers = applied;
+#endif
+}
+
+std::shared_ptr<codec_strand> codec_thread_pool::make_strand(size_t max_depth)
+{
+    return std::make_shared<codec_strand>(*this, max_depth, current_node());
+}
+
+void codec_thread_pool::schedule(std::shared_ptr<codec_strand> strand, size_t hint)
+{
+    const std::vector<size_t>& local = d_node_workers[strand->home_node()];
+    worker& w = local.empty() ? *d_workers[hint % d_workers.size()] : *d_workers[local[hint % local.size()]];
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.queue.push_back(std::move(strand));
+        d_queued.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(d_sleep_mutex);
+    }
+    d_sleep_cv.notify_one();
+}
+
+std::shared_ptr<codec_strand> codec_thread_pool::take(size_t self)
+{
+    {
+        worker& w = *d_workers[self];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (!w.queue.empty()) {
+            std::shared_ptr<codec_strand> strand = std::move(w.queue.front());
+            w.queue.pop_front();
+            d_queued.fetch_sub(1, std::memory_order_acq_rel);
+            return strand;
+        }
+    }
+
+    // Steal from the back: same node first, remote nodes last.
+    const int node = d_workers[self]->node;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t n = 0; n < d_node_workers.size(); ++n) {
+            if ((pass == 0) != (static_cast<int>(n) == node)) {
+                continue;
+            }
+            for (size_t victim : d_node_workers[n]) {
+                if (victim == self) {
+                    continue;
+                }
+                worker& w = *d_workers[victim];
+                std::lock_guard<std::mutex> lock(w.mutex);
+                if (!w.queue.empty()) {
+                    std::shared_ptr<codec_strand> strand = std::move(w.queue.back());
+                    w.queue.pop_back();
+                    d_queued.fetch_sub(1, std::memory_order_acq_rel);
+                    d_steals.fetch_add(1, std::memory_order_relaxed);
+                    return strand;
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+void codec_thread_pool::worker_loop(size_t self)
+{
+    for (;;) {
+        std::shared_ptr<codec_strand> strand = take(self);
+        if (strand) {
+            if (strand->run_batch(strand_batch_jobs)) {
+                worker& w = *d_workers[self];
+                {
+                    std::lock_guard<std::mutex> lock(w.mutex);
+                    w.queue.push_back(std::move(strand));
+                    d_queued.fetch_add(1, std::memory_order_release);
+                }
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(d_sleep_mutex);
+        d_sleep_cv.wait(lock, [this] { return d_shutdown || d_queued.load(std::memory_order_acquire) > 0; });
+        if (d_shutdown) {
+            return;
+        }
+    }
+}
+
+} // namespace gr_opus
+} // namespace gr
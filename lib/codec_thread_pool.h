@@ -0,0 +1,154 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_CODEC_THREAD_POOL_H
+#define INCLUDED_GR_OPUS_CODEC_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class codec_thread_pool;
+
+/*
+ * Serial job queue owned by one block. Jobs submitted to a strand run one at
+ * a time and in submission order, on whichever pool worker picks the strand
+ * up, so a block's codec state is never touched by two threads at once.
+ */
+class codec_strand : public std::enable_shared_from_this<codec_strand>
+{
+public:
+    typedef std::function<void()> job_t;
+
+    codec_strand(codec_thread_pool& pool, size_t max_depth, int home_node);
+    ~codec_strand();
+
+    // Returns false without queuing when max_depth jobs are already pending.
+    // A job that throws is counted in the pool's jobs_failed() and dropped,
+    // so jobs that others wait on must signal completion before rethrowing.
+    bool try_submit(job_t job);
+    void wait_idle();
+
+    size_t pending() const;
+    size_t max_depth() const { return d_max_depth; }
+    int home_node() const { return d_home_node; }
+
+private:
+    friend class codec_thread_pool;
+
+    // Runs up to max_jobs queued jobs; returns true if the strand must be
+    // rescheduled because more work is waiting.
+    bool run_batch(size_t max_jobs);
+
+    codec_thread_pool& d_pool;
+    const size_t d_max_depth;
+    const int d_home_node;
+    mutable std::mutex d_mutex;
+    std::condition_variable d_idle_cv;
+    std::deque<job_t> d_jobs;
+    size_t d_pending;
+    bool d_scheduled;
+};
+
+/*
+ * Process-wide pool of codec workers shared by every gr-opus block. One
+ * worker is started per CPU in the process affinity mask, grouped by NUMA
+ * node and bound to that node's CPUs. Ready strands are queued on a worker
+ * of their home node; idle workers steal from their own node first and only
+ * then from remote nodes.
+ */
+class codec_thread_pool
+{
+public:
+    static codec_thread_pool& instance();
+
+    std::shared_ptr<codec_strand> make_strand(size_t max_depth);
+
+    size_t num_threads() const { return d_workers.size(); }
+    size_t num_nodes() const { return d_node_workers.size(); }
+    uint64_t jobs_executed() const { return d_jobs_executed.load(std::memory_order_relaxed); }
+    uint64_t steals() const { return d_steals.load(std::memory_order_relaxed); }
+    uint64_t jobs_failed() const { return d_jobs_failed.load(std::memory_order_relaxed); }
+
+    // Real-time mode for the workers: SCHED_FIFO at priority and each worker
+    // pinned to one CPU of its node. The pool is shared, so each call is a
+    // request held until release_realtime(priority), and the workers run at
+    // the highest priority still requested. Returns how many workers run
+    // under SCHED_FIFO; 0 where the system does not permit it.
+    size_t set_realtime(int priority);
+    // Drops one set_realtime(priority) request. Once none is left the
+    // workers go back to SCHED_OTHER on every CPU of their node.
+    void release_realtime(int priority);
+    int realtime_priority() const { return d_rt_priority.load(); }
+
+private:
+    friend class codec_strand;
+
+    struct worker {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<codec_strand>> queue;
+        int node;
+        std::vector<int> cpus;
+        std::thread thread;
+    };
+
+    codec_thread_pool();
+    ~codec_thread_pool();
+    codec_thread_pool(const codec_thread_pool&) = delete;
+    codec_thread_pool& operator=(const codec_thread_pool&) = delete;
+
+    void schedule(std::shared_ptr<codec_strand> strand, size_t hint);
+    std::shared_ptr<codec_strand> take(size_t self);
+    void worker_loop(size_t self);
+    int current_node() const;
+    void apply_realtime(int priority);
+
+    std::vector<std::unique_ptr<worker>> d_workers;
+    std::vector<std::vector<size_t>> d_node_workers;
+    std::vector<int> d_cpu_node;
+
+    std::mutex d_sleep_mutex;
+    std::condition_variable d_sleep_cv;
+    std::atomic<size_t> d_queued;
+    std::atomic<size_t> d_next_worker;
+    std::atomic<uint64_t> d_jobs_executed;
+    std::atomic<uint64_t> d_steals;
+    std::atomic<uint64_t> d_jobs_failed;
+    bool d_shutdown;
+    std::mutex d_rt_mutex;
+    std::atomic<int> d_rt_priority;
+    size_t d_rt_workers;
+    std::multiset<int> d_rt_requests;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_CODEC_THREAD_POOL_H */
@@ -0,0 +1,62 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "dnn_blob_cache.h"
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+dnn_blob_ptr load_dnn_blob(const std::string& path)
+{
+    static std::mutex cache_mutex;
+    static std::map<std::string, std::weak_ptr<const std::vector<char>>> cache;
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(path);
+    if (it != cache.end()) {
+        dnn_blob_ptr blob = it->second.lock();
+        if (blob) {
+            return blob;
+        }
+    }
+
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    if (!f) {
+        throw std::runtime_error("Failed to open DNN blob file: " + path);
+    }
+    std::shared_ptr<std::vector<char>> blob = std::make_shared<std::vector<char>>(f.tellg());
+    f.seekg(0);
+    if (!f.read(blob->data(), blob->size())) {
+        throw std::runtime_error("Failed to read DNN blob file: " + path);
+    }
+    cache[path] = blob;
+    return blob;
+}
+
+} // namespace gr_opus
+} // namespace gr
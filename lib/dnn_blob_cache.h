@@ -0,0 +1,44 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_DNN_BLOB_CACHE_H
+#define INCLUDED_GR_OPUS_DNN_BLOB_CACHE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+typedef std::shared_ptr<const std::vector<char>> dnn_blob_ptr;
+
+/*
+ * Loads a DNN weights blob, sharing one copy between every codec that names
+ * the same file. libopus keeps pointers into the blob after OPUS_SET_DNN_BLOB,
+ * so callers must hold the returned pointer for as long as the codec lives.
+ * Throws std::runtime_error if the file cannot be read.
+ */
+dnn_blob_ptr load_dnn_blob(const std::string& path);
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_DNN_BLOB_CACHE_H */
@@ -0,0 +1,215 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/gr_opus/load_governor.h>
+#include "load_registry.h"
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class load_registry
+{
+public:
+    static load_registry& instance()
+    {
+        // Leaked for the same reason as codec_thread_pool::instance().
+        static load_registry* registry = new load_registry();
+        return *registry;
+    }
+
+    std::shared_ptr<load_channel> add(load_priority_t priority)
+    {
+        std::shared_ptr<load_channel> channel = std::make_shared<load_channel>(priority);
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_channels.push_back(channel);
+        return channel;
+    }
+
+    void maybe_evaluate()
+    {
+        int64_t now = now_ns();
+        int64_t last = d_last_eval_ns.load(std::memory_order_relaxed);
+        if (now - last < interval_ns) {
+            return;
+        }
+        // One reporting thread wins the interval; the rest carry on.
+        if (!d_last_eval_ns.compare_exchange_strong(last, now)) {
+            return;
+        }
+        evaluate(now - last);
+    }
+
+    void set_budget(double cores)
+    {
+        if (cores < 0.0) {
+            throw std::runtime_error("Load governor core budget must not be negative");
+        }
+        d_budget.store(cores);
+        if (cores == 0.0) {
+            std::lock_guard<std::mutex> lock(d_mutex);
+            for (auto& channel : live_channels()) {
+                channel->d_level.store(SHED_NONE);
+            }
+        }
+    }
+
+    double budget() const { return d_budget.load(); }
+    double load() const { return d_load.load(); }
+
+    int channels()
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        return static_cast<int>(live_channels().size());
+    }
+
+private:
+    // Load is measured over at least this long; a step back up needs
+    // restore_intervals calm intervals in a row so a shed channel whose
+    // load vanished does not bounce straight back.
+    static constexpr int64_t interval_ns = 100000000;
+    static constexpr int restore_intervals = 10;
+
+    load_registry() : d_budget(0.0), d_load(0.0), d_last_eval_ns(now_ns()), d_calm_intervals(0) {}
+
+    static int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Caller holds d_mutex. Drops channels whose blocks are gone.
+    std::vector<std::shared_ptr<load_channel>> live_channels()
+    {
+        std::vector<std::shared_ptr<load_channel>> live;
+        size_t keep = 0;
+        for (size_t i = 0; i < d_channels.size(); ++i) {
+            std::shared_ptr<load_channel> channel = d_channels[i].lock();
+            if (channel) {
+                live.push_back(channel);
+                d_channels[keep++] = d_channels[i];
+            }
+        }
+        d_channels.resize(keep);
+        return live;
+    }
+
+    void evaluate(int64_t wall_ns)
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        std::vector<std::shared_ptr<load_channel>> live = live_channels();
+
+        uint64_t busy_ns = 0;
+        for (auto& channel : live) {
+            busy_ns += channel->d_busy_ns.exchange(0, std::memory_order_relaxed);
+            if (channel->priority() == load_priority_t::EMERGENCY) {
+                channel->d_level.store(SHED_NONE);
+            }
+        }
+        const double load = static_cast<double>(busy_ns) / static_cast<double>(wall_ns);
+        d_load.store(load);
+
+        const double budget = d_budget.load();
+        if (budget <= 0.0) {
+            d_calm_intervals = 0;
+            return;
+        }
+
+        if (load > budget) {
+            d_calm_intervals = 0;
+            // Shed one step across the lowest class that still has room.
+            for (load_priority_t cls : { load_priority_t::LOW, load_priority_t::NORMAL, load_priority_t::HIGH }) {
+                if (step(live, cls, +1)) {
+                    return;
+                }
+            }
+        } else if (load < budget * 0.7) {
+            if (++d_calm_intervals < restore_intervals) {
+                return;
+            }
+            d_calm_intervals = 0;
+            // Restore one step, most important class first.
+            for (load_priority_t cls : { load_priority_t::HIGH, load_priority_t::NORMAL, load_priority_t::LOW }) {
+                if (step(live, cls, -1)) {
+                    return;
+                }
+            }
+        } else {
+            d_calm_intervals = 0;
+        }
+    }
+
+    // Moves every channel of one class a level up or down; false if none could move.
+    static bool step(const std::vector<std::shared_ptr<load_channel>>& live, load_priority_t cls, int direction)
+    {
+        bool moved = false;
+        for (auto& channel : live) {
+            if (channel->priority() != cls) {
+                continue;
+            }
+            int level = channel->d_level.load();
+            int next = level + direction;
+            if (next < SHED_NONE || next > SHED_MUTED) {
+                continue;
+            }
+            channel->d_level.store(next);
+            moved = true;
+        }
+        return moved;
+    }
+
+    std::mutex d_mutex;
+    std::vector<std::weak_ptr<load_channel>> d_channels;
+    std::atomic<double> d_budget;
+    std::atomic<double> d_load;
+    std::atomic<int64_t> d_last_eval_ns;
+    int d_calm_intervals;
+};
+
+void load_channel::add_busy(uint64_t ns)
+{
+    d_busy_ns.fetch_add(ns, std::memory_order_relaxed);
+    load_registry::instance().maybe_evaluate();
+}
+
+void load_channel::poll() { load_registry::instance().maybe_evaluate(); }
+
+std::shared_ptr<load_channel> register_load_channel(load_priority_t priority)
+{
+    return load_registry::instance().add(priority);
+}
+
+void load_governor::set_core_budget(double cores) { load_registry::instance().set_budget(cores); }
+
+double load_governor::core_budget() { return load_registry::instance().budget(); }
+
+double load_governor::codec_load() { return load_registry::instance().load(); }
+
+int load_governor::channels() { return load_registry::instance().channels(); }
+
+} // namespace gr_opus
+} // namespace gr
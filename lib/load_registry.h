@@ -0,0 +1,101 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_LOAD_REGISTRY_H
+#define INCLUDED_GR_OPUS_LOAD_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+// Priority classes under the load governor, lowest first.
+enum class load_priority_t { LOW, NORMAL, HIGH, EMERGENCY };
+
+inline load_priority_t load_priority_from_string(const std::string& priority)
+{
+    if (priority == "low") {
+        return load_priority_t::LOW;
+    } else if (priority == "normal") {
+        return load_priority_t::NORMAL;
+    } else if (priority == "high") {
+        return load_priority_t::HIGH;
+    } else if (priority == "emergency") {
+        return load_priority_t::EMERGENCY;
+    }
+    throw std::runtime_error("Unknown load priority: " + priority);
+}
+
+inline const char* load_priority_to_string(load_priority_t priority)
+{
+    switch (priority) {
+    case load_priority_t::LOW:
+        return "low";
+    case load_priority_t::HIGH:
+        return "high";
+    case load_priority_t::EMERGENCY:
+        return "emergency";
+    default:
+        return "normal";
+    }
+}
+
+// Shed levels handed out by the governor. Each block maps them onto its own
+// knobs; see opus_encoder_impl::adjust_quality and opus_decoder_impl::apply_complexity.
+enum shed_level { SHED_NONE = 0, SHED_REDUCED = 1, SHED_MINIMAL = 2, SHED_MUTED = 3 };
+
+/*
+ * One block's registration with the governor. The block reports codec time
+ * from whichever thread ran the codec and calls poll() and level() from work().
+ */
+class load_channel
+{
+public:
+    explicit load_channel(load_priority_t priority) : d_priority(priority), d_level(SHED_NONE), d_busy_ns(0) {}
+
+    // Adds codec time; may run a governor evaluation on the calling thread.
+    void add_busy(uint64_t ns);
+    // Runs a due evaluation without reporting time. Blocks call it from every
+    // work() so a muted channel, which no longer reports, can still be restored.
+    void poll();
+
+    void set_priority(load_priority_t priority) { d_priority.store(priority); }
+    load_priority_t priority() const { return d_priority.load(); }
+    int level() const { return d_level.load(std::memory_order_relaxed); }
+
+private:
+    friend class load_registry;
+
+    std::atomic<load_priority_t> d_priority;
+    std::atomic<int> d_level;
+    std::atomic<uint64_t> d_busy_ns;
+};
+
+// Registers a new channel; it unregisters itself when the last reference goes.
+std::shared_ptr<load_channel> register_load_channel(load_priority_t priority = load_priority_t::NORMAL);
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_LOAD_REGISTRY_H */
@@ -0,0 +1,63 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_LOSS_RECOVERY_H
+#define INCLUDED_GR_OPUS_LOSS_RECOVERY_H
+
+#include <stdexcept>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * How the decoder rebuilds frames it is told were lost ("packet_lost"
+ * tags): concealment only, the next packet's in-band FEC, or its DRED data.
+ */
+enum class loss_recovery_t { PLC, FEC, DRED };
+
+inline loss_recovery_t loss_recovery_from_string(const std::string& mode)
+{
+    if (mode == "plc") {
+        return loss_recovery_t::PLC;
+    } else if (mode == "fec") {
+        return loss_recovery_t::FEC;
+    } else if (mode == "dred") {
+        return loss_recovery_t::DRED;
+    }
+    throw std::runtime_error("Unknown loss recovery mode: " + mode);
+}
+
+inline const char* loss_recovery_to_string(loss_recovery_t mode)
+{
+    switch (mode) {
+    case loss_recovery_t::FEC:
+        return "fec";
+    case loss_recovery_t::DRED:
+        return "dred";
+    default:
+        return "plc";
+    }
+}
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_LOSS_RECOVERY_H */
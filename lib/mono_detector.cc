@@ -0,0 +1,98 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mono_detector.h"
+#include <cmath>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// Side energy per sample that counts as no difference at all (-90 dBFS).
+const float side_floor = 1e-9f;
+// Independent accumulators, so the energy loop vectorises without
+// reassociating a single floating-point sum.
+const int lanes = 8;
+
+} // namespace
+
+mono_detector::mono_detector() { reset(25, 30.0); }
+
+void mono_detector::reset(size_t hold, double threshold_db)
+{
+    d_hold = hold > 0 ? hold : 1;
+    d_threshold_db = threshold_db;
+    d_collapse_ratio = std::pow(10.0, -threshold_db / 10.0);
+    d_expand_ratio = std::pow(10.0, -(threshold_db - 6.0) / 10.0);
+    d_mono_run = 0;
+    d_mono = false;
+}
+
+bool mono_detector::update(const float* samples, int frame_size)
+{
+    float mid[lanes] = {};
+    float side[lanes] = {};
+    int n = 0;
+    for (; n + lanes <= frame_size; n += lanes) {
+        const float* s = samples + 2 * n;
+        for (int j = 0; j < lanes; ++j) {
+            float m = s[2 * j] + s[2 * j + 1];
+            float d = s[2 * j] - s[2 * j + 1];
+            mid[j] += m * m;
+            side[j] += d * d;
+        }
+    }
+    for (; n < frame_size; ++n) {
+        float m = samples[2 * n] + samples[2 * n + 1];
+        float d = samples[2 * n] - samples[2 * n + 1];
+        mid[0] += m * m;
+        side[0] += d * d;
+    }
+    double mid_energy = 0.0;
+    double side_energy = 0.0;
+    for (int j = 0; j < lanes; ++j) {
+        mid_energy += mid[j];
+        side_energy += side[j];
+    }
+
+    // (L - R)^2 sums to 4x the side energy per sample.
+    const bool silent_side = side_energy <= 4.0 * side_floor * frame_size;
+    if (d_mono) {
+        if (!silent_side && side_energy > d_expand_ratio * mid_energy) {
+            d_mono = false;
+            d_mono_run = 0;
+        }
+    } else if (silent_side || side_energy <= d_collapse_ratio * mid_energy) {
+        if (++d_mono_run >= d_hold) {
+            d_mono = true;
+        }
+    } else {
+        d_mono_run = 0;
+    }
+    return d_mono;
+}
+
+} // namespace gr_opus
+} // namespace gr
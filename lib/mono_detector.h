@@ -0,0 +1,64 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_MONO_DETECTOR_H
+#define INCLUDED_GR_OPUS_MONO_DETECTOR_H
+
+#include <cstddef>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Decides whether a stereo input is effectively mono, from the energy of
+ * the side signal (L - R) relative to the mid signal (L + R) in each frame.
+ * A frame is mono when the side is threshold_db or more below the mid, or
+ * below -90 dBFS (dual-mono with independent dither, digital silence). The
+ * input collapses to mono once hold frames in a row are mono, and returns to
+ * stereo at once on a frame whose side is less than threshold_db - 6 dB
+ * below the mid.
+ */
+class mono_detector
+{
+public:
+    mono_detector();
+
+    void reset(size_t hold, double threshold_db);
+
+    // One interleaved stereo frame of frame_size samples per channel;
+    // returns mono().
+    bool update(const float* samples, int frame_size);
+
+    bool mono() const { return d_mono; }
+    double threshold_db() const { return d_threshold_db; }
+
+private:
+    size_t d_hold;
+    double d_threshold_db;
+    double d_collapse_ratio;
+    double d_expand_ratio;
+    size_t d_mono_run;
+    bool d_mono;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_MONO_DETECTOR_H */
@@ -0,0 +1,378 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ogg_opus.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+struct crc_table {
+    uint32_t entries[256];
+    crc_table()
+    {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t r = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                r = (r & 0x80000000u) ? (r << 1) ^ 0x04c11db7u : (r << 1);
+            }
+            entries[i] = r;
+        }
+    }
+};
+
+void put_le(std::vector<unsigned char>& out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+uint32_t crc_update(uint32_t crc, const unsigned char* data, size_t len)
+{
+    static const crc_table table;
+    for (size_t i = 0; i < len; ++i) {
+        crc = (crc << 8) ^ table.entries[((crc >> 24) ^ data[i]) & 0xff];
+    }
+    return crc;
+}
+
+// Verifies a whole raw page, reading its checksum field as zero.
+bool page_crc_ok(const unsigned char* raw, size_t len)
+{
+    static const unsigned char zero[4] = { 0, 0, 0, 0 };
+    uint32_t stored = 0;
+    for (int i = 0; i < 4; ++i) {
+        stored |= static_cast<uint32_t>(raw[22 + i]) << (8 * i);
+    }
+    uint32_t crc = crc_update(0, raw, 22);
+    crc = crc_update(crc, zero, 4);
+    return crc_update(crc, raw + 26, len - 26) == stored;
+}
+
+// Fills page from a verified raw page, reassembling packets that span
+// pages in partial.
+void read_page(const unsigned char* raw, ogg_page& page, std::vector<unsigned char>& partial, bool& have_partial)
+{
+    page.flags = raw[5];
+    page.granule = 0;
+    for (int i = 0; i < 8; ++i) {
+        page.granule |= static_cast<int64_t>(raw[6 + i]) << (8 * i);
+    }
+    page.serial = raw[14] | (raw[15] << 8) | (raw[16] << 16) | (static_cast<uint32_t>(raw[17]) << 24);
+    page.sequence = raw[18] | (raw[19] << 8) | (raw[20] << 16) | (static_cast<uint32_t>(raw[21]) << 24);
+    page.packets.clear();
+
+    // A fragment continuing a packet we never saw the start of is dropped.
+    const int nseg = raw[26];
+    const bool continued = page.flags & 0x01;
+    bool drop = continued && !have_partial;
+    if (!continued) {
+        partial.clear();
+    }
+    const unsigned char* body = raw + 27 + nseg;
+    for (int i = 0; i < nseg; ++i) {
+        unsigned char lace = raw[27 + i];
+        partial.insert(partial.end(), body, body + lace);
+        body += lace;
+        if (lace < 255) {
+            if (!drop) {
+                page.packets.push_back(std::move(partial));
+            }
+            partial.clear();
+            drop = false;
+        }
+    }
+    have_partial = nseg > 0 && raw[27 + nseg - 1] == 255;
+}
+
+} // namespace
+
+uint32_t ogg_crc(const unsigned char* data, size_t len) { return crc_update(0, data, len); }
+
+std::vector<unsigned char> opus_head_packet(int channels, int input_sample_rate, int pre_skip)
+{
+    std::vector<unsigned char> head = { 'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1 };
+    head.push_back(static_cast<unsigned char>(channels));
+    put_le(head, static_cast<uint16_t>(pre_skip), 2);
+    put_le(head, static_cast<uint32_t>(input_sample_rate), 4);
+    put_le(head, 0, 2); // output gain
+    head.push_back(0);  // mapping family
+    return head;
+}
+
+std::vector<unsigned char> opus_tags_packet(const std::string& vendor)
+{
+    std::vector<unsigned char> tags = { 'O', 'p', 'u', 's', 'T', 'a', 'g', 's' };
+    put_le(tags, vendor.size(), 4);
+    tags.insert(tags.end(), vendor.begin(), vendor.end());
+    put_le(tags, 0, 4); // no user comments
+    return tags;
+}
+
+ogg_page_builder::ogg_page_builder(uint32_t serial)
+    : d_serial(serial), d_sequence(0), d_granule(0), d_packets(0)
+{
+}
+
+bool ogg_page_builder::fits(size_t len) const
+{
+    return d_lacing.size() + len / 255 + 1 <= 255;
+}
+
+void ogg_page_builder::add_packet(const unsigned char* data, size_t len, int64_t granule)
+{
+    for (size_t n = len; ; n -= 255) {
+        if (n < 255) {
+            d_lacing.push_back(static_cast<unsigned char>(n));
+            break;
+        }
+        d_lacing.push_back(255);
+    }
+    d_body.insert(d_body.end(), data, data + len);
+    d_granule = granule;
+    d_packets++;
+}
+
+void ogg_page_builder::flush(std::vector<unsigned char>& out, bool bos, bool eos)
+{
+    size_t start = out.size();
+    out.insert(out.end(), { 'O', 'g', 'g', 'S', 0 });
+    out.push_back(static_cast<unsigned char>((bos ? 0x02 : 0) | (eos ? 0x04 : 0)));
+    put_le(out, static_cast<uint64_t>(d_granule), 8);
+    put_le(out, d_serial, 4);
+    put_le(out, d_sequence++, 4);
+    put_le(out, 0, 4); // checksum, filled in below
+    out.push_back(static_cast<unsigned char>(d_lacing.size()));
+    out.insert(out.end(), d_lacing.begin(), d_lacing.end());
+    out.insert(out.end(), d_body.begin(), d_body.end());
+
+    uint32_t crc = ogg_crc(out.data() + start, out.size() - start);
+    for (int i = 0; i < 4; ++i) {
+        out[start + 22 + i] = static_cast<unsigned char>(crc >> (8 * i));
+    }
+    d_lacing.clear();
+    d_body.clear();
+    d_packets = 0;
+}
+
+ogg_page_reader::ogg_page_reader(const std::string& path)
+    : d_file(path, std::ios::binary), d_have_partial(false), d_crc_errors(0)
+{
+    if (!d_file) {
+        throw std::runtime_error("Failed to open Ogg file: " + path);
+    }
+}
+
+void ogg_page_reader::seek(uint64_t offset)
+{
+    d_file.clear();
+    d_file.seekg(static_cast<std::streamoff>(offset));
+    d_partial.clear();
+    d_have_partial = false;
+}
+
+bool ogg_page_reader::sync()
+{
+    // Leaves the stream on the next "OggS", one byte at a time.
+    const char pattern[] = "OggS";
+    int matched = 0;
+    char c;
+    while (d_file.get(c)) {
+        matched = (c == pattern[matched]) ? matched + 1 : (c == 'O' ? 1 : 0);
+        if (matched == 4) {
+            d_file.seekg(-4, std::ios::cur);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ogg_page_reader::next(ogg_page& page)
+{
+    unsigned char header[27 + 255];
+    for (;;) {
+        if (!sync()) {
+            return false;
+        }
+        page.offset = static_cast<uint64_t>(d_file.tellg());
+        if (!d_file.read(reinterpret_cast<char*>(header), 27) ||
+            !d_file.read(reinterpret_cast<char*>(header + 27), header[26])) {
+            return false;
+        }
+        const int nseg = header[26];
+        size_t body_len = 0;
+        for (int i = 0; i < nseg; ++i) {
+            body_len += header[27 + i];
+        }
+        std::vector<unsigned char> raw(header, header + 27 + nseg);
+        raw.resize(27 + nseg + body_len);
+        if (!d_file.read(reinterpret_cast<char*>(raw.data() + 27 + nseg), body_len)) {
+            return false;
+        }
+
+        if (!page_crc_ok(raw.data(), raw.size())) {
+            d_crc_errors++;
+            seek(page.offset + 1);
+            continue;
+        }
+        read_page(raw.data(), page, d_partial, d_have_partial);
+        return true;
+    }
+}
+
+ogg_stream_parser::ogg_stream_parser()
+    : d_read(0), d_offset(0), d_have_partial(false), d_crc_errors(0), d_bytes_skipped(0), d_serial(0), d_sequence(0),
+      d_have_page(false)
+{
+}
+
+void ogg_stream_parser::push(const unsigned char* data, size_t len) { d_buffer.insert(d_buffer.end(), data, data + len); }
+
+void ogg_stream_parser::reset()
+{
+    d_buffer.clear();
+    d_read = 0;
+    d_offset = 0;
+    d_partial.clear();
+    d_have_partial = false;
+    d_have_page = false;
+}
+
+void ogg_stream_parser::compact()
+{
+    if (d_read == d_buffer.size()) {
+        d_offset += d_read;
+        d_buffer.clear();
+        d_read = 0;
+    } else if (d_read > 65536 && d_read * 2 > d_buffer.size()) {
+        d_offset += d_read;
+        d_buffer.erase(d_buffer.begin(), d_buffer.begin() + d_read);
+        d_read = 0;
+    }
+}
+
+bool ogg_stream_parser::sync()
+{
+    const unsigned char* start = d_buffer.data() + d_read;
+    const unsigned char* end = d_buffer.data() + d_buffer.size();
+    const unsigned char* p = start;
+    while (end - p >= 4) {
+        p = static_cast<const unsigned char*>(std::memchr(p, 'O', end - p - 3));
+        if (p == nullptr) {
+            p = end - 3;
+            break;
+        }
+        if (std::memcmp(p, "OggS", 4) == 0) {
+            break;
+        }
+        ++p;
+    }
+    // Up to three trailing bytes may still be the start of a pattern.
+    size_t skip = static_cast<size_t>(p - start);
+    if (skip > 0) {
+        d_bytes_skipped += skip;
+        d_read += skip;
+        // Whatever was skipped may have held the rest of a packet.
+        d_partial.clear();
+        d_have_partial = false;
+    }
+    return end - p >= 4;
+}
+
+bool ogg_stream_parser::next(ogg_page& page)
+{
+    for (;;) {
+        if (!sync()) {
+            compact();
+            return false;
+        }
+        const unsigned char* raw = d_buffer.data() + d_read;
+        const size_t avail = d_buffer.size() - d_read;
+        if (avail > 4 && raw[4] != 0) {
+            // Not a page (version 0 is the only one): resync one byte on
+            // now rather than waiting for the length it claims.
+            d_bytes_skipped++;
+            d_read++;
+            d_partial.clear();
+            d_have_partial = false;
+            continue;
+        }
+        if (avail < 27 || avail < 27u + raw[26]) {
+            compact();
+            return false;
+        }
+        const int nseg = raw[26];
+        size_t len = 27 + nseg;
+        for (int i = 0; i < nseg; ++i) {
+            len += raw[27 + i];
+        }
+        if (avail < len) {
+            compact();
+            return false;
+        }
+        if (!page_crc_ok(raw, len)) {
+            // A damaged page: resync one byte on.
+            d_crc_errors++;
+            d_bytes_skipped++;
+            d_read++;
+            d_partial.clear();
+            d_have_partial = false;
+            continue;
+        }
+
+        // A gap in a stream's page sequence loses any packet in progress.
+        const uint32_t serial = raw[14] | (raw[15] << 8) | (raw[16] << 16) | (static_cast<uint32_t>(raw[17]) << 24);
+        const uint32_t sequence = raw[18] | (raw[19] << 8) | (raw[20] << 16) | (static_cast<uint32_t>(raw[21]) << 24);
+        if (d_have_page && serial == d_serial && sequence != d_sequence + 1) {
+            d_partial.clear();
+            d_have_partial = false;
+        }
+        d_serial = serial;
+        d_sequence = sequence;
+        d_have_page = true;
+
+        page.offset = d_offset + d_read;
+        read_page(raw, page, d_partial, d_have_partial);
+        d_read += len;
+        compact();
+        return true;
+    }
+}
+
+bool parse_opus_head(const std::vector<unsigned char>& packet, int& channels, int& pre_skip)
+{
+    if (packet.size() < 19 || std::memcmp(packet.data(), "OpusHead", 8) != 0) {
+        return false;
+    }
+    channels = packet[9];
+    pre_skip = packet[10] | (packet[11] << 8);
+    return true;
+}
+
+} // namespace gr_opus
+} // namespace gr
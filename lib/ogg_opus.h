@@ -0,0 +1,150 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OGG_OPUS_H
+#define INCLUDED_GR_OPUS_OGG_OPUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+// Ogg page checksum (CRC-32, polynomial 0x04c11db7, unreflected, zero init).
+uint32_t ogg_crc(const unsigned char* data, size_t len);
+
+// RFC 7845 identification and comment header packets (mapping family 0).
+std::vector<unsigned char> opus_head_packet(int channels, int input_sample_rate, int pre_skip);
+std::vector<unsigned char> opus_tags_packet(const std::string& vendor);
+
+/*
+ * Collects packets of one logical Ogg stream into pages. Granule positions
+ * are in 48 kHz samples as RFC 7845 requires, whatever the coded rate.
+ */
+class ogg_page_builder
+{
+public:
+    explicit ogg_page_builder(uint32_t serial);
+
+    // False when the packet's lacing values no longer fit on the open page.
+    bool fits(size_t len) const;
+    // granule is the stream position at the end of this packet.
+    void add_packet(const unsigned char* data, size_t len, int64_t granule);
+    // Appends the open page (possibly empty) to out and starts a new one.
+    void flush(std::vector<unsigned char>& out, bool bos, bool eos);
+
+    size_t pending_packets() const { return d_packets; }
+    int64_t granule() const { return d_granule; }
+
+private:
+    const uint32_t d_serial;
+    uint32_t d_sequence;
+    int64_t d_granule;
+    size_t d_packets;
+    std::vector<unsigned char> d_lacing;
+    std::vector<unsigned char> d_body;
+};
+
+struct ogg_page {
+    uint64_t offset; // file offset of the capture pattern
+    unsigned char flags;
+    int64_t granule;
+    uint32_t serial;
+    uint32_t sequence;
+    std::vector<std::vector<unsigned char>> packets; // packets completed on this page
+};
+
+/*
+ * Reads pages from an Ogg file, reassembling packets that span pages.
+ * Pages with a bad checksum are skipped by scanning for the next capture
+ * pattern.
+ */
+class ogg_page_reader
+{
+public:
+    // Throws if the file cannot be opened.
+    explicit ogg_page_reader(const std::string& path);
+
+    // False at end of file.
+    bool next(ogg_page& page);
+    // Continue at a page boundary; a packet continued from before it is dropped.
+    void seek(uint64_t offset);
+
+    uint64_t crc_errors() const { return d_crc_errors; }
+
+private:
+    bool sync();
+
+    std::ifstream d_file;
+    std::vector<unsigned char> d_partial;
+    bool d_have_partial;
+    uint64_t d_crc_errors;
+};
+
+/*
+ * Incremental page parser for Ogg arriving as a live byte stream. Bytes are
+ * pushed as they come and complete pages are taken with next(); packets are
+ * reassembled across pages as in ogg_page_reader. Garbage, cuts and pages
+ * with a bad checksum are skipped by searching the buffer for the next
+ * capture pattern.
+ */
+class ogg_stream_parser
+{
+public:
+    ogg_stream_parser();
+
+    void push(const unsigned char* data, size_t len);
+    // False until another complete page is buffered. page.offset counts
+    // bytes pushed since construction or reset().
+    bool next(ogg_page& page);
+    void reset();
+
+    size_t buffered() const { return d_buffer.size() - d_read; }
+    uint64_t crc_errors() const { return d_crc_errors; }
+    uint64_t bytes_skipped() const { return d_bytes_skipped; }
+
+private:
+    // Moves d_read to the next capture pattern (or near the end of the
+    // buffer); false if there is none yet.
+    bool sync();
+    void compact();
+
+    std::vector<unsigned char> d_buffer;
+    size_t d_read;
+    uint64_t d_offset; // stream offset of d_buffer[0]
+    std::vector<unsigned char> d_partial;
+    bool d_have_partial;
+    uint64_t d_crc_errors;
+    uint64_t d_bytes_skipped;
+    uint32_t d_serial; // of the last page, for sequence gaps
+    uint32_t d_sequence;
+    bool d_have_page;
+};
+
+// Parses an OpusHead packet; false if it is not one.
+bool parse_opus_head(const std::vector<unsigned char>& packet, int& channels, int& pre_skip);
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OGG_OPUS_H */
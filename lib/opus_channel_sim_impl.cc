@@ -0,0 +1,202 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_channel_sim_impl.h"
+#include "upstream_done.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// Delivered bytes held before input is left waiting upstream.
+const size_t max_queued_bytes = 64 * 1024;
+
+void check_probability(double p, const char* what)
+{
+    if (!(p >= 0.0 && p <= 1.0)) {
+        throw std::runtime_error(std::string(what) + " must be between 0 and 1");
+    }
+}
+
+} // namespace
+
+opus_channel_sim::sptr opus_channel_sim::make(long seed, int packet_size)
+{
+    return gnuradio::get_initial_sptr(new opus_channel_sim_impl(seed, packet_size));
+}
+
+opus_channel_sim_impl::opus_channel_sim_impl(long seed, int packet_size)
+    : gr::block("opus_channel_sim",
+                gr::io_signature::make(1, 1, sizeof(unsigned char)),
+                gr::io_signature::make(1, 1, sizeof(unsigned char))),
+      d_framer(packet_size),
+      d_params(channel_model::clean()),
+      d_model(static_cast<uint64_t>(seed)),
+      d_queue_read(0),
+      d_emitted(0)
+{
+    if (packet_size < 0) {
+        throw std::runtime_error("packet_size must be 0 (packet_len tags) or positive");
+    }
+    // Output tags are rebuilt per delivered packet.
+    set_tag_propagation_policy(TPP_DONT);
+}
+
+opus_channel_sim_impl::~opus_channel_sim_impl() {}
+
+void opus_channel_sim_impl::set_burst_loss(double p_good_to_bad, double p_bad_to_good, double loss_good, double loss_bad)
+{
+    check_probability(p_good_to_bad, "p_good_to_bad");
+    check_probability(p_bad_to_good, "p_bad_to_good");
+    check_probability(loss_good, "loss_good");
+    check_probability(loss_bad, "loss_bad");
+    std::lock_guard<std::mutex> lock(d_params_mutex);
+    d_params.p_good_to_bad = p_good_to_bad;
+    d_params.p_bad_to_good = p_bad_to_good;
+    d_params.loss_good = loss_good;
+    d_params.loss_bad = loss_bad;
+}
+
+void opus_channel_sim_impl::set_jitter(double jitter_ms, double playout_delay_ms)
+{
+    if (jitter_ms < 0.0 || playout_delay_ms < 0.0) {
+        throw std::runtime_error("Jitter and playout delay must not be negative");
+    }
+    std::lock_guard<std::mutex> lock(d_params_mutex);
+    d_params.jitter_ms = jitter_ms;
+    d_params.playout_delay_ms = playout_delay_ms;
+}
+
+void opus_channel_sim_impl::set_reordering(double probability)
+{
+    check_probability(probability, "Reordering probability");
+    std::lock_guard<std::mutex> lock(d_params_mutex);
+    d_params.reorder = probability;
+}
+
+void opus_channel_sim_impl::set_duplication(double probability)
+{
+    check_probability(probability, "Duplication probability");
+    std::lock_guard<std::mutex> lock(d_params_mutex);
+    d_params.duplicate = probability;
+}
+
+void opus_channel_sim_impl::set_bit_error_rate(double ber)
+{
+    check_probability(ber, "Bit error rate");
+    std::lock_guard<std::mutex> lock(d_params_mutex);
+    d_params.ber = ber;
+}
+
+void opus_channel_sim_impl::enqueue(const unsigned char* packet, size_t len, long lost)
+{
+    d_queue.insert(d_queue.end(), packet, packet + len);
+    d_queued.push_back({ len, lost });
+}
+
+int opus_channel_sim_impl::emit(unsigned char* out, int noutput_items)
+{
+    int produced = 0;
+    while (!d_queued.empty() && produced < noutput_items) {
+        const queued_packet& packet = d_queued.front();
+        if (d_emitted == 0) {
+            const uint64_t offset = nitems_written(0) + produced;
+            add_item_tag(0, offset, pmt::mp("packet_len"), pmt::from_long(static_cast<long>(packet.len)));
+            if (packet.lost > 0) {
+                add_item_tag(0, offset, pmt::mp("packet_lost"), pmt::from_long(packet.lost));
+            }
+        }
+        // Packets may straddle work() calls when the output buffer is short.
+        size_t n = std::min(packet.len - d_emitted, static_cast<size_t>(noutput_items - produced));
+        std::memcpy(out + produced, d_queue.data() + d_queue_read, n);
+        produced += static_cast<int>(n);
+        d_queue_read += n;
+        d_emitted += n;
+        if (d_emitted == packet.len) {
+            d_emitted = 0;
+            d_queued.pop_front();
+        }
+    }
+    if (d_queue_read == d_queue.size()) {
+        d_queue.clear();
+        d_queue_read = 0;
+    } else if (d_queue_read > 4096 && d_queue_read * 2 > d_queue.size()) {
+        d_queue.erase(d_queue.begin(), d_queue.begin() + d_queue_read);
+        d_queue_read = 0;
+    }
+    return produced;
+}
+
+void opus_channel_sim_impl::forecast(int noutput_items, gr_vector_int& ninput_items_required)
+{
+    ninput_items_required[0] = d_queued.empty() && !(d_model.holding() && upstream_done(*this, 0)) ? 1 : 0;
+}
+
+int opus_channel_sim_impl::general_work(int noutput_items,
+                                        gr_vector_int& ninput_items,
+                                        gr_vector_const_void_star& input_items,
+                                        gr_vector_void_star& output_items)
+{
+    const unsigned char* in = (const unsigned char*)input_items[0];
+    unsigned char* out = (unsigned char*)output_items[0];
+
+    int produced = emit(out, noutput_items);
+    if (d_queue.size() - d_queue_read >= max_queued_bytes) {
+        return produced;
+    }
+    if (ninput_items[0] == 0) {
+        if (d_model.holding() && upstream_done(*this, 0)) {
+            d_model.flush([this](const unsigned char* data, size_t n, long lost) { enqueue(data, n, lost); });
+            produced += emit(out + produced, noutput_items - produced);
+        }
+        return produced;
+    }
+
+    channel_model::params params;
+    {
+        std::lock_guard<std::mutex> lock(d_params_mutex);
+        params = d_params;
+    }
+
+    const uint64_t first = nitems_read(0);
+    const int ninput = ninput_items[0];
+    std::vector<gr::tag_t> tags;
+    get_tags_in_range(tags, 0, first, first + ninput, pmt::mp("packet_len"));
+    d_framer.feed(first, in, static_cast<size_t>(ninput), tags, [&](const unsigned char* packet, int len) {
+        d_model.on_packet(params, packet, len, [this](const unsigned char* data, size_t n, long lost) {
+            enqueue(data, n, lost);
+        });
+    });
+    consume_each(ninput);
+
+    return produced + emit(out + produced, noutput_items - produced);
+}
+
+} // namespace gr_opus
+} // namespace gr
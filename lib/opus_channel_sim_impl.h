@@ -0,0 +1,84 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_CHANNEL_SIM_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_CHANNEL_SIM_IMPL_H
+
+#include <gnuradio/gr_opus/opus_channel_sim.h>
+#include "channel_model.h"
+#include "packet_framer.h"
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_channel_sim_impl : public opus_channel_sim
+{
+private:
+    // A packet waiting in d_queue, and how many were lost just before it.
+    struct queued_packet {
+        size_t len;
+        long lost;
+    };
+
+    packet_framer d_framer;
+    mutable std::mutex d_params_mutex;
+    channel_model::params d_params;
+    channel_model d_model;
+
+    std::vector<unsigned char> d_queue;
+    size_t d_queue_read;
+    std::deque<queued_packet> d_queued;
+    size_t d_emitted; // bytes of the front packet already emitted
+
+    void enqueue(const unsigned char* packet, size_t len, long lost);
+    int emit(unsigned char* out, int noutput_items);
+
+public:
+    opus_channel_sim_impl(long seed, int packet_size);
+    ~opus_channel_sim_impl();
+
+    void set_burst_loss(double p_good_to_bad, double p_bad_to_good, double loss_good, double loss_bad) override;
+    void set_jitter(double jitter_ms, double playout_delay_ms) override;
+    void set_reordering(double probability) override;
+    void set_duplication(double probability) override;
+    void set_bit_error_rate(double ber) override;
+
+    long packets_in() const override { return d_model.packets_in(); }
+    long packets_delivered() const override { return d_model.packets_delivered(); }
+    long packets_lost() const override { return d_model.packets_lost(); }
+    long packets_late() const override { return d_model.packets_late(); }
+    long packets_reordered() const override { return d_model.packets_reordered(); }
+    long packets_duplicated() const override { return d_model.packets_duplicated(); }
+    long bits_flipped() const override { return d_model.bits_flipped(); }
+
+    void forecast(int noutput_items, gr_vector_int& ninput_items_required) override;
+    int general_work(int noutput_items,
+                     gr_vector_int& ninput_items,
+                     gr_vector_const_void_star& input_items,
+                     gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_CHANNEL_SIM_IMPL_H */
@@ -0,0 +1,156 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "opus_custom_engine.h"
+#include <stdexcept>
+#include <string>
+
+#ifdef OPUS_HAVE_CUSTOM
+#include <opus/opus_custom.h>
+#endif
+
+namespace gr {
+namespace gr_opus {
+
+#ifndef OPUS_HAVE_CUSTOM
+namespace {
+void custom_unavailable()
+{
+    throw std::runtime_error("Opus Custom mode not available: libopus was built without --enable-custom-modes");
+}
+} // namespace
+#endif
+
+custom_encoder_engine::custom_encoder_engine() : d_mode(nullptr), d_state(nullptr), d_frame_size(0) {}
+
+custom_encoder_engine::~custom_encoder_engine() { destroy(); }
+
+void custom_encoder_engine::create(int sample_rate, int channels, int frame_size)
+{
+    destroy();
+#ifdef OPUS_HAVE_CUSTOM
+    int error;
+    d_mode = opus_custom_mode_create(sample_rate, frame_size, &error);
+    if (error != OPUS_OK || d_mode == nullptr) {
+        d_mode = nullptr;
+        throw std::runtime_error("Failed to create Opus Custom mode: " + std::string(opus_strerror(error)));
+    }
+    d_state = opus_custom_encoder_create(d_mode, channels, &error);
+    if (error != OPUS_OK || d_state == nullptr) {
+        d_state = nullptr;
+        destroy();
+        throw std::runtime_error("Failed to create Opus Custom encoder: " + std::string(opus_strerror(error)));
+    }
+    d_frame_size = frame_size;
+#else
+    (void)sample_rate;
+    (void)channels;
+    (void)frame_size;
+    custom_unavailable();
+#endif
+}
+
+void custom_encoder_engine::destroy()
+{
+#ifdef OPUS_HAVE_CUSTOM
+    if (d_state != nullptr) {
+        opus_custom_encoder_destroy(d_state);
+        d_state = nullptr;
+    }
+    if (d_mode != nullptr) {
+        opus_custom_mode_destroy(d_mode);
+        d_mode = nullptr;
+    }
+#endif
+}
+
+int custom_encoder_engine::encode(const opus_int16* pcm, unsigned char* packet, int packet_bytes)
+{
+#ifdef OPUS_HAVE_CUSTOM
+    return opus_custom_encode(d_state, pcm, d_frame_size, packet, packet_bytes);
+#else
+    (void)pcm;
+    (void)packet;
+    (void)packet_bytes;
+    return OPUS_UNIMPLEMENTED;
+#endif
+}
+
+custom_decoder_engine::custom_decoder_engine() : d_mode(nullptr), d_state(nullptr), d_frame_size(0) {}
+
+custom_decoder_engine::~custom_decoder_engine() { destroy(); }
+
+void custom_decoder_engine::create(int sample_rate, int channels, int frame_size)
+{
+    destroy();
+#ifdef OPUS_HAVE_CUSTOM
+    int error;
+    d_mode = opus_custom_mode_create(sample_rate, frame_size, &error);
+    if (error != OPUS_OK || d_mode == nullptr) {
+        d_mode = nullptr;
+        throw std::runtime_error("Failed to create Opus Custom mode: " + std::string(opus_strerror(error)));
+    }
+    d_state = opus_custom_decoder_create(d_mode, channels, &error);
+    if (error != OPUS_OK || d_state == nullptr) {
+        d_state = nullptr;
+        destroy();
+        throw std::runtime_error("Failed to create Opus Custom decoder: " + std::string(opus_strerror(error)));
+    }
+    d_frame_size = frame_size;
+#else
+    (void)sample_rate;
+    (void)channels;
+    (void)frame_size;
+    custom_unavailable();
+#endif
+}
+
+void custom_decoder_engine::destroy()
+{
+#ifdef OPUS_HAVE_CUSTOM
+    if (d_state != nullptr) {
+        opus_custom_decoder_destroy(d_state);
+        d_state = nullptr;
+    }
+    if (d_mode != nullptr) {
+        opus_custom_mode_destroy(d_mode);
+        d_mode = nullptr;
+    }
+#endif
+}
+
+int custom_decoder_engine::decode(const unsigned char* packet, int len, opus_int16* pcm)
+{
+#ifdef OPUS_HAVE_CUSTOM
+    return opus_custom_decode(d_state, packet, len, pcm, d_frame_size);
+#else
+    (void)packet;
+    (void)len;
+    (void)pcm;
+    return OPUS_UNIMPLEMENTED;
+#endif
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,96 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_CUSTOM_ENGINE_H
+#define INCLUDED_GR_OPUS_OPUS_CUSTOM_ENGINE_H
+
+#include <opus/opus.h>
+
+// Opaque libopus types. <opus/opus_custom.h> is only included by the engine
+// itself, and only with OPUS_HAVE_CUSTOM: some distributions do not ship it.
+typedef struct OpusCustomMode OpusCustomMode;
+typedef struct OpusCustomEncoder OpusCustomEncoder;
+typedef struct OpusCustomDecoder OpusCustomDecoder;
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Opus Custom (CELT-only) codec state. Unlike standard Opus it runs at any
+ * sample rate from 8 to 96 kHz with any even frame size of 40..1024 samples
+ * (at least 1 ms), at the cost of a non-standard bitstream. Custom mode is
+ * always constant bitrate: every packet is exactly the size passed to
+ * encode(). Without OPUS_HAVE_CUSTOM, create() throws.
+ */
+class custom_encoder_engine
+{
+public:
+    custom_encoder_engine();
+    ~custom_encoder_engine();
+
+    // (Re)creates the mode and encoder state; throws std::runtime_error.
+    void create(int sample_rate, int channels, int frame_size);
+    void destroy();
+    bool ready() const { return d_state != nullptr; }
+
+    int encode(const opus_int16* pcm, unsigned char* packet, int packet_bytes);
+
+private:
+    custom_encoder_engine(const custom_encoder_engine&) = delete;
+    custom_encoder_engine& operator=(const custom_encoder_engine&) = delete;
+
+    OpusCustomMode* d_mode;
+    OpusCustomEncoder* d_state;
+    int d_frame_size;
+};
+
+class custom_decoder_engine
+{
+public:
+    custom_decoder_engine();
+    ~custom_decoder_engine();
+
+    // (Re)creates the mode and decoder state; throws std::runtime_error.
+    void create(int sample_rate, int channels, int frame_size);
+    void destroy();
+    bool ready() const { return d_state != nullptr; }
+
+    int decode(const unsigned char* packet, int len, opus_int16* pcm);
+
+private:
+    custom_decoder_engine(const custom_decoder_engine&) = delete;
+    custom_decoder_engine& operator=(const custom_decoder_engine&) = delete;
+
+    OpusCustomMode* d_mode;
+    OpusCustomDecoder* d_state;
+    int d_frame_size;
+};
+
+// Bytes per constant-bitrate custom packet for the requested bitrate.
+inline int custom_packet_bytes(int bitrate, int sample_rate, int frame_size)
+{
+    long long bytes = static_cast<long long>(bitrate) * frame_size / (8LL * sample_rate);
+    return static_cast<int>(bytes < 2 ? 2 : (bytes > 1275 ? 1275 : bytes));
+}
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_CUSTOM_ENGINE_H */
@@ -24,85 +24,246 @@
 
 #include <gnuradio/io_signature.h>
 #include "opus_decoder_impl.h"
+#include "codec_format.h"
+#include "upstream_done.h"
 #include <stdexcept>
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <set>
-#include <fstream>
 #include <vector>
 
 namespace gr {
 namespace gr_opus {
 
+namespace {
+
+// Audio bandwidth of an OPUS_BANDWIDTH_* value, 0 if unknown.
+int audio_bandwidth_hz(int bandwidth)
+{
+    switch (bandwidth) {
+    case OPUS_BANDWIDTH_NARROWBAND:
+        return 4000;
+    case OPUS_BANDWIDTH_MEDIUMBAND:
+        return 6000;
+    case OPUS_BANDWIDTH_WIDEBAND:
+        return 8000;
+    case OPUS_BANDWIDTH_SUPERWIDEBAND:
+        return 12000;
+    case OPUS_BANDWIDTH_FULLBAND:
+        return 20000;
+    default:
+        return 0;
+    }
+}
+
+// TOC bits that stay fixed across a constant-size stream: configuration
+// (mode, bandwidth, frame duration) and the stereo flag.
+const unsigned char toc_stream_mask = 0xFC;
+
+// True if packets of len bytes line up with data: the next two slices, as
+// far as buffered, begin with the same TOC stream bits as the first.
+bool framed_at(const unsigned char* data, int avail, int len)
+{
+    for (int k = 1; k <= 2 && k * len < avail; ++k) {
+        if ((data[k * len] & toc_stream_mask) != (data[0] & toc_stream_mask)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 opus_decoder::sptr
-opus_decoder::make(int sample_rate, int channels, int packet_size, const std::string& dnn_blob_path)
+opus_decoder::make(int sample_rate, int channels, int packet_size, const std::string& dnn_blob_path, bool defer_init)
 {
-    return gnuradio::get_initial_sptr(new opus_decoder_impl(sample_rate, channels, packet_size, dnn_blob_path));
+    return gnuradio::get_initial_sptr(new opus_decoder_impl(sample_rate, channels, packet_size, dnn_blob_path, defer_init));
 }
 
-opus_decoder_impl::opus_decoder_impl(int sample_rate, int channels, int packet_size, const std::string& dnn_blob_path)
-    : gr::sync_block("opus_decoder",
-                     gr::io_signature::make(1, 1, sizeof(unsigned char)),
-                     gr::io_signature::make(1, 1, sizeof(float))),
+opus_decoder::sptr
+opus_decoder::make_custom(int sample_rate, int channels, int frame_size, int packet_size)
+{
+    check_custom_format(sample_rate, channels, frame_size);
+    if (packet_size <= 0) {
+        throw std::runtime_error("Opus Custom decoding needs a fixed packet_size");
+    }
+    return gnuradio::get_initial_sptr(new opus_decoder_impl(sample_rate, channels, packet_size, "", false, frame_size));
+}
+
+opus_decoder_impl::opus_decoder_impl(int sample_rate, int channels, int packet_size, const std::string& dnn_blob_path, bool defer_init, int custom_frame_size)
+    : gr::block("opus_decoder",
+                gr::io_signature::make(1, 1, sizeof(unsigned char)),
+                gr::io_signature::make(1, 1, sizeof(float))),
+      d_decoder(nullptr),
+      d_decoder_mem(nullptr),
+      d_custom_frame_size(custom_frame_size),
       d_sample_rate(sample_rate),
       d_channels(channels),
       d_packet_size(packet_size),
-      d_frame_size(static_cast<int>(sample_rate * 0.020)),
-      d_max_buffer_size(1024 * 1024)
+      d_frame_size(custom_frame_size > 0 ? custom_frame_size : static_cast<int>(sample_rate * 0.020)),
+      d_dnn_blob_path(dnn_blob_path),
+      d_max_buffer_size(1024 * 1024),
+      d_overload_policy(overload_policy_t::DROP_OLDEST),
+      d_skip_bytes(0),
+      d_packets_shed(0),
+      d_bytes_shed(0),
+      d_backpressure_events(0),
+      d_decoded_pcm(d_frame_size * channels),
+      d_stream_channels(0),
+      d_stream_bandwidth(0),
+      d_complexity(-1),
+      d_effective_complexity(-1),
+      d_applied_complexity(-1),
+      d_default_complexity(0),
+      d_complexity_supported(true),
+      d_governor_enabled(false),
+      d_governor_max_load(0.5),
+      d_decode_ns(0),
+      d_timed_frames(0),
+      d_decode_load(0.0),
+      d_governor_hold(0),
+      d_governor_steps_down(0),
+      d_governor_steps_up(0),
+      d_load_channel(register_load_channel()),
+      d_packets_muted(0),
+      d_bytes_muted(0),
+      d_locked_packet_size(0),
+      d_lock_candidate(0),
+      d_lock_streak(0),
+      d_lock_toc(0),
+      d_lock_ins(0),
+      d_lock_losses(0),
+      d_trial_decodes(0),
+      d_tag_framing(false),
+      d_applied_tag_framing(false),
+      d_buffer_offset(0),
+      d_lost_pending(0),
+      d_loss_recovery(loss_recovery_t::PLC),
+      d_packets_lost(0),
+      d_frames_concealed(0),
+      d_frames_fec_recovered(0),
+      d_frames_dred_recovered(0)
 #ifdef OPUS_HAVE_DRED
       , d_dred_decoder(nullptr)
       , d_dred(nullptr)
       , d_lost_count(0)
+      , d_dred_pcm(d_frame_size * channels)
 #endif
+      , d_slot_head(0)
+      , d_slot_count(0)
+      , d_pool_requested(false)
+      , d_pool_depth_requested(4)
+      , d_use_pool(false)
+      , d_batcher(true)
+      , d_frame_out(6 * d_frame_size * channels)
+      , d_max_frames_per_work(0)
+      , d_min_frames_per_emit(1)
+      , d_telemetry_interval(50)
+      , d_realtime(false)
+      , d_realtime_priority(0)
+      , d_rt_pending(false)
+      , d_applied_rt_priority(0)
+      , d_pool_rt_priority(0)
+      , d_memory_locked(false)
+      , d_locked_bytes(0)
+      , d_work_minor_faults(0)
+      , d_work_major_faults(0)
+      , d_frames_decoded(0)
+      , d_decode_errors(0)
+      , d_pool_errors(0)
+      , d_samples_emitted(0)
+      , d_work_calls(0)
+      , d_emit_calls(0)
+      , d_interval_frames(0)
+      , d_interval_work_calls(0)
+      , d_interval_emit_calls(0)
+      , d_format_pending(false)
+      , d_pending_sample_rate(sample_rate)
+      , d_pending_channels(channels)
+      , d_format_changes(0)
 {
-    int error;
+    message_port_register_out(pmt::mp("telemetry"));
+    message_port_register_in(pmt::mp("reconfig"));
+    set_msg_handler(pmt::mp("reconfig"), [this](const pmt::pmt_t& msg) { handle_reconfig(msg); });
 
-    d_decoder = opus_decoder_create(sample_rate, channels, &error);
-    if (error != OPUS_OK || d_decoder == nullptr) {
-        throw std::runtime_error("Failed to create Opus decoder: " + std::string(opus_strerror(error)));
+    if (defer_init) {
+        d_init_strand = codec_thread_pool::instance().make_strand(1);
+        d_init_strand->try_submit([this] {
+            try {
+                create_codec();
+            } catch (...) {
+                d_init_error = std::current_exception();
+            }
+        });
+    } else {
+        create_codec();
+    }
+}
+
+opus_decoder_impl::~opus_decoder_impl()
+{
+    if (d_init_strand) {
+        d_init_strand->wait_idle();
+    }
+    if (d_strand) {
+        d_strand->wait_idle();
+    }
+    d_locked.unlock_all();
+    if (d_pool_rt_priority > 0) {
+        codec_thread_pool::instance().release_realtime(d_pool_rt_priority);
+    }
+    destroy_codec();
+}
+
+void opus_decoder_impl::create_codec()
+{
+    if (d_custom_frame_size > 0) {
+        init_codec();
+        return;
+    }
+
+    int size = std::max(opus_decoder_get_size(1), opus_decoder_get_size(2));
+    d_decoder_mem = std::malloc(size);
+    if (d_decoder_mem == nullptr) {
+        throw std::runtime_error("Failed to allocate Opus decoder state");
+    }
+    d_decoder = static_cast<OpusDecoder*>(d_decoder_mem);
+    if (d_packet_size <= 0) {
+        d_state_snapshot.resize(size);
     }
 
+    try {
 #ifdef OPUS_HAVE_DNN_BLOB
-    std::vector<char> blob;
-    if (!dnn_blob_path.empty()) {
-        std::ifstream f(dnn_blob_path, std::ios::binary | std::ios::ate);
-        if (!f) {
-            opus_decoder_destroy(d_decoder);
-            throw std::runtime_error("Failed to open DNN blob file: " + dnn_blob_path);
-        }
-        blob.resize(f.tellg());
-        f.seekg(0);
-        if (!f.read(blob.data(), blob.size())) {
-            opus_decoder_destroy(d_decoder);
-            throw std::runtime_error("Failed to read DNN blob file: " + dnn_blob_path);
-        }
-        error = opus_decoder_ctl(d_decoder, OPUS_SET_DNN_BLOB(blob.data(), static_cast<int>(blob.size())));
-        if (error != OPUS_OK) {
-            opus_decoder_destroy(d_decoder);
-            throw std::runtime_error("Failed to set Opus DNN blob (FARGAN): " + std::string(opus_strerror(error)));
+        if (!d_dnn_blob_path.empty()) {
+            d_dnn_blob = load_dnn_blob(d_dnn_blob_path);
         }
-    }
 #endif
+        init_codec();
+    } catch (...) {
+        destroy_codec();
+        throw;
+    }
 
 #ifdef OPUS_HAVE_DRED
+    int error;
     d_dred_decoder = opus_dred_decoder_create(&error);
     if (error != OPUS_OK || d_dred_decoder == nullptr) {
-        opus_decoder_destroy(d_decoder);
+        d_dred_decoder = nullptr;
+        destroy_codec();
         throw std::runtime_error("Failed to create Opus DRED decoder: " + std::string(opus_strerror(error)));
     }
     d_dred = opus_dred_alloc(&error);
     if (error != OPUS_OK || d_dred == nullptr) {
-        opus_dred_decoder_destroy(d_dred_decoder);
-        opus_decoder_destroy(d_decoder);
+        d_dred = nullptr;
+        destroy_codec();
         throw std::runtime_error("Failed to alloc Opus DRED state: " + std::string(opus_strerror(error)));
     }
 #ifdef OPUS_HAVE_DNN_BLOB
-    if (!dnn_blob_path.empty() && !blob.empty()) {
-        error = opus_dred_decoder_ctl(d_dred_decoder, OPUS_SET_DNN_BLOB(blob.data(), static_cast<int>(blob.size())));
+    if (d_dnn_blob && !d_dnn_blob->empty()) {
+        error = opus_dred_decoder_ctl(d_dred_decoder, OPUS_SET_DNN_BLOB(d_dnn_blob->data(), static_cast<int>(d_dnn_blob->size())));
         if (error != OPUS_OK) {
-            opus_dred_free(d_dred);
-            opus_dred_decoder_destroy(d_dred_decoder);
-            opus_decoder_destroy(d_decoder);
+            destroy_codec();
             throw std::runtime_error("Failed to set DRED DNN blob: " + std::string(opus_strerror(error)));
         }
     }
@@ -110,8 +271,39 @@ opus_decoder_impl::opus_decoder_impl(int sample_rate, int channels, int packet_s
 #endif
 }
 
-opus_decoder_impl::~opus_decoder_impl()
+void opus_decoder_impl::init_codec()
+{
+    d_post.reset(d_sample_rate * d_channels);
+    if (d_custom_frame_size > 0) {
+        d_custom.create(d_sample_rate, d_channels, d_custom_frame_size);
+        return;
+    }
+
+    int error = opus_decoder_init(d_decoder, d_sample_rate, d_channels);
+    if (error != OPUS_OK) {
+        throw std::runtime_error("Failed to create Opus decoder: " + std::string(opus_strerror(error)));
+    }
+
+#ifdef OPUS_HAVE_DNN_BLOB
+    if (d_dnn_blob) {
+        error = opus_decoder_ctl(d_decoder, OPUS_SET_DNN_BLOB(d_dnn_blob->data(), static_cast<int>(d_dnn_blob->size())));
+        if (error != OPUS_OK) {
+            throw std::runtime_error("Failed to set Opus DNN blob (FARGAN): " + std::string(opus_strerror(error)));
+        }
+    }
+#endif
+
+    // Fresh state: libopus default complexity until the next decode re-applies ours.
+    if (opus_decoder_ctl(d_decoder, OPUS_GET_COMPLEXITY(&d_default_complexity)) != OPUS_OK) {
+        d_default_complexity = 0;
+        d_complexity_supported.store(false);
+    }
+    d_applied_complexity = -1;
+}
+
+void opus_decoder_impl::destroy_codec()
 {
+    d_custom.destroy();
 #ifdef OPUS_HAVE_DRED
     if (d_dred != nullptr) {
         opus_dred_free(d_dred);
@@ -122,171 +314,1146 @@ opus_decoder_impl::~opus_decoder_impl()
         d_dred_decoder = nullptr;
     }
 #endif
-    if (d_decoder != nullptr) {
-        opus_decoder_destroy(d_decoder);
-        d_decoder = nullptr;
+    std::free(d_decoder_mem);
+    d_decoder_mem = nullptr;
+    d_decoder = nullptr;
+    d_dnn_blob.reset();
+}
+
+void opus_decoder_impl::wait_codec()
+{
+    if (d_init_strand) {
+        d_init_strand->wait_idle();
+        d_init_strand.reset();
+        if (d_init_error) {
+            std::exception_ptr error = d_init_error;
+            d_init_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+    if (!codec_ready()) {
+        create_codec();
     }
 }
 
-int opus_decoder_impl::work(int noutput_items,
-                            gr_vector_const_void_star& input_items,
-                            gr_vector_void_star& output_items)
+bool opus_decoder_impl::start()
 {
-    const unsigned char* in = (const unsigned char*)input_items[0];
-    float* out = (float*)output_items[0];
+    wait_codec();
+    return true;
+}
+
+void opus_decoder_impl::set_shared_pool(bool enable, int queue_depth)
+{
+    d_pool_depth_requested.store(std::max(1, std::min(64, queue_depth)));
+    d_pool_requested.store(enable);
+}
+
+void opus_decoder_impl::set_max_frames_per_work(int frames)
+{
+    d_max_frames_per_work.store(std::max(0, frames));
+}
+
+void opus_decoder_impl::set_min_frames_per_emit(int frames)
+{
+    d_min_frames_per_emit.store(std::max(1, frames));
+}
+
+void opus_decoder_impl::set_telemetry_interval(int frames)
+{
+    d_telemetry_interval.store(std::max(0, frames));
+}
+
+bool opus_decoder_impl::valid_format(int sample_rate, int channels) const
+{
+    return d_custom_frame_size > 0 ? valid_custom_format(sample_rate, channels, d_custom_frame_size)
+                                   : valid_opus_format(sample_rate, channels);
+}
+
+void opus_decoder_impl::set_format(int sample_rate, int channels)
+{
+    if (d_custom_frame_size > 0) {
+        check_custom_format(sample_rate, channels, d_custom_frame_size);
+    } else {
+        check_opus_format(sample_rate, channels);
+    }
+    std::lock_guard<std::mutex> lock(d_format_mutex);
+    d_pending_sample_rate = sample_rate;
+    d_pending_channels = channels;
+    d_format_pending.store(true);
+}
+
+void opus_decoder_impl::set_overload_policy(const std::string& policy)
+{
+    overload_policy_t parsed = overload_policy_from_string(policy);
+    if (parsed == overload_policy_t::DEGRADE_BITRATE) {
+        throw std::runtime_error("degrade_bitrate only applies to the encoder");
+    }
+    d_overload_policy.store(parsed);
+}
+
+void opus_decoder_impl::set_packet_tags(bool enable)
+{
+    if (enable && d_packet_size > 0) {
+        throw std::runtime_error("Packet tag framing needs packet_size 0");
+    }
+    d_tag_framing.store(enable);
+}
 
-    size_t ninput = noutput_items;
+void opus_decoder_impl::set_loss_recovery(const std::string& mode)
+{
+    loss_recovery_t parsed = loss_recovery_from_string(mode);
+    if (parsed != loss_recovery_t::PLC && d_custom_frame_size > 0) {
+        throw std::runtime_error("Opus Custom decoders only support loss recovery \"plc\"");
+    }
+    d_loss_recovery.store(parsed);
+}
+
+void opus_decoder_impl::set_squelch(bool enable, double threshold_dbfs, int hang_ms)
+{
+    d_post.set_squelch(enable, threshold_dbfs, hang_ms);
+}
+
+void opus_decoder_impl::set_realtime(bool enable, int priority)
+{
+    if (priority < 0 || priority > 99) {
+        throw std::runtime_error("Real-time priority must be 0-99");
+    }
+    d_realtime_priority.store(priority);
+    d_realtime.store(enable);
+    d_rt_pending.store(true);
+}
+
+void opus_decoder_impl::apply_realtime()
+{
+    d_rt_pending.store(false);
+    const bool enable = d_realtime.load();
+    const int priority = enable ? d_realtime_priority.load() : 0;
+    if (priority != d_applied_rt_priority && set_thread_realtime(priority)) {
+        d_applied_rt_priority = priority;
+    }
+    const int pool_priority = d_pool_requested.load() && d_packet_size > 0 ? priority : 0;
+    if (pool_priority != d_pool_rt_priority) {
+        codec_thread_pool& pool = codec_thread_pool::instance();
+        if (d_pool_rt_priority > 0) {
+            pool.release_realtime(d_pool_rt_priority);
+        }
+        if (pool_priority > 0) {
+            pool.set_realtime(pool_priority);
+        }
+        d_pool_rt_priority = pool_priority;
+    }
+    d_locked.unlock_all();
+    d_memory_locked = false;
+    d_locked_bytes = 0;
+    if (!enable) {
+        return;
+    }
+
+    // The backlog can overshoot its limit by one input chunk before
+    // shedding, and staged output holds a few batches of frames.
+    const size_t input_slack = 65536;
+    bool locked = d_locked.reserve(d_packet_buffer, d_max_buffer_size + input_slack);
+    locked &= d_batcher.lock_storage(std::max<size_t>(65536, 8 * d_frame_out.size()), d_locked);
+    locked &= d_locked.reserve(d_frame_out, d_frame_out.size());
+    locked &= d_locked.reserve(d_decoded_pcm, d_decoded_pcm.size());
+    locked &= d_locked.reserve(d_state_snapshot, d_state_snapshot.size());
+#ifdef OPUS_HAVE_DRED
+    locked &= d_locked.reserve(d_dred_pcm, d_dred_pcm.size());
+#endif
+    if (d_decoder_mem != nullptr) {
+        locked &= d_locked.lock(d_decoder_mem,
+                                static_cast<size_t>(std::max(opus_decoder_get_size(1), opus_decoder_get_size(2))));
+    }
+    for (auto& slot : d_slots) {
+        locked &= d_locked.lock(slot.get(), sizeof(pool_slot));
+        locked &= d_locked.reserve(slot->packet, slot->packet.size());
+        locked &= d_locked.reserve(slot->pcm, slot->pcm.size());
+    }
+    prefault_stack();
+    d_memory_locked = locked;
+    d_locked_bytes = d_locked.bytes();
+}
+
+void opus_decoder_impl::set_load_priority(const std::string& priority)
+{
+    d_load_channel->set_priority(load_priority_from_string(priority));
+}
+
+void opus_decoder_impl::set_complexity(int complexity)
+{
+    if (complexity < -1 || complexity > 10) {
+        throw std::runtime_error("Decoder complexity must be -1 (libopus default) or 0-10");
+    }
+    if (complexity >= 0 && d_custom_frame_size > 0) {
+        throw std::runtime_error("Decoder complexity is not available in Opus Custom mode");
+    }
+    d_complexity.store(complexity);
+    d_effective_complexity.store(complexity);
+}
+
+void opus_decoder_impl::set_complexity_governor(bool enable, double max_load)
+{
+    if (max_load <= 0.0) {
+        throw std::runtime_error("Governor max_load must be positive");
+    }
+    d_governor_max_load.store(max_load);
+    d_governor_enabled.store(enable);
+    if (!enable) {
+        d_effective_complexity.store(d_complexity.load());
+        d_decode_load.store(0.0);
+    }
+    d_decode_ns.store(0);
+    d_timed_frames.store(0);
+}
+
+void opus_decoder_impl::handle_reconfig(const pmt::pmt_t& msg)
+{
+    int sample_rate, channels;
+    {
+        std::lock_guard<std::mutex> lock(d_format_mutex);
+        sample_rate = d_pending_sample_rate;
+        channels = d_pending_channels;
+    }
+    // Malformed requests are dropped rather than taking down the flowgraph.
+    if (parse_format_msg(msg, sample_rate, channels) && valid_format(sample_rate, channels)) {
+        set_format(sample_rate, channels);
+    }
+}
+
+void opus_decoder_impl::apply_format(int output_idx)
+{
+    // Wait for in-flight pool packets; they were decoded with the old state.
+    if (d_slot_count > 0) {
+        return;
+    }
+
+    int sample_rate, channels;
+    {
+        std::lock_guard<std::mutex> lock(d_format_mutex);
+        sample_rate = d_pending_sample_rate;
+        channels = d_pending_channels;
+        d_format_pending.store(false);
+    }
+    if (sample_rate == d_sample_rate && channels == d_channels) {
+        return;
+    }
+
+    // Frames already decoded in the old format go out ahead of the tag.
+    d_batcher.release_all();
 
-    d_packet_buffer.insert(d_packet_buffer.end(), in, in + ninput);
+    // Buffers are resized and the slots freed below; apply_realtime relocks.
+    d_locked.unlock_all();
+    d_sample_rate = sample_rate;
+    d_channels = channels;
+    if (d_custom_frame_size == 0) {
+        d_frame_size = static_cast<int>(sample_rate * 0.020);
+    }
+    d_decoded_pcm.resize(d_frame_size * channels);
+    d_frame_out.resize(6 * d_frame_size * channels);
+#ifdef OPUS_HAVE_DRED
+    d_dred_pcm.resize(d_frame_size * channels);
+    d_lost_count = 0;
+#endif
+    init_codec();
+    reset_lock();
+
+    // Pool slots are sized per frame; rebuild them on the next work() call.
+    d_slots.clear();
+    d_slot_head = 0;
+    d_strand.reset();
+    d_use_pool = false;
+
+    d_rt_pending.store(true);
+    d_format_changes++;
+    d_format_tags.emplace_back(nitems_written(0) + output_idx + d_batcher.staged_items(),
+                               format_tag_value(sample_rate, channels));
+}
+
+void opus_decoder_impl::flush_format_tags(int produced)
+{
+    uint64_t end = nitems_written(0) + produced;
+    while (!d_format_tags.empty() && d_format_tags.front().first < end) {
+        add_item_tag(0, d_format_tags.front().first, pmt::mp("opus_format"), d_format_tags.front().second);
+        d_format_tags.pop_front();
+    }
+}
+
+bool opus_decoder_impl::stop()
+{
+    if (d_strand) {
+        d_strand->wait_idle();
+    }
+    return true;
+}
+
+size_t opus_decoder_impl::accept_input(const unsigned char* in, size_t ninput)
+{
+    overload_policy_t policy = d_overload_policy.load();
+
+    if (policy == overload_policy_t::BACKPRESSURE) {
+        size_t room = d_packet_buffer.size() < d_max_buffer_size ? d_max_buffer_size - d_packet_buffer.size() : 0;
+        size_t take = std::min(ninput, room);
+        if (take < ninput) {
+            d_backpressure_events++;
+        }
+        d_packet_buffer.insert(d_packet_buffer.end(), in, in + take);
+        return take;
+    }
+
+    // Finish discarding a packet that drop_newest cut short last time.
+    size_t skip = std::min(d_skip_bytes, ninput);
+    d_skip_bytes -= skip;
+    d_bytes_shed += skip;
+
+    if (d_packet_buffer.size() + ninput - skip <= d_max_buffer_size) {
+        d_packet_buffer.insert(d_packet_buffer.end(), in + skip, in + ninput);
+        return ninput;
+    }
+
+    if (d_packet_size <= 0) {
+        // No framing: drop a whole side so no packet is spliced mid-way.
+        if (policy == overload_policy_t::DROP_NEWEST) {
+            d_bytes_shed += ninput - skip;
+        } else {
+            d_bytes_shed += d_packet_buffer.size();
+            d_packet_buffer.assign(in + skip, in + ninput);
+        }
+        return ninput;
+    }
 
-    if (d_packet_buffer.size() > d_max_buffer_size) {
+    // The buffer always starts on a packet boundary; drop whole packets.
+    const size_t packet = static_cast<size_t>(d_packet_size);
+    d_packet_buffer.insert(d_packet_buffer.end(), in + skip, in + ninput);
+    if (policy == overload_policy_t::DROP_NEWEST) {
+        size_t keep = d_max_buffer_size / packet * packet;
+        size_t partial = d_packet_buffer.size() % packet;
+        size_t drop = d_packet_buffer.size() - keep;
+        d_packet_buffer.resize(keep);
+        d_packets_shed += (drop + packet - 1) / packet;
+        d_bytes_shed += drop;
+        if (partial > 0) {
+            d_skip_bytes = packet - partial;
+        }
+    } else {
         size_t excess = d_packet_buffer.size() - d_max_buffer_size;
-        d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + excess);
+        size_t drop = (excess + packet - 1) / packet * packet;
+        drop = std::min(drop, d_packet_buffer.size() / packet * packet);
+        d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + drop);
+        d_packets_shed += drop / packet;
+        d_bytes_shed += drop;
+    }
+    return ninput;
+}
+
+int opus_decoder_impl::recover_lost(const unsigned char* packet, int len, int lost, float* out, int max_samples)
+{
+    loss_recovery_t mode = d_loss_recovery.load();
+    if (d_custom_frame_size > 0 || d_load_channel->level() >= SHED_MINIMAL) {
+        mode = loss_recovery_t::PLC;
+    }
+
+    // Frames immediately before the packet that its redundancy can rebuild;
+    // anything older is concealed.
+    int recoverable = 0;
+    if (mode == loss_recovery_t::FEC) {
+        recoverable = 1;
+    }
+#ifdef OPUS_HAVE_DRED
+    if (mode == loss_recovery_t::DRED) {
+        int dred_end = 0;
+        int dred_amount = opus_dred_parse(d_dred_decoder, d_dred, packet, len,
+            lost * d_frame_size, d_sample_rate, &dred_end, 0);
+        recoverable = dred_amount > 0 ? dred_amount / d_frame_size : 0;
+    }
+#endif
+
+    int output_idx = 0;
+    for (int back = lost; back > 0 && output_idx + d_frame_size * d_channels <= max_samples; --back) {
+        int samples = -1;
+        if (back <= recoverable && mode == loss_recovery_t::FEC) {
+            samples = opus_decode(d_decoder, packet, len, d_decoded_pcm.data(), d_frame_size, 1);
+            if (samples > 0) {
+                d_frames_fec_recovered++;
+            }
+        }
+#ifdef OPUS_HAVE_DRED
+        if (back <= recoverable && mode == loss_recovery_t::DRED) {
+            samples = opus_decoder_dred_decode_float(d_decoder, d_dred, back * d_frame_size,
+                d_dred_pcm.data(), d_frame_size);
+            if (samples > 0) {
+                d_post.process(d_dred_pcm.data(), out + output_idx, samples * d_channels);
+                output_idx += samples * d_channels;
+                d_frames_dred_recovered++;
+                continue;
+            }
+        }
+#endif
+        if (samples <= 0) {
+            samples = d_custom_frame_size > 0
+                ? d_custom.decode(nullptr, 0, d_decoded_pcm.data())
+                : opus_decode(d_decoder, nullptr, 0, d_decoded_pcm.data(), d_frame_size, 0);
+            if (samples <= 0) {
+                continue;
+            }
+            d_frames_concealed++;
+        }
+        d_post.process(d_decoded_pcm.data(), out + output_idx, samples * d_channels);
+        output_idx += samples * d_channels;
     }
+    return output_idx;
+}
 
+int opus_decoder_impl::decode_packet(const unsigned char* packet, int len, float* out, int max_samples, int lost)
+{
     int output_idx = 0;
-    std::vector<opus_int16> decoded_pcm(d_frame_size * d_channels);
-    std::vector<float> dred_pcm(d_frame_size * d_channels);
+    apply_complexity();
+    const auto decode_start = std::chrono::steady_clock::now();
 
-    if (d_packet_size > 0) {
-        while (d_packet_buffer.size() >= static_cast<size_t>(d_packet_size) && output_idx < noutput_items) {
-            std::vector<unsigned char> packet(
-                d_packet_buffer.begin(),
-                d_packet_buffer.begin() + d_packet_size
-            );
-            d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + d_packet_size);
+    if (lost > 0) {
+        output_idx = recover_lost(packet, len, lost, out, max_samples);
+    }
 
 #ifdef OPUS_HAVE_DRED
-            if (d_lost_count > 0) {
-                int dred_end = 0;
-                int dred_amount = opus_dred_parse(d_dred_decoder, d_dred, packet.data(), d_packet_size,
-                    d_lost_count * d_frame_size, d_sample_rate, &dred_end, 0);
-                if (dred_amount > 0) {
-                    for (int fr = 0; fr < d_lost_count && output_idx < noutput_items; ++fr) {
-                        int dred_offset = (d_lost_count - fr) * d_frame_size;
-                        int samples = opus_decoder_dred_decode_float(d_decoder, d_dred, dred_offset,
-                            dred_pcm.data(), d_frame_size);
-                        if (samples > 0) {
-                            int to_write = std::min(samples * d_channels, noutput_items - output_idx);
-                            for (int i = 0; i < to_write; ++i) {
-                                out[output_idx + i] = std::max(-1.0f, std::min(1.0f, dred_pcm[i]));
-                            }
-                            output_idx += to_write;
-                        }
-                    }
+    if (d_lost_count > 0 && d_load_channel->level() >= SHED_MINIMAL) {
+        d_lost_count = 0;
+    }
+    if (d_lost_count > 0 && d_custom_frame_size == 0) {
+        int dred_end = 0;
+        int dred_amount = opus_dred_parse(d_dred_decoder, d_dred, packet, len,
+            d_lost_count * d_frame_size, d_sample_rate, &dred_end, 0);
+        if (dred_amount > 0) {
+            for (int fr = 0; fr < d_lost_count && output_idx < max_samples; ++fr) {
+                int dred_offset = (d_lost_count - fr) * d_frame_size;
+                int samples = opus_decoder_dred_decode_float(d_decoder, d_dred, dred_offset,
+                    d_dred_pcm.data(), d_frame_size);
+                if (samples > 0) {
+                    int to_write = std::min(samples * d_channels, max_samples - output_idx);
+                    d_post.process(d_dred_pcm.data(), out + output_idx, to_write);
+                    output_idx += to_write;
                 }
-                d_lost_count = 0;
             }
+        }
+        d_lost_count = 0;
+    }
 #endif
 
-            int decoded_samples = opus_decode(d_decoder,
-                                               packet.data(),
-                                               d_packet_size,
-                                               decoded_pcm.data(),
-                                               d_frame_size,
-                                               0);
+    int decoded_samples = d_custom_frame_size > 0
+        ? d_custom.decode(packet, len, d_decoded_pcm.data())
+        : opus_decode(d_decoder, packet, len, d_decoded_pcm.data(), d_frame_size, 0);
+    time_decode(decode_start);
 
-            if (decoded_samples < 0) {
+    if (decoded_samples < 0) {
+        d_decode_errors++;
 #ifdef OPUS_HAVE_DRED
-                d_lost_count++;
+        d_lost_count++;
 #endif
+        return output_idx;
+    }
+
+    d_frames_decoded++;
+    note_stream_format(packet);
+
+    int samples_to_write = decoded_samples * d_channels;
+    samples_to_write = std::min(samples_to_write, max_samples - output_idx);
+
+    d_post.process(d_decoded_pcm.data(), out + output_idx, samples_to_write);
+
+    return output_idx + samples_to_write;
+}
+
+void opus_decoder_impl::apply_tag_framing()
+{
+    // Switching framing mid-stream drops what was buffered for the old one.
+    d_applied_tag_framing = d_tag_framing.load();
+    d_bytes_shed += d_packet_buffer.size();
+    d_packet_buffer.clear();
+    d_tagged_packets.clear();
+    d_lost_pending = 0;
+    d_buffer_offset = nitems_read(0);
+    reset_lock();
+}
+
+int opus_decoder_impl::decode_tagged(const unsigned char* in, int ninput, float* out, int noutput_items, int max_frames, int& frames)
+{
+    // Longest run of lost frames rebuilt ahead of one packet (1 s).
+    const int max_recovered_frames = 50;
+
+    size_t room = d_packet_buffer.size() < d_max_buffer_size ? d_max_buffer_size - d_packet_buffer.size() : 0;
+    size_t take = std::min(static_cast<size_t>(ninput), room);
+    if (take < static_cast<size_t>(ninput)) {
+        d_backpressure_events++;
+    }
+    if (take > 0) {
+        const uint64_t first = nitems_read(0);
+        std::vector<gr::tag_t> tags;
+        get_tags_in_range(tags, 0, first, first + take);
+        std::sort(tags.begin(), tags.end(), gr::tag_t::offset_compare);
+        for (const gr::tag_t& tag : tags) {
+            if (!pmt::is_integer(tag.value)) {
                 continue;
             }
+            long value = std::max<long>(0, pmt::to_long(tag.value));
+            if (pmt::eqv(tag.key, pmt::mp("packet_lost"))) {
+                d_lost_pending += static_cast<int>(std::min<long>(value, max_recovered_frames));
+                d_packets_lost += value;
+            } else if (pmt::eqv(tag.key, pmt::mp("packet_len"))) {
+                d_tagged_packets.push_back({ tag.offset, static_cast<int>(value), std::min(d_lost_pending, max_recovered_frames) });
+                d_lost_pending = 0;
+            }
+        }
+        d_packet_buffer.insert(d_packet_buffer.end(), in, in + take);
+        consume_each(static_cast<int>(take));
+    }
 
-            int samples_to_write = decoded_samples * d_channels;
-            samples_to_write = std::min(samples_to_write, noutput_items - output_idx);
+    const bool muted = d_load_channel->level() >= SHED_MUTED;
+    const uint64_t buffer_end = d_buffer_offset + d_packet_buffer.size();
+    int output_idx = static_cast<int>(d_batcher.emit(out, noutput_items));
+    uint64_t done = d_buffer_offset;
+
+    while (!d_tagged_packets.empty() && (max_frames <= 0 || frames < max_frames) &&
+           d_batcher.released_units() == 0) {
+        tagged_packet packet = d_tagged_packets.front();
+        // A packet cut short by the next tag ends there.
+        if (d_tagged_packets.size() > 1) {
+            packet.len = static_cast<int>(std::min<uint64_t>(packet.len, d_tagged_packets[1].offset - packet.offset));
+        }
+        if (packet.offset + packet.len > buffer_end) {
+            break;
+        }
+        d_tagged_packets.pop_front();
+        d_bytes_shed += packet.offset - done;
+        done = packet.offset + packet.len;
+        frames++;
+
+        const unsigned char* data = d_packet_buffer.data() + (packet.offset - d_buffer_offset);
+        if (muted) {
+            d_packets_muted++;
+            d_bytes_muted += packet.len;
+            continue;
+        }
+        size_t needed = static_cast<size_t>(packet.lost + 6) * d_frame_size * d_channels;
+        if (d_frame_out.size() < needed) {
+            if (needed > d_frame_out.capacity() && d_locked.bytes() > 0) {
+                // Growing moves the buffer; lock it again on the next call.
+                d_locked.unlock_all();
+                d_rt_pending.store(true);
+            }
+            d_frame_out.resize(needed);
+        }
+        int samples = decode_packet(data, packet.len, d_frame_out.data(), static_cast<int>(d_frame_out.size()), packet.lost);
+        if (samples > 0) {
+            d_batcher.push(d_frame_out.data(), samples);
+            output_idx += d_batcher.emit(out + output_idx, noutput_items - output_idx);
+        }
+    }
+
+    // Bytes no packet_len tag claims are dropped once nothing can still
+    // reach back to them.
+    if (d_tagged_packets.empty()) {
+        d_bytes_shed += buffer_end - done;
+        done = buffer_end;
+    }
+    if (done > d_buffer_offset) {
+        d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + (done - d_buffer_offset));
+        d_buffer_offset = done;
+    }
+    return output_idx;
+}
+
+int opus_decoder_impl::search_packet(const unsigned char* data,
+                                     int avail,
+                                     const std::vector<int>& candidates,
+                                     int& samples)
+{
+    // Failed decodes leave the state alone; only a candidate that decodes
+    // but is then rejected has to be rolled back.
+    const size_t state_size = static_cast<size_t>(opus_decoder_get_size(d_channels));
+    std::memcpy(d_state_snapshot.data(), d_decoder, state_size);
+
+    // Lengths after which the stream visibly continues are tried first;
+    // almost any length decodes, so the rest are only a fallback.
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int packet_size : candidates) {
+            if (packet_size > avail) {
+                break;
+            }
+            if (framed_at(data, avail, packet_size) != (pass == 0)) {
+                continue;
+            }
+
+            d_trial_decodes++;
+            int decoded_samples = opus_decode(d_decoder, data, packet_size, d_decoded_pcm.data(), d_frame_size, 0);
+            if (decoded_samples < 0) {
+                continue;
+            }
 
-            for (int i = 0; i < samples_to_write; ++i) {
-                float sample = static_cast<float>(decoded_pcm[i]) / 32767.0f;
-                sample = std::max(-1.0f, std::min(1.0f, sample));
-                out[output_idx + i] = sample;
+            bool is_silence = true;
+            for (int i = 0; i < decoded_samples * d_channels; ++i) {
+                if (std::abs(d_decoded_pcm[i]) > 100) {
+                    is_silence = false;
+                    break;
+                }
             }
 
-            output_idx += samples_to_write;
+            if (!is_silence) {
+                samples = decoded_samples;
+                return packet_size;
+            }
+            std::memcpy(d_decoder, d_state_snapshot.data(), state_size);
         }
+    }
+    return 0;
+}
+
+void opus_decoder_impl::note_packet_length(const unsigned char* packet, int avail, int len)
+{
+    // Packets found by search in a row with the same length and TOC, each
+    // followed by the next, before locking.
+    const int lock_threshold = 8;
+
+    if (!framed_at(packet, avail, len)) {
+        d_lock_streak = 0;
+        return;
+    }
+    if (len == d_lock_candidate && (packet[0] & toc_stream_mask) == d_lock_toc && d_lock_streak > 0) {
+        d_lock_streak++;
     } else {
-        int estimated_packet_size = std::max(40, std::min(400, static_cast<int>(d_packet_buffer.size()) / 5));
+        d_lock_candidate = len;
+        d_lock_toc = packet[0] & toc_stream_mask;
+        d_lock_streak = 1;
+    }
+    if (d_lock_streak >= lock_threshold) {
+        d_locked_packet_size.store(len);
+        d_lock_ins++;
+    }
+}
+
+void opus_decoder_impl::note_stream_format(const unsigned char* packet)
+{
+    if (d_custom_frame_size > 0) {
+        d_stream_channels.store(d_channels, std::memory_order_relaxed);
+        return;
+    }
+    d_stream_channels.store(opus_packet_get_nb_channels(packet), std::memory_order_relaxed);
+    d_stream_bandwidth.store(opus_packet_get_bandwidth(packet), std::memory_order_relaxed);
+}
+
+void opus_decoder_impl::apply_complexity()
+{
+    int wanted = d_effective_complexity.load(std::memory_order_relaxed);
+    if (wanted < 0) {
+        wanted = d_default_complexity;
+    }
+    // The bank-wide governor caps it: no enhancement, then no neural features.
+    const int shed = d_load_channel->level();
+    if (shed >= SHED_MINIMAL) {
+        wanted = 0;
+    } else if (shed == SHED_REDUCED) {
+        wanted = std::min(wanted, 5);
+    }
+    if (wanted == d_applied_complexity || d_custom_frame_size > 0 || !d_complexity_supported.load()) {
+        return;
+    }
+    if (opus_decoder_ctl(d_decoder, OPUS_SET_COMPLEXITY(wanted)) != OPUS_OK) {
+        d_complexity_supported.store(false);
+        return;
+    }
+    d_applied_complexity = wanted;
+}
+
+void opus_decoder_impl::time_decode(std::chrono::steady_clock::time_point start)
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    d_load_channel->add_busy(static_cast<uint64_t>(elapsed.count()));
+    if (!d_governor_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    d_decode_ns.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    d_timed_frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+void opus_decoder_impl::govern_complexity()
+{
+    // Frames per load measurement, and measurements to wait after a step
+    // before stepping up again.
+    const uint64_t window_frames = 25;
+    const int hold_windows = 4;
+
+    if (d_timed_frames.load(std::memory_order_relaxed) < window_frames) {
+        return;
+    }
+    const uint64_t frames = d_timed_frames.exchange(0);
+    const uint64_t ns = d_decode_ns.exchange(0);
+    const double frame_ns = 1e9 * d_frame_size / d_sample_rate;
+    const double load = static_cast<double>(ns) / (frames * frame_ns);
+    d_decode_load.store(load);
+
+    const double max_load = d_governor_max_load.load();
+    const int configured = d_complexity.load() >= 0 ? d_complexity.load() : d_default_complexity;
+    int current = d_effective_complexity.load();
+    if (current < 0) {
+        current = configured;
+    }
 
-        std::set<int> packet_size_candidates;
-        if (estimated_packet_size <= static_cast<int>(d_packet_buffer.size())) {
-            packet_size_candidates.insert(estimated_packet_size);
+    // Steps follow the decoder's feature thresholds so each one sheds a
+    // neural stage: NoLACE (7+) -> LACE (6) -> deep PLC (5) -> none (0).
+    if (load > max_load && current > 0) {
+        current = current > 7 ? 7 : (current > 5 ? current - 1 : 0);
+        d_effective_complexity.store(current);
+        d_governor_steps_down++;
+        d_governor_hold = hold_windows;
+    } else if (load < max_load / 4 && current < configured) {
+        if (d_governor_hold > 0) {
+            d_governor_hold--;
+            return;
         }
+        current = std::min(configured, current < 5 ? 5 : (current < 7 ? current + 1 : 10));
+        d_effective_complexity.store(current);
+        d_governor_steps_up++;
+        d_governor_hold = hold_windows;
+    }
+}
 
-        int common_sizes[] = { 60, 80, 100, 120, 150, 180, 200, 250, 300, 350, 400 };
-        for (int size : common_sizes) {
-            if (size <= static_cast<int>(d_packet_buffer.size())) {
-                packet_size_candidates.insert(size);
-            }
+void opus_decoder_impl::reset_lock()
+{
+    d_locked_packet_size.store(0);
+    d_lock_candidate = 0;
+    d_lock_streak = 0;
+}
+
+void opus_decoder_impl::apply_pool_mode()
+{
+    bool enable = d_pool_requested.load() && d_packet_size > 0;
+    size_t depth = static_cast<size_t>(d_pool_depth_requested.load());
+    if (enable == d_use_pool && (!enable || depth == d_slots.size())) {
+        return;
+    }
+    if (d_slot_count > 0) {
+        return;
+    }
+
+    d_use_pool = enable;
+    d_locked.unlock_all();
+    d_slots.clear();
+    d_slot_head = 0;
+    d_strand.reset();
+    // Either way the pool's real-time request and the locked slots change.
+    d_rt_pending.store(true);
+    if (!enable) {
+        return;
+    }
+
+    // Room for one frame plus the DRED frames recovered ahead of it.
+    const int slot_frames = 6;
+    d_strand = codec_thread_pool::instance().make_strand(depth);
+    for (size_t i = 0; i < depth; ++i) {
+        std::unique_ptr<pool_slot> slot(new pool_slot());
+        slot->packet.resize(d_packet_size);
+        slot->pcm.resize(slot_frames * d_frame_size * d_channels);
+        slot->samples = 0;
+        slot->failed = false;
+        slot->done.store(false);
+        d_slots.push_back(std::move(slot));
+    }
+}
+
+bool opus_decoder_impl::wait_head_slot()
+{
+    // Bounded so a stalled pool cannot hang the scheduler thread.
+    pool_slot& slot = *d_slots[d_slot_head];
+    std::unique_lock<std::mutex> lock(d_slot_mutex);
+    return d_slot_cv.wait_for(lock, std::chrono::milliseconds(10),
+                              [&slot] { return slot.done.load(std::memory_order_acquire); });
+}
+
+int opus_decoder_impl::release_at_end(float* out, int noutput_items)
+{
+    // Once the input has ended nothing will complete a partial batch.
+    if (d_batcher.staged_units() == d_batcher.released_units() || d_slot_count > 0 || !upstream_done(*this, 0)) {
+        return 0;
+    }
+    d_batcher.release_all();
+    return static_cast<int>(d_batcher.emit(out, noutput_items));
+}
+
+void opus_decoder_impl::complete_slot(pool_slot& slot)
+{
+    slot.done.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(d_slot_mutex);
+    }
+    d_slot_cv.notify_one();
+}
+
+int opus_decoder_impl::drain_pool(float* out, int noutput_items)
+{
+    int output_idx = static_cast<int>(d_batcher.emit(out, noutput_items));
+    while (d_slot_count > 0 && d_batcher.released_units() == 0) {
+        pool_slot& slot = *d_slots[d_slot_head];
+        if (!slot.done.load(std::memory_order_acquire)) {
+            break;
         }
+        if (slot.failed) {
+            d_pool_errors++;
+        } else if (slot.samples > 0) {
+            d_batcher.push(slot.pcm.data(), slot.samples);
+        }
+        d_slot_head = (d_slot_head + 1) % d_slots.size();
+        d_slot_count--;
+        output_idx += d_batcher.emit(out + output_idx, noutput_items - output_idx);
+    }
+    return output_idx;
+}
 
-        int max_candidates = 50;
-        for (int size = 1; size <= std::min(4000, static_cast<int>(d_packet_buffer.size())); ++size) {
-            if (packet_size_candidates.find(size) == packet_size_candidates.end()) {
-                packet_size_candidates.insert(size);
-            }
-            if (packet_size_candidates.size() >= static_cast<size_t>(max_candidates)) {
-                break;
+int opus_decoder_impl::submit_pool_packets(int max_frames)
+{
+    size_t consumed = 0;
+    int submitted = 0;
+
+    while (d_packet_buffer.size() - consumed >= static_cast<size_t>(d_packet_size) && d_slot_count < d_slots.size() &&
+           (max_frames <= 0 || submitted < max_frames)) {
+        pool_slot* slot = d_slots[(d_slot_head + d_slot_count) % d_slots.size()].get();
+        std::memcpy(slot->packet.data(), d_packet_buffer.data() + consumed, d_packet_size);
+        slot->failed = false;
+        slot->done.store(false, std::memory_order_relaxed);
+
+        bool queued = d_strand->try_submit([this, slot]() {
+            try {
+                slot->samples = decode_packet(slot->packet.data(), d_packet_size,
+                                              slot->pcm.data(), static_cast<int>(slot->pcm.size()));
+            } catch (...) {
+                // Complete the slot so work() moves past it; the pool counts the exception.
+                slot->failed = true;
+                complete_slot(*slot);
+                throw;
             }
+            complete_slot(*slot);
+        });
+        if (!queued) {
+            break;
         }
+        consumed += d_packet_size;
+        d_slot_count++;
+        submitted++;
+    }
+
+    if (consumed > 0) {
+        d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + consumed);
+    }
+    return submitted;
+}
 
-        std::vector<int> candidates_sorted(packet_size_candidates.begin(), packet_size_candidates.end());
-        std::sort(candidates_sorted.begin(), candidates_sorted.end());
+pmt::pmt_t opus_decoder_impl::telemetry_dict() const
+{
+    double frames_per_work = d_interval_work_calls > 0
+        ? static_cast<double>(d_interval_frames) / d_interval_work_calls : 0.0;
+    double frames_per_emit = d_interval_emit_calls > 0
+        ? static_cast<double>(d_interval_frames) / d_interval_emit_calls : 0.0;
 
-        while (output_idx < noutput_items && !d_packet_buffer.empty()) {
-            bool decoded = false;
+    pmt::pmt_t dict = pmt::make_dict();
+    dict = pmt::dict_add(dict, pmt::mp("frames_decoded"), pmt::from_uint64(d_frames_decoded.load()));
+    dict = pmt::dict_add(dict, pmt::mp("decode_errors"), pmt::from_uint64(d_decode_errors.load()));
+    dict = pmt::dict_add(dict, pmt::mp("samples_emitted"), pmt::from_uint64(d_samples_emitted));
+    dict = pmt::dict_add(dict, pmt::mp("work_calls"), pmt::from_uint64(d_work_calls));
+    dict = pmt::dict_add(dict, pmt::mp("emit_calls"), pmt::from_uint64(d_emit_calls));
+    dict = pmt::dict_add(dict, pmt::mp("frames_per_work"), pmt::from_double(frames_per_work));
+    dict = pmt::dict_add(dict, pmt::mp("frames_per_emit"), pmt::from_double(frames_per_emit));
+    dict = pmt::dict_add(dict, pmt::mp("max_frames_per_work"), pmt::from_long(d_max_frames_per_work.load()));
+    dict = pmt::dict_add(dict, pmt::mp("min_frames_per_emit"), pmt::from_long(d_min_frames_per_emit.load()));
+    dict = pmt::dict_add(dict, pmt::mp("staged_frames"), pmt::from_uint64(d_batcher.staged_units()));
+    dict = pmt::dict_add(dict, pmt::mp("buffered_bytes"), pmt::from_uint64(d_packet_buffer.size()));
+    dict = pmt::dict_add(dict, pmt::mp("shared_pool"), pmt::from_bool(d_use_pool));
+    dict = pmt::dict_add(dict, pmt::mp("pool_errors"), pmt::from_uint64(d_pool_errors));
+    dict = pmt::dict_add(dict, pmt::mp("pool_jobs_failed"),
+                         pmt::from_uint64(codec_thread_pool::instance().jobs_failed()));
+    dict = pmt::dict_add(dict, pmt::mp("sample_rate"), pmt::from_long(d_sample_rate));
+    dict = pmt::dict_add(dict, pmt::mp("channels"), pmt::from_long(d_channels));
+    dict = pmt::dict_add(dict, pmt::mp("format_changes"), pmt::from_uint64(d_format_changes));
+    dict = pmt::dict_add(dict, pmt::mp("custom_mode"), pmt::from_bool(d_custom_frame_size > 0));
+    dict = pmt::dict_add(dict, pmt::mp("overload_policy"), pmt::mp(overload_policy_to_string(d_overload_policy.load())));
+    dict = pmt::dict_add(dict, pmt::mp("packets_shed"), pmt::from_uint64(d_packets_shed));
+    dict = pmt::dict_add(dict, pmt::mp("bytes_shed"), pmt::from_uint64(d_bytes_shed));
+    dict = pmt::dict_add(dict, pmt::mp("backpressure_events"), pmt::from_uint64(d_backpressure_events));
+    dict = pmt::dict_add(dict, pmt::mp("stream_channels"), pmt::from_long(d_stream_channels.load()));
+    dict = pmt::dict_add(dict, pmt::mp("stream_bandwidth_hz"), pmt::from_long(audio_bandwidth_hz(d_stream_bandwidth.load())));
+    dict = pmt::dict_add(dict, pmt::mp("complexity"), pmt::from_long(d_complexity.load()));
+    dict = pmt::dict_add(dict, pmt::mp("effective_complexity"), pmt::from_long(d_effective_complexity.load()));
+    dict = pmt::dict_add(dict, pmt::mp("complexity_supported"), pmt::from_bool(d_complexity_supported.load()));
+    dict = pmt::dict_add(dict, pmt::mp("decode_load"), pmt::from_double(d_decode_load.load()));
+    dict = pmt::dict_add(dict, pmt::mp("governor_steps_down"), pmt::from_uint64(d_governor_steps_down));
+    dict = pmt::dict_add(dict, pmt::mp("governor_steps_up"), pmt::from_uint64(d_governor_steps_up));
+    dict = pmt::dict_add(dict, pmt::mp("load_priority"), pmt::mp(load_priority_to_string(d_load_channel->priority())));
+    dict = pmt::dict_add(dict, pmt::mp("load_shed_level"), pmt::from_long(d_load_channel->level()));
+    dict = pmt::dict_add(dict, pmt::mp("packets_muted"), pmt::from_uint64(d_packets_muted));
+    dict = pmt::dict_add(dict, pmt::mp("bytes_muted"), pmt::from_uint64(d_bytes_muted));
+    dict = pmt::dict_add(dict, pmt::mp("locked_packet_size"), pmt::from_long(d_locked_packet_size.load()));
+    dict = pmt::dict_add(dict, pmt::mp("lock_ins"), pmt::from_uint64(d_lock_ins));
+    dict = pmt::dict_add(dict, pmt::mp("lock_losses"), pmt::from_uint64(d_lock_losses));
+    dict = pmt::dict_add(dict, pmt::mp("trial_decodes"), pmt::from_uint64(d_trial_decodes));
+    dict = pmt::dict_add(dict, pmt::mp("packet_tags"), pmt::from_bool(d_applied_tag_framing));
+    dict = pmt::dict_add(dict, pmt::mp("loss_recovery"), pmt::mp(loss_recovery_to_string(d_loss_recovery.load())));
+    dict = pmt::dict_add(dict, pmt::mp("packets_lost"), pmt::from_uint64(d_packets_lost));
+    dict = pmt::dict_add(dict, pmt::mp("frames_concealed"), pmt::from_uint64(d_frames_concealed));
+    dict = pmt::dict_add(dict, pmt::mp("frames_fec_recovered"), pmt::from_uint64(d_frames_fec_recovered));
+    dict = pmt::dict_add(dict, pmt::mp("frames_dred_recovered"), pmt::from_uint64(d_frames_dred_recovered));
+    dict = pmt::dict_add(dict, pmt::mp("output_gain_db"), pmt::from_double(d_post.gain_db()));
+    dict = pmt::dict_add(dict, pmt::mp("samples_limited"), pmt::from_uint64(d_post.samples_limited()));
+    if (d_post.metering() || d_post.squelch()) {
+        dict = pmt::dict_add(dict, pmt::mp("level_peak_dbfs"), pmt::from_double(d_post.peak_dbfs()));
+        dict = pmt::dict_add(dict, pmt::mp("level_rms_dbfs"), pmt::from_double(d_post.rms_dbfs()));
+    }
+    dict = pmt::dict_add(dict, pmt::mp("squelch_open"), pmt::from_bool(d_post.gate_open()));
+    dict = pmt::dict_add(dict, pmt::mp("frames_squelched"), pmt::from_uint64(d_post.frames_squelched()));
+    dict = pmt::dict_add(dict, pmt::mp("realtime"), pmt::from_bool(d_realtime.load()));
+    dict = pmt::dict_add(dict, pmt::mp("realtime_priority"), pmt::from_long(d_applied_rt_priority));
+    dict = pmt::dict_add(dict, pmt::mp("pool_realtime_priority"), pmt::from_long(codec_thread_pool::instance().realtime_priority()));
+    dict = pmt::dict_add(dict, pmt::mp("memory_locked"), pmt::from_bool(d_memory_locked));
+    dict = pmt::dict_add(dict, pmt::mp("locked_bytes"), pmt::from_uint64(d_locked_bytes));
+    dict = pmt::dict_add(dict, pmt::mp("work_minor_faults"), pmt::from_uint64(d_work_minor_faults));
+    dict = pmt::dict_add(dict, pmt::mp("work_major_faults"), pmt::from_uint64(d_work_major_faults));
+    return dict;
+}
 
-            for (int packet_size : candidates_sorted) {
-                if (packet_size > static_cast<int>(d_packet_buffer.size())) {
-                    continue;
-                }
+void opus_decoder_impl::update_telemetry(int frames, int produced)
+{
+    d_work_calls++;
+    d_interval_work_calls++;
+    d_interval_frames += frames;
+    if (produced > 0) {
+        d_samples_emitted += produced;
+        d_emit_calls++;
+        d_interval_emit_calls++;
+    }
 
-                std::vector<unsigned char> packet(
-                    d_packet_buffer.begin(),
-                    d_packet_buffer.begin() + packet_size
-                );
+    int interval = d_telemetry_interval.load();
+    if (interval > 0 && d_interval_frames >= static_cast<uint64_t>(interval)) {
+        message_port_pub(pmt::mp("telemetry"), telemetry_dict());
+        d_interval_frames = 0;
+        d_interval_work_calls = 0;
+        d_interval_emit_calls = 0;
+    }
+}
 
-                int decoded_samples = opus_decode(d_decoder,
-                                                   packet.data(),
-                                                   packet_size,
-                                                   decoded_pcm.data(),
-                                                   d_frame_size,
-                                                   0);
+void opus_decoder_impl::forecast(int noutput_items, gr_vector_int& ninput_items_required)
+{
+    // Buffered packets and in-flight frames can be emitted without new
+    // input; that also lets backpressure drain the backlog.
+    bool pending = (d_packet_size > 0 && d_packet_buffer.size() >= static_cast<size_t>(d_packet_size)) ||
+                   d_slot_count > 0 || d_batcher.released_units() > 0 ||
+                   (d_batcher.staged_units() > 0 && upstream_done(*this, 0)) ||
+                   (d_applied_tag_framing && !d_tagged_packets.empty() &&
+                    d_tagged_packets.front().offset + d_tagged_packets.front().len <= d_buffer_offset + d_packet_buffer.size());
+    ninput_items_required[0] = pending ? 0 : 1;
+}
 
-                if (decoded_samples < 0) {
-                    continue;
-                }
+int opus_decoder_impl::general_work(int noutput_items,
+                                    gr_vector_int& ninput_items,
+                                    gr_vector_const_void_star& input_items,
+                                    gr_vector_void_star& output_items)
+{
+    const unsigned char* in = (const unsigned char*)input_items[0];
+    float* out = (float*)output_items[0];
+    if (!codec_ready()) {
+        wait_codec();
+    }
+    if (d_rt_pending.load() && d_slot_count == 0) {
+        apply_realtime();
+    }
+    // Both steps above fault pages in on purpose; count only what follows.
+    fault_scope faults(d_realtime.load(), d_work_minor_faults, d_work_major_faults);
+    d_load_channel->poll();
+
+    int output_idx = 0;
+    if (d_format_pending.load()) {
+        output_idx = drain_pool(out, noutput_items);
+        apply_format(output_idx);
+    }
+
+    if (d_tag_framing.load() != d_applied_tag_framing) {
+        apply_tag_framing();
+    }
+    if (d_applied_tag_framing) {
+        if (d_governor_enabled.load()) {
+            govern_complexity();
+        }
+        d_batcher.set_min_batch(d_min_frames_per_emit.load());
+        int frames = 0;
+        output_idx += decode_tagged(in, ninput_items[0], out + output_idx, noutput_items - output_idx,
+                                    d_max_frames_per_work.load(), frames);
+        output_idx += release_at_end(out + output_idx, noutput_items - output_idx);
+        if (!d_format_tags.empty()) {
+            flush_format_tags(output_idx);
+        }
+        update_telemetry(frames, output_idx);
+        return output_idx;
+    }
+
+    consume_each(static_cast<int>(accept_input(in, ninput_items[0])));
+    if (d_load_channel->level() >= SHED_MUTED) {
+        // Muted by the load governor: packets are discarded undecoded.
+        size_t drop = d_packet_buffer.size();
+        if (d_packet_size > 0) {
+            drop -= drop % d_packet_size;
+            d_packets_muted += drop / d_packet_size;
+        }
+        d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + drop);
+        d_bytes_muted += drop;
+    }
+
+    if (d_governor_enabled.load()) {
+        govern_complexity();
+    }
+
+    apply_pool_mode();
+    d_batcher.set_min_batch(d_min_frames_per_emit.load());
+
+    const int max_frames = d_max_frames_per_work.load();
+    int frames_this_call = 0;
+    output_idx += drain_pool(out + output_idx, noutput_items - output_idx);
+
+    if (d_use_pool) {
+        if (d_pool_requested.load()) {
+            frames_this_call = submit_pool_packets(max_frames);
+        }
+        // With nothing to emit yet, wait for the head slot: returning empty
+        // while jobs are in flight would have the scheduler spin on us.
+        while (output_idx == 0 && d_slot_count > 0 && wait_head_slot()) {
+            output_idx += drain_pool(out, noutput_items);
+        }
+        output_idx += release_at_end(out + output_idx, noutput_items - output_idx);
+        if (!d_format_tags.empty()) {
+            flush_format_tags(output_idx);
+        }
+        update_telemetry(frames_this_call, output_idx);
+        return output_idx;
+    }
+    if (d_slot_count > 0) {
+        output_idx += release_at_end(out + output_idx, noutput_items - output_idx);
+        if (!d_format_tags.empty()) {
+            flush_format_tags(output_idx);
+        }
+        update_telemetry(0, output_idx);
+        return output_idx;
+    }
+
+    std::vector<opus_int16>& decoded_pcm = d_decoded_pcm;
+
+    if (d_packet_size > 0) {
+        size_t consumed = 0;
+        while (d_packet_buffer.size() - consumed >= static_cast<size_t>(d_packet_size) &&
+               (max_frames <= 0 || frames_this_call < max_frames) &&
+               d_batcher.released_units() == 0) {
+            int samples = decode_packet(d_packet_buffer.data() + consumed, d_packet_size,
+                                        d_frame_out.data(), static_cast<int>(d_frame_out.size()));
+            consumed += d_packet_size;
+            frames_this_call++;
+            if (samples > 0) {
+                d_batcher.push(d_frame_out.data(), samples);
+                output_idx += d_batcher.emit(out + output_idx, noutput_items - output_idx);
+            }
+        }
+        if (consumed > 0) {
+            d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + consumed);
+        }
+    } else {
+        apply_complexity();
+        std::vector<int> candidates_sorted;
+        size_t consumed = 0;
+
+        while (consumed < d_packet_buffer.size() &&
+               (max_frames <= 0 || frames_this_call < max_frames) &&
+               d_batcher.released_units() == 0) {
+            const unsigned char* data = d_packet_buffer.data() + consumed;
+            const int avail = static_cast<int>(d_packet_buffer.size() - consumed);
+            int packet_size = 0;
+            int decoded_samples = -1;
 
-                bool is_silence = true;
-                for (int i = 0; i < decoded_samples * d_channels; ++i) {
-                    if (std::abs(decoded_pcm[i]) > 100) {
-                        is_silence = false;
-                        break;
+            const auto decode_start = std::chrono::steady_clock::now();
+            const int locked = d_locked_packet_size.load();
+            if (locked > 0) {
+                if (avail < locked) {
+                    break;
+                }
+                // A mis-framed slice usually still decodes, so check first that
+                // it continues the locked stream and parses as a whole packet.
+                const unsigned char* frames[48];
+                opus_int16 frame_sizes[48];
+                if ((data[0] & toc_stream_mask) != d_lock_toc ||
+                    opus_packet_parse(data, locked, nullptr, frames, frame_sizes, nullptr) < 0) {
+                    d_lock_losses++;
+                    reset_lock();
+                } else {
+                    // Malformed packets are rejected before the state is
+                    // touched, so the locked path needs no snapshot.
+                    decoded_samples = opus_decode(d_decoder, data, locked, decoded_pcm.data(), d_frame_size, 0);
+                    if (decoded_samples >= 0) {
+                        packet_size = locked;
+                    } else {
+                        d_decode_errors++;
+                        d_lock_losses++;
+                        reset_lock();
                     }
                 }
+            }
+
+            if (packet_size == 0) {
+                if (candidates_sorted.empty()) {
+                    int estimated_packet_size = std::max(40, std::min(400, avail / 5));
 
-                if (!is_silence) {
-                    int samples_to_write = decoded_samples * d_channels;
-                    samples_to_write = std::min(samples_to_write, noutput_items - output_idx);
+                    std::set<int> packet_size_candidates;
+                    if (estimated_packet_size <= avail) {
+                        packet_size_candidates.insert(estimated_packet_size);
+                    }
+
+                    int common_sizes[] = { 60, 80, 100, 120, 150, 180, 200, 250, 300, 350, 400 };
+                    for (int size : common_sizes) {
+                        if (size <= avail) {
+                            packet_size_candidates.insert(size);
+                        }
+                    }
 
-                    for (int i = 0; i < samples_to_write; ++i) {
-                        float sample = static_cast<float>(decoded_pcm[i]) / 32767.0f;
-                        sample = std::max(-1.0f, std::min(1.0f, sample));
-                        out[output_idx + i] = sample;
+                    int max_candidates = 50;
+                    for (int size = 1; size <= std::min(4000, avail); ++size) {
+                        if (packet_size_candidates.find(size) == packet_size_candidates.end()) {
+                            packet_size_candidates.insert(size);
+                        }
+                        if (packet_size_candidates.size() >= static_cast<size_t>(max_candidates)) {
+                            break;
+                        }
                     }
 
-                    output_idx += samples_to_write;
-                    d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + packet_size);
-                    decoded = true;
+                    candidates_sorted.assign(packet_size_candidates.begin(), packet_size_candidates.end());
+                }
+
+                packet_size = search_packet(data, avail, candidates_sorted, decoded_samples);
+                if (packet_size == 0) {
                     break;
                 }
+                note_packet_length(data, avail, packet_size);
             }
+            note_stream_format(data);
+            time_decode(decode_start);
 
-            if (!decoded) {
-                break;
-            }
+            int samples_to_write = decoded_samples * d_channels;
+            d_post.process(decoded_pcm.data(), d_frame_out.data(), samples_to_write);
+
+            d_batcher.push(d_frame_out.data(), samples_to_write);
+            output_idx += d_batcher.emit(out + output_idx, noutput_items - output_idx);
+            consumed += packet_size;
+            d_frames_decoded++;
+            frames_this_call++;
+        }
+
+        if (consumed > 0) {
+            d_packet_buffer.erase(d_packet_buffer.begin(), d_packet_buffer.begin() + consumed);
         }
     }
 
+    output_idx += release_at_end(out + output_idx, noutput_items - output_idx);
+    if (!d_format_tags.empty()) {
+        flush_format_tags(output_idx);
+    }
+    update_telemetry(frames_this_call, output_idx);
     return output_idx;
 }
 
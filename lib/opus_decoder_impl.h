@@ -22,6 +22,22 @@
 #define INCLUDED_GR_OPUS_OPUS_DECODER_IMPL_H
 
 #include <gnuradio/gr_opus/opus_decoder.h>
+#include "codec_thread_pool.h"
+#include "dnn_blob_cache.h"
+#include "load_registry.h"
+#include "loss_recovery.h"
+#include "opus_custom_engine.h"
+#include "overload_policy.h"
+#include "output_batcher.h"
+#include "post_processor.h"
+#include "realtime.h"
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <opus/opus.h>
 #include <vector>
 
@@ -31,26 +47,232 @@ namespace gr_opus {
 class opus_decoder_impl : public opus_decoder
 {
 private:
+    // Codec state lives in memory we own (sized for stereo) so a format
+    // change can re-run opus_decoder_init without reallocating.
     OpusDecoder* d_decoder;
+    void* d_decoder_mem;
+    // Opus Custom engine, used instead of the standard state when the block
+    // was made with make_custom (d_custom_frame_size > 0).
+    int d_custom_frame_size;
+    custom_decoder_engine d_custom;
     int d_sample_rate;
     int d_channels;
     int d_packet_size;
     int d_frame_size;
+    std::string d_dnn_blob_path;
+    dnn_blob_ptr d_dnn_blob;
     std::vector<unsigned char> d_packet_buffer;
     size_t d_max_buffer_size;
+
+    std::atomic<overload_policy_t> d_overload_policy;
+    size_t d_skip_bytes; // rest of a packet cut short by drop_newest
+    uint64_t d_packets_shed;
+    uint64_t d_bytes_shed;
+    uint64_t d_backpressure_events;
+    std::vector<opus_int16> d_decoded_pcm;
+    // Every decoded frame reaches the output through d_post.
+    post_processor d_post;
+    // Coded format of the latest packet; written from pool workers too.
+    std::atomic<int> d_stream_channels;
+    std::atomic<int> d_stream_bandwidth;
+
+    // Decoder complexity. d_effective_complexity is what the governor allows
+    // (-1 = libopus default); it is applied by whichever thread decodes next,
+    // so the ctl never races a pool worker.
+    std::atomic<int> d_complexity;
+    std::atomic<int> d_effective_complexity;
+    int d_applied_complexity;
+    int d_default_complexity;
+    std::atomic<bool> d_complexity_supported;
+    std::atomic<bool> d_governor_enabled;
+    std::atomic<double> d_governor_max_load;
+    std::atomic<uint64_t> d_decode_ns;
+    std::atomic<uint64_t> d_timed_frames;
+    std::atomic<double> d_decode_load;
+    int d_governor_hold;
+    uint64_t d_governor_steps_down;
+    uint64_t d_governor_steps_up;
+
+    std::shared_ptr<load_channel> d_load_channel;
+    uint64_t d_packets_muted;
+    uint64_t d_bytes_muted;
+
+    // Auto mode (packet_size == 0): trial decodes run against a snapshot of
+    // the state so rejected candidates leave no trace, and a run of equal
+    // packet lengths locks onto the fixed-size path until a decode fails.
+    std::vector<unsigned char> d_state_snapshot;
+    std::atomic<int> d_locked_packet_size;
+    int d_lock_candidate;
+    int d_lock_streak;
+    unsigned char d_lock_toc;
+    uint64_t d_lock_ins;
+    uint64_t d_lock_losses;
+    uint64_t d_trial_decodes;
+
+    // Tag framing (packet_size == 0 with packet tags): d_packet_buffer
+    // holds input from absolute offset d_buffer_offset, and every packet
+    // whose packet_len tag has been seen is queued with the number of
+    // packets signalled lost ahead of it.
+    struct tagged_packet {
+        uint64_t offset;
+        int len;
+        int lost;
+    };
+    std::atomic<bool> d_tag_framing;
+    bool d_applied_tag_framing;
+    uint64_t d_buffer_offset;
+    std::deque<tagged_packet> d_tagged_packets;
+    int d_lost_pending;
+    std::atomic<loss_recovery_t> d_loss_recovery;
+    uint64_t d_packets_lost;
+    uint64_t d_frames_concealed;
+    uint64_t d_frames_fec_recovered;
+    uint64_t d_frames_dred_recovered;
 #ifdef OPUS_HAVE_DRED
     OpusDREDDecoder* d_dred_decoder;
     OpusDRED* d_dred;
     int d_lost_count;
+    std::vector<float> d_dred_pcm;
 #endif
 
+    struct pool_slot {
+        std::vector<unsigned char> packet;
+        std::vector<float> pcm;
+        int samples;
+        bool failed; // the job threw; samples is not valid
+        std::atomic<bool> done;
+    };
+    std::shared_ptr<codec_strand> d_strand;
+    std::vector<std::unique_ptr<pool_slot>> d_slots;
+    size_t d_slot_head;
+    size_t d_slot_count;
+    std::atomic<bool> d_pool_requested;
+    std::atomic<int> d_pool_depth_requested;
+    bool d_use_pool;
+    // Pool jobs signal here as their slots complete.
+    std::mutex d_slot_mutex;
+    std::condition_variable d_slot_cv;
+
+    output_batcher<float> d_batcher;
+    std::vector<float> d_frame_out;
+    std::atomic<int> d_max_frames_per_work;
+    std::atomic<int> d_min_frames_per_emit;
+    std::atomic<int> d_telemetry_interval;
+
+    // Real-time mode; applied from work() while no pool job is in flight,
+    // and again whenever buffers have been rebuilt.
+    std::atomic<bool> d_realtime;
+    std::atomic<int> d_realtime_priority;
+    std::atomic<bool> d_rt_pending;
+    int d_applied_rt_priority;
+    int d_pool_rt_priority; // our request on the shared pool, 0 for none
+    locked_ranges d_locked;
+    bool d_memory_locked;
+    uint64_t d_locked_bytes;
+    uint64_t d_work_minor_faults;
+    uint64_t d_work_major_faults;
+
+    // Updated from pool workers when the shared pool is in use.
+    std::atomic<uint64_t> d_frames_decoded;
+    std::atomic<uint64_t> d_decode_errors;
+    uint64_t d_pool_errors;
+    uint64_t d_samples_emitted;
+    uint64_t d_work_calls;
+    uint64_t d_emit_calls;
+    uint64_t d_interval_frames;
+    uint64_t d_interval_work_calls;
+    uint64_t d_interval_emit_calls;
+
+    std::mutex d_format_mutex;
+    std::atomic<bool> d_format_pending;
+    int d_pending_sample_rate;
+    int d_pending_channels;
+    uint64_t d_format_changes;
+    std::deque<std::pair<uint64_t, pmt::pmt_t>> d_format_tags;
+
+    // Deferred initialisation: codec creation runs on the shared pool and
+    // is joined in start() (or the first work() call).
+    std::shared_ptr<codec_strand> d_init_strand;
+    std::exception_ptr d_init_error;
+
+    void create_codec();
+    void init_codec();
+    void destroy_codec();
+    void wait_codec();
+    bool codec_ready() const { return d_custom_frame_size > 0 ? d_custom.ready() : d_decoder != nullptr; }
+    bool valid_format(int sample_rate, int channels) const;
+    void handle_reconfig(const pmt::pmt_t& msg);
+    void apply_format(int output_idx);
+    void flush_format_tags(int produced);
+    size_t accept_input(const unsigned char* in, size_t ninput);
+    int decode_packet(const unsigned char* packet, int len, float* out, int max_samples, int lost = 0);
+    int recover_lost(const unsigned char* packet, int len, int lost, float* out, int max_samples);
+    void apply_tag_framing();
+    int decode_tagged(const unsigned char* in, int ninput, float* out, int noutput_items, int max_frames, int& frames);
+    int search_packet(const unsigned char* data, int avail, const std::vector<int>& candidates, int& samples);
+    void note_packet_length(const unsigned char* packet, int avail, int len);
+    void note_stream_format(const unsigned char* packet);
+    void apply_complexity();
+    void time_decode(std::chrono::steady_clock::time_point start);
+    void govern_complexity();
+    void reset_lock();
+    void apply_pool_mode();
+    void apply_realtime();
+    int drain_pool(float* out, int noutput_items);
+    bool wait_head_slot();
+    void complete_slot(pool_slot& slot);
+    int release_at_end(float* out, int noutput_items);
+    int submit_pool_packets(int max_frames);
+    void update_telemetry(int frames, int produced);
+    pmt::pmt_t telemetry_dict() const;
+
 public:
-    opus_decoder_impl(int sample_rate, int channels, int packet_size, const std::string& dnn_blob_path = "");
+    opus_decoder_impl(int sample_rate, int channels, int packet_size, const std::string& dnn_blob_path = "", bool defer_init = false, int custom_frame_size = 0);
     ~opus_decoder_impl();
 
-    int work(int noutput_items,
-             gr_vector_const_void_star& input_items,
-             gr_vector_void_star& output_items);
+    void set_shared_pool(bool enable, int queue_depth) override;
+    bool shared_pool() const override { return d_pool_requested.load(); }
+
+    void set_max_frames_per_work(int frames) override;
+    int max_frames_per_work() const override { return d_max_frames_per_work.load(); }
+    void set_min_frames_per_emit(int frames) override;
+    int min_frames_per_emit() const override { return d_min_frames_per_emit.load(); }
+    void set_telemetry_interval(int frames) override;
+    void set_realtime(bool enable, int priority) override;
+    bool realtime() const override { return d_realtime.load(); }
+    void set_format(int sample_rate, int channels) override;
+    void set_overload_policy(const std::string& policy) override;
+    std::string overload_policy() const override { return overload_policy_to_string(d_overload_policy.load()); }
+    void set_complexity(int complexity) override;
+    int complexity() const override { return d_complexity.load(); }
+    void set_complexity_governor(bool enable, double max_load) override;
+    int effective_complexity() const override { return d_effective_complexity.load(); }
+    void set_load_priority(const std::string& priority) override;
+    std::string load_priority() const override { return load_priority_to_string(d_load_channel->priority()); }
+    int load_shed_level() const override { return d_load_channel->level(); }
+    int stream_channels() const override { return d_stream_channels.load(); }
+    void set_packet_tags(bool enable) override;
+    bool packet_tags() const override { return d_tag_framing.load(); }
+    void set_loss_recovery(const std::string& mode) override;
+    std::string loss_recovery() const override { return loss_recovery_to_string(d_loss_recovery.load()); }
+    void set_output_gain(double gain_db) override { d_post.set_gain_db(gain_db); }
+    double output_gain() const override { return d_post.gain_db(); }
+    void set_soft_limiter(bool enable) override { d_post.set_soft_limit(enable); }
+    bool soft_limiter() const override { return d_post.soft_limit(); }
+    void set_squelch(bool enable, double threshold_dbfs, int hang_ms) override;
+    bool squelch() const override { return d_post.squelch(); }
+    void set_level_meter(bool enable) override { d_post.set_metering(enable); }
+    bool level_meter() const override { return d_post.metering(); }
+    int detected_packet_size() const override { return d_packet_size > 0 ? d_packet_size : d_locked_packet_size.load(); }
+
+    bool start() override;
+    bool stop() override;
+
+    void forecast(int noutput_items, gr_vector_int& ninput_items_required) override;
+    int general_work(int noutput_items,
+                     gr_vector_int& ninput_items,
+                     gr_vector_const_void_star& input_items,
+                     gr_vector_void_star& output_items) override;
 };
 
 } // namespace gr_opus
@@ -0,0 +1,238 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_encoder_bank_impl.h"
+#include "codec_format.h"
+#include "pcm_convert.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+void check_bitrate(int bitrate)
+{
+    if (bitrate < 500 || bitrate > 512000) {
+        throw std::runtime_error("Bitrate must be between 500 and 512000 bps");
+    }
+}
+
+uint64_t elapsed_ns(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+} // namespace
+
+opus_encoder_bank::sptr
+opus_encoder_bank::make(int num_channels, int sample_rate, int bitrate, const std::string& application)
+{
+    return gnuradio::get_initial_sptr(new opus_encoder_bank_impl(num_channels, sample_rate, bitrate, application));
+}
+
+opus_encoder_bank_impl::opus_encoder_bank_impl(int num_channels, int sample_rate, int bitrate, const std::string& application)
+    : gr::block("opus_encoder_bank",
+                gr::io_signature::make(num_channels, num_channels, sizeof(float)),
+                gr::io_signature::make(num_channels, num_channels, sizeof(unsigned char))),
+      d_num_channels(num_channels),
+      d_sample_rate(sample_rate),
+      d_frame_size(sample_rate / 50),
+      d_state_mem(nullptr),
+      d_state_stride(0),
+      d_bitrate(bitrate),
+      d_applied_bitrate(bitrate),
+      d_max_frames(8),
+      d_frames_encoded(0),
+      d_encode_errors(0),
+      d_work_ns(0),
+      d_codec_ns(0)
+{
+    if (num_channels < 1 || num_channels > 4096) {
+        throw std::runtime_error("An encoder bank needs 1 to 4096 channels");
+    }
+    check_opus_format(sample_rate, 1);
+    check_bitrate(bitrate);
+    const int opus_application = opus_application_from_string(application);
+
+    // Cache-line aligned states, back to back.
+    d_state_stride = (static_cast<size_t>(opus_encoder_get_size(1)) + 63) / 64 * 64;
+    d_state_mem = std::aligned_alloc(64, d_state_stride * num_channels);
+    if (d_state_mem == nullptr) {
+        throw std::runtime_error("Failed to allocate Opus encoder bank state");
+    }
+    for (int c = 0; c < num_channels; ++c) {
+        int error = opus_encoder_init(state(c), sample_rate, 1, opus_application);
+        if (error == OPUS_OK) {
+            error = opus_encoder_ctl(state(c), OPUS_SET_BITRATE(bitrate));
+        }
+        if (error != OPUS_OK) {
+            std::free(d_state_mem);
+            throw std::runtime_error("Failed to create Opus encoder: " + std::string(opus_strerror(error)));
+        }
+    }
+
+    d_batchers.reserve(num_channels);
+    for (int c = 0; c < num_channels; ++c) {
+        d_batchers.emplace_back(false);
+        d_batchers.back().set_record_units(true);
+    }
+    d_produced.resize(num_channels);
+    // Output tags are one "packet_len" per packet.
+    set_tag_propagation_policy(TPP_DONT);
+}
+
+opus_encoder_bank_impl::~opus_encoder_bank_impl() { std::free(d_state_mem); }
+
+void opus_encoder_bank_impl::set_bitrate(int bitrate)
+{
+    check_bitrate(bitrate);
+    d_bitrate.store(bitrate);
+}
+
+void opus_encoder_bank_impl::set_max_frames_per_work(int frames)
+{
+    if (frames < 1 || frames > 50) {
+        throw std::runtime_error("max_frames_per_work must be between 1 and 50");
+    }
+    d_max_frames.store(frames);
+}
+
+double opus_encoder_bank_impl::overhead_fraction() const
+{
+    uint64_t work = d_work_ns.load();
+    return work > 0 ? 1.0 - static_cast<double>(std::min(d_codec_ns.load(), work)) / work : 0.0;
+}
+
+bool opus_encoder_bank_impl::staged() const
+{
+    for (const auto& batcher : d_batchers) {
+        if (batcher.staged_units() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int opus_encoder_bank_impl::emit(int channel, unsigned char* out, int noutput_items)
+{
+    output_batcher<unsigned char>& batcher = d_batchers[channel];
+    const uint64_t first = nitems_written(channel);
+    int written = static_cast<int>(batcher.emit(out, noutput_items));
+    uint64_t offset = first;
+    for (size_t len : batcher.emitted_units()) {
+        add_item_tag(channel, offset, pmt::mp("packet_len"), pmt::from_long(static_cast<long>(len)));
+        offset += len;
+    }
+    batcher.clear_emitted_units();
+    return written;
+}
+
+void opus_encoder_bank_impl::forecast(int noutput_items, gr_vector_int& ninput_items_required)
+{
+    // Staged packets go out before any new frame is taken.
+    int required = staged() ? 0 : d_frame_size;
+    std::fill(ninput_items_required.begin(), ninput_items_required.end(), required);
+}
+
+int opus_encoder_bank_impl::general_work(int noutput_items,
+                                         gr_vector_int& ninput_items,
+                                         gr_vector_const_void_star& input_items,
+                                         gr_vector_void_star& output_items)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < d_num_channels; ++c) {
+        d_produced[c] = emit(c, static_cast<unsigned char*>(output_items[c]), noutput_items);
+    }
+    // The channels advance in lockstep, so one slow consumer holds the bank.
+    int frames = 0;
+    if (!staged()) {
+        frames = *std::min_element(ninput_items.begin(), ninput_items.end()) / d_frame_size;
+        frames = std::min(frames, d_max_frames.load());
+    }
+
+    if (frames > 0) {
+        const int bitrate = d_bitrate.load();
+        if (bitrate != d_applied_bitrate) {
+            for (int c = 0; c < d_num_channels; ++c) {
+                opus_encoder_ctl(state(c), OPUS_SET_BITRATE(bitrate));
+            }
+            d_applied_bitrate = bitrate;
+        }
+
+        const size_t run = static_cast<size_t>(frames) * d_frame_size;
+        d_pcm.resize(run * d_num_channels);
+        d_packets.resize(static_cast<size_t>(frames) * d_num_channels * max_packet_bytes);
+        d_packet_len.resize(static_cast<size_t>(frames) * d_num_channels);
+
+        for (int c = 0; c < d_num_channels; ++c) {
+            float_to_int16(static_cast<const float*>(input_items[c]), d_pcm.data() + c * run, run);
+        }
+
+        const auto codec_start = std::chrono::steady_clock::now();
+        for (int c = 0; c < d_num_channels; ++c) {
+            OpusEncoder* enc = state(c);
+            const opus_int16* pcm = d_pcm.data() + c * run;
+            unsigned char* packet = d_packets.data() + static_cast<size_t>(c) * frames * max_packet_bytes;
+            int* len = d_packet_len.data() + static_cast<size_t>(c) * frames;
+            for (int f = 0; f < frames; ++f) {
+                len[f] = opus_encode(enc, pcm + f * d_frame_size, d_frame_size, packet + f * max_packet_bytes,
+                                     max_packet_bytes);
+            }
+        }
+        d_codec_ns += elapsed_ns(codec_start);
+
+        long errors = 0;
+        for (int c = 0; c < d_num_channels; ++c) {
+            const unsigned char* packet = d_packets.data() + static_cast<size_t>(c) * frames * max_packet_bytes;
+            const int* len = d_packet_len.data() + static_cast<size_t>(c) * frames;
+            for (int f = 0; f < frames; ++f) {
+                if (len[f] < 0) {
+                    errors++;
+                    continue;
+                }
+                d_batchers[c].push(packet + f * max_packet_bytes, len[f]);
+            }
+            d_produced[c] += emit(c, static_cast<unsigned char*>(output_items[c]) + d_produced[c],
+                                noutput_items - d_produced[c]);
+        }
+        d_frames_encoded += static_cast<long>(frames) * d_num_channels - errors;
+        d_encode_errors += errors;
+        consume_each(static_cast<int>(run));
+    }
+
+    for (int c = 0; c < d_num_channels; ++c) {
+        produce(c, d_produced[c]);
+    }
+    d_work_ns += elapsed_ns(start);
+    return WORK_CALLED_PRODUCE;
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,95 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_ENCODER_BANK_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_ENCODER_BANK_IMPL_H
+
+#include <gnuradio/gr_opus/opus_encoder_bank.h>
+#include "output_batcher.h"
+#include <atomic>
+#include <opus/opus.h>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_encoder_bank_impl : public opus_encoder_bank
+{
+private:
+    // Largest packet opus_encode produces for a single 20 ms frame.
+    static constexpr int max_packet_bytes = 1276;
+
+    const int d_num_channels;
+    const int d_sample_rate;
+    const int d_frame_size;
+
+    // All encoder states in one allocation, d_state_stride bytes apart.
+    void* d_state_mem;
+    size_t d_state_stride;
+    std::atomic<int> d_bitrate;
+    int d_applied_bitrate;
+    std::atomic<int> d_max_frames;
+
+    // Structure of arrays, channel-major: channel c's frames are contiguous
+    // at c * frames * frame_size in d_pcm, and its packets and lengths at
+    // c * frames in d_packets / d_packet_len.
+    std::vector<opus_int16> d_pcm;
+    std::vector<unsigned char> d_packets;
+    std::vector<int> d_packet_len;
+    std::vector<output_batcher<unsigned char>> d_batchers;
+    std::vector<int> d_produced;
+
+    std::atomic<long> d_frames_encoded;
+    std::atomic<long> d_encode_errors;
+    std::atomic<uint64_t> d_work_ns;
+    std::atomic<uint64_t> d_codec_ns;
+
+    OpusEncoder* state(int channel) const
+    {
+        return reinterpret_cast<OpusEncoder*>(static_cast<unsigned char*>(d_state_mem) + channel * d_state_stride);
+    }
+    bool staged() const;
+    int emit(int channel, unsigned char* out, int noutput_items);
+
+public:
+    opus_encoder_bank_impl(int num_channels, int sample_rate, int bitrate, const std::string& application);
+    ~opus_encoder_bank_impl();
+
+    void set_bitrate(int bitrate) override;
+    int bitrate() const override { return d_bitrate.load(); }
+    void set_max_frames_per_work(int frames) override;
+    int max_frames_per_work() const override { return d_max_frames.load(); }
+
+    int num_channels() const override { return d_num_channels; }
+    long frames_encoded() const override { return d_frames_encoded.load(); }
+    long encode_errors() const override { return d_encode_errors.load(); }
+    double overhead_fraction() const override;
+
+    void forecast(int noutput_items, gr_vector_int& ninput_items_required) override;
+    int general_work(int noutput_items,
+                     gr_vector_int& ninput_items,
+                     gr_vector_const_void_star& input_items,
+                     gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_ENCODER_BANK_IMPL_H */
@@ -24,155 +24,1035 @@
 
 #include <gnuradio/io_signature.h>
 #include "opus_encoder_impl.h"
+#include "codec_format.h"
+#include "pcm_convert.h"
+#include "upstream_done.h"
 #include <string>
 #include <stdexcept>
 #include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
-#include <fstream>
 #include <vector>
 
 namespace gr {
 namespace gr_opus {
 
 opus_encoder::sptr
-opus_encoder::make(int sample_rate, int channels, int bitrate, const std::string& application, bool enable_fargan_voice, const std::string& dnn_blob_path)
+opus_encoder::make(int sample_rate, int channels, int bitrate, const std::string& application, bool enable_fargan_voice, const std::string& dnn_blob_path, bool defer_init)
 {
-    return gnuradio::get_initial_sptr(new opus_encoder_impl(sample_rate, channels, bitrate, application, enable_fargan_voice, dnn_blob_path));
+    return gnuradio::get_initial_sptr(new opus_encoder_impl(sample_rate, channels, bitrate, application, enable_fargan_voice, dnn_blob_path, defer_init));
 }
 
-int opus_encoder_impl::application_string_to_int(const std::string& application)
+opus_encoder::sptr
+opus_encoder::make_custom(int sample_rate, int channels, int bitrate, int frame_size)
 {
-    if (application == "voip") {
-        return OPUS_APPLICATION_VOIP;
-    } else if (application == "lowdelay") {
-        return OPUS_APPLICATION_RESTRICTED_LOWDELAY;
-    } else {
-        return OPUS_APPLICATION_AUDIO;
-    }
+    check_custom_format(sample_rate, channels, frame_size);
+    return gnuradio::get_initial_sptr(new opus_encoder_impl(sample_rate, channels, bitrate, "lowdelay", false, "", false, frame_size));
 }
 
-opus_encoder_impl::opus_encoder_impl(int sample_rate, int channels, int bitrate, const std::string& application, bool enable_fargan_voice, const std::string& dnn_blob_path)
-    : gr::sync_block("opus_encoder",
-                     gr::io_signature::make(1, 1, sizeof(float)),
-                     gr::io_signature::make(1, 1, sizeof(unsigned char))),
+opus_encoder_impl::opus_encoder_impl(int sample_rate, int channels, int bitrate, const std::string& application, bool enable_fargan_voice, const std::string& dnn_blob_path, bool defer_init, int custom_frame_size)
+    : gr::block("opus_encoder",
+                gr::io_signature::make(1, 1, sizeof(float)),
+                gr::io_signature::make(1, 1, sizeof(unsigned char))),
+      d_encoder(nullptr),
+      d_encoder_mem(nullptr),
+      d_custom_frame_size(custom_frame_size),
+      d_custom_packet_bytes(0),
       d_sample_rate(sample_rate),
       d_channels(channels),
       d_bitrate(bitrate),
-      d_frame_size(static_cast<int>(sample_rate * 0.020)),
+      d_application(opus_application_from_string(application)),
+      d_frame_size(custom_frame_size > 0 ? custom_frame_size : static_cast<int>(sample_rate * 0.020)),
+      d_enable_fargan_voice(enable_fargan_voice),
+      d_dnn_blob_path(dnn_blob_path),
       d_max_buffer_samples(sample_rate * channels * 10),
-      d_enable_fargan_voice(enable_fargan_voice)
+      d_overload_policy(overload_policy_t::DROP_OLDEST),
+      d_skip_samples(0),
+      d_current_bitrate(bitrate),
+      d_complexity(10),
+      d_current_complexity(10),
+      d_calls_since_adjust(0),
+      d_frames_shed(0),
+      d_samples_shed(0),
+      d_backpressure_events(0),
+      d_quality_steps_down(0),
+      d_load_channel(register_load_channel()),
+      d_applied_shed_level(SHED_NONE),
+      d_frames_muted(0),
+      d_int16_frame(d_frame_size * channels),
+      d_slot_head(0),
+      d_slot_count(0),
+      d_pool_requested(false),
+      d_pool_depth_requested(4),
+      d_use_pool(false),
+      d_batcher(false),
+      d_max_frames_per_work(0),
+      d_min_frames_per_emit(1),
+      d_telemetry_interval(50),
+      d_packet_tags(false),
+      d_dtx(false),
+      d_applied_dtx(false),
+      d_fec(false),
+      d_fec_loss_percent(10),
+      d_applied_fec(false),
+      d_applied_fec_loss_percent(0),
+      d_classify(false),
+      d_classifier_active(false),
+      d_applied_signal(OPUS_AUTO),
+      d_applied_max_bandwidth(OPUS_BANDWIDTH_FULLBAND),
+      d_classifier_switches(0),
+      d_mono_collapse(false),
+      d_mono_threshold_db(30.0),
+      d_mono_detector_active(false),
+      d_applied_mono(false),
+      d_mono_switches(0),
+      d_collapsed_us(0),
+      d_stereo_us(0),
+      d_realtime(false),
+      d_realtime_priority(0),
+      d_rt_pending(false),
+      d_applied_rt_priority(0),
+      d_pool_rt_priority(0),
+      d_memory_locked(false),
+      d_locked_bytes(0),
+      d_work_minor_faults(0),
+      d_work_major_faults(0),
+      d_frames_encoded(0),
+      d_encode_errors(0),
+      d_pool_errors(0),
+      d_bytes_emitted(0),
+      d_work_calls(0),
+      d_emit_calls(0),
+      d_interval_frames(0),
+      d_interval_work_calls(0),
+      d_interval_emit_calls(0),
+      d_format_pending(false),
+      d_pending_sample_rate(sample_rate),
+      d_pending_channels(channels),
+      d_format_changes(0)
 {
-    int error;
-    int application_int = application_string_to_int(application);
+    message_port_register_out(pmt::mp("telemetry"));
+    message_port_register_in(pmt::mp("reconfig"));
+    set_msg_handler(pmt::mp("reconfig"), [this](const pmt::pmt_t& msg) { handle_reconfig(msg); });
+
+    if (defer_init) {
+        d_init_strand = codec_thread_pool::instance().make_strand(1);
+        d_init_strand->try_submit([this] {
+            try {
+                create_codec();
+            } catch (...) {
+                d_init_error = std::current_exception();
+            }
+        });
+    } else {
+        create_codec();
+    }
+}
+
+opus_encoder_impl::~opus_encoder_impl()
+{
+    if (d_init_strand) {
+        d_init_strand->wait_idle();
+    }
+    if (d_strand) {
+        d_strand->wait_idle();
+    }
+    d_locked.unlock_all();
+    if (d_pool_rt_priority > 0) {
+        codec_thread_pool::instance().release_realtime(d_pool_rt_priority);
+    }
+    destroy_codec();
+}
+
+void opus_encoder_impl::create_codec()
+{
+    if (d_custom_frame_size > 0) {
+        init_codec();
+        return;
+    }
 
-    d_encoder = opus_encoder_create(sample_rate, channels, application_int, &error);
-    if (error != OPUS_OK || d_encoder == nullptr) {
+    int size = std::max(opus_encoder_get_size(1), opus_encoder_get_size(2));
+    d_encoder_mem = std::malloc(size);
+    if (d_encoder_mem == nullptr) {
+        throw std::runtime_error("Failed to allocate Opus encoder state");
+    }
+    d_encoder = static_cast<OpusEncoder*>(d_encoder_mem);
+
+#ifdef OPUS_HAVE_DNN_BLOB
+    if (!d_dnn_blob_path.empty()) {
+        try {
+            d_dnn_blob = load_dnn_blob(d_dnn_blob_path);
+        } catch (...) {
+            destroy_codec();
+            throw;
+        }
+    }
+#endif
+
+    try {
+        init_codec();
+    } catch (...) {
+        destroy_codec();
+        throw;
+    }
+}
+
+void opus_encoder_impl::init_codec()
+{
+    if (d_custom_frame_size > 0) {
+        d_custom.create(d_sample_rate, d_channels, d_custom_frame_size);
+        d_custom_packet_bytes = custom_packet_bytes(d_bitrate, d_sample_rate, d_custom_frame_size);
+        return;
+    }
+
+    int error = opus_encoder_init(d_encoder, d_sample_rate, d_channels, d_application);
+    if (error != OPUS_OK) {
         throw std::runtime_error("Failed to create Opus encoder: " + std::string(opus_strerror(error)));
     }
 
-    error = opus_encoder_ctl(d_encoder, OPUS_SET_BITRATE(bitrate));
+    error = opus_encoder_ctl(d_encoder, OPUS_SET_BITRATE(d_bitrate));
     if (error != OPUS_OK) {
-        opus_encoder_destroy(d_encoder);
         throw std::runtime_error("Failed to set Opus encoder bitrate: " + std::string(opus_strerror(error)));
     }
+    opus_encoder_ctl(d_encoder, OPUS_GET_COMPLEXITY(&d_complexity));
+    d_applied_dtx = d_dtx.load();
+    opus_encoder_ctl(d_encoder, OPUS_SET_DTX(d_applied_dtx ? 1 : 0));
+    apply_fec();
+    // A fresh state is back to automatic signal type and full band.
+    d_classifier_active = false;
+    d_applied_signal.store(OPUS_AUTO);
+    d_applied_max_bandwidth.store(OPUS_BANDWIDTH_FULLBAND);
+    d_mono_detector_active = false;
+    d_applied_mono.store(false);
+    d_current_bitrate = d_bitrate;
+    d_current_complexity = d_complexity;
+    d_calls_since_adjust = 0;
+    d_applied_shed_level = SHED_NONE;
 
 #ifdef OPUS_HAVE_DRED
     if (d_enable_fargan_voice) {
         const int dred_duration = 5;
         error = opus_encoder_ctl(d_encoder, OPUS_SET_DRED_DURATION(dred_duration));
         if (error != OPUS_OK) {
-            opus_encoder_destroy(d_encoder);
             throw std::runtime_error("Failed to set Opus DRED/FARGAN: " + std::string(opus_strerror(error)));
         }
     }
 #endif
 
 #ifdef OPUS_HAVE_DNN_BLOB
-    if (!dnn_blob_path.empty()) {
-        std::ifstream f(dnn_blob_path, std::ios::binary | std::ios::ate);
-        if (!f) {
-            opus_encoder_destroy(d_encoder);
-            throw std::runtime_error("Failed to open DNN blob file: " + dnn_blob_path);
-        }
-        std::vector<char> blob(f.tellg());
-        f.seekg(0);
-        if (!f.read(blob.data(), blob.size())) {
-            opus_encoder_destroy(d_encoder);
-            throw std::runtime_error("Failed to read DNN blob file: " + dnn_blob_path);
-        }
-        error = opus_encoder_ctl(d_encoder, OPUS_SET_DNN_BLOB(blob.data(), static_cast<int>(blob.size())));
+    if (d_dnn_blob) {
+        error = opus_encoder_ctl(d_encoder, OPUS_SET_DNN_BLOB(d_dnn_blob->data(), static_cast<int>(d_dnn_blob->size())));
         if (error != OPUS_OK) {
-            opus_encoder_destroy(d_encoder);
             throw std::runtime_error("Failed to set Opus DNN blob (FARGAN): " + std::string(opus_strerror(error)));
         }
     }
 #endif
 }
 
-opus_encoder_impl::~opus_encoder_impl()
+void opus_encoder_impl::destroy_codec()
+{
+    d_custom.destroy();
+    std::free(d_encoder_mem);
+    d_encoder_mem = nullptr;
+    d_encoder = nullptr;
+    d_dnn_blob.reset();
+}
+
+void opus_encoder_impl::wait_codec()
 {
-    if (d_encoder != nullptr) {
-        opus_encoder_destroy(d_encoder);
-        d_encoder = nullptr;
+    if (d_init_strand) {
+        d_init_strand->wait_idle();
+        d_init_strand.reset();
+        if (d_init_error) {
+            std::exception_ptr error = d_init_error;
+            d_init_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+    if (!codec_ready()) {
+        create_codec();
     }
 }
 
-int opus_encoder_impl::work(int noutput_items,
-                            gr_vector_const_void_star& input_items,
-                            gr_vector_void_star& output_items)
+bool opus_encoder_impl::start()
 {
-    const float* in = (const float*)input_items[0];
-    unsigned char* out = (unsigned char*)output_items[0];
+    wait_codec();
+    return true;
+}
 
-    size_t ninput = noutput_items;
+void opus_encoder_impl::set_shared_pool(bool enable, int queue_depth)
+{
+    d_pool_depth_requested.store(std::max(1, std::min(64, queue_depth)));
+    d_pool_requested.store(enable);
+}
 
-    d_sample_buffer.insert(d_sample_buffer.end(), in, in + ninput);
+void opus_encoder_impl::set_max_frames_per_work(int frames)
+{
+    d_max_frames_per_work.store(std::max(0, frames));
+}
+
+void opus_encoder_impl::set_min_frames_per_emit(int frames)
+{
+    d_min_frames_per_emit.store(std::max(1, frames));
+}
+
+void opus_encoder_impl::set_telemetry_interval(int frames)
+{
+    d_telemetry_interval.store(std::max(0, frames));
+}
 
-    if (d_sample_buffer.size() > d_max_buffer_samples) {
-        size_t excess = d_sample_buffer.size() - d_max_buffer_samples;
-        d_sample_buffer.erase(d_sample_buffer.begin(), d_sample_buffer.begin() + excess);
+bool opus_encoder_impl::valid_format(int sample_rate, int channels) const
+{
+    return d_custom_frame_size > 0 ? valid_custom_format(sample_rate, channels, d_custom_frame_size)
+                                   : valid_opus_format(sample_rate, channels);
+}
+
+void opus_encoder_impl::set_format(int sample_rate, int channels)
+{
+    if (d_custom_frame_size > 0) {
+        check_custom_format(sample_rate, channels, d_custom_frame_size);
+    } else {
+        check_opus_format(sample_rate, channels);
     }
+    std::lock_guard<std::mutex> lock(d_format_mutex);
+    d_pending_sample_rate = sample_rate;
+    d_pending_channels = channels;
+    d_format_pending.store(true);
+}
 
-    int output_idx = 0;
-    int frame_size_samples = d_frame_size * d_channels;
-    int frames_encoded = 0;
+void opus_encoder_impl::set_overload_policy(const std::string& policy)
+{
+    overload_policy_t parsed = overload_policy_from_string(policy);
+    if (parsed == overload_policy_t::DEGRADE_BITRATE && d_custom_frame_size > 0) {
+        throw std::runtime_error("degrade_bitrate is not available for Opus Custom encoders");
+    }
+    d_overload_policy.store(parsed);
+}
+
+void opus_encoder_impl::handle_reconfig(const pmt::pmt_t& msg)
+{
+    int sample_rate, channels;
+    {
+        std::lock_guard<std::mutex> lock(d_format_mutex);
+        sample_rate = d_pending_sample_rate;
+        channels = d_pending_channels;
+    }
+    // Malformed requests are dropped rather than taking down the flowgraph.
+    if (parse_format_msg(msg, sample_rate, channels) && valid_format(sample_rate, channels)) {
+        set_format(sample_rate, channels);
+    }
+}
+
+void opus_encoder_impl::apply_format(int output_idx)
+{
+    // Wait for in-flight pool frames; they were encoded with the old state.
+    if (d_slot_count > 0) {
+        return;
+    }
+
+    int sample_rate, channels;
+    {
+        std::lock_guard<std::mutex> lock(d_format_mutex);
+        sample_rate = d_pending_sample_rate;
+        channels = d_pending_channels;
+        d_format_pending.store(false);
+    }
+    if (sample_rate == d_sample_rate && channels == d_channels) {
+        return;
+    }
 
-    std::vector<opus_int16> int16_frame(frame_size_samples);
+    // Flush the remaining old-format samples, padded to a whole frame.
+    size_t frame_size_samples = d_frame_size * d_channels;
+    size_t consumed = 0;
+    unsigned char encoded_data[4000];
+    while (consumed < d_sample_buffer.size()) {
+        if (d_sample_buffer.size() - consumed < frame_size_samples) {
+            d_sample_buffer.resize(consumed + frame_size_samples, 0.0f);
+        }
+        int encoded_len = encode_frame(d_sample_buffer.data() + consumed, encoded_data, sizeof(encoded_data));
+        consumed += frame_size_samples;
+        if (encoded_len < 0) {
+            d_encode_errors++;
+            continue;
+        }
+        d_frames_encoded++;
+        d_batcher.push(encoded_data, encoded_len);
+    }
+    d_sample_buffer.clear();
+    d_skip_samples = 0;
+    d_batcher.release_all();
 
-    while (d_sample_buffer.size() >= static_cast<size_t>(frame_size_samples) && output_idx < noutput_items) {
-        std::vector<float> frame_samples(
-            d_sample_buffer.begin(),
-            d_sample_buffer.begin() + frame_size_samples
-        );
-        d_sample_buffer.erase(d_sample_buffer.begin(), d_sample_buffer.begin() + frame_size_samples);
+    // Buffers are resized and the slots freed below; apply_realtime relocks.
+    d_locked.unlock_all();
+    d_sample_rate = sample_rate;
+    d_channels = channels;
+    if (d_custom_frame_size == 0) {
+        d_frame_size = static_cast<int>(sample_rate * 0.020);
+    }
+    d_max_buffer_samples = sample_rate * channels * 10;
+    d_int16_frame.resize(d_frame_size * channels);
+    init_codec();
+
+    // Pool slots are sized per frame; rebuild them on the next work() call.
+    d_slots.clear();
+    d_slot_head = 0;
+    d_strand.reset();
+    d_use_pool = false;
+
+    d_rt_pending.store(true);
+    d_format_changes++;
+    d_format_tags.emplace_back(nitems_written(0) + output_idx + d_batcher.staged_items(),
+                               format_tag_value(sample_rate, channels));
+}
+
+void opus_encoder_impl::flush_format_tags(int produced)
+{
+    uint64_t end = nitems_written(0) + produced;
+    while (!d_format_tags.empty() && d_format_tags.front().first < end) {
+        add_item_tag(0, d_format_tags.front().first, pmt::mp("opus_format"), d_format_tags.front().second);
+        d_format_tags.pop_front();
+    }
+}
 
-        for (size_t i = 0; i < frame_samples.size(); ++i) {
-            float sample = frame_samples[i];
-            sample = std::max(-1.0f, std::min(1.0f, sample));
-            int16_frame[i] = static_cast<opus_int16>(sample * 32767.0f);
+void opus_encoder_impl::flush_packet_tags()
+{
+    // Packets are emitted whole and back to back from the start of out.
+    uint64_t offset = nitems_written(0);
+    for (size_t len : d_batcher.emitted_units()) {
+        add_item_tag(0, offset, pmt::mp("packet_len"), pmt::from_long(static_cast<long>(len)));
+        offset += len;
+    }
+    d_batcher.clear_emitted_units();
+}
+
+bool opus_encoder_impl::stop()
+{
+    if (d_strand) {
+        d_strand->wait_idle();
+    }
+    return true;
+}
+
+void opus_encoder_impl::shed_oldest()
+{
+    // The buffer always starts on a frame boundary, so dropping whole frames
+    // from the front keeps every later frame intact.
+    size_t frame_size_samples = d_frame_size * d_channels;
+    size_t excess = d_sample_buffer.size() - d_max_buffer_samples;
+    size_t drop = (excess + frame_size_samples - 1) / frame_size_samples * frame_size_samples;
+    drop = std::min(drop, d_sample_buffer.size() / frame_size_samples * frame_size_samples);
+    d_sample_buffer.erase(d_sample_buffer.begin(), d_sample_buffer.begin() + drop);
+    d_frames_shed += drop / frame_size_samples;
+    d_samples_shed += drop;
+}
+
+size_t opus_encoder_impl::accept_input(const float* in, size_t ninput)
+{
+    size_t frame_size_samples = d_frame_size * d_channels;
+    overload_policy_t policy = d_overload_policy.load();
+
+    if (policy == overload_policy_t::BACKPRESSURE) {
+        size_t room = d_sample_buffer.size() < d_max_buffer_samples ? d_max_buffer_samples - d_sample_buffer.size() : 0;
+        size_t take = std::min(ninput, room);
+        if (take < ninput) {
+            d_backpressure_events++;
         }
+        d_sample_buffer.insert(d_sample_buffer.end(), in, in + take);
+        return take;
+    }
 
-        unsigned char encoded_data[4000];
-        int encoded_len = opus_encode(d_encoder,
-                                      int16_frame.data(),
-                                      d_frame_size,
-                                      encoded_data,
-                                      4000);
+    // Finish discarding a frame that drop_newest cut short last time.
+    size_t skip = std::min(d_skip_samples, ninput);
+    d_skip_samples -= skip;
+    d_samples_shed += skip;
+    d_sample_buffer.insert(d_sample_buffer.end(), in + skip, in + ninput);
 
-        if (encoded_len < 0) {
+    if (d_sample_buffer.size() <= d_max_buffer_samples) {
+        return ninput;
+    }
+
+    if (policy == overload_policy_t::DROP_NEWEST) {
+        size_t keep = d_max_buffer_samples / frame_size_samples * frame_size_samples;
+        size_t partial = d_sample_buffer.size() % frame_size_samples;
+        size_t drop = d_sample_buffer.size() - keep;
+        d_sample_buffer.resize(keep);
+        d_frames_shed += (drop + frame_size_samples - 1) / frame_size_samples;
+        d_samples_shed += drop;
+        if (partial > 0) {
+            d_skip_samples = frame_size_samples - partial;
+        }
+    } else {
+        shed_oldest();
+    }
+    return ninput;
+}
+
+void opus_encoder_impl::set_dtx(bool enable)
+{
+    if (enable && d_custom_frame_size > 0) {
+        throw std::runtime_error("DTX is not available for Opus Custom encoders");
+    }
+    d_dtx.store(enable);
+}
+
+void opus_encoder_impl::set_inband_fec(bool enable, int expected_loss_percent)
+{
+    if (enable && d_custom_frame_size > 0) {
+        throw std::runtime_error("In-band FEC is not available for Opus Custom encoders");
+    }
+    if (expected_loss_percent < 0 || expected_loss_percent > 100) {
+        throw std::runtime_error("Expected loss must be 0-100 %");
+    }
+    d_fec_loss_percent.store(expected_loss_percent);
+    d_fec.store(enable);
+}
+
+void opus_encoder_impl::apply_fec()
+{
+    d_applied_fec = d_fec.load();
+    d_applied_fec_loss_percent = d_fec_loss_percent.load();
+    opus_encoder_ctl(d_encoder, OPUS_SET_INBAND_FEC(d_applied_fec ? 1 : 0));
+    opus_encoder_ctl(d_encoder, OPUS_SET_PACKET_LOSS_PERC(d_applied_fec ? d_applied_fec_loss_percent : 0));
+}
+
+void opus_encoder_impl::set_signal_classifier(bool enable)
+{
+    if (enable && d_custom_frame_size > 0) {
+        throw std::runtime_error("The signal classifier is not available for Opus Custom encoders");
+    }
+    d_classify.store(enable);
+}
+
+void opus_encoder_impl::classify_frame(const float* samples)
+{
+    int signal = OPUS_AUTO;
+    int bandwidth = OPUS_BANDWIDTH_FULLBAND;
+    if (d_classify.load()) {
+        if (!d_classifier_active) {
+            d_classifier.reset(d_sample_rate, 1000.0 * d_frame_size / d_sample_rate);
+            d_classifier_active = true;
+        }
+        d_classifier.update(samples, d_frame_size, d_channels);
+        if (d_classifier.signal() == signal_classifier::SIGNAL_VOICE) {
+            signal = OPUS_SIGNAL_VOICE;
+        } else if (d_classifier.signal() == signal_classifier::SIGNAL_MUSIC) {
+            signal = OPUS_SIGNAL_MUSIC;
+        }
+        switch (d_classifier.bandwidth_hz()) {
+        case 4000:
+            bandwidth = OPUS_BANDWIDTH_NARROWBAND;
+            break;
+        case 8000:
+            bandwidth = OPUS_BANDWIDTH_WIDEBAND;
+            break;
+        case 12000:
+            bandwidth = OPUS_BANDWIDTH_SUPERWIDEBAND;
+            break;
+        default:
             break;
         }
+    } else {
+        d_classifier_active = false;
+    }
 
-        if (output_idx + encoded_len <= noutput_items) {
-            std::memcpy(out + output_idx, encoded_data, encoded_len);
-            output_idx += encoded_len;
-            frames_encoded++;
+    if (signal != d_applied_signal.load(std::memory_order_relaxed)) {
+        opus_encoder_ctl(d_encoder, OPUS_SET_SIGNAL(signal));
+        d_applied_signal.store(signal, std::memory_order_relaxed);
+        d_classifier_switches.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (bandwidth != d_applied_max_bandwidth.load(std::memory_order_relaxed)) {
+        opus_encoder_ctl(d_encoder, OPUS_SET_MAX_BANDWIDTH(bandwidth));
+        d_applied_max_bandwidth.store(bandwidth, std::memory_order_relaxed);
+        d_classifier_switches.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void opus_encoder_impl::set_mono_collapse(bool enable, double threshold_db)
+{
+    if (enable && d_custom_frame_size > 0) {
+        throw std::runtime_error("Mono collapse is not available for Opus Custom encoders");
+    }
+    if (threshold_db < 12.0 || threshold_db > 90.0) {
+        throw std::runtime_error("Mono collapse threshold must be 12-90 dB");
+    }
+    d_mono_threshold_db.store(threshold_db);
+    d_mono_collapse.store(enable);
+}
+
+void opus_encoder_impl::detect_mono(const float* samples)
+{
+    bool mono = false;
+    if (d_mono_collapse.load(std::memory_order_relaxed)) {
+        const double threshold_db = d_mono_threshold_db.load(std::memory_order_relaxed);
+        if (!d_mono_detector_active || threshold_db != d_mono_detector.threshold_db()) {
+            // Half a second of identical channels before collapsing.
+            d_mono_detector.reset((d_sample_rate / 2 + d_frame_size - 1) / d_frame_size, threshold_db);
+            d_mono_detector_active = true;
+        }
+        mono = d_mono_detector.update(samples, d_frame_size);
+    } else {
+        d_mono_detector_active = false;
+    }
+
+    if (mono != d_applied_mono.load(std::memory_order_relaxed)) {
+        opus_encoder_ctl(d_encoder, OPUS_SET_FORCE_CHANNELS(mono ? 1 : OPUS_AUTO));
+        d_applied_mono.store(mono, std::memory_order_relaxed);
+        d_mono_switches.fetch_add(1, std::memory_order_relaxed);
+    }
+    const uint64_t frame_us = static_cast<uint64_t>(d_frame_size) * 1000000 / d_sample_rate;
+    (mono ? d_collapsed_us : d_stereo_us).fetch_add(frame_us, std::memory_order_relaxed);
+}
+
+void opus_encoder_impl::set_realtime(bool enable, int priority)
+{
+    if (priority < 0 || priority > 99) {
+        throw std::runtime_error("Real-time priority must be 0-99");
+    }
+    d_realtime_priority.store(priority);
+    d_realtime.store(enable);
+    d_rt_pending.store(true);
+}
+
+void opus_encoder_impl::apply_realtime()
+{
+    d_rt_pending.store(false);
+    const bool enable = d_realtime.load();
+    const int priority = enable ? d_realtime_priority.load() : 0;
+    if (priority != d_applied_rt_priority && set_thread_realtime(priority)) {
+        d_applied_rt_priority = priority;
+    }
+    const int pool_priority = d_pool_requested.load() ? priority : 0;
+    if (pool_priority != d_pool_rt_priority) {
+        codec_thread_pool& pool = codec_thread_pool::instance();
+        if (d_pool_rt_priority > 0) {
+            pool.release_realtime(d_pool_rt_priority);
+        }
+        if (pool_priority > 0) {
+            pool.set_realtime(pool_priority);
+        }
+        d_pool_rt_priority = pool_priority;
+    }
+    d_locked.unlock_all();
+    d_memory_locked = false;
+    d_locked_bytes = 0;
+    if (!enable) {
+        return;
+    }
+
+    // The backlog can overshoot its limit by one input chunk before
+    // shedding, so leave room for that too.
+    const size_t input_slack = 65536;
+    bool locked = d_locked.reserve(d_sample_buffer, d_max_buffer_samples + input_slack);
+    locked &= d_batcher.lock_storage(65536, d_locked);
+    locked &= d_locked.reserve(d_int16_frame, d_int16_frame.size());
+    if (d_encoder_mem != nullptr) {
+        locked &= d_locked.lock(d_encoder_mem,
+                                static_cast<size_t>(std::max(opus_encoder_get_size(1), opus_encoder_get_size(2))));
+    }
+    for (auto& slot : d_slots) {
+        locked &= d_locked.lock(slot.get(), sizeof(pool_slot));
+        locked &= d_locked.reserve(slot->pcm, slot->pcm.size());
+    }
+    prefault_stack();
+    d_memory_locked = locked;
+    d_locked_bytes = d_locked.bytes();
+}
+
+void opus_encoder_impl::set_load_priority(const std::string& priority)
+{
+    d_load_channel->set_priority(load_priority_from_string(priority));
+}
+
+void opus_encoder_impl::adjust_quality()
+{
+    // Codec ctls must not race a pool worker using the same state.
+    if (d_custom_frame_size > 0 || d_slot_count > 0) {
+        return;
+    }
+    // Re-evaluate at most every 10 work() calls so each step can take effect.
+    if (++d_calls_since_adjust < 10) {
+        return;
+    }
+
+    // The bank-wide governor caps complexity and, at minimal level, DRED.
+    const int shed = std::min<int>(d_load_channel->level(), SHED_MINIMAL);
+    const int max_complexity = shed == SHED_MINIMAL ? 0 : (shed == SHED_REDUCED ? 4 : 10);
+    if (shed != d_applied_shed_level) {
+#ifdef OPUS_HAVE_DRED
+        if (d_enable_fargan_voice && (shed == SHED_MINIMAL) != (d_applied_shed_level == SHED_MINIMAL)) {
+            opus_encoder_ctl(d_encoder, OPUS_SET_DRED_DURATION(shed == SHED_MINIMAL ? 0 : 5));
+        }
+#endif
+        d_applied_shed_level = shed;
+    }
+
+    size_t backlog = d_sample_buffer.size();
+    int bitrate = d_current_bitrate;
+    int complexity = d_current_complexity;
+    if (d_overload_policy.load() != overload_policy_t::DEGRADE_BITRATE) {
+        bitrate = d_bitrate;
+        complexity = d_complexity;
+    } else if (backlog > d_max_buffer_samples / 2) {
+        complexity = std::max(0, complexity - 2);
+        bitrate = std::max(6000, bitrate * 3 / 4);
+    } else if (backlog < d_max_buffer_samples / 8) {
+        complexity = std::min(d_complexity, complexity + 2);
+        bitrate = std::min(d_bitrate, bitrate * 4 / 3);
+    }
+    complexity = std::min(complexity, max_complexity);
+    if (bitrate == d_current_bitrate && complexity == d_current_complexity) {
+        return;
+    }
+
+    if (bitrate < d_current_bitrate || complexity < d_current_complexity) {
+        d_quality_steps_down++;
+    }
+    opus_encoder_ctl(d_encoder, OPUS_SET_BITRATE(bitrate));
+    opus_encoder_ctl(d_encoder, OPUS_SET_COMPLEXITY(complexity));
+    d_current_bitrate = bitrate;
+    d_current_complexity = complexity;
+    d_calls_since_adjust = 0;
+}
+
+int opus_encoder_impl::encode_frame(const float* samples, unsigned char* packet, opus_int32 max_bytes)
+{
+    const auto start = std::chrono::steady_clock::now();
+    if (d_custom_frame_size == 0 && (d_classify.load(std::memory_order_relaxed) || d_classifier_active)) {
+        classify_frame(samples);
+    }
+    if (d_custom_frame_size == 0 && d_channels == 2) {
+        detect_mono(samples);
+    }
+    float_to_int16(samples, d_int16_frame.data(), static_cast<size_t>(d_frame_size) * d_channels);
+    int encoded_len = d_custom_frame_size > 0
+        ? d_custom.encode(d_int16_frame.data(), packet, std::min<int>(max_bytes, d_custom_packet_bytes))
+        : opus_encode(d_encoder, d_int16_frame.data(), d_frame_size, packet, max_bytes);
+    d_load_channel->add_busy(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    return encoded_len;
+}
+
+void opus_encoder_impl::apply_pool_mode()
+{
+    bool enable = d_pool_requested.load();
+    size_t depth = static_cast<size_t>(d_pool_depth_requested.load());
+    if (enable == d_use_pool && (!enable || depth == d_slots.size())) {
+        return;
+    }
+    // Switch only once every in-flight packet has been emitted, so the
+    // output never reorders across the change.
+    if (d_slot_count > 0) {
+        return;
+    }
+
+    d_use_pool = enable;
+    d_locked.unlock_all();
+    d_slots.clear();
+    d_slot_head = 0;
+    d_strand.reset();
+    // Either way the pool's real-time request and the locked slots change.
+    d_rt_pending.store(true);
+    if (!enable) {
+        return;
+    }
+
+    d_strand = codec_thread_pool::instance().make_strand(depth);
+    for (size_t i = 0; i < depth; ++i) {
+        std::unique_ptr<pool_slot> slot(new pool_slot());
+        slot->pcm.resize(d_frame_size * d_channels);
+        slot->packet_len = 0;
+        slot->failed = false;
+        slot->done.store(false);
+        d_slots.push_back(std::move(slot));
+    }
+}
+
+bool opus_encoder_impl::wait_head_slot()
+{
+    // Bounded so a stalled pool cannot hang the scheduler thread.
+    pool_slot& slot = *d_slots[d_slot_head];
+    std::unique_lock<std::mutex> lock(d_slot_mutex);
+    return d_slot_cv.wait_for(lock, std::chrono::milliseconds(10),
+                              [&slot] { return slot.done.load(std::memory_order_acquire); });
+}
+
+void opus_encoder_impl::complete_slot(pool_slot& slot)
+{
+    slot.done.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(d_slot_mutex);
+    }
+    d_slot_cv.notify_one();
+}
+
+int opus_encoder_impl::release_at_end(unsigned char* out, int noutput_items)
+{
+    // Once the input has ended nothing will complete a partial batch.
+    if (d_batcher.staged_units() == d_batcher.released_units() || d_slot_count > 0 || !upstream_done(*this, 0)) {
+        return 0;
+    }
+    d_batcher.release_all();
+    return static_cast<int>(d_batcher.emit(out, noutput_items));
+}
+
+int opus_encoder_impl::drain_pool(unsigned char* out, int noutput_items)
+{
+    int output_idx = static_cast<int>(d_batcher.emit(out, noutput_items));
+    while (d_slot_count > 0 && d_batcher.released_units() == 0) {
+        pool_slot& slot = *d_slots[d_slot_head];
+        if (!slot.done.load(std::memory_order_acquire)) {
+            break;
+        }
+        if (slot.failed) {
+            d_pool_errors++;
+        } else if (slot.packet_len > 0) {
+            d_batcher.push(slot.packet, slot.packet_len);
+            d_frames_encoded++;
         } else {
-            d_sample_buffer.insert(d_sample_buffer.begin(), frame_samples.begin(), frame_samples.end());
+            d_encode_errors++;
+        }
+        d_slot_head = (d_slot_head + 1) % d_slots.size();
+        d_slot_count--;
+        output_idx += d_batcher.emit(out + output_idx, noutput_items - output_idx);
+    }
+    return output_idx;
+}
+
+int opus_encoder_impl::submit_pool_frames(int max_frames)
+{
+    size_t frame_size_samples = d_frame_size * d_channels;
+    size_t consumed = 0;
+    int submitted = 0;
+
+    while (d_sample_buffer.size() - consumed >= frame_size_samples && d_slot_count < d_slots.size() &&
+           (max_frames <= 0 || submitted < max_frames)) {
+        pool_slot* slot = d_slots[(d_slot_head + d_slot_count) % d_slots.size()].get();
+        std::copy(d_sample_buffer.begin() + consumed,
+                  d_sample_buffer.begin() + consumed + frame_size_samples,
+                  slot->pcm.begin());
+        slot->failed = false;
+        slot->done.store(false, std::memory_order_relaxed);
+
+        bool queued = d_strand->try_submit([this, slot]() {
+            try {
+                slot->packet_len = encode_frame(slot->pcm.data(), slot->packet, sizeof(slot->packet));
+            } catch (...) {
+                // Complete the slot so work() moves past it; the pool counts the exception.
+                slot->failed = true;
+                complete_slot(*slot);
+                throw;
+            }
+            complete_slot(*slot);
+        });
+        if (!queued) {
             break;
         }
+        consumed += frame_size_samples;
+        d_slot_count++;
+        submitted++;
+    }
+
+    if (consumed > 0) {
+        d_sample_buffer.erase(d_sample_buffer.begin(), d_sample_buffer.begin() + consumed);
+    }
+    return submitted;
+}
+
+pmt::pmt_t opus_encoder_impl::telemetry_dict() const
+{
+    double frames_per_work = d_interval_work_calls > 0
+        ? static_cast<double>(d_interval_frames) / d_interval_work_calls : 0.0;
+    double frames_per_emit = d_interval_emit_calls > 0
+        ? static_cast<double>(d_interval_frames) / d_interval_emit_calls : 0.0;
+
+    pmt::pmt_t dict = pmt::make_dict();
+    dict = pmt::dict_add(dict, pmt::mp("frames_encoded"), pmt::from_uint64(d_frames_encoded));
+    dict = pmt::dict_add(dict, pmt::mp("encode_errors"), pmt::from_uint64(d_encode_errors));
+    dict = pmt::dict_add(dict, pmt::mp("bytes_emitted"), pmt::from_uint64(d_bytes_emitted));
+    dict = pmt::dict_add(dict, pmt::mp("work_calls"), pmt::from_uint64(d_work_calls));
+    dict = pmt::dict_add(dict, pmt::mp("emit_calls"), pmt::from_uint64(d_emit_calls));
+    dict = pmt::dict_add(dict, pmt::mp("frames_per_work"), pmt::from_double(frames_per_work));
+    dict = pmt::dict_add(dict, pmt::mp("frames_per_emit"), pmt::from_double(frames_per_emit));
+    dict = pmt::dict_add(dict, pmt::mp("max_frames_per_work"), pmt::from_long(d_max_frames_per_work.load()));
+    dict = pmt::dict_add(dict, pmt::mp("min_frames_per_emit"), pmt::from_long(d_min_frames_per_emit.load()));
+    dict = pmt::dict_add(dict, pmt::mp("staged_packets"), pmt::from_uint64(d_batcher.staged_units()));
+    dict = pmt::dict_add(dict, pmt::mp("buffered_samples"), pmt::from_uint64(d_sample_buffer.size()));
+    dict = pmt::dict_add(dict, pmt::mp("shared_pool"), pmt::from_bool(d_use_pool));
+    dict = pmt::dict_add(dict, pmt::mp("pool_errors"), pmt::from_uint64(d_pool_errors));
+    dict = pmt::dict_add(dict, pmt::mp("pool_jobs_failed"),
+                         pmt::from_uint64(codec_thread_pool::instance().jobs_failed()));
+    dict = pmt::dict_add(dict, pmt::mp("sample_rate"), pmt::from_long(d_sample_rate));
+    dict = pmt::dict_add(dict, pmt::mp("channels"), pmt::from_long(d_channels));
+    dict = pmt::dict_add(dict, pmt::mp("format_changes"), pmt::from_uint64(d_format_changes));
+    dict = pmt::dict_add(dict, pmt::mp("custom_mode"), pmt::from_bool(d_custom_frame_size > 0));
+    dict = pmt::dict_add(dict, pmt::mp("overload_policy"), pmt::mp(overload_policy_to_string(d_overload_policy.load())));
+    dict = pmt::dict_add(dict, pmt::mp("frames_shed"), pmt::from_uint64(d_frames_shed));
+    dict = pmt::dict_add(dict, pmt::mp("samples_shed"), pmt::from_uint64(d_samples_shed));
+    dict = pmt::dict_add(dict, pmt::mp("backpressure_events"), pmt::from_uint64(d_backpressure_events));
+    dict = pmt::dict_add(dict, pmt::mp("quality_steps_down"), pmt::from_uint64(d_quality_steps_down));
+    dict = pmt::dict_add(dict, pmt::mp("current_bitrate"), pmt::from_long(d_current_bitrate));
+    dict = pmt::dict_add(dict, pmt::mp("current_complexity"), pmt::from_long(d_current_complexity));
+    dict = pmt::dict_add(dict, pmt::mp("load_priority"), pmt::mp(load_priority_to_string(d_load_channel->priority())));
+    dict = pmt::dict_add(dict, pmt::mp("load_shed_level"), pmt::from_long(d_load_channel->level()));
+    dict = pmt::dict_add(dict, pmt::mp("frames_muted"), pmt::from_uint64(d_frames_muted));
+    const int signal = d_applied_signal.load(std::memory_order_relaxed);
+    const int max_bandwidth = d_applied_max_bandwidth.load(std::memory_order_relaxed);
+    dict = pmt::dict_add(dict, pmt::mp("signal_classifier"), pmt::from_bool(d_classify.load()));
+    dict = pmt::dict_add(dict, pmt::mp("signal_type"),
+                         pmt::mp(signal == OPUS_SIGNAL_VOICE ? "voice" : (signal == OPUS_SIGNAL_MUSIC ? "music" : "auto")));
+    dict = pmt::dict_add(dict, pmt::mp("max_bandwidth_hz"),
+                         pmt::from_long(max_bandwidth == OPUS_BANDWIDTH_NARROWBAND ? 4000 :
+                                        max_bandwidth == OPUS_BANDWIDTH_WIDEBAND ? 8000 :
+                                        max_bandwidth == OPUS_BANDWIDTH_SUPERWIDEBAND ? 12000 : 20000));
+    dict = pmt::dict_add(dict, pmt::mp("classifier_switches"), pmt::from_uint64(d_classifier_switches.load()));
+    dict = pmt::dict_add(dict, pmt::mp("mono_collapse"), pmt::from_bool(d_mono_collapse.load()));
+    dict = pmt::dict_add(dict, pmt::mp("mono_collapsed"), pmt::from_bool(d_applied_mono.load(std::memory_order_relaxed)));
+    dict = pmt::dict_add(dict, pmt::mp("mono_switches"), pmt::from_uint64(d_mono_switches.load()));
+    dict = pmt::dict_add(dict, pmt::mp("collapsed_seconds"), pmt::from_double(collapsed_seconds()));
+    dict = pmt::dict_add(dict, pmt::mp("stereo_seconds"), pmt::from_double(stereo_seconds()));
+    dict = pmt::dict_add(dict, pmt::mp("realtime"), pmt::from_bool(d_realtime.load()));
+    dict = pmt::dict_add(dict, pmt::mp("realtime_priority"), pmt::from_long(d_applied_rt_priority));
+    dict = pmt::dict_add(dict, pmt::mp("pool_realtime_priority"), pmt::from_long(codec_thread_pool::instance().realtime_priority()));
+    dict = pmt::dict_add(dict, pmt::mp("memory_locked"), pmt::from_bool(d_memory_locked));
+    dict = pmt::dict_add(dict, pmt::mp("locked_bytes"), pmt::from_uint64(d_locked_bytes));
+    dict = pmt::dict_add(dict, pmt::mp("work_minor_faults"), pmt::from_uint64(d_work_minor_faults));
+    dict = pmt::dict_add(dict, pmt::mp("work_major_faults"), pmt::from_uint64(d_work_major_faults));
+    return dict;
+}
+
+void opus_encoder_impl::update_telemetry(int frames, int produced)
+{
+    d_work_calls++;
+    d_interval_work_calls++;
+    d_interval_frames += frames;
+    if (produced > 0) {
+        d_bytes_emitted += produced;
+        d_emit_calls++;
+        d_interval_emit_calls++;
+    }
+
+    int interval = d_telemetry_interval.load();
+    if (interval > 0 && d_interval_frames >= static_cast<uint64_t>(interval)) {
+        message_port_pub(pmt::mp("telemetry"), telemetry_dict());
+        d_interval_frames = 0;
+        d_interval_work_calls = 0;
+        d_interval_emit_calls = 0;
     }
+}
 
+void opus_encoder_impl::forecast(int noutput_items, gr_vector_int& ninput_items_required)
+{
+    // Buffered frames and in-flight packets can be emitted without new
+    // input; that also lets backpressure drain the backlog.
+    size_t frame_size_samples = d_frame_size * d_channels;
+    bool pending = d_sample_buffer.size() >= frame_size_samples || d_slot_count > 0 || d_batcher.released_units() > 0 ||
+                   (d_batcher.staged_units() > 0 && upstream_done(*this, 0));
+    ninput_items_required[0] = pending ? 0 : 1;
+}
+
+int opus_encoder_impl::general_work(int noutput_items,
+                                    gr_vector_int& ninput_items,
+                                    gr_vector_const_void_star& input_items,
+                                    gr_vector_void_star& output_items)
+{
+    const float* in = (const float*)input_items[0];
+    unsigned char* out = (unsigned char*)output_items[0];
+    if (!codec_ready()) {
+        wait_codec();
+    }
+    if (d_rt_pending.load() && d_slot_count == 0) {
+        apply_realtime();
+    }
+    // Both steps above fault pages in on purpose; count only what follows.
+    fault_scope faults(d_realtime.load(), d_work_minor_faults, d_work_major_faults);
+    d_load_channel->poll();
+
+    d_batcher.set_record_units(d_packet_tags.load());
+
+    int output_idx = 0;
+    if (d_format_pending.load()) {
+        output_idx = drain_pool(out, noutput_items);
+        apply_format(output_idx);
+    }
+
+    consume_each(static_cast<int>(accept_input(in, ninput_items[0])));
+    const int shed = d_load_channel->level();
+    if (shed >= SHED_MUTED) {
+        // Muted by the load governor: whole frames are discarded unencoded.
+        size_t frame_size_samples = d_frame_size * d_channels;
+        size_t frames = d_sample_buffer.size() / frame_size_samples;
+        d_sample_buffer.erase(d_sample_buffer.begin(), d_sample_buffer.begin() + frames * frame_size_samples);
+        d_frames_muted += frames;
+    }
+    if (d_overload_policy.load() == overload_policy_t::DEGRADE_BITRATE || d_current_bitrate != d_bitrate ||
+        d_current_complexity != d_complexity || std::min<int>(shed, SHED_MINIMAL) != d_applied_shed_level) {
+        adjust_quality();
+    }
+
+    // Like the quality ctls, only while no pool job holds the encoder.
+    if (d_dtx.load() != d_applied_dtx && d_slot_count == 0 && d_custom_frame_size == 0) {
+        d_applied_dtx = d_dtx.load();
+        opus_encoder_ctl(d_encoder, OPUS_SET_DTX(d_applied_dtx ? 1 : 0));
+    }
+    if ((d_fec.load() != d_applied_fec || d_fec_loss_percent.load() != d_applied_fec_loss_percent) &&
+        d_slot_count == 0 && d_custom_frame_size == 0) {
+        apply_fec();
+    }
+
+    apply_pool_mode();
+    d_batcher.set_min_batch(d_min_frames_per_emit.load());
+
+    const int max_frames = d_max_frames_per_work.load();
+    int frames_this_call = 0;
+    output_idx += drain_pool(out + output_idx, noutput_items - output_idx);
+
+    if (d_use_pool) {
+        if (d_pool_requested.load()) {
+            frames_this_call = submit_pool_frames(max_frames);
+        }
+        // With nothing to emit yet, wait for the head slot: returning empty
+        // while jobs are in flight would have the scheduler spin on us.
+        while (output_idx == 0 && d_slot_count > 0 && wait_head_slot()) {
+            output_idx += drain_pool(out, noutput_items);
+        }
+    } else if (d_slot_count == 0) {
+        size_t frame_size_samples = d_frame_size * d_channels;
+        size_t consumed = 0;
+        unsigned char encoded_data[4000];
+
+        // Stop once a released batch no longer fits: the rest of the input
+        // stays buffered instead of piling up as staged packets.
+        while (d_sample_buffer.size() - consumed >= frame_size_samples &&
+               (max_frames <= 0 || frames_this_call < max_frames) &&
+               d_batcher.released_units() == 0) {
+            int encoded_len = encode_frame(d_sample_buffer.data() + consumed, encoded_data, sizeof(encoded_data));
+            consumed += frame_size_samples;
+            frames_this_call++;
+
+            if (encoded_len < 0) {
+                d_encode_errors++;
+                continue;
+            }
+            d_frames_encoded++;
+            d_batcher.push(encoded_data, encoded_len);
+            output_idx += d_batcher.emit(out + output_idx, noutput_items - output_idx);
+        }
+
+        if (consumed > 0) {
+            d_sample_buffer.erase(d_sample_buffer.begin(), d_sample_buffer.begin() + consumed);
+        }
+    }
+
+    output_idx += release_at_end(out + output_idx, noutput_items - output_idx);
+
+    if (!d_format_tags.empty()) {
+        flush_format_tags(output_idx);
+    }
+    if (d_packet_tags.load()) {
+        flush_packet_tags();
+    }
+    update_telemetry(frames_this_call, output_idx);
     return output_idx;
 }
 
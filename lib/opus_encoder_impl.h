@@ -22,6 +22,21 @@
 #define INCLUDED_GR_OPUS_OPUS_ENCODER_IMPL_H
 
 #include <gnuradio/gr_opus/opus_encoder.h>
+#include "codec_thread_pool.h"
+#include "dnn_blob_cache.h"
+#include "load_registry.h"
+#include "opus_custom_engine.h"
+#include "overload_policy.h"
+#include "output_batcher.h"
+#include "mono_detector.h"
+#include "realtime.h"
+#include "signal_classifier.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <opus/opus.h>
 #include <vector>
@@ -32,24 +47,194 @@ namespace gr_opus {
 class opus_encoder_impl : public opus_encoder
 {
 private:
+    // Codec state lives in memory we own (sized for stereo) so a format
+    // change can re-run opus_encoder_init without reallocating.
     OpusEncoder* d_encoder;
+    void* d_encoder_mem;
+    // Opus Custom engine, used instead of the standard state when the block
+    // was made with make_custom (d_custom_frame_size > 0).
+    int d_custom_frame_size;
+    custom_encoder_engine d_custom;
+    int d_custom_packet_bytes;
     int d_sample_rate;
     int d_channels;
     int d_bitrate;
+    int d_application;
     int d_frame_size;
     bool d_enable_fargan_voice;
+    std::string d_dnn_blob_path;
+    dnn_blob_ptr d_dnn_blob;
     std::vector<float> d_sample_buffer;
     size_t d_max_buffer_samples;
 
-    int application_string_to_int(const std::string& application);
+    std::atomic<overload_policy_t> d_overload_policy;
+    size_t d_skip_samples; // rest of a frame cut short by drop_newest
+    int d_current_bitrate;
+    int d_complexity;
+    int d_current_complexity;
+    int d_calls_since_adjust;
+    uint64_t d_frames_shed;
+    uint64_t d_samples_shed;
+    uint64_t d_backpressure_events;
+    uint64_t d_quality_steps_down;
+
+    std::shared_ptr<load_channel> d_load_channel;
+    int d_applied_shed_level;
+    uint64_t d_frames_muted;
+    std::vector<opus_int16> d_int16_frame;
+
+    struct pool_slot {
+        std::vector<float> pcm;
+        unsigned char packet[4000];
+        int packet_len;
+        bool failed; // the job threw; packet_len is not valid
+        std::atomic<bool> done;
+    };
+    std::shared_ptr<codec_strand> d_strand;
+    std::vector<std::unique_ptr<pool_slot>> d_slots;
+    size_t d_slot_head;
+    size_t d_slot_count;
+    std::atomic<bool> d_pool_requested;
+    std::atomic<int> d_pool_depth_requested;
+    bool d_use_pool;
+    // Pool jobs signal here as their slots complete.
+    std::mutex d_slot_mutex;
+    std::condition_variable d_slot_cv;
+
+    output_batcher<unsigned char> d_batcher;
+    std::atomic<int> d_max_frames_per_work;
+    std::atomic<int> d_min_frames_per_emit;
+    std::atomic<int> d_telemetry_interval;
+    std::atomic<bool> d_packet_tags;
+    std::atomic<bool> d_dtx;
+    bool d_applied_dtx;
+    std::atomic<bool> d_fec;
+    std::atomic<int> d_fec_loss_percent;
+    bool d_applied_fec;
+    int d_applied_fec_loss_percent;
+    // Classifier state is only touched from encode_frame(), which runs
+    // serially (inline or on the strand); the applied values are read by
+    // telemetry.
+    std::atomic<bool> d_classify;
+    bool d_classifier_active;
+    signal_classifier d_classifier;
+    std::atomic<int> d_applied_signal;
+    std::atomic<int> d_applied_max_bandwidth;
+    std::atomic<uint64_t> d_classifier_switches;
+    // Mono collapse, on the same terms as the classifier. Time in each mode
+    // is kept in microseconds of audio.
+    std::atomic<bool> d_mono_collapse;
+    std::atomic<double> d_mono_threshold_db;
+    bool d_mono_detector_active;
+    mono_detector d_mono_detector;
+    std::atomic<bool> d_applied_mono;
+    std::atomic<uint64_t> d_mono_switches;
+    std::atomic<uint64_t> d_collapsed_us;
+    std::atomic<uint64_t> d_stereo_us;
+
+    // Real-time mode; applied from work() while no pool job is in flight,
+    // and again whenever buffers have been rebuilt.
+    std::atomic<bool> d_realtime;
+    std::atomic<int> d_realtime_priority;
+    std::atomic<bool> d_rt_pending;
+    int d_applied_rt_priority;
+    int d_pool_rt_priority; // our request on the shared pool, 0 for none
+    locked_ranges d_locked;
+    bool d_memory_locked;
+    uint64_t d_locked_bytes;
+    uint64_t d_work_minor_faults;
+    uint64_t d_work_major_faults;
+
+    uint64_t d_frames_encoded;
+    uint64_t d_encode_errors;
+    uint64_t d_pool_errors;
+    uint64_t d_bytes_emitted;
+    uint64_t d_work_calls;
+    uint64_t d_emit_calls;
+    uint64_t d_interval_frames;
+    uint64_t d_interval_work_calls;
+    uint64_t d_interval_emit_calls;
+
+    std::mutex d_format_mutex;
+    std::atomic<bool> d_format_pending;
+    int d_pending_sample_rate;
+    int d_pending_channels;
+    uint64_t d_format_changes;
+    std::deque<std::pair<uint64_t, pmt::pmt_t>> d_format_tags;
+
+    // Deferred initialisation: codec creation runs on the shared pool and
+    // is joined in start() (or the first work() call).
+    std::shared_ptr<codec_strand> d_init_strand;
+    std::exception_ptr d_init_error;
+
+    void create_codec();
+    void init_codec();
+    void destroy_codec();
+    void wait_codec();
+    bool codec_ready() const { return d_custom_frame_size > 0 ? d_custom.ready() : d_encoder != nullptr; }
+    bool valid_format(int sample_rate, int channels) const;
+    void handle_reconfig(const pmt::pmt_t& msg);
+    void apply_format(int output_idx);
+    void flush_format_tags(int produced);
+    void flush_packet_tags();
+    size_t accept_input(const float* in, size_t ninput);
+    void shed_oldest();
+    void adjust_quality();
+    void apply_fec();
+    void classify_frame(const float* samples);
+    void detect_mono(const float* samples);
+    void apply_realtime();
+    int encode_frame(const float* samples, unsigned char* packet, opus_int32 max_bytes);
+    void apply_pool_mode();
+    int drain_pool(unsigned char* out, int noutput_items);
+    bool wait_head_slot();
+    void complete_slot(pool_slot& slot);
+    int release_at_end(unsigned char* out, int noutput_items);
+    int submit_pool_frames(int max_frames);
+    void update_telemetry(int frames, int produced);
+    pmt::pmt_t telemetry_dict() const;
 
 public:
-    opus_encoder_impl(int sample_rate, int channels, int bitrate, const std::string& application, bool enable_fargan_voice = false, const std::string& dnn_blob_path = "");
+    opus_encoder_impl(int sample_rate, int channels, int bitrate, const std::string& application, bool enable_fargan_voice = false, const std::string& dnn_blob_path = "", bool defer_init = false, int custom_frame_size = 0);
     ~opus_encoder_impl();
 
-    int work(int noutput_items,
-             gr_vector_const_void_star& input_items,
-             gr_vector_void_star& output_items);
+    void set_shared_pool(bool enable, int queue_depth) override;
+    bool shared_pool() const override { return d_pool_requested.load(); }
+
+    void set_max_frames_per_work(int frames) override;
+    int max_frames_per_work() const override { return d_max_frames_per_work.load(); }
+    void set_min_frames_per_emit(int frames) override;
+    int min_frames_per_emit() const override { return d_min_frames_per_emit.load(); }
+    void set_telemetry_interval(int frames) override;
+    void set_packet_tags(bool enable) override { d_packet_tags.store(enable); }
+    bool packet_tags() const override { return d_packet_tags.load(); }
+    void set_dtx(bool enable) override;
+    bool dtx() const override { return d_dtx.load(); }
+    void set_inband_fec(bool enable, int expected_loss_percent) override;
+    bool inband_fec() const override { return d_fec.load(); }
+    void set_signal_classifier(bool enable) override;
+    bool signal_classifier_enabled() const override { return d_classify.load(); }
+    void set_mono_collapse(bool enable, double threshold_db) override;
+    bool mono_collapse() const override { return d_mono_collapse.load(); }
+    double collapsed_seconds() const override { return d_collapsed_us.load() * 1e-6; }
+    double stereo_seconds() const override { return d_stereo_us.load() * 1e-6; }
+    void set_realtime(bool enable, int priority) override;
+    bool realtime() const override { return d_realtime.load(); }
+    void set_format(int sample_rate, int channels) override;
+    void set_overload_policy(const std::string& policy) override;
+    std::string overload_policy() const override { return overload_policy_to_string(d_overload_policy.load()); }
+    void set_load_priority(const std::string& priority) override;
+    std::string load_priority() const override { return load_priority_to_string(d_load_channel->priority()); }
+    int load_shed_level() const override { return d_load_channel->level(); }
+
+    bool start() override;
+    bool stop() override;
+
+    void forecast(int noutput_items, gr_vector_int& ninput_items_required) override;
+    int general_work(int noutput_items,
+                     gr_vector_int& ninput_items,
+                     gr_vector_const_void_star& input_items,
+                     gr_vector_void_star& output_items) override;
 };
 
 } // namespace gr_opus
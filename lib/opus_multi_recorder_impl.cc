@@ -0,0 +1,282 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_multi_recorder_impl.h"
+#include "codec_format.h"
+#include <opus/opus.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// libopus lookahead in the default applications, in 48 kHz samples. Every
+// segment starts a fresh decoder, so each file declares it.
+const int ogg_pre_skip = 312;
+
+// Data pages are closed after this much audio, which bounds both the seek
+// index granularity and what a crash can lose from an open page.
+const int64_t page_samples = 48000;
+
+// A spurt closes after this much silence (48 kHz samples). libopus codes
+// about 200 ms of silence normally before DTX engages, and sends isolated
+// comfort-noise updates while idle; a spurt must hold more active audio
+// than that to be indexed.
+const int64_t spurt_hangover = 14400;
+const int64_t min_spurt_active = 12000;
+
+} // namespace
+
+opus_multi_recorder::sptr opus_multi_recorder::make(int num_inputs,
+                                                    const std::string& directory,
+                                                    const std::string& prefix,
+                                                    int sample_rate,
+                                                    int channels,
+                                                    int packet_size,
+                                                    double segment_seconds,
+                                                    long segment_bytes,
+                                                    long max_queued_bytes)
+{
+    return gnuradio::get_initial_sptr(new opus_multi_recorder_impl(num_inputs,
+                                                                   directory,
+                                                                   prefix,
+                                                                   sample_rate,
+                                                                   channels,
+                                                                   packet_size,
+                                                                   segment_seconds,
+                                                                   segment_bytes,
+                                                                   max_queued_bytes));
+}
+
+opus_multi_recorder_impl::opus_multi_recorder_impl(int num_inputs,
+                                                   const std::string& directory,
+                                                   const std::string& prefix,
+                                                   int sample_rate,
+                                                   int channels,
+                                                   int packet_size,
+                                                   double segment_seconds,
+                                                   long segment_bytes,
+                                                   long max_queued_bytes)
+    : gr::sync_block("opus_multi_recorder",
+                     gr::io_signature::make(std::max(1, num_inputs), std::max(1, num_inputs), sizeof(unsigned char)),
+                     gr::io_signature::make(0, 0, 0)),
+      d_directory(directory),
+      d_prefix(prefix),
+      d_sample_rate(sample_rate),
+      d_channels(channels),
+      d_segment_samples(segment_seconds > 0.0 ? static_cast<int64_t>(segment_seconds * 48000) : 0),
+      d_segment_bytes(segment_bytes),
+      d_serial_base(std::random_device()()),
+      d_rotate(false),
+      d_segments_completed(0),
+      d_spurts_indexed(0),
+      d_pages_dropped(0),
+      d_invalid_packets(0),
+      d_writer(static_cast<size_t>(std::max(1L, max_queued_bytes)))
+{
+    if (num_inputs < 1) {
+        throw std::runtime_error("opus_multi_recorder needs at least one input");
+    }
+    check_opus_format(sample_rate, channels);
+    if (access(directory.c_str(), W_OK) != 0) {
+        throw std::runtime_error("Recording directory is not writable: " + directory);
+    }
+
+    d_inputs.reserve(num_inputs);
+    for (int i = 0; i < num_inputs; ++i) {
+        d_inputs.emplace_back(packet_size);
+    }
+}
+
+opus_multi_recorder_impl::~opus_multi_recorder_impl()
+{
+    stop();
+}
+
+bool opus_multi_recorder_impl::stop()
+{
+    for (size_t i = 0; i < d_inputs.size(); ++i) {
+        if (d_inputs[i].pages) {
+            close_segment(static_cast<int>(i));
+        }
+    }
+    return true;
+}
+
+bool opus_multi_recorder_impl::send(int file, std::vector<unsigned char> data)
+{
+    if (!d_writer.write(file, std::move(data))) {
+        d_pages_dropped++;
+        return false;
+    }
+    return true;
+}
+
+void opus_multi_recorder_impl::open_segment(int input)
+{
+    input_state& s = d_inputs[input];
+    char name[64];
+    std::snprintf(name, sizeof(name), "_ch%03d_%06ld", input, s.segment);
+    std::string base = d_directory + "/" + d_prefix + name;
+    s.file = d_writer.open(base + ".opus");
+    s.index = d_writer.open(base + ".idx");
+    s.spurts = d_writer.open(base + ".spurts");
+    s.in_spurt = false;
+    s.pages.reset(new ogg_page_builder(d_serial_base + static_cast<uint32_t>(input) * 7919u +
+                                       static_cast<uint32_t>(s.segment)));
+    s.page_granule = 0;
+    s.file_bytes = 0;
+
+    // Stagger the first segment of each input so that a bank does not
+    // rotate (and sync) every file in the same instant.
+    s.time_limit = d_segment_samples;
+    if (s.segment == 0 && d_segment_samples > 0) {
+        s.time_limit -= d_segment_samples * input / static_cast<int64_t>(d_inputs.size());
+    }
+
+    std::vector<unsigned char> headers;
+    std::vector<unsigned char> head = opus_head_packet(d_channels, d_sample_rate, ogg_pre_skip);
+    s.pages->add_packet(head.data(), head.size(), 0);
+    s.pages->flush(headers, true, false);
+    std::vector<unsigned char> tags = opus_tags_packet("gr-opus");
+    s.pages->add_packet(tags.data(), tags.size(), 0);
+    s.pages->flush(headers, false, false);
+    size_t size = headers.size();
+    if (send(s.file, std::move(headers))) {
+        s.file_bytes += size;
+    }
+}
+
+void opus_multi_recorder_impl::write_page(input_state& s, bool eos)
+{
+    std::vector<unsigned char> page;
+    s.pages->flush(page, false, eos);
+    size_t size = page.size();
+    if (!send(s.file, std::move(page))) {
+        return;
+    }
+    std::string line = std::to_string(s.pages->granule()) + " " + std::to_string(s.file_bytes) + "\n";
+    send(s.index, std::vector<unsigned char>(line.begin(), line.end()));
+    s.file_bytes += size;
+    s.page_granule = s.pages->granule();
+}
+
+void opus_multi_recorder_impl::track_activity(input_state& s, int64_t start, int64_t end, bool active)
+{
+    if (active) {
+        if (!s.in_spurt) {
+            s.in_spurt = true;
+            s.spurt_start = start;
+            s.spurt_active = 0;
+        }
+        s.spurt_end = end;
+        s.spurt_active += end - start;
+    } else if (s.in_spurt && end - s.spurt_end >= spurt_hangover) {
+        end_spurt(s);
+    }
+}
+
+void opus_multi_recorder_impl::end_spurt(input_state& s)
+{
+    s.in_spurt = false;
+    if (s.spurt_active <= min_spurt_active) {
+        return;
+    }
+    std::string line = std::to_string(s.spurt_start) + " " + std::to_string(s.spurt_end) + "\n";
+    send(s.spurts, std::vector<unsigned char>(line.begin(), line.end()));
+    d_spurts_indexed++;
+}
+
+void opus_multi_recorder_impl::close_segment(int input)
+{
+    input_state& s = d_inputs[input];
+    if (s.in_spurt) {
+        end_spurt(s);
+    }
+    write_page(s, true);
+    d_writer.close(s.file, true);
+    d_writer.close(s.index, false);
+    d_writer.close(s.spurts, false);
+    s.pages.reset();
+    s.segment++;
+    d_segments_completed++;
+}
+
+void opus_multi_recorder_impl::store(int input, const unsigned char* packet, int len)
+{
+    int samples = opus_packet_get_nb_samples(packet, len, 48000);
+    if (samples <= 0) {
+        d_invalid_packets++;
+        return;
+    }
+
+    input_state& s = d_inputs[input];
+    if (s.pages && ((s.time_limit > 0 && s.pages->granule() >= s.time_limit) ||
+                    (d_segment_bytes > 0 && s.file_bytes >= static_cast<uint64_t>(d_segment_bytes)))) {
+        close_segment(input);
+    }
+    if (!s.pages) {
+        open_segment(input);
+    }
+
+    if (!s.pages->fits(len)) {
+        write_page(s, false);
+    }
+    const int64_t start = s.pages->granule();
+    s.pages->add_packet(packet, len, start + samples);
+    track_activity(s, start, start + samples, len > 2);
+    if (s.pages->granule() - s.page_granule >= page_samples) {
+        write_page(s, false);
+    }
+}
+
+int opus_multi_recorder_impl::work(int noutput_items,
+                                   gr_vector_const_void_star& input_items,
+                                   gr_vector_void_star& output_items)
+{
+    if (d_rotate.exchange(false)) {
+        stop();
+    }
+
+    std::vector<gr::tag_t> tags;
+    for (size_t i = 0; i < d_inputs.size(); ++i) {
+        const unsigned char* in = (const unsigned char*)input_items[i];
+        const uint64_t first = nitems_read(i);
+        tags.clear();
+        get_tags_in_range(tags, i, first, first + noutput_items, pmt::mp("packet_len"));
+        d_inputs[i].framer.feed(first, in, noutput_items, tags, [this, i](const unsigned char* packet, int len) {
+            store(static_cast<int>(i), packet, len);
+        });
+    }
+    return noutput_items;
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,112 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_MULTI_RECORDER_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_MULTI_RECORDER_IMPL_H
+
+#include <gnuradio/gr_opus/opus_multi_recorder.h>
+#include "batch_writer.h"
+#include "ogg_opus.h"
+#include "packet_framer.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_multi_recorder_impl : public opus_multi_recorder
+{
+private:
+    struct input_state {
+        explicit input_state(int packet_size) : framer(packet_size) {}
+
+        packet_framer framer;
+        std::unique_ptr<ogg_page_builder> pages; // null between segments
+        int file = -1;
+        int index = -1;
+        int spurts = -1;
+        long segment = 0;
+        int64_t time_limit = 0;   // 48 kHz samples, 0 = none
+        int64_t page_granule = 0; // granule of the last page written
+        uint64_t file_bytes = 0;
+
+        // Talk spurt being tracked, in granules of the current segment.
+        bool in_spurt = false;
+        int64_t spurt_start = 0;
+        int64_t spurt_end = 0;
+        int64_t spurt_active = 0;
+    };
+
+    const std::string d_directory;
+    const std::string d_prefix;
+    const int d_sample_rate;
+    const int d_channels;
+    const int64_t d_segment_samples;
+    const long d_segment_bytes;
+    const uint32_t d_serial_base;
+
+    std::vector<input_state> d_inputs;
+    std::atomic<bool> d_rotate;
+    std::atomic<long> d_segments_completed;
+    std::atomic<long> d_spurts_indexed;
+    std::atomic<long> d_pages_dropped;
+    std::atomic<long> d_invalid_packets;
+    batch_writer d_writer;
+
+    void store(int input, const unsigned char* packet, int len);
+    void open_segment(int input);
+    void close_segment(int input);
+    void write_page(input_state& s, bool eos);
+    void track_activity(input_state& s, int64_t start, int64_t end, bool active);
+    void end_spurt(input_state& s);
+    bool send(int file, std::vector<unsigned char> data);
+
+public:
+    opus_multi_recorder_impl(int num_inputs,
+                             const std::string& directory,
+                             const std::string& prefix,
+                             int sample_rate,
+                             int channels,
+                             int packet_size,
+                             double segment_seconds,
+                             long segment_bytes,
+                             long max_queued_bytes);
+    ~opus_multi_recorder_impl();
+
+    bool stop() override;
+    void rotate() override { d_rotate = true; }
+
+    long segments_completed() const override { return d_segments_completed.load(); }
+    long spurts_indexed() const override { return d_spurts_indexed.load(); }
+    long bytes_written() const override { return static_cast<long>(d_writer.bytes_written()); }
+    long pages_dropped() const override { return d_pages_dropped.load(); }
+    long write_errors() const override { return static_cast<long>(d_writer.write_errors()); }
+    long queued_bytes() const override { return static_cast<long>(d_writer.queued_bytes()); }
+
+    int work(int noutput_items,
+             gr_vector_const_void_star& input_items,
+             gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_MULTI_RECORDER_IMPL_H */
@@ -0,0 +1,215 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_ogg_demux_impl.h"
+#include <opus/opus.h>
+#include <algorithm>
+#include <cstring>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// RFC 7845 granule positions count 48 kHz samples.
+const double granule_rate = 48000.0;
+
+bool is_header_packet(const std::vector<unsigned char>& packet)
+{
+    return packet.size() >= 8 &&
+           (std::memcmp(packet.data(), "OpusHead", 8) == 0 || std::memcmp(packet.data(), "OpusTags", 8) == 0);
+}
+
+} // namespace
+
+opus_ogg_demux::sptr opus_ogg_demux::make() { return gnuradio::get_initial_sptr(new opus_ogg_demux_impl()); }
+
+opus_ogg_demux_impl::opus_ogg_demux_impl()
+    : gr::block("opus_ogg_demux",
+                gr::io_signature::make(1, 1, sizeof(unsigned char)),
+                gr::io_signature::make(1, 1, sizeof(unsigned char))),
+      d_batcher(false),
+      d_have_stream(false),
+      d_serial(0),
+      d_sequence(0),
+      d_headers_left(0),
+      d_have_granule(false),
+      d_granule(0),
+      d_channels(0),
+      d_pre_skip(0),
+      d_stream_time(0.0),
+      d_pages(0),
+      d_packets(0),
+      d_streams(0),
+      d_crc_errors(0),
+      d_bytes_skipped(0),
+      d_pages_lost(0)
+{
+    d_batcher.set_record_units(true);
+    // Output tags are rebuilt per packet.
+    set_tag_propagation_policy(TPP_DONT);
+}
+
+opus_ogg_demux_impl::~opus_ogg_demux_impl() {}
+
+bool opus_ogg_demux_impl::start_stream(const ogg_page& page)
+{
+    // Other codecs multiplexed into the same Ogg stream are ignored.
+    int channels, pre_skip;
+    if (page.packets.empty() || !parse_opus_head(page.packets.front(), channels, pre_skip)) {
+        return false;
+    }
+    d_have_stream = true;
+    d_serial = page.serial;
+    d_sequence = page.sequence;
+    d_headers_left = 2;
+    d_have_granule = false;
+    d_channels.store(channels);
+    d_pre_skip.store(pre_skip);
+    d_streams++;
+    return true;
+}
+
+void opus_ogg_demux_impl::on_page(const ogg_page& page)
+{
+    d_pages++;
+    int64_t gap_start = -1;
+    if (page.flags & 0x02) {
+        if (!start_stream(page)) {
+            return;
+        }
+    } else if (!d_have_stream) {
+        // Joined mid-stream without headers: follow the first stream seen.
+        d_have_stream = true;
+        d_serial = page.serial;
+        d_sequence = page.sequence;
+        d_headers_left = 0;
+        d_have_granule = false;
+        d_streams++;
+    } else if (page.serial != d_serial) {
+        return;
+    } else {
+        if (page.sequence != d_sequence + 1) {
+            d_pages_lost += static_cast<long>(page.sequence - d_sequence - 1);
+            gap_start = d_have_granule ? d_granule : -1;
+            d_have_granule = false;
+        }
+        d_sequence = page.sequence;
+    }
+
+    // Packet starts run forward from the previous page's granule when the
+    // stream is unbroken, which stays exact across end trimming; otherwise
+    // back from this page's granule.
+    const size_t count = page.packets.size();
+    d_durations.resize(count);
+    int64_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const std::vector<unsigned char>& packet = page.packets[i];
+        int samples = opus_packet_get_nb_samples(packet.data(), static_cast<opus_int32>(packet.size()), 48000);
+        d_durations[i] = samples > 0 ? samples : 0;
+        total += d_durations[i];
+    }
+    int64_t position = d_have_granule ? d_granule : page.granule - total;
+    const int pre_skip = d_pre_skip.load();
+    // Packets lost with the missing pages, counted in units of the first
+    // packet after them, for opus_decoder's loss recovery.
+    long lost = 0;
+    if (gap_start >= 0 && position > gap_start && count > 0 && d_durations[0] > 0) {
+        lost = static_cast<long>((position - gap_start + d_durations[0] / 2) / d_durations[0]);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const std::vector<unsigned char>& packet = page.packets[i];
+        if (d_headers_left > 0 || is_header_packet(packet)) {
+            d_headers_left = std::max(0, d_headers_left - 1);
+            continue;
+        }
+        if (packet.empty()) {
+            continue;
+        }
+        d_batcher.push(packet.data(), packet.size());
+        d_tags.push_back({ (position - pre_skip) / granule_rate, lost });
+        lost = 0;
+        position += d_durations[i];
+        d_packets++;
+    }
+    if (count > 0 && page.granule >= 0) {
+        d_granule = page.granule;
+        d_have_granule = true;
+    }
+}
+
+int opus_ogg_demux_impl::emit(unsigned char* out, int noutput_items)
+{
+    int written = static_cast<int>(d_batcher.emit(out, noutput_items));
+    uint64_t offset = nitems_written(0);
+    for (size_t len : d_batcher.emitted_units()) {
+        add_item_tag(0, offset, pmt::mp("packet_len"), pmt::from_long(static_cast<long>(len)));
+        add_item_tag(0, offset, pmt::mp("packet_time"), pmt::from_double(d_tags.front().time));
+        if (d_tags.front().lost > 0) {
+            add_item_tag(0, offset, pmt::mp("packet_lost"), pmt::from_long(d_tags.front().lost));
+        }
+        d_stream_time.store(d_tags.front().time);
+        d_tags.pop_front();
+        offset += len;
+    }
+    d_batcher.clear_emitted_units();
+    return written;
+}
+
+void opus_ogg_demux_impl::forecast(int noutput_items, gr_vector_int& ninput_items_required)
+{
+    ninput_items_required[0] = d_batcher.staged_units() > 0 ? 0 : 1;
+}
+
+int opus_ogg_demux_impl::general_work(int noutput_items,
+                                      gr_vector_int& ninput_items,
+                                      gr_vector_const_void_star& input_items,
+                                      gr_vector_void_star& output_items)
+{
+    const unsigned char* in = static_cast<const unsigned char*>(input_items[0]);
+    unsigned char* out = static_cast<unsigned char*>(output_items[0]);
+
+    int produced = emit(out, noutput_items);
+
+    size_t take = 0;
+    if (d_parser.buffered() < max_buffered_bytes) {
+        take = std::min<size_t>(ninput_items[0], max_buffered_bytes - d_parser.buffered());
+        d_parser.push(in, take);
+    }
+    consume_each(static_cast<int>(take));
+
+    while (d_batcher.staged_units() < max_staged_packets && d_parser.next(d_page)) {
+        on_page(d_page);
+    }
+    produced += emit(out + produced, noutput_items - produced);
+
+    d_crc_errors.store(static_cast<long>(d_parser.crc_errors()));
+    d_bytes_skipped.store(static_cast<long>(d_parser.bytes_skipped()));
+    return produced;
+}
+
+} // namespace gr_opus
+} // namespace gr
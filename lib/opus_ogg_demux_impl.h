@@ -0,0 +1,100 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_OGG_DEMUX_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_OGG_DEMUX_IMPL_H
+
+#include <gnuradio/gr_opus/opus_ogg_demux.h>
+#include "ogg_opus.h"
+#include "output_batcher.h"
+#include <atomic>
+#include <deque>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_ogg_demux_impl : public opus_ogg_demux
+{
+private:
+    // Input held in the parser, and packets staged for the output, before
+    // upstream is left waiting.
+    static constexpr size_t max_buffered_bytes = 256 * 1024;
+    static constexpr size_t max_staged_packets = 64;
+
+    ogg_stream_parser d_parser;
+    ogg_page d_page;
+    output_batcher<unsigned char> d_batcher;
+    // Tags of each staged packet.
+    struct staged_tags {
+        double time;
+        long lost;
+    };
+    std::deque<staged_tags> d_tags;
+    std::vector<int> d_durations;
+
+    // The logical stream being followed.
+    bool d_have_stream;
+    uint32_t d_serial;
+    uint32_t d_sequence;
+    int d_headers_left;
+    bool d_have_granule;
+    int64_t d_granule; // end of the last packet completed in the stream
+
+    std::atomic<int> d_channels;
+    std::atomic<int> d_pre_skip;
+    std::atomic<double> d_stream_time;
+    std::atomic<long> d_pages;
+    std::atomic<long> d_packets;
+    std::atomic<long> d_streams;
+    std::atomic<long> d_crc_errors;
+    std::atomic<long> d_bytes_skipped;
+    std::atomic<long> d_pages_lost;
+
+    bool start_stream(const ogg_page& page);
+    void on_page(const ogg_page& page);
+    int emit(unsigned char* out, int noutput_items);
+
+public:
+    opus_ogg_demux_impl();
+    ~opus_ogg_demux_impl();
+
+    int channels() const override { return d_channels.load(); }
+    int pre_skip() const override { return d_pre_skip.load(); }
+    double stream_time() const override { return d_stream_time.load(); }
+
+    long pages() const override { return d_pages.load(); }
+    long packets() const override { return d_packets.load(); }
+    long streams() const override { return d_streams.load(); }
+    long crc_errors() const override { return d_crc_errors.load(); }
+    long bytes_skipped() const override { return d_bytes_skipped.load(); }
+    long pages_lost() const override { return d_pages_lost.load(); }
+
+    void forecast(int noutput_items, gr_vector_int& ninput_items_required) override;
+    int general_work(int noutput_items,
+                     gr_vector_int& ninput_items,
+                     gr_vector_const_void_star& input_items,
+                     gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_OGG_DEMUX_IMPL_H */
@@ -0,0 +1,223 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_pdu_encoder_impl.h"
+#include "codec_format.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+opus_pdu_encoder::sptr
+opus_pdu_encoder::make(int sample_rate, int channels, int bitrate, const std::string& application, double frame_ms)
+{
+    return gnuradio::get_initial_sptr(
+        new opus_pdu_encoder_impl(sample_rate, channels, bitrate, application, frame_ms));
+}
+
+opus_pdu_encoder_impl::opus_pdu_encoder_impl(int sample_rate, int channels, int bitrate, const std::string& application, double frame_ms)
+    : gr::block("opus_pdu_encoder",
+                gr::io_signature::make(0, 0, 0),
+                gr::io_signature::make(0, 0, 0)),
+      d_sample_rate(sample_rate),
+      d_channels(channels),
+      d_frame_size(static_cast<int>(std::lround(sample_rate * frame_ms / 1000.0))),
+      d_bitrate(bitrate),
+      d_flush(true),
+      d_packet_padding(0),
+      d_encoder(nullptr),
+      d_bursts(0),
+      d_packets(0),
+      d_padded_samples(0),
+      d_oversize_packets(0),
+      d_invalid_pdus(0)
+{
+    check_opus_format(sample_rate, channels);
+    static const double valid_ms[] = { 2.5, 5.0, 10.0, 20.0, 40.0, 60.0, 80.0, 100.0, 120.0 };
+    if (std::find(std::begin(valid_ms), std::end(valid_ms), frame_ms) == std::end(valid_ms)) {
+        throw std::runtime_error("Unsupported Opus frame duration: " + std::to_string(frame_ms) + " ms");
+    }
+
+    int error = OPUS_OK;
+    d_encoder = opus_encoder_create(sample_rate, channels, opus_application_from_string(application), &error);
+    if (error != OPUS_OK || d_encoder == nullptr) {
+        throw std::runtime_error("Failed to create Opus encoder: " + std::string(opus_strerror(error)));
+    }
+    error = opus_encoder_ctl(d_encoder, OPUS_SET_BITRATE(bitrate));
+    if (error != OPUS_OK) {
+        opus_encoder_destroy(d_encoder);
+        throw std::runtime_error("Failed to set Opus encoder bitrate: " + std::string(opus_strerror(error)));
+    }
+    d_ring.reserve(d_frame_size * channels * 2);
+
+    message_port_register_in(pmt::mp("in"));
+    message_port_register_out(pmt::mp("out"));
+    set_msg_handler(pmt::mp("in"), [this](const pmt::pmt_t& msg) { handle_pdu(msg); });
+}
+
+opus_pdu_encoder_impl::~opus_pdu_encoder_impl() { opus_encoder_destroy(d_encoder); }
+
+void opus_pdu_encoder_impl::set_packet_padding(int bytes)
+{
+    if (bytes < 0 || bytes > max_packet_bytes) {
+        throw std::runtime_error("Packet padding must be between 0 and " + std::to_string(max_packet_bytes) + " bytes");
+    }
+    d_packet_padding.store(bytes);
+}
+
+void opus_pdu_encoder_impl::set_bitrate(int bitrate)
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    int error = opus_encoder_ctl(d_encoder, OPUS_SET_BITRATE(bitrate));
+    if (error != OPUS_OK) {
+        throw std::runtime_error("Failed to set Opus encoder bitrate: " + std::string(opus_strerror(error)));
+    }
+    d_bitrate.store(bitrate);
+}
+
+std::vector<int> opus_pdu_encoder_impl::last_packet_lengths() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return d_last_lengths;
+}
+
+void opus_pdu_encoder_impl::append(const float* samples, size_t n)
+{
+    d_ring.insert(d_ring.end(), samples, samples + n);
+    encode_frames();
+}
+
+void opus_pdu_encoder_impl::encode_frames()
+{
+    const size_t frame_samples = static_cast<size_t>(d_frame_size) * d_channels;
+    const int padding = d_packet_padding.load();
+    size_t consumed = 0;
+    while (d_ring.size() - consumed >= frame_samples) {
+        int len = opus_encode_float(d_encoder, d_ring.data() + consumed, d_frame_size, d_packet, max_packet_bytes);
+        consumed += frame_samples;
+        if (len < 0) {
+            d_ring.erase(d_ring.begin(), d_ring.begin() + consumed);
+            throw std::runtime_error("Opus encoding failed: " + std::string(opus_strerror(len)));
+        }
+        if (padding > 0) {
+            if (len <= padding && opus_packet_pad(d_packet, len, padding) == OPUS_OK) {
+                len = padding;
+            } else {
+                d_oversize_packets++;
+            }
+        }
+        d_burst.insert(d_burst.end(), d_packet, d_packet + len);
+        d_burst_lengths.push_back(len);
+        d_packets++;
+    }
+    // What is left is less than a frame, so moving it to the front is cheap.
+    d_ring.erase(d_ring.begin(), d_ring.begin() + consumed);
+}
+
+long opus_pdu_encoder_impl::end_burst()
+{
+    long padded = 0;
+    if (d_flush.load() && !d_ring.empty()) {
+        const size_t frame_samples = static_cast<size_t>(d_frame_size) * d_channels;
+        padded = static_cast<long>(frame_samples - d_ring.size());
+        d_ring.resize(frame_samples, 0.0f);
+        encode_frames();
+        d_padded_samples += padded;
+    }
+    d_last_lengths.swap(d_burst_lengths);
+    d_burst_lengths.clear();
+    d_bursts++;
+    return padded;
+}
+
+std::vector<unsigned char> opus_pdu_encoder_impl::encode_burst(const std::vector<float>& samples, bool burst_end)
+{
+    if (samples.size() % d_channels != 0) {
+        throw std::runtime_error("Burst length must be a whole number of " + std::to_string(d_channels) +
+                                 "-channel samples");
+    }
+    std::vector<unsigned char> packets;
+    std::lock_guard<std::mutex> lock(d_mutex);
+    append(samples.data(), samples.size());
+    if (burst_end) {
+        end_burst();
+        packets.swap(d_burst);
+    }
+    return packets;
+}
+
+void opus_pdu_encoder_impl::handle_pdu(const pmt::pmt_t& msg)
+{
+    if (!pmt::is_pair(msg) || !pmt::is_f32vector(pmt::cdr(msg))) {
+        d_invalid_pdus++;
+        return;
+    }
+    pmt::pmt_t meta = pmt::car(msg);
+    if (!pmt::is_dict(meta)) {
+        meta = pmt::make_dict();
+    }
+    size_t n = 0;
+    const float* samples = pmt::f32vector_elements(pmt::cdr(msg), n);
+    if (n % d_channels != 0) {
+        d_invalid_pdus++;
+        return;
+    }
+    pmt::pmt_t end = pmt::dict_ref(meta, pmt::mp("burst_end"), pmt::PMT_NIL);
+    bool burst_end = !pmt::is_bool(end) || pmt::to_bool(end);
+
+    std::vector<unsigned char> packets;
+    std::vector<int> lengths;
+    long padded = 0;
+    long burst = 0;
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        // A failed encode loses the PDU rather than taking down the flowgraph.
+        try {
+            append(samples, n);
+            if (!burst_end) {
+                return;
+            }
+            padded = end_burst();
+        } catch (const std::runtime_error&) {
+            return;
+        }
+        burst = d_bursts.load() - 1;
+        packets.swap(d_burst);
+        lengths = d_last_lengths;
+    }
+
+    meta = pmt::dict_add(meta, pmt::mp("burst"), pmt::from_long(burst));
+    meta = pmt::dict_add(meta, pmt::mp("packet_lengths"), pmt::init_s32vector(lengths.size(), lengths));
+    meta = pmt::dict_add(meta, pmt::mp("sample_rate"), pmt::from_long(d_sample_rate));
+    meta = pmt::dict_add(meta, pmt::mp("channels"), pmt::from_long(d_channels));
+    meta = pmt::dict_add(meta, pmt::mp("padded_samples"), pmt::from_long(padded));
+    message_port_pub(pmt::mp("out"), pmt::cons(meta, pmt::init_u8vector(packets.size(), packets)));
+}
+
+} // namespace gr_opus
+} // namespace gr
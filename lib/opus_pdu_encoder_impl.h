@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_PDU_ENCODER_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_PDU_ENCODER_IMPL_H
+
+#include <gnuradio/gr_opus/opus_pdu_encoder.h>
+#include <atomic>
+#include <mutex>
+#include <opus/opus.h>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_pdu_encoder_impl : public opus_pdu_encoder
+{
+private:
+    // Largest packet opus_encode_float can produce, and the largest padding.
+    static constexpr int max_packet_bytes = 4000;
+
+    int d_sample_rate;
+    int d_channels;
+    int d_frame_size;
+    std::atomic<int> d_bitrate;
+    std::atomic<bool> d_flush;
+    std::atomic<int> d_packet_padding;
+
+    // Codec state, the ring and the burst being built are shared by the
+    // message handler and encode_burst().
+    mutable std::mutex d_mutex;
+    OpusEncoder* d_encoder;
+    std::vector<float> d_ring; // always starts on a frame boundary
+    std::vector<unsigned char> d_burst;
+    std::vector<int> d_burst_lengths;
+    std::vector<int> d_last_lengths;
+    unsigned char d_packet[max_packet_bytes];
+
+    std::atomic<long> d_bursts;
+    std::atomic<long> d_packets;
+    std::atomic<long> d_padded_samples;
+    std::atomic<long> d_oversize_packets;
+    std::atomic<long> d_invalid_pdus;
+
+    void append(const float* samples, size_t n);
+    void encode_frames();
+    long end_burst();
+    void handle_pdu(const pmt::pmt_t& msg);
+
+public:
+    opus_pdu_encoder_impl(int sample_rate, int channels, int bitrate, const std::string& application, double frame_ms);
+    ~opus_pdu_encoder_impl();
+
+    std::vector<unsigned char> encode_burst(const std::vector<float>& samples, bool burst_end) override;
+    std::vector<int> last_packet_lengths() const override;
+
+    void set_flush(bool enable) override { d_flush.store(enable); }
+    bool flush() const override { return d_flush.load(); }
+    void set_packet_padding(int bytes) override;
+    int packet_padding() const override { return d_packet_padding.load(); }
+    void set_bitrate(int bitrate) override;
+    int bitrate() const override { return d_bitrate.load(); }
+
+    long bursts() const override { return d_bursts.load(); }
+    long packets() const override { return d_packets.load(); }
+    long padded_samples() const override { return d_padded_samples.load(); }
+    long oversize_packets() const override { return d_oversize_packets.load(); }
+    long invalid_pdus() const override { return d_invalid_pdus.load(); }
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_PDU_ENCODER_IMPL_H */
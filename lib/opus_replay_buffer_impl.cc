@@ -0,0 +1,217 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_replay_buffer_impl.h"
+#include "codec_format.h"
+#include <opus/opus.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// Room for the history at max_bitrate plus one maximum-size packet.
+size_t arena_size(double history_seconds, int max_bitrate)
+{
+    return static_cast<size_t>(history_seconds * max_bitrate / 8.0) + 1275;
+}
+
+} // namespace
+
+opus_replay_buffer::sptr
+opus_replay_buffer::make(int sample_rate, int channels, int packet_size, double history_seconds, int max_bitrate)
+{
+    return gnuradio::get_initial_sptr(
+        new opus_replay_buffer_impl(sample_rate, channels, packet_size, history_seconds, max_bitrate));
+}
+
+opus_replay_buffer_impl::opus_replay_buffer_impl(int sample_rate, int channels, int packet_size, double history_seconds, int max_bitrate)
+    : gr::sync_block("opus_replay_buffer",
+                     gr::io_signature::make(1, 1, sizeof(unsigned char)),
+                     gr::io_signature::make(0, 0, 0)),
+      d_sample_rate(sample_rate),
+      d_channels(channels),
+      d_framer(packet_size),
+      d_arena(arena_size(history_seconds, max_bitrate)),
+      d_invalid_packets(0),
+      d_next_id(0)
+{
+    check_opus_format(sample_rate, channels);
+    if (history_seconds <= 0.0 || max_bitrate <= 0) {
+        throw std::runtime_error("Replay history and max_bitrate must be positive");
+    }
+    d_strand = codec_thread_pool::instance().make_strand(16);
+
+    message_port_register_out(pmt::mp("replay"));
+    message_port_register_in(pmt::mp("request"));
+    set_msg_handler(pmt::mp("request"), [this](const pmt::pmt_t& msg) { handle_request(msg); });
+}
+
+opus_replay_buffer_impl::~opus_replay_buffer_impl()
+{
+    d_strand->wait_idle();
+}
+
+void opus_replay_buffer_impl::store(const unsigned char* packet, int len)
+{
+    int samples = opus_packet_get_nb_samples(packet, len, d_sample_rate);
+    std::lock_guard<std::mutex> lock(d_mutex);
+    if (samples <= 0 || !d_arena.store(packet, len, samples)) {
+        d_invalid_packets++;
+    }
+}
+
+std::vector<float> opus_replay_buffer_impl::decode_window(double seconds_ago, double duration, uint64_t& start_sample)
+{
+    if (seconds_ago < 0.0 || duration <= 0.0) {
+        throw std::runtime_error("Replay needs seconds_ago >= 0 and duration > 0");
+    }
+
+    // Copy the packets out so the live stream keeps writing while we decode.
+    std::vector<unsigned char> packets;
+    std::vector<replay_arena::entry> picked;
+    uint64_t start, stop;
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        const uint64_t total = d_arena.total_samples();
+        uint64_t ago = static_cast<uint64_t>(seconds_ago * d_sample_rate);
+        start = ago > total ? 0 : total - ago;
+        stop = std::min(total, start + static_cast<uint64_t>(duration * d_sample_rate));
+        uint64_t preroll = static_cast<uint64_t>(preroll_seconds * d_sample_rate);
+        d_arena.collect(start > preroll ? start - preroll : 0, stop, packets, picked);
+    }
+
+    start_sample = picked.empty() ? start : std::max(start, picked.front().sample_pos);
+    std::vector<float> out;
+    if (picked.empty()) {
+        return out;
+    }
+
+    int error;
+    std::unique_ptr<OpusDecoder, void (*)(OpusDecoder*)> decoder(
+        opus_decoder_create(d_sample_rate, d_channels, &error), opus_decoder_destroy);
+    if (error != OPUS_OK || !decoder) {
+        throw std::runtime_error("Failed to create Opus decoder: " + std::string(opus_strerror(error)));
+    }
+
+    const int max_frame = d_sample_rate * 120 / 1000;
+    std::vector<float> pcm(max_frame * d_channels);
+    out.reserve((stop - start_sample) * d_channels);
+    for (const replay_arena::entry& p : picked) {
+        int n = opus_decode_float(decoder.get(), packets.data() + p.offset, p.len, pcm.data(), max_frame, 0);
+        if (n <= 0) {
+            continue;
+        }
+        uint64_t first = std::max(p.sample_pos, start_sample);
+        uint64_t last = std::min(p.sample_pos + n, stop);
+        if (first >= last) {
+            continue;
+        }
+        const float* src = pcm.data() + (first - p.sample_pos) * d_channels;
+        out.insert(out.end(), src, src + (last - first) * d_channels);
+    }
+    return out;
+}
+
+long opus_replay_buffer_impl::request_replay(double seconds_ago, double duration)
+{
+    if (seconds_ago < 0.0 || duration <= 0.0) {
+        throw std::runtime_error("Replay needs seconds_ago >= 0 and duration > 0");
+    }
+    long id = d_next_id++;
+    bool queued = d_strand->try_submit([this, id, seconds_ago, duration] {
+        pmt::pmt_t meta = pmt::make_dict();
+        meta = pmt::dict_add(meta, pmt::mp("id"), pmt::from_long(id));
+        meta = pmt::dict_add(meta, pmt::mp("sample_rate"), pmt::from_long(d_sample_rate));
+        meta = pmt::dict_add(meta, pmt::mp("channels"), pmt::from_long(d_channels));
+        std::vector<float> pcm;
+        try {
+            uint64_t start_sample = 0;
+            pcm = decode_window(seconds_ago, duration, start_sample);
+            meta = pmt::dict_add(meta, pmt::mp("start_sample"), pmt::from_uint64(start_sample));
+        } catch (const std::exception& e) {
+            meta = pmt::dict_add(meta, pmt::mp("error"), pmt::mp(e.what()));
+        }
+        message_port_pub(pmt::mp("replay"), pmt::cons(meta, pmt::init_f32vector(pcm.size(), pcm)));
+    });
+    if (!queued) {
+        throw std::runtime_error("Replay request queue is full");
+    }
+    return id;
+}
+
+std::vector<float> opus_replay_buffer_impl::replay(double seconds_ago, double duration)
+{
+    uint64_t start_sample;
+    return decode_window(seconds_ago, duration, start_sample);
+}
+
+void opus_replay_buffer_impl::handle_request(const pmt::pmt_t& msg)
+{
+    if (!pmt::is_dict(msg)) {
+        return;
+    }
+    pmt::pmt_t ago = pmt::dict_ref(msg, pmt::mp("seconds_ago"), pmt::PMT_NIL);
+    pmt::pmt_t duration = pmt::dict_ref(msg, pmt::mp("duration"), pmt::PMT_NIL);
+    if (!pmt::is_number(ago) || !pmt::is_number(duration)) {
+        return;
+    }
+    // Malformed or excess requests are dropped rather than taking down the flowgraph.
+    try {
+        request_replay(pmt::to_double(ago), pmt::to_double(duration));
+    } catch (const std::runtime_error&) {
+    }
+}
+
+double opus_replay_buffer_impl::history_available() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return static_cast<double>(d_arena.total_samples() - d_arena.oldest_sample()) / d_sample_rate;
+}
+
+size_t opus_replay_buffer_impl::packets_stored() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return d_arena.packets();
+}
+
+int opus_replay_buffer_impl::work(int noutput_items,
+                                  gr_vector_const_void_star& input_items,
+                                  gr_vector_void_star& output_items)
+{
+    const unsigned char* in = (const unsigned char*)input_items[0];
+    const uint64_t first = nitems_read(0);
+
+    std::vector<gr::tag_t> tags;
+    get_tags_in_range(tags, 0, first, first + noutput_items, pmt::mp("packet_len"));
+    d_framer.feed(first, in, noutput_items, tags, [this](const unsigned char* packet, int len) { store(packet, len); });
+    return noutput_items;
+}
+
+} // namespace gr_opus
+} // namespace gr
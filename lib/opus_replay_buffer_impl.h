@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_REPLAY_BUFFER_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_REPLAY_BUFFER_IMPL_H
+
+#include <gnuradio/gr_opus/opus_replay_buffer.h>
+#include "codec_thread_pool.h"
+#include "packet_framer.h"
+#include "replay_arena.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_replay_buffer_impl : public opus_replay_buffer
+{
+private:
+    // A replay decodes this much audio before the window so the fresh
+    // decoder has converged by the first sample returned.
+    static constexpr double preroll_seconds = 0.080;
+
+    int d_sample_rate;
+    int d_channels;
+    packet_framer d_framer;
+
+    mutable std::mutex d_mutex; // guards the arena
+    replay_arena d_arena;
+    uint64_t d_invalid_packets;
+
+    std::shared_ptr<codec_strand> d_strand;
+    std::atomic<long> d_next_id;
+
+    void store(const unsigned char* packet, int len);
+    void handle_request(const pmt::pmt_t& msg);
+    std::vector<float> decode_window(double seconds_ago, double duration, uint64_t& start_sample);
+
+public:
+    opus_replay_buffer_impl(int sample_rate, int channels, int packet_size, double history_seconds, int max_bitrate);
+    ~opus_replay_buffer_impl();
+
+    long request_replay(double seconds_ago, double duration) override;
+    std::vector<float> replay(double seconds_ago, double duration) override;
+
+    double history_available() const override;
+    size_t arena_bytes() const override { return d_arena.bytes(); }
+    size_t packets_stored() const override;
+
+    int work(int noutput_items,
+             gr_vector_const_void_star& input_items,
+             gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_REPLAY_BUFFER_IMPL_H */
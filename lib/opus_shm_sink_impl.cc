@@ -0,0 +1,84 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_shm_sink_impl.h"
+#include "codec_format.h"
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+int checked_rate(int sample_rate, int channels)
+{
+    check_opus_format(sample_rate, channels);
+    return sample_rate;
+}
+
+} // namespace
+
+opus_shm_sink::sptr
+opus_shm_sink::make(const std::string& name, int sample_rate, int channels, int frame_samples, int slot_count)
+{
+    return gnuradio::get_initial_sptr(new opus_shm_sink_impl(name, sample_rate, channels, frame_samples, slot_count));
+}
+
+opus_shm_sink_impl::opus_shm_sink_impl(const std::string& name, int sample_rate, int channels, int frame_samples, int slot_count)
+    : gr::sync_block("opus_shm_sink",
+                     gr::io_signature::make(1, 1, sizeof(float)),
+                     gr::io_signature::make(0, 0, 0)),
+      d_writer(name, checked_rate(sample_rate, channels), channels, frame_samples, slot_count)
+{
+}
+
+opus_shm_sink_impl::~opus_shm_sink_impl()
+{
+    stop();
+}
+
+bool opus_shm_sink_impl::start()
+{
+    d_writer.set_closed(false);
+    return true;
+}
+
+bool opus_shm_sink_impl::stop()
+{
+    d_writer.flush();
+    d_writer.set_closed(true);
+    return true;
+}
+
+int opus_shm_sink_impl::work(int noutput_items,
+                             gr_vector_const_void_star& input_items,
+                             gr_vector_void_star& output_items)
+{
+    d_writer.write((const float*)input_items[0], static_cast<size_t>(noutput_items));
+    return noutput_items;
+}
+
+} // namespace gr_opus
+} // namespace gr
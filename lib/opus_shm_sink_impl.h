@@ -0,0 +1,54 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_SHM_SINK_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_SHM_SINK_IMPL_H
+
+#include <gnuradio/gr_opus/opus_shm_sink.h>
+#include "shm_ring_writer.h"
+
+namespace gr {
+namespace gr_opus {
+
+class opus_shm_sink_impl : public opus_shm_sink
+{
+private:
+    shm_ring_writer d_writer;
+
+public:
+    opus_shm_sink_impl(const std::string& name, int sample_rate, int channels, int frame_samples, int slot_count);
+    ~opus_shm_sink_impl();
+
+    bool start() override;
+    bool stop() override;
+
+    long frames_published() const override { return d_writer.frames_published(); }
+    int readers() const override { return d_writer.readers(); }
+    long reader_overruns() const override { return d_writer.reader_overruns(); }
+
+    int work(int noutput_items,
+             gr_vector_const_void_star& input_items,
+             gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_SHM_SINK_IMPL_H */
@@ -0,0 +1,284 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_spurt_source_impl.h"
+#include "codec_format.h"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// Audio decoded (and discarded) ahead of each spurt so the decoder has
+// converged by its first sample, in 48 kHz samples.
+const int64_t spurt_preroll = 3840;
+
+// A following spurt this close to the read position is reached by reading
+// on rather than seeking.
+const int64_t max_read_ahead = 48000;
+
+} // namespace
+
+opus_spurt_source::sptr opus_spurt_source::make(const std::string& path, int sample_rate, int channels)
+{
+    return gnuradio::get_initial_sptr(new opus_spurt_source_impl(path, sample_rate, channels));
+}
+
+opus_spurt_source_impl::opus_spurt_source_impl(const std::string& path, int sample_rate, int channels)
+    : gr::sync_block("opus_spurt_source",
+                     gr::io_signature::make(0, 0, 0),
+                     gr::io_signature::make(1, 1, sizeof(float))),
+      d_sample_rate(sample_rate),
+      d_channels(channels),
+      d_reader(path),
+      d_pre_skip(0),
+      d_data_offset(0),
+      d_decoder(nullptr, opus_decoder_destroy),
+      d_next_spurt(0),
+      d_in_spurt(false),
+      d_spurt_tagged(false),
+      d_positioned(false),
+      d_cursor(0),
+      d_spurts_played(0)
+{
+    check_opus_format(sample_rate, channels);
+
+    int error;
+    d_decoder.reset(opus_decoder_create(sample_rate, channels, &error));
+    if (error != OPUS_OK || !d_decoder) {
+        throw std::runtime_error("Failed to create Opus decoder: " + std::string(opus_strerror(error)));
+    }
+    d_frame.resize(sample_rate * 120 / 1000 * channels);
+
+    read_headers(path);
+    load_sidecars(path);
+}
+
+opus_spurt_source_impl::~opus_spurt_source_impl() {}
+
+void opus_spurt_source_impl::read_headers(const std::string& path)
+{
+    ogg_page page;
+    int stream_channels;
+    if (!d_reader.next(page) || page.packets.empty() ||
+        !parse_opus_head(page.packets[0], stream_channels, d_pre_skip)) {
+        throw std::runtime_error("Not an Ogg Opus file: " + path);
+    }
+    // OpusTags may span several pages; audio starts on the page after it.
+    do {
+        if (!d_reader.next(page)) {
+            throw std::runtime_error("Ogg Opus file has no comment header: " + path);
+        }
+    } while (page.packets.empty());
+
+    if (d_reader.next(page)) {
+        d_data_offset = page.offset;
+    } else {
+        d_data_offset = std::numeric_limits<uint64_t>::max();
+    }
+}
+
+void opus_spurt_source_impl::load_sidecars(const std::string& path)
+{
+    std::string base = path;
+    if (base.size() > 5 && base.compare(base.size() - 5, 5, ".opus") == 0) {
+        base.resize(base.size() - 5);
+    }
+
+    std::ifstream index(base + ".idx");
+    index_entry e;
+    while (index >> e.granule >> e.offset) {
+        d_index.push_back(e);
+    }
+
+    std::ifstream spurts(base + ".spurts");
+    if (!spurts) {
+        d_spurts.push_back({ 0, d_index.empty() ? std::numeric_limits<int64_t>::max() : d_index.back().granule });
+    } else {
+        spurt s;
+        while (spurts >> s.start >> s.end) {
+            if (s.end > s.start) {
+                d_spurts.push_back(s);
+            }
+        }
+    }
+    if (d_data_offset == std::numeric_limits<uint64_t>::max()) {
+        d_spurts.clear();
+    }
+}
+
+double opus_spurt_source_impl::spurt_seconds() const
+{
+    int64_t total = 0;
+    for (const spurt& s : d_spurts) {
+        if (s.end == std::numeric_limits<int64_t>::max()) {
+            return -1.0;
+        }
+        total += s.end - s.start;
+    }
+    return total / 48000.0;
+}
+
+void opus_spurt_source_impl::begin_spurt()
+{
+    const int64_t from = std::max<int64_t>(0, d_spurts[d_next_spurt].start - spurt_preroll);
+    d_in_spurt = true;
+    d_spurt_tagged = false;
+    if (d_positioned && d_cursor <= from && from - d_cursor <= max_read_ahead) {
+        return;
+    }
+
+    // Seek to the page holding `from`: the first whose end granule is past it.
+    uint64_t offset = d_data_offset;
+    if (!d_index.empty()) {
+        auto it = std::upper_bound(d_index.begin(), d_index.end(), from, [](int64_t g, const index_entry& e) {
+            return g < e.granule;
+        });
+        offset = (it == d_index.end() ? d_index.back() : *it).offset;
+    }
+    d_reader.seek(offset);
+    d_packets.clear();
+    opus_decoder_ctl(d_decoder.get(), OPUS_RESET_STATE);
+    d_positioned = true;
+}
+
+bool opus_spurt_source_impl::next_packet(std::vector<unsigned char>& packet)
+{
+    while (d_packets.empty()) {
+        ogg_page page;
+        if (!d_reader.next(page)) {
+            return false;
+        }
+        if (page.packets.empty()) {
+            continue;
+        }
+        // The page granule ends its last packet; work back to the first.
+        int64_t total = 0;
+        for (auto& p : page.packets) {
+            total += std::max(0, opus_packet_get_nb_samples(p.data(), static_cast<opus_int32>(p.size()), 48000));
+            d_packets.push_back(std::move(p));
+        }
+        d_cursor = page.granule - total;
+    }
+    packet = std::move(d_packets.front());
+    d_packets.pop_front();
+    return true;
+}
+
+bool opus_spurt_source_impl::fill(size_t want)
+{
+    std::vector<unsigned char> packet;
+    while (d_pcm.size() < want) {
+        if (!d_in_spurt) {
+            if (d_next_spurt >= d_spurts.size()) {
+                return false;
+            }
+            begin_spurt();
+        }
+        const spurt& s = d_spurts[d_next_spurt];
+
+        bool end = !next_packet(packet);
+        if (end) {
+            d_positioned = false;
+        } else if (d_cursor >= s.end) {
+            d_packets.push_front(std::move(packet));
+            end = true;
+        }
+        if (end) {
+            d_in_spurt = false;
+            d_next_spurt++;
+            d_spurts_played++;
+            continue;
+        }
+
+        int duration = opus_packet_get_nb_samples(packet.data(), static_cast<opus_int32>(packet.size()), 48000);
+        if (duration <= 0) {
+            continue;
+        }
+        const int64_t start = d_cursor;
+        d_cursor += duration;
+        if (d_cursor <= s.start - spurt_preroll) {
+            continue; // before the preroll: skipped undecoded
+        }
+
+        int n = opus_decode_float(d_decoder.get(),
+                                  packet.data(),
+                                  static_cast<opus_int32>(packet.size()),
+                                  d_frame.data(),
+                                  static_cast<int>(d_frame.size()) / d_channels,
+                                  0);
+        if (n <= 0) {
+            continue;
+        }
+        int64_t lo = std::max<int64_t>(0, s.start - start) * d_sample_rate / 48000;
+        int64_t hi = std::min<int64_t>(n, std::min<int64_t>(duration, s.end - start) * d_sample_rate / 48000);
+        if (lo >= hi) {
+            continue;
+        }
+        if (!d_spurt_tagged) {
+            d_tags.emplace_back(d_pcm.size(),
+                                static_cast<uint64_t>(std::max<int64_t>(0, s.start - d_pre_skip)) * d_sample_rate / 48000);
+            d_spurt_tagged = true;
+        }
+        d_pcm.insert(d_pcm.end(), d_frame.data() + lo * d_channels, d_frame.data() + hi * d_channels);
+    }
+    return true;
+}
+
+int opus_spurt_source_impl::work(int noutput_items,
+                                 gr_vector_const_void_star& input_items,
+                                 gr_vector_void_star& output_items)
+{
+    float* out = (float*)output_items[0];
+
+    fill(static_cast<size_t>(noutput_items));
+    size_t n = std::min(d_pcm.size(), static_cast<size_t>(noutput_items));
+    if (n == 0) {
+        return WORK_DONE;
+    }
+    std::copy(d_pcm.begin(), d_pcm.begin() + n, out);
+
+    while (!d_tags.empty() && d_tags.front().first < n) {
+        add_item_tag(0,
+                     nitems_written(0) + d_tags.front().first,
+                     pmt::mp("spurt_start"),
+                     pmt::from_uint64(d_tags.front().second));
+        d_tags.pop_front();
+    }
+
+    // What is left over is less than one frame; move it to the front.
+    d_pcm.erase(d_pcm.begin(), d_pcm.begin() + n);
+    for (auto& tag : d_tags) {
+        tag.first -= n;
+    }
+    return static_cast<int>(n);
+}
+
+} // namespace gr_opus
+} // namespace gr
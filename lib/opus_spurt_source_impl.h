@@ -0,0 +1,93 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_SPURT_SOURCE_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_SPURT_SOURCE_IMPL_H
+
+#include <gnuradio/gr_opus/opus_spurt_source.h>
+#include "ogg_opus.h"
+#include <opus/opus.h>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_spurt_source_impl : public opus_spurt_source
+{
+private:
+    struct spurt {
+        int64_t start;
+        int64_t end;
+    };
+    struct index_entry {
+        int64_t granule;
+        uint64_t offset;
+    };
+
+    const int d_sample_rate;
+    const int d_channels;
+    ogg_page_reader d_reader;
+    int d_pre_skip;
+    uint64_t d_data_offset;
+    std::vector<spurt> d_spurts;
+    std::vector<index_entry> d_index;
+
+    std::unique_ptr<OpusDecoder, void (*)(OpusDecoder*)> d_decoder;
+    std::vector<float> d_frame;
+
+    // Playback position: d_cursor is the granule at the start of the next
+    // packet in d_packets.
+    size_t d_next_spurt;
+    bool d_in_spurt;
+    bool d_spurt_tagged;
+    bool d_positioned;
+    int64_t d_cursor;
+    std::deque<std::vector<unsigned char>> d_packets;
+    long d_spurts_played;
+
+    std::vector<float> d_pcm;
+    std::deque<std::pair<size_t, uint64_t>> d_tags; // d_pcm index, recording position
+
+    void read_headers(const std::string& path);
+    void load_sidecars(const std::string& path);
+    void begin_spurt();
+    bool next_packet(std::vector<unsigned char>& packet);
+    bool fill(size_t want);
+
+public:
+    opus_spurt_source_impl(const std::string& path, int sample_rate, int channels);
+    ~opus_spurt_source_impl();
+
+    long num_spurts() const override { return static_cast<long>(d_spurts.size()); }
+    double spurt_seconds() const override;
+    long spurts_played() const override { return d_spurts_played; }
+
+    int work(int noutput_items,
+             gr_vector_const_void_star& input_items,
+             gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_SPURT_SOURCE_IMPL_H */
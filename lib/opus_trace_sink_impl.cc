@@ -0,0 +1,143 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_trace_sink_impl.h"
+#include "codec_format.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+opus_trace_sink::sptr opus_trace_sink::make(const std::string& path, int sample_rate, int channels, int packet_size)
+{
+    return gnuradio::get_initial_sptr(new opus_trace_sink_impl(path, sample_rate, channels, packet_size));
+}
+
+opus_trace_sink_impl::opus_trace_sink_impl(const std::string& path, int sample_rate, int channels, int packet_size)
+    : gr::sync_block("opus_trace_sink",
+                     gr::io_signature::make(1, 1, sizeof(unsigned char)),
+                     gr::io_signature::make(0, 0, 0)),
+      d_sample_rate(sample_rate),
+      d_channels(channels),
+      d_framer(packet_size),
+      d_writer(16 * 1024 * 1024),
+      d_file(-1),
+      d_started(false),
+      d_packets_captured(0),
+      d_packets_dropped(0)
+{
+    check_opus_format(sample_rate, channels);
+    d_file = d_writer.open(path);
+}
+
+opus_trace_sink_impl::~opus_trace_sink_impl()
+{
+    d_writer.close(d_file, false);
+}
+
+bool opus_trace_sink_impl::start()
+{
+    // Times are relative to the first start; a restart continues the trace.
+    if (d_started) {
+        return true;
+    }
+    d_started = true;
+    d_start = std::chrono::steady_clock::now();
+
+    trace_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, trace_magic, sizeof(trace_magic));
+    header.version = 1;
+    header.sample_rate = static_cast<uint32_t>(d_sample_rate);
+    header.channels = static_cast<uint32_t>(d_channels);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    header.start_time_ns = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&header);
+    d_writer.write(d_file, std::vector<unsigned char>(bytes, bytes + sizeof(header)));
+    return true;
+}
+
+void opus_trace_sink_impl::append(const unsigned char* packet, int len, uint64_t time_ns, long lost)
+{
+    size_t at = d_records.size();
+    d_records.resize(at + trace_record_bytes(static_cast<uint32_t>(len)), 0);
+    trace_record record = { time_ns, static_cast<uint32_t>(len),
+                            static_cast<uint32_t>(std::min<long>(std::max<long>(lost, 0), UINT32_MAX)) };
+    std::memcpy(d_records.data() + at, &record, sizeof(record));
+    std::memcpy(d_records.data() + at + sizeof(record), packet, len);
+}
+
+int opus_trace_sink_impl::work(int noutput_items,
+                               gr_vector_const_void_star& input_items,
+                               gr_vector_void_star& output_items)
+{
+    const unsigned char* in = (const unsigned char*)input_items[0];
+    const uint64_t first = nitems_read(0);
+    if (!d_started) {
+        start();
+    }
+
+    // Every packet that completes in this call shares its arrival time.
+    const uint64_t now_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - d_start).count());
+
+    std::vector<gr::tag_t> tags;
+    get_tags_in_range(tags, 0, first, first + noutput_items, pmt::mp("packet_lost"));
+    std::sort(tags.begin(), tags.end(), gr::tag_t::offset_compare);
+    d_lost_tags.insert(d_lost_tags.end(), tags.begin(), tags.end());
+    tags.clear();
+    get_tags_in_range(tags, 0, first, first + noutput_items, pmt::mp("packet_len"));
+    long packets = 0;
+    d_framer.feed(first, in, noutput_items, tags, [&](const unsigned char* packet, int len) {
+        // Losses tagged on dropped bytes carry over to the next packet.
+        long lost = 0;
+        while (!d_lost_tags.empty() && d_lost_tags.front().offset <= d_framer.packet_offset()) {
+            if (pmt::is_integer(d_lost_tags.front().value)) {
+                lost += pmt::to_long(d_lost_tags.front().value);
+            }
+            d_lost_tags.pop_front();
+        }
+        append(packet, len, now_ns, lost);
+        packets++;
+    });
+
+    if (!d_records.empty()) {
+        if (d_writer.write(d_file, std::move(d_records))) {
+            d_packets_captured += packets;
+        } else {
+            d_packets_dropped += packets;
+        }
+        d_records.clear();
+    }
+    return noutput_items;
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,71 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_TRACE_SINK_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_TRACE_SINK_IMPL_H
+
+#include <gnuradio/gr_opus/opus_trace_sink.h>
+#include "batch_writer.h"
+#include "packet_framer.h"
+#include "packet_trace.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_trace_sink_impl : public opus_trace_sink
+{
+private:
+    const int d_sample_rate;
+    const int d_channels;
+    packet_framer d_framer;
+    batch_writer d_writer;
+    int d_file;
+    bool d_started;
+    std::chrono::steady_clock::time_point d_start;
+    std::vector<unsigned char> d_records; // built during one work() call
+    std::deque<gr::tag_t> d_lost_tags;     // "packet_lost" tags not yet matched to a packet
+
+    std::atomic<long> d_packets_captured;
+    std::atomic<long> d_packets_dropped;
+
+    void append(const unsigned char* packet, int len, uint64_t time_ns, long lost);
+
+public:
+    opus_trace_sink_impl(const std::string& path, int sample_rate, int channels, int packet_size);
+    ~opus_trace_sink_impl();
+
+    bool start() override;
+
+    long packets_captured() const override { return d_packets_captured.load(); }
+    long packets_dropped() const override { return d_packets_dropped.load(); }
+
+    int work(int noutput_items,
+             gr_vector_const_void_star& input_items,
+             gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_TRACE_SINK_IMPL_H */
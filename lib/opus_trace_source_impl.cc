@@ -0,0 +1,178 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "opus_trace_source_impl.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// Longest single sleep in realtime mode, so a stop request is not held up
+// by a long gap in the trace.
+const std::chrono::milliseconds max_sleep(50);
+
+} // namespace
+
+opus_trace_source::sptr opus_trace_source::make(const std::string& path, bool realtime, bool repeat)
+{
+    return gnuradio::get_initial_sptr(new opus_trace_source_impl(path, realtime, repeat));
+}
+
+opus_trace_source_impl::opus_trace_source_impl(const std::string& path, bool realtime, bool repeat)
+    : gr::sync_block("opus_trace_source",
+                     gr::io_signature::make(0, 0, 0),
+                     gr::io_signature::make(1, 1, sizeof(unsigned char))),
+      d_realtime(realtime),
+      d_repeat(repeat),
+      d_base(nullptr),
+      d_size(0),
+      d_header(nullptr),
+      d_duration_ns(0),
+      d_next(0),
+      d_emitted(0),
+      d_loop_offset(0),
+      d_clock_started(false),
+      d_packets_replayed(0),
+      d_max_lateness_ms(0.0)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open packet trace: " + path);
+    }
+    struct stat st;
+    void* base = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(trace_header)) {
+        d_size = static_cast<size_t>(st.st_size);
+        base = mmap(nullptr, d_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Not a packet trace: " + path);
+    }
+    d_base = static_cast<const unsigned char*>(base);
+    d_header = reinterpret_cast<const trace_header*>(d_base);
+    if (std::memcmp(d_header->magic, trace_magic, sizeof(trace_magic)) != 0 || d_header->version != 1) {
+        munmap(const_cast<unsigned char*>(d_base), d_size);
+        throw std::runtime_error("Not a packet trace: " + path);
+    }
+
+    // Index the complete records; a truncated tail is ignored.
+    size_t pos = sizeof(trace_header);
+    while (pos + sizeof(trace_record) <= d_size) {
+        const trace_record* r = reinterpret_cast<const trace_record*>(d_base + pos);
+        if (pos + sizeof(trace_record) + r->len > d_size) {
+            break;
+        }
+        d_records.push_back(pos);
+        d_duration_ns = std::max(d_duration_ns, r->time_ns);
+        pos += trace_record_bytes(r->len);
+    }
+    if (d_repeat && d_records.empty()) {
+        munmap(const_cast<unsigned char*>(d_base), d_size);
+        throw std::runtime_error("Cannot repeat an empty packet trace: " + path);
+    }
+    madvise(const_cast<unsigned char*>(d_base), d_size, MADV_SEQUENTIAL);
+}
+
+opus_trace_source_impl::~opus_trace_source_impl()
+{
+    munmap(const_cast<unsigned char*>(d_base), d_size);
+}
+
+int opus_trace_source_impl::work(int noutput_items,
+                                 gr_vector_const_void_star& input_items,
+                                 gr_vector_void_star& output_items)
+{
+    unsigned char* out = (unsigned char*)output_items[0];
+    if (!d_clock_started) {
+        d_clock_started = true;
+        d_t0 = std::chrono::steady_clock::now();
+    }
+
+    int produced = 0;
+    while (produced < noutput_items) {
+        if (d_next == d_records.size()) {
+            if (!d_repeat) {
+                break;
+            }
+            // Keep the packet spacing across the loop point.
+            d_next = 0;
+            d_loop_offset += d_duration_ns + 1000000;
+        }
+        const trace_record* r = reinterpret_cast<const trace_record*>(d_base + d_records[d_next]);
+
+        if (d_emitted == 0) {
+            if (d_realtime) {
+                auto due = d_t0 + std::chrono::nanoseconds(r->time_ns + d_loop_offset);
+                auto now = std::chrono::steady_clock::now();
+                if (now < due) {
+                    if (produced > 0) {
+                        break;
+                    }
+                    std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(due - now, max_sleep));
+                    return 0;
+                }
+                double late = std::chrono::duration<double, std::milli>(now - due).count();
+                if (late > d_max_lateness_ms.load()) {
+                    d_max_lateness_ms = late;
+                }
+            }
+            add_item_tag(0, nitems_written(0) + produced, pmt::mp("packet_len"), pmt::from_long(r->len));
+            if (r->lost > 0) {
+                add_item_tag(0, nitems_written(0) + produced, pmt::mp("packet_lost"), pmt::from_long(r->lost));
+            }
+        }
+
+        // Packets may straddle work() calls when the output buffer is short.
+        const unsigned char* payload = reinterpret_cast<const unsigned char*>(r + 1);
+        size_t n = std::min<size_t>(r->len - d_emitted, static_cast<size_t>(noutput_items - produced));
+        std::memcpy(out + produced, payload + d_emitted, n);
+        produced += static_cast<int>(n);
+        d_emitted += n;
+        if (d_emitted == r->len) {
+            d_emitted = 0;
+            d_next++;
+            d_packets_replayed++;
+        }
+    }
+
+    if (produced == 0 && d_next == d_records.size() && !d_repeat) {
+        return WORK_DONE;
+    }
+    return produced;
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OPUS_TRACE_SOURCE_IMPL_H
+#define INCLUDED_GR_OPUS_OPUS_TRACE_SOURCE_IMPL_H
+
+#include <gnuradio/gr_opus/opus_trace_source.h>
+#include "packet_trace.h"
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+class opus_trace_source_impl : public opus_trace_source
+{
+private:
+    const bool d_realtime;
+    const bool d_repeat;
+    const unsigned char* d_base; // read-only mapping of the whole file
+    size_t d_size;
+    const trace_header* d_header;
+    std::vector<size_t> d_records; // offsets of the complete records
+    uint64_t d_duration_ns;
+
+    size_t d_next;          // record being emitted
+    size_t d_emitted;       // payload bytes of it already emitted
+    uint64_t d_loop_offset; // added to record times on repeats
+    bool d_clock_started;
+    std::chrono::steady_clock::time_point d_t0;
+
+    std::atomic<long> d_packets_replayed;
+    std::atomic<double> d_max_lateness_ms;
+
+public:
+    opus_trace_source_impl(const std::string& path, bool realtime, bool repeat);
+    ~opus_trace_source_impl();
+
+    int sample_rate() const override { return static_cast<int>(d_header->sample_rate); }
+    int channels() const override { return static_cast<int>(d_header->channels); }
+    long num_packets() const override { return static_cast<long>(d_records.size()); }
+    double duration_seconds() const override { return d_duration_ns / 1e9; }
+    long packets_replayed() const override { return d_packets_replayed.load(); }
+    double max_lateness_ms() const override { return d_max_lateness_ms.load(); }
+
+    int work(int noutput_items,
+             gr_vector_const_void_star& input_items,
+             gr_vector_void_star& output_items) override;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OPUS_TRACE_SOURCE_IMPL_H */
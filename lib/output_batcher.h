@@ -0,0 +1,146 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OUTPUT_BATCHER_H
+#define INCLUDED_GR_OPUS_OUTPUT_BATCHER_H
+
+#include "realtime.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Staging area between the codec and the output buffer. Units (encoded
+ * packets or decoded frames) are held back until min_batch of them are
+ * waiting and are then released together. Packets are always written whole;
+ * when split_units is set (PCM), a unit may straddle two output buffers.
+ */
+template <typename T>
+class output_batcher
+{
+public:
+    explicit output_batcher(bool split_units)
+        : d_split_units(split_units), d_read(0), d_released(0), d_min_batch(1), d_record_units(false)
+    {
+    }
+
+    // Record the length of every unit that finishes leaving emit(), in
+    // order, so the caller can tag unit boundaries in its output.
+    void set_record_units(bool record)
+    {
+        d_record_units = record;
+        if (!record) {
+            d_emitted_units.clear();
+        }
+    }
+    const std::vector<size_t>& emitted_units() const { return d_emitted_units; }
+    void clear_emitted_units() { d_emitted_units.clear(); }
+
+    void set_min_batch(size_t units)
+    {
+        d_min_batch = std::max<size_t>(1, units);
+        if (d_lengths.size() - d_released >= d_min_batch) {
+            d_released = d_lengths.size();
+        }
+    }
+
+    void push(const T* data, size_t n)
+    {
+        d_items.insert(d_items.end(), data, data + n);
+        d_lengths.push_back(n);
+        if (d_lengths.size() - d_released >= d_min_batch) {
+            d_released = d_lengths.size();
+        }
+    }
+
+    // Releases everything staged regardless of min_batch (end of input, reconfiguration).
+    void release_all() { d_released = d_lengths.size(); }
+
+    size_t emit(T* out, size_t capacity)
+    {
+        size_t written = 0;
+        while (d_released > 0 && written < capacity) {
+            size_t len = d_lengths.front();
+            size_t n = std::min(len, capacity - written);
+            if (n < len && !d_split_units) {
+                break;
+            }
+            std::memcpy(out + written, d_items.data() + d_read, n * sizeof(T));
+            written += n;
+            d_read += n;
+            if (n < len) {
+                d_lengths.front() = len - n;
+                break;
+            }
+            if (d_record_units) {
+                d_emitted_units.push_back(len);
+            }
+            d_lengths.pop_front();
+            d_released--;
+        }
+        compact();
+        return written;
+    }
+
+    void clear()
+    {
+        d_items.clear();
+        d_lengths.clear();
+        d_read = 0;
+        d_released = 0;
+    }
+
+    // Preallocates, faults in and locks room for items staged items.
+    bool lock_storage(size_t items, locked_ranges& locks) { return locks.reserve(d_items, items); }
+
+    size_t staged_units() const { return d_lengths.size(); }
+    size_t staged_items() const { return d_items.size() - d_read; }
+    size_t released_units() const { return d_released; }
+
+private:
+    void compact()
+    {
+        if (d_read == d_items.size()) {
+            d_items.clear();
+            d_read = 0;
+        } else if (d_read > 4096 && d_read * 2 > d_items.size()) {
+            d_items.erase(d_items.begin(), d_items.begin() + d_read);
+            d_read = 0;
+        }
+    }
+
+    const bool d_split_units;
+    std::vector<T> d_items;
+    size_t d_read;
+    std::deque<size_t> d_lengths;
+    size_t d_released;
+    size_t d_min_batch;
+    bool d_record_units;
+    std::vector<size_t> d_emitted_units;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OUTPUT_BATCHER_H */
@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_OVERLOAD_POLICY_H
+#define INCLUDED_GR_OPUS_OVERLOAD_POLICY_H
+
+#include <stdexcept>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * What a block does when its input backlog reaches the buffer limit. Drops
+ * are always whole frames (encoder) or whole packets (decoder with a fixed
+ * packet_size), so the codec never sees a frame or packet cut in half.
+ */
+enum class overload_policy_t { DROP_OLDEST, DROP_NEWEST, BACKPRESSURE, DEGRADE_BITRATE };
+
+inline overload_policy_t overload_policy_from_string(const std::string& policy)
+{
+    if (policy == "drop_oldest") {
+        return overload_policy_t::DROP_OLDEST;
+    } else if (policy == "drop_newest") {
+        return overload_policy_t::DROP_NEWEST;
+    } else if (policy == "backpressure") {
+        return overload_policy_t::BACKPRESSURE;
+    } else if (policy == "degrade_bitrate") {
+        return overload_policy_t::DEGRADE_BITRATE;
+    }
+    throw std::runtime_error("Unknown overload policy: " + policy);
+}
+
+inline const char* overload_policy_to_string(overload_policy_t policy)
+{
+    switch (policy) {
+    case overload_policy_t::DROP_NEWEST:
+        return "drop_newest";
+    case overload_policy_t::BACKPRESSURE:
+        return "backpressure";
+    case overload_policy_t::DEGRADE_BITRATE:
+        return "degrade_bitrate";
+    default:
+        return "drop_oldest";
+    }
+}
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_OVERLOAD_POLICY_H */
@@ -0,0 +1,135 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_PACKET_FRAMER_H
+#define INCLUDED_GR_OPUS_PACKET_FRAMER_H
+
+#include <gnuradio/tags.h>
+#include <pmt/pmt.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Splits a byte stream of Opus packets back into packets, either every
+ * packet_size bytes or at the "packet_len" tags written by
+ * opus_encoder::set_packet_tags (packet_size 0). Bytes outside a tagged
+ * packet, and packets cut short by the next tag, are dropped and counted.
+ */
+class packet_framer
+{
+public:
+    explicit packet_framer(int packet_size)
+        : d_packet_size(packet_size), d_expected(0), d_pos(0), d_packet_start(0), d_dropped_bytes(0)
+    {
+    }
+
+    // Feeds ninput items whose first has absolute offset first; tags are
+    // the "packet_len" tags in that range (ignored with a fixed
+    // packet_size). Calls on_packet(const unsigned char*, int) for every
+    // complete packet.
+    template <typename F>
+    void feed(uint64_t first, const unsigned char* in, size_t ninput, std::vector<gr::tag_t>& tags, F on_packet)
+    {
+        d_pos = first;
+        if (d_packet_size > 0) {
+            consume(in, ninput, on_packet);
+            return;
+        }
+
+        std::sort(tags.begin(), tags.end(), gr::tag_t::offset_compare);
+        size_t pos = 0;
+        for (const gr::tag_t& tag : tags) {
+            size_t at = static_cast<size_t>(tag.offset - first);
+            consume(in + pos, at - pos, on_packet);
+            pos = at;
+            if (!d_packet.empty()) {
+                d_dropped_bytes += d_packet.size();
+                d_packet.clear();
+            }
+            d_expected = pmt::is_integer(tag.value) ? std::max<long>(0, pmt::to_long(tag.value)) : 0;
+        }
+        consume(in + pos, ninput - pos, on_packet);
+    }
+
+    void reset()
+    {
+        d_packet.clear();
+        d_expected = 0;
+    }
+
+    uint64_t dropped_bytes() const { return d_dropped_bytes; }
+    // Absolute offset of the first byte of the packet passed to on_packet.
+    uint64_t packet_offset() const { return d_packet_start; }
+
+private:
+    template <typename F>
+    void consume(const unsigned char* data, size_t n, F& on_packet)
+    {
+        while (n > 0) {
+            if (d_expected == 0) {
+                if (d_packet_size <= 0) {
+                    d_dropped_bytes += n;
+                    d_pos += n;
+                    return;
+                }
+                d_expected = static_cast<size_t>(d_packet_size);
+            }
+            // Whole packets straight from the input when nothing is pending.
+            if (d_packet.empty() && n >= d_expected) {
+                d_packet_start = d_pos;
+                d_pos += d_expected;
+                on_packet(data, static_cast<int>(d_expected));
+                data += d_expected;
+                n -= d_expected;
+                d_expected = 0;
+                continue;
+            }
+            size_t take = std::min(n, d_expected - d_packet.size());
+            if (d_packet.empty()) {
+                d_packet_start = d_pos;
+            }
+            d_pos += take;
+            d_packet.insert(d_packet.end(), data, data + take);
+            data += take;
+            n -= take;
+            if (d_packet.size() == d_expected) {
+                on_packet(d_packet.data(), static_cast<int>(d_packet.size()));
+                d_packet.clear();
+                d_expected = 0;
+            }
+        }
+    }
+
+    const int d_packet_size;
+    size_t d_expected;
+    std::vector<unsigned char> d_packet;
+    uint64_t d_pos; // absolute offset of the next byte consumed
+    uint64_t d_packet_start;
+    uint64_t d_dropped_bytes;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_PACKET_FRAMER_H */
@@ -0,0 +1,67 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_PACKET_TRACE_H
+#define INCLUDED_GR_OPUS_PACKET_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Packet trace file: a trace_header, then one record per packet until end
+ * of file (a capture cut short by a crash simply ends early). Each record
+ * is a trace_record followed by len payload bytes, padded so the next
+ * record starts 8-byte aligned; the file can be mapped and walked in place.
+ * Native-endian. Arrival times are taken once per work() call of the sink,
+ * so packets that arrived in one buffer share a time.
+ */
+static const char trace_magic[8] = { 'G', 'R', 'O', 'P', 'T', 'R', 'C', '1' };
+
+struct trace_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t reserved0;
+    uint64_t start_time_ns; // CLOCK_REALTIME when capture started
+    uint64_t reserved[4];
+};
+
+struct trace_record {
+    uint64_t time_ns; // arrival time, steady clock, relative to capture start
+    uint32_t len;     // payload bytes
+    uint32_t lost;    // packets lost just before this one ("packet_lost" tag)
+};
+
+static_assert(sizeof(trace_header) == 64, "trace_header layout changed");
+static_assert(sizeof(trace_record) == 16, "trace_record layout changed");
+
+inline size_t trace_record_bytes(uint32_t len)
+{
+    return (sizeof(trace_record) + len + 7) & ~size_t(7);
+}
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_PACKET_TRACE_H */
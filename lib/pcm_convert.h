@@ -0,0 +1,46 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_PCM_CONVERT_H
+#define INCLUDED_GR_OPUS_PCM_CONVERT_H
+
+#include <opus/opus.h>
+#include <cstddef>
+
+namespace gr {
+namespace gr_opus {
+
+// Float samples to the int16 input of opus_encode, clipped to +-1.0 (NaN
+// gives full scale). Scaling first and clamping with plain selects lets the
+// compiler vectorise the loop.
+inline void float_to_int16(const float* __restrict in, opus_int16* __restrict out, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        float sample = in[i] * 32767.0f;
+        sample = sample < 32767.0f ? sample : 32767.0f;
+        sample = sample > -32767.0f ? sample : -32767.0f;
+        out[i] = static_cast<opus_int16>(sample);
+    }
+}
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_PCM_CONVERT_H */
@@ -0,0 +1,207 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "post_processor.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+// The soft limiter is linear up to the knee (-1 dBFS) and then bends
+// smoothly towards full scale, with no corner at the knee.
+const float limit_knee = 0.891f;
+const double meter_floor_dbfs = -120.0;
+
+} // namespace
+
+post_processor::post_processor()
+    : d_gain_db(0.0),
+      d_gain(1.0f),
+      d_soft_limit(false),
+      d_squelch(false),
+      d_squelch_threshold(1e-5f),
+      d_squelch_hang_ms(200),
+      d_metering(false),
+      d_samples_per_second(48000),
+      d_gate_gain(1.0f),
+      d_hang_left(0),
+      d_peak(0.0f),
+      d_mean_square(0.0f),
+      d_peak_out(0.0f),
+      d_mean_square_out(0.0f),
+      d_gate_open(true),
+      d_samples_limited(0),
+      d_frames_squelched(0)
+{
+}
+
+void post_processor::set_gain_db(double gain_db)
+{
+    if (!(gain_db >= -60.0 && gain_db <= 40.0)) {
+        throw std::runtime_error("Output gain must be -60 to +40 dB");
+    }
+    d_gain_db.store(gain_db);
+    d_gain.store(static_cast<float>(std::pow(10.0, gain_db / 20.0)));
+}
+
+void post_processor::set_squelch(bool enable, double threshold_dbfs, int hang_ms)
+{
+    if (!(threshold_dbfs >= -120.0 && threshold_dbfs <= 0.0)) {
+        throw std::runtime_error("Squelch threshold must be -120 to 0 dBFS");
+    }
+    if (hang_ms < 0 || hang_ms > 10000) {
+        throw std::runtime_error("Squelch hang time must be 0-10000 ms");
+    }
+    d_squelch_threshold.store(static_cast<float>(std::pow(10.0, threshold_dbfs / 10.0)));
+    d_squelch_hang_ms.store(hang_ms);
+    d_squelch.store(enable);
+}
+
+void post_processor::reset(int samples_per_second)
+{
+    d_samples_per_second = std::max(1, samples_per_second);
+    d_gate_gain = 1.0f;
+    d_hang_left = 0;
+    d_peak = 0.0f;
+    d_mean_square = 0.0f;
+    d_peak_out.store(0.0f);
+    d_mean_square_out.store(0.0f);
+    d_gate_open.store(true);
+}
+
+void post_processor::process(const opus_int16* in, float* out, int samples)
+{
+    run(in, 1.0f / 32767.0f, out, samples);
+}
+
+void post_processor::process(const float* in, float* out, int samples)
+{
+    run(in, 1.0f, out, samples);
+}
+
+template <typename T>
+void post_processor::run(const T* in, float scale, float* out, int samples)
+{
+    if (samples <= 0) {
+        return;
+    }
+    const bool limit = d_soft_limit.load(std::memory_order_relaxed);
+    const bool squelch = d_squelch.load(std::memory_order_relaxed);
+    const bool meter = d_metering.load(std::memory_order_relaxed) || squelch;
+    const float gain = scale * d_gain.load(std::memory_order_relaxed);
+
+    // While the gate is open it follows the level of the frames before this
+    // one, so the frame is touched once. A closed gate looks at the frame
+    // first, so an onset is not lost; closed frames are quiet and rare
+    // enough for the extra pass to cost little. Either way the gate ramps
+    // across the frame so opening and closing never click.
+    const int hang_samples = std::max(1, d_squelch_hang_ms.load(std::memory_order_relaxed)) *
+                             std::max(1, d_samples_per_second / 1000);
+    const float threshold = d_squelch_threshold.load(std::memory_order_relaxed);
+    if (squelch && d_hang_left == 0) {
+        float sum_sq = 0.0f;
+        for (int i = 0; i < samples; ++i) {
+            float x = gain * static_cast<float>(in[i]);
+            sum_sq += x * x;
+        }
+        if (sum_sq / samples >= threshold) {
+            d_hang_left = hang_samples;
+        }
+    }
+    float gate_start = d_gate_gain;
+    float gate_end = 1.0f;
+    if (squelch) {
+        gate_end = d_hang_left > 0 ? 1.0f : 0.0f;
+    }
+    const float gate_step = (gate_end - gate_start) / samples;
+
+    if (!limit && !meter && gate_start == 1.0f && gate_end == 1.0f) {
+        for (int i = 0; i < samples; ++i) {
+            out[i] = std::max(-1.0f, std::min(1.0f, gain * static_cast<float>(in[i])));
+        }
+    } else {
+        float peak = 0.0f;
+        float sum_sq = 0.0f;
+        int limited = 0;
+        for (int i = 0; i < samples; ++i) {
+            float x = gain * static_cast<float>(in[i]);
+            float a = std::fabs(x);
+            peak = std::max(peak, a);
+            sum_sq += x * x;
+            float y;
+            if (limit) {
+                // Branch-free so the loop vectorises: t / (1 + t) has unit
+                // slope at the knee and approaches 1 from below.
+                float t = std::max(a - limit_knee, 0.0f) * (1.0f / (1.0f - limit_knee));
+                y = std::copysign(std::min(a, limit_knee) + (1.0f - limit_knee) * t / (1.0f + t), x);
+                limited += a > limit_knee;
+            } else {
+                y = std::max(-1.0f, std::min(1.0f, x));
+            }
+            out[i] = y * (gate_start + gate_step * i);
+        }
+        d_samples_limited.fetch_add(static_cast<uint64_t>(limited), std::memory_order_relaxed);
+
+        if (meter) {
+            const double seconds = static_cast<double>(samples) / d_samples_per_second;
+            const float frame_ms = sum_sq / samples;
+            d_peak = std::max(peak, d_peak * static_cast<float>(std::pow(10.0, -seconds)));
+            d_mean_square += static_cast<float>(1.0 - std::exp(-seconds / 0.3)) * (frame_ms - d_mean_square);
+            d_peak_out.store(d_peak, std::memory_order_relaxed);
+            d_mean_square_out.store(d_mean_square, std::memory_order_relaxed);
+
+            if (squelch) {
+                if (frame_ms >= threshold) {
+                    d_hang_left = hang_samples;
+                } else {
+                    d_hang_left = std::max(0, d_hang_left - samples);
+                }
+                if (gate_end == 0.0f && gate_start == 0.0f) {
+                    d_frames_squelched.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+    d_gate_gain = gate_end;
+    d_gate_open.store(gate_end > 0.0f, std::memory_order_relaxed);
+}
+
+double post_processor::peak_dbfs() const
+{
+    float peak = d_peak_out.load(std::memory_order_relaxed);
+    return peak > 0.0f ? std::max(meter_floor_dbfs, 20.0 * std::log10(peak)) : meter_floor_dbfs;
+}
+
+double post_processor::rms_dbfs() const
+{
+    float ms = d_mean_square_out.load(std::memory_order_relaxed);
+    return ms > 0.0f ? std::max(meter_floor_dbfs, 10.0 * std::log10(ms)) : meter_floor_dbfs;
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,97 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_POST_PROCESSOR_H
+#define INCLUDED_GR_OPUS_POST_PROCESSOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <opus/opus.h>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Output stage of the decoder: turns each decoded frame into float samples
+ * and, in the same pass, applies gain, a soft limiter, level metering and a
+ * squelch gate. With every stage off it is the plain conversion with a hard
+ * clamp to [-1, 1].
+ *
+ * Settings may change from any thread and take effect at the next frame.
+ * process() must be called serially; the meters can be read from anywhere.
+ */
+class post_processor
+{
+public:
+    post_processor();
+
+    void set_gain_db(double gain_db);
+    double gain_db() const { return d_gain_db.load(); }
+    void set_soft_limit(bool enable) { d_soft_limit.store(enable); }
+    bool soft_limit() const { return d_soft_limit.load(); }
+    void set_squelch(bool enable, double threshold_dbfs, int hang_ms);
+    bool squelch() const { return d_squelch.load(); }
+    void set_metering(bool enable) { d_metering.store(enable); }
+    bool metering() const { return d_metering.load(); }
+
+    // Clears levels and reopens the gate; samples_per_second counts frames
+    // of all channels (sample rate x channels).
+    void reset(int samples_per_second);
+
+    // samples interleaved values, int16 or float PCM from libopus.
+    void process(const opus_int16* in, float* out, int samples);
+    void process(const float* in, float* out, int samples);
+
+    // Levels after the gain: peak hold falling at 20 dB/s and RMS over
+    // about 300 ms, in dBFS (-120 for silence).
+    double peak_dbfs() const;
+    double rms_dbfs() const;
+    bool gate_open() const { return d_gate_open.load(std::memory_order_relaxed); }
+    uint64_t samples_limited() const { return d_samples_limited.load(std::memory_order_relaxed); }
+    uint64_t frames_squelched() const { return d_frames_squelched.load(std::memory_order_relaxed); }
+
+private:
+    template <typename T>
+    void run(const T* in, float scale, float* out, int samples);
+
+    std::atomic<double> d_gain_db;
+    std::atomic<float> d_gain;
+    std::atomic<bool> d_soft_limit;
+    std::atomic<bool> d_squelch;
+    std::atomic<float> d_squelch_threshold; // mean square
+    std::atomic<int> d_squelch_hang_ms;
+    std::atomic<bool> d_metering;
+
+    int d_samples_per_second;
+    float d_gate_gain;
+    int d_hang_left; // samples
+    float d_peak;
+    float d_mean_square;
+    std::atomic<float> d_peak_out;
+    std::atomic<float> d_mean_square_out;
+    std::atomic<bool> d_gate_open;
+    std::atomic<uint64_t> d_samples_limited;
+    std::atomic<uint64_t> d_frames_squelched;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_POST_PROCESSOR_H */
@@ -0,0 +1,120 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "realtime.h"
+#include <cstring>
+
+#ifdef __linux__
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace gr {
+namespace gr_opus {
+
+bool prefault_and_lock(void* data, size_t bytes)
+{
+    if (data == nullptr || bytes == 0) {
+        return true;
+    }
+#ifdef __linux__
+    // Reading is not enough: a private page stays mapped to the shared zero
+    // page until its first write. Writing back what is there keeps the data.
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(data);
+    for (size_t offset = 0; offset < bytes; offset += page) {
+        p[offset] = p[offset];
+    }
+    p[bytes - 1] = p[bytes - 1];
+    return mlock(data, bytes) == 0;
+#else
+    return false;
+#endif
+}
+
+bool locked_ranges::lock(void* data, size_t bytes)
+{
+    if (!prefault_and_lock(data, bytes)) {
+        return false;
+    }
+    if (data != nullptr && bytes > 0) {
+        d_ranges.push_back({ data, bytes });
+        d_bytes += bytes;
+    }
+    return true;
+}
+
+void locked_ranges::unlock_all()
+{
+#ifdef __linux__
+    for (const range& r : d_ranges) {
+        munlock(r.data, r.bytes);
+    }
+#endif
+    d_ranges.clear();
+    d_bytes = 0;
+}
+
+void prefault_stack(size_t stack_bytes)
+{
+#ifdef __linux__
+    // volatile keeps the compiler from dropping the writes.
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(stack_bytes));
+    for (size_t offset = 0; offset < stack_bytes; offset += 4096) {
+        stack[offset] = 0;
+    }
+#endif
+}
+
+bool set_thread_realtime(int priority)
+{
+#ifdef __linux__
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param) == 0;
+#else
+    return priority <= 0;
+#endif
+}
+
+page_faults thread_page_faults()
+{
+    page_faults faults = { 0, 0 };
+#if defined(__linux__) && defined(RUSAGE_THREAD)
+    rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+        faults.minor = static_cast<uint64_t>(usage.ru_minflt);
+        faults.major = static_cast<uint64_t>(usage.ru_majflt);
+    }
+#endif
+    return faults;
+}
+
+} // namespace gr_opus
+} // namespace gr
@@ -0,0 +1,129 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_REALTIME_H
+#define INCLUDED_GR_OPUS_REALTIME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Helpers for the blocks' real-time mode. Everything here degrades
+ * gracefully: a request the system refuses (RLIMIT_MEMLOCK, no
+ * CAP_SYS_NICE, a non-Linux build) returns false and changes nothing.
+ */
+
+// Writes every page of [data, data + bytes) and mlocks the range.
+bool prefault_and_lock(void* data, size_t bytes);
+
+/*
+ * The memory one block has locked. mlock does not nest and a page can be
+ * shared by two buffers, so ranges are not unlocked one at a time: before
+ * freeing or reallocating a locked buffer the owner calls unlock_all(),
+ * then locks what is still in use again. Everything is unlocked on
+ * destruction.
+ */
+class locked_ranges
+{
+public:
+    locked_ranges() : d_bytes(0) {}
+    ~locked_ranges() { unlock_all(); }
+    locked_ranges(const locked_ranges&) = delete;
+    locked_ranges& operator=(const locked_ranges&) = delete;
+
+    bool lock(void* data, size_t bytes);
+
+    // Grows v's capacity to at least items, faults in and locks all of it.
+    // The size is unchanged; as long as v stays within the capacity it is
+    // never reallocated, so the locked pages stay in use.
+    template <typename T>
+    bool reserve(std::vector<T>& v, size_t items)
+    {
+        const size_t size = v.size();
+        if (v.capacity() < items) {
+            v.reserve(items);
+        }
+        v.resize(v.capacity());
+        v.resize(size);
+        return lock(v.data(), v.capacity() * sizeof(T));
+    }
+
+    void unlock_all();
+    // Bytes currently locked.
+    size_t bytes() const { return d_bytes; }
+
+private:
+    struct range {
+        void* data;
+        size_t bytes;
+    };
+    std::vector<range> d_ranges;
+    size_t d_bytes;
+};
+
+// Touches the next stack_bytes of the calling thread's stack.
+void prefault_stack(size_t stack_bytes = 256 * 1024);
+
+// SCHED_FIFO at priority (1-99) for the calling thread, or back to
+// SCHED_OTHER with priority 0.
+bool set_thread_realtime(int priority);
+
+// Minor and major page faults of the calling thread so far.
+struct page_faults {
+    uint64_t minor;
+    uint64_t major;
+};
+page_faults thread_page_faults();
+
+// Adds the calling thread's page faults between construction and
+// destruction to minor and major; does nothing when not enabled.
+class fault_scope
+{
+public:
+    fault_scope(bool enabled, uint64_t& minor, uint64_t& major)
+        : d_enabled(enabled), d_minor(minor), d_major(major), d_start(enabled ? thread_page_faults() : page_faults{ 0, 0 })
+    {
+    }
+    ~fault_scope()
+    {
+        if (d_enabled) {
+            page_faults end = thread_page_faults();
+            d_minor += end.minor - d_start.minor;
+            d_major += end.major - d_start.major;
+        }
+    }
+    fault_scope(const fault_scope&) = delete;
+    fault_scope& operator=(const fault_scope&) = delete;
+
+private:
+    const bool d_enabled;
+    uint64_t& d_minor;
+    uint64_t& d_major;
+    const page_faults d_start;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_REALTIME_H */
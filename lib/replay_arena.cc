@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "replay_arena.h"
+#include <cstring>
+
+namespace gr {
+namespace gr_opus {
+
+replay_arena::replay_arena(size_t bytes) : d_arena(bytes), d_write(0), d_total_samples(0) {}
+
+bool replay_arena::store(const unsigned char* packet, int len, int samples)
+{
+    if (len <= 0 || static_cast<size_t>(len) > d_arena.size()) {
+        return false;
+    }
+    if (d_write + len > d_arena.size()) {
+        // Wrap; packets left in the unused tail belong to the previous lap.
+        while (!d_index.empty() && d_index.front().offset >= d_write) {
+            d_index.pop_front();
+        }
+        d_write = 0;
+    }
+    while (!d_index.empty() && d_index.front().offset < d_write + len &&
+           d_index.front().offset + d_index.front().len > d_write) {
+        d_index.pop_front();
+    }
+
+    std::memcpy(d_arena.data() + d_write, packet, len);
+    d_index.push_back({ d_write, len, d_total_samples, samples });
+    d_write += len;
+    d_total_samples += samples;
+    return true;
+}
+
+void replay_arena::collect(uint64_t from, uint64_t stop, std::vector<unsigned char>& packets,
+                           std::vector<entry>& picked) const
+{
+    for (const entry& e : d_index) {
+        if (e.sample_pos + e.samples <= from) {
+            continue;
+        }
+        if (e.sample_pos >= stop) {
+            break;
+        }
+        picked.push_back({ packets.size(), e.len, e.sample_pos, e.samples });
+        packets.insert(packets.end(), d_arena.data() + e.offset, d_arena.data() + e.offset + e.len);
+    }
+}
+
+} // namespace gr_opus
+} // namespace gr
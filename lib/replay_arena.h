@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_REPLAY_ARENA_H
+#define INCLUDED_GR_OPUS_REPLAY_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Fixed-size circular store of variable-length packets, indexed by stream
+ * sample position. A packet that does not fit before the end of the arena
+ * wraps to the start; every older packet it overlaps is evicted, oldest
+ * first. Not thread-safe.
+ */
+class replay_arena
+{
+public:
+    // One stored packet: where it sits in the arena and the stream sample
+    // position of its first sample.
+    struct entry {
+        size_t offset;
+        int len;
+        uint64_t sample_pos;
+        int samples;
+    };
+
+    explicit replay_arena(size_t bytes);
+
+    // False, storing nothing, if len exceeds the arena.
+    bool store(const unsigned char* packet, int len, int samples);
+
+    // Appends copies of the packets overlapping samples [from, stop) to
+    // packets; the offsets of the returned entries index into packets.
+    void collect(uint64_t from, uint64_t stop, std::vector<unsigned char>& packets, std::vector<entry>& picked) const;
+
+    size_t bytes() const { return d_arena.size(); }
+    size_t packets() const { return d_index.size(); }
+    uint64_t total_samples() const { return d_total_samples; }
+    // Stream position of the oldest stored sample (total_samples() if empty).
+    uint64_t oldest_sample() const { return d_index.empty() ? d_total_samples : d_index.front().sample_pos; }
+
+private:
+    std::vector<unsigned char> d_arena;
+    size_t d_write;
+    std::deque<entry> d_index;
+    uint64_t d_total_samples;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_REPLAY_ARENA_H */
@@ -0,0 +1,184 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "shm_ring_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+
+namespace gr {
+namespace gr_opus {
+
+shm_ring_writer::shm_ring_writer(const std::string& name, int sample_rate, int channels, int frame_samples, int slot_count)
+    : d_name("/" + name),
+      d_channels(channels),
+      d_frame_samples(frame_samples),
+      d_base(nullptr),
+      d_size(0),
+      d_header(nullptr),
+      d_readers(nullptr),
+      d_slot(nullptr),
+      d_filled(0),
+      d_seq(0),
+      d_sample_offset(0),
+      d_frames_published(0),
+      d_reader_count(0),
+      d_reader_overruns(0)
+{
+    if (name.empty() || name.find('/') != std::string::npos) {
+        throw std::runtime_error("Shared-memory ring name must be non-empty and contain no '/'");
+    }
+    if (frame_samples <= 0 || slot_count < 2) {
+        throw std::runtime_error("Shared-memory ring needs frame_samples > 0 and slot_count >= 2");
+    }
+    d_size = shm_ring_size(channels, frame_samples, slot_count);
+
+    // A stale ring from a crashed writer is replaced, never reused.
+    shm_unlink(d_name.c_str());
+    int fd = shm_open(d_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create shared-memory ring " + name + ": " + std::strerror(errno));
+    }
+    void* base = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(d_size)) == 0) {
+        base = mmap(nullptr, d_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int error = errno;
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(d_name.c_str());
+        throw std::runtime_error("Failed to map shared-memory ring " + name + ": " + std::strerror(error));
+    }
+    d_base = base;
+
+    // The fresh mapping is zero-filled; only the constants need writing.
+    d_header = static_cast<shm_ring_header*>(d_base);
+    d_header->version = shm_ring_version;
+    d_header->sample_rate = static_cast<uint32_t>(sample_rate);
+    d_header->channels = static_cast<uint32_t>(channels);
+    d_header->frame_samples = static_cast<uint32_t>(frame_samples);
+    d_header->slot_count = static_cast<uint32_t>(slot_count);
+    d_header->slot_bytes = static_cast<uint32_t>(shm_ring_slot_bytes(channels, frame_samples));
+    d_header->max_readers = shm_ring_max_readers;
+    d_header->writer_pid = static_cast<uint32_t>(getpid());
+    d_readers = reinterpret_cast<shm_ring_reader_entry*>(d_header + 1);
+    // No reader has been lapped yet, including one still at sequence 0.
+    std::fill(d_lapped_seq, d_lapped_seq + shm_ring_max_readers, UINT64_MAX);
+    // Readers check the magic last.
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(d_header->magic, shm_ring_magic, sizeof(shm_ring_magic));
+}
+
+shm_ring_writer::~shm_ring_writer()
+{
+    munmap(d_base, d_size);
+    shm_unlink(d_name.c_str());
+}
+
+void shm_ring_writer::write(const float* samples, size_t n)
+{
+    const size_t frame_floats = static_cast<size_t>(d_frame_samples) * d_channels;
+    size_t pos = 0;
+    while (pos < n) {
+        if (!d_slot) {
+            begin_frame();
+        }
+        float* dst = reinterpret_cast<float*>(d_slot + 1) + d_filled;
+        size_t take = std::min(frame_floats - d_filled, n - pos);
+        std::memcpy(dst, samples + pos, take * sizeof(float));
+        d_filled += take;
+        pos += take;
+        if (d_filled == frame_floats) {
+            publish(static_cast<uint32_t>(d_frame_samples));
+        }
+    }
+}
+
+void shm_ring_writer::flush()
+{
+    if (d_slot && d_filled > 0) {
+        publish(static_cast<uint32_t>(d_filled / d_channels));
+    }
+}
+
+void shm_ring_writer::set_closed(bool closed)
+{
+    d_header->closed.store(closed ? 1 : 0, std::memory_order_release);
+}
+
+void shm_ring_writer::begin_frame()
+{
+    d_slot = shm_ring_slot_at(d_base, d_seq + 1);
+    d_slot->seq_begin.store(d_seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    d_filled = 0;
+}
+
+void shm_ring_writer::publish(uint32_t samples)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    d_slot->sample_offset = d_sample_offset;
+    d_slot->timestamp_ns = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    d_slot->samples = samples;
+    d_seq++;
+    d_slot->seq_end.store(d_seq, std::memory_order_release);
+    d_header->write_seq.store(d_seq, std::memory_order_release);
+
+    d_sample_offset += samples;
+    d_frames_published++;
+    d_slot = nullptr;
+    d_filled = 0;
+    check_readers();
+}
+
+void shm_ring_writer::check_readers()
+{
+    // Dead readers are reaped once per lap so their entries can be reused.
+    const bool reap = d_seq % d_header->slot_count == 0;
+    int count = 0;
+    for (uint32_t i = 0; i < shm_ring_max_readers; ++i) {
+        uint32_t pid = d_readers[i].pid.load(std::memory_order_acquire);
+        if (pid == 0) {
+            continue;
+        }
+        if (reap && kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH) {
+            d_readers[i].pid.compare_exchange_strong(pid, 0);
+            continue;
+        }
+        count++;
+        uint64_t read = d_readers[i].read_seq.load(std::memory_order_acquire);
+        // Count each lap once: the reader must move before it is flagged again.
+        if (d_seq - read >= d_header->slot_count && d_lapped_seq[i] != read) {
+            d_lapped_seq[i] = read;
+            d_reader_overruns++;
+        }
+    }
+    d_reader_count = count;
+}
+
+} // namespace gr_opus
+} // namespace gr
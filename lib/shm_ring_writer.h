@@ -0,0 +1,85 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_SHM_RING_WRITER_H
+#define INCLUDED_GR_OPUS_SHM_RING_WRITER_H
+
+#include <gnuradio/gr_opus/shm_ring.h>
+#include <atomic>
+#include <string>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Writer side of the shared-memory PCM ring (see shm_ring.h). Creates
+ * /dev/shm/<name>, replacing any stale ring, and removes it again on
+ * destruction. Interleaved samples are cut into frames of frame_samples
+ * per channel, each published through its slot's seqlock. Never waits for
+ * readers; readers found a full ring behind are counted.
+ */
+class shm_ring_writer
+{
+public:
+    shm_ring_writer(const std::string& name, int sample_rate, int channels, int frame_samples, int slot_count);
+    ~shm_ring_writer();
+
+    shm_ring_writer(const shm_ring_writer&) = delete;
+    shm_ring_writer& operator=(const shm_ring_writer&) = delete;
+
+    // n interleaved floats; frames are published as they fill.
+    void write(const float* samples, size_t n);
+    // Publishes a trailing partial frame short rather than losing it.
+    void flush();
+    // Marks the ring open or closed for readers.
+    void set_closed(bool closed);
+
+    long frames_published() const { return d_frames_published.load(); }
+    int readers() const { return d_reader_count.load(); }
+    long reader_overruns() const { return d_reader_overruns.load(); }
+
+private:
+    void begin_frame();
+    void publish(uint32_t samples);
+    void check_readers();
+
+    const std::string d_name;
+    const int d_channels;
+    const int d_frame_samples;
+    void* d_base;
+    size_t d_size;
+    shm_ring_header* d_header;
+    shm_ring_reader_entry* d_readers;
+
+    shm_ring_slot* d_slot; // slot being filled, seq_begin already stored
+    size_t d_filled;       // floats written into it
+    uint64_t d_seq;
+    uint64_t d_sample_offset;
+    uint64_t d_lapped_seq[shm_ring_max_readers];
+
+    std::atomic<long> d_frames_published;
+    std::atomic<int> d_reader_count;
+    std::atomic<long> d_reader_overruns;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_SHM_RING_WRITER_H */
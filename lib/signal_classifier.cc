@@ -0,0 +1,215 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "signal_classifier.h"
+#include <algorithm>
+#include <cmath>
+
+namespace gr {
+namespace gr_opus {
+
+namespace {
+
+const int band_edges_hz[3] = { 4000, 8000, 12000 };
+const int full_band_hz = 20000;
+
+// Frames below about -70 dBFS leave both decisions alone.
+const double silence_energy = 1e-7;
+// Energy above a band edge, relative to the total, that still counts as
+// empty (-30 dB over the window) or forces a wider band at once (-25 dB in
+// one frame).
+const double empty_band_ratio = 1e-3;
+const double widen_ratio = 3e-3;
+
+} // namespace
+
+double signal_classifier::biquad::process(double x)
+{
+    double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    return y;
+}
+
+signal_classifier::signal_classifier() { reset(48000, 20.0); }
+
+void signal_classifier::reset(int sample_rate, double frame_ms)
+{
+    d_sample_rate = sample_rate;
+    d_window = std::max<size_t>(4, static_cast<size_t>(std::lround(1000.0 / frame_ms)));
+    d_hold = d_window / 2;
+    d_num_bands = 0;
+    for (int edge : band_edges_hz) {
+        // Each band edge gets two cascaded Butterworth sections, so
+        // strong content an octave below leaks in at -24 dB or less.
+        if (edge >= 0.45 * sample_rate) {
+            break;
+        }
+        const double pi = 3.14159265358979323846;
+        double w0 = 2.0 * pi * edge / sample_rate;
+        double alpha = std::sin(w0) / (2.0 * std::sqrt(0.5));
+        double c = std::cos(w0);
+        double a0 = 1.0 + alpha;
+        biquad& f = d_highpass[d_num_bands];
+        f.b0 = (1.0 + c) / 2.0 / a0;
+        f.b1 = -(1.0 + c) / a0;
+        f.b2 = (1.0 + c) / 2.0 / a0;
+        f.a1 = -2.0 * c / a0;
+        f.a2 = (1.0 - alpha) / a0;
+        f.x1 = f.x2 = f.y1 = f.y2 = 0.0;
+        d_num_bands++;
+    }
+    std::copy(d_highpass, d_highpass + d_num_bands, d_cascade);
+    d_last_sample = 0.0;
+
+    d_history.assign(d_window, frame_stats());
+    d_next = 0;
+    d_filled = 0;
+    d_signal_age = 0;
+    d_bandwidth_age = 0;
+    d_signal = SIGNAL_UNKNOWN;
+    d_bandwidth_hz = full_band_hz;
+}
+
+void signal_classifier::update(const float* samples, int frame_size, int channels)
+{
+    frame_stats frame = { 0.0, 0.0, { 0.0, 0.0, 0.0 } };
+    int crossings = 0;
+    for (int i = 0; i < frame_size; ++i) {
+        double x = 0.0;
+        for (int c = 0; c < channels; ++c) {
+            x += samples[i * channels + c];
+        }
+        x /= channels;
+        frame.energy += x * x;
+        if ((x >= 0.0) != (d_last_sample >= 0.0)) {
+            crossings++;
+        }
+        d_last_sample = x;
+        for (int b = 0; b < d_num_bands; ++b) {
+            double y = d_cascade[b].process(d_highpass[b].process(x));
+            frame.above[b] += y * y;
+        }
+    }
+    frame.energy /= frame_size;
+    frame.zcr = static_cast<double>(crossings) / frame_size;
+    for (int b = 0; b < d_num_bands; ++b) {
+        frame.above[b] /= frame_size;
+    }
+
+    d_history[d_next] = frame;
+    d_next = (d_next + 1) % d_window;
+    d_filled = std::min(d_filled + 1, d_window);
+    d_signal_age++;
+    d_bandwidth_age++;
+
+    if (frame.energy < silence_energy) {
+        return;
+    }
+    decide_bandwidth(frame);
+    if (d_filled >= d_window / 4) {
+        decide_signal();
+    }
+}
+
+void signal_classifier::decide_signal()
+{
+    double mean_energy = 0.0;
+    for (size_t i = 0; i < d_filled; ++i) {
+        mean_energy += d_history[i].energy;
+    }
+    mean_energy /= d_filled;
+
+    size_t low = 0, active = 0;
+    double zcr_sum = 0.0, zcr_sq = 0.0;
+    for (size_t i = 0; i < d_filled; ++i) {
+        const frame_stats& f = d_history[i];
+        if (f.energy < 0.5 * mean_energy) {
+            low++;
+        }
+        if (f.energy >= silence_energy) {
+            active++;
+            zcr_sum += f.zcr;
+            zcr_sq += f.zcr * f.zcr;
+        }
+    }
+    const double low_ratio = static_cast<double>(low) / d_filled;
+    const double zcr_mean = active > 0 ? zcr_sum / active : 0.0;
+    const double zcr_std = active > 0 ? std::sqrt(std::max(0.0, zcr_sq / active - zcr_mean * zcr_mean)) : 0.0;
+
+    signal_class want = d_signal;
+    if (low_ratio >= 0.35 || (low_ratio >= 0.25 && zcr_std >= 0.05)) {
+        want = SIGNAL_VOICE;
+    } else if (low_ratio < 0.15 && zcr_std < 0.05) {
+        want = SIGNAL_MUSIC;
+    }
+    if (want != d_signal && (d_signal == SIGNAL_UNKNOWN || d_signal_age >= d_hold)) {
+        d_signal = want;
+        d_signal_age = 0;
+    }
+}
+
+void signal_classifier::decide_bandwidth(const frame_stats& frame)
+{
+    int current = 0;
+    while (current < d_num_bands && band_edges_hz[current] != d_bandwidth_hz) {
+        current++;
+    }
+
+    // Widen at once: cutting off content that is there is audible.
+    if (current < d_num_bands && frame.above[current] > widen_ratio * frame.energy) {
+        int wider = current + 1;
+        while (wider < d_num_bands && frame.above[wider] > widen_ratio * frame.energy) {
+            wider++;
+        }
+        d_bandwidth_hz = wider < d_num_bands ? band_edges_hz[wider] : full_band_hz;
+        d_bandwidth_age = 0;
+        return;
+    }
+
+    if (d_bandwidth_age < d_hold || d_filled < d_window / 2) {
+        return;
+    }
+    double total = 0.0;
+    double above[3] = { 0.0, 0.0, 0.0 };
+    for (size_t i = 0; i < d_filled; ++i) {
+        total += d_history[i].energy;
+        for (int b = 0; b < d_num_bands; ++b) {
+            above[b] += d_history[i].above[b];
+        }
+    }
+    int narrowest = 0;
+    while (narrowest < d_num_bands && above[narrowest] >= empty_band_ratio * total) {
+        narrowest++;
+    }
+    if (narrowest < current) {
+        d_bandwidth_hz = band_edges_hz[narrowest];
+        d_bandwidth_age = 0;
+    }
+}
+
+} // namespace gr_opus
+} // namespace gr
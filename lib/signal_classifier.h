@@ -0,0 +1,95 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_SIGNAL_CLASSIFIER_H
+#define INCLUDED_GR_OPUS_SIGNAL_CLASSIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace gr {
+namespace gr_opus {
+
+/*
+ * Cheap voice/music and audio bandwidth classifier run in front of the
+ * encoder. Per frame it measures energy, zero-crossing rate and the energy
+ * above 4, 8 and 12 kHz (2nd-order high-pass filters), and judges over the
+ * last second:
+ *  - voice when many frames are well below the mean energy (syllables and
+ *    pauses), helped by a spread of zero-crossing rates (voiced vs
+ *    fricative); music when the level and the zero-crossing rate are steady.
+ *  - bandwidth as the narrowest band holding all but -30 dB of the energy.
+ * Both decisions are held for at least half a second between changes, except
+ * that the bandwidth widens at once when a frame has content above it.
+ */
+class signal_classifier
+{
+public:
+    enum signal_class { SIGNAL_UNKNOWN, SIGNAL_VOICE, SIGNAL_MUSIC };
+
+    signal_classifier();
+
+    // Clears all history; frame_ms is the duration of one update() frame.
+    void reset(int sample_rate, double frame_ms);
+
+    // One interleaved frame of frame_size samples per channel.
+    void update(const float* samples, int frame_size, int channels);
+
+    signal_class signal() const { return d_signal; }
+    // Upper edge of the content in Hz: 4000, 8000, 12000 or 20000 (full band).
+    int bandwidth_hz() const { return d_bandwidth_hz; }
+
+private:
+    struct biquad {
+        double b0, b1, b2, a1, a2;
+        double x1, x2, y1, y2;
+        double process(double x);
+    };
+    struct frame_stats {
+        double energy;
+        double zcr;
+        double above[3]; // energy above 4, 8 and 12 kHz
+    };
+
+    void decide_signal();
+    void decide_bandwidth(const frame_stats& frame);
+
+    int d_sample_rate;
+    size_t d_window;
+    size_t d_hold;
+    int d_num_bands; // high-pass filters below Nyquist
+    biquad d_highpass[3];
+    biquad d_cascade[3];
+    double d_last_sample;
+
+    std::vector<frame_stats> d_history;
+    size_t d_next;
+    size_t d_filled;
+    size_t d_signal_age;
+    size_t d_bandwidth_age;
+
+    signal_class d_signal;
+    int d_bandwidth_hz;
+};
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_SIGNAL_CLASSIFIER_H */
@@ -0,0 +1,47 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_GR_OPUS_UPSTREAM_DONE_H
+#define INCLUDED_GR_OPUS_UPSTREAM_DONE_H
+
+#include <gnuradio/block.h>
+#include <gnuradio/block_detail.h>
+#ifdef GR_HAVE_BUFFER_READER_H
+#include <gnuradio/buffer_reader.h>
+#else
+#include <gnuradio/buffer.h>
+#endif
+
+namespace gr {
+namespace gr_opus {
+
+// True once the block feeding input port has finished: the items already
+// available are the last. Lets a block that holds output back release it
+// at end of stream, since nothing can be produced once work() stops.
+inline bool upstream_done(const gr::block& b, unsigned int port)
+{
+    gr::block_detail_sptr detail = b.detail();
+    return detail && detail->input(port)->done();
+}
+
+} // namespace gr_opus
+} // namespace gr
+
+#endif /* INCLUDED_GR_OPUS_UPSTREAM_DONE_H */
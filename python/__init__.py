@@ -4,11 +4,53 @@ Opus audio codec wrapper module
 """
 
 try:
-    from ._gr_opus_swig import opus_decoder, opus_encoder
+    from ._gr_opus_swig import (
+        load_governor,
+        opus_channel_sim,
+        opus_decoder,
+        opus_encoder,
+        opus_encoder_bank,
+        opus_multi_recorder,
+        opus_ogg_demux,
+        opus_pdu_encoder,
+        opus_replay_buffer,
+        opus_shm_sink,
+        opus_spurt_source,
+        opus_trace_sink,
+        opus_trace_source,
+    )
 except ImportError:
     try:
-        from .gr_opus_swig import opus_decoder, opus_encoder
+        from .gr_opus_swig import (
+            load_governor,
+            opus_channel_sim,
+            opus_decoder,
+            opus_encoder,
+            opus_encoder_bank,
+            opus_multi_recorder,
+            opus_ogg_demux,
+            opus_pdu_encoder,
+            opus_replay_buffer,
+            opus_shm_sink,
+            opus_spurt_source,
+            opus_trace_sink,
+            opus_trace_source,
+        )
     except ImportError:
+        # The load governor, the channel simulator, the PDU encoder, the
+        # encoder bank, the Ogg demuxer and the recording, trace and
+        # shared-memory blocks are C++ only
+        load_governor = None
+        opus_replay_buffer = None
+        opus_multi_recorder = None
+        opus_spurt_source = None
+        opus_shm_sink = None
+        opus_trace_sink = None
+        opus_trace_source = None
+        opus_channel_sim = None
+        opus_pdu_encoder = None
+        opus_encoder_bank = None
+        opus_ogg_demux = None
         try:
             from .opus_decoder import opus_decoder
             from .opus_encoder import opus_encoder
@@ -20,4 +62,18 @@ except ImportError:
             from .opus_decoder import opus_decoder
             from .opus_encoder import opus_encoder
 
-__all__ = ["opus_encoder", "opus_decoder"]
+__all__ = [
+    "opus_encoder",
+    "opus_decoder",
+    "load_governor",
+    "opus_replay_buffer",
+    "opus_multi_recorder",
+    "opus_spurt_source",
+    "opus_shm_sink",
+    "opus_trace_sink",
+    "opus_trace_source",
+    "opus_channel_sim",
+    "opus_pdu_encoder",
+    "opus_encoder_bank",
+    "opus_ogg_demux",
+]
@@ -17,15 +17,18 @@ class opus_decoder(gr.sync_block):
     Output: Float32 audio samples (mono or stereo)
     """
 
-    def __init__(self, sample_rate=48000, channels=1, packet_size=0, dnn_blob_path=""):
+    def __init__(self, sample_rate=48000, channels=1, packet_size=0, dnn_blob_path="", defer_init=False):
         """
         Initialize Opus decoder
 
         Args:
-            sample_rate: Output sample rate (8000, 12000, 16000, 24000, or 48000 Hz)
-            channels: Number of channels (1 for mono, 2 for stereo)
+            sample_rate: Output sample rate (8000, 12000, 16000, 24000, or 48000 Hz),
+                independent of the rate the stream was encoded at
+            channels: Output channels (1 for mono, 2 for stereo); stereo streams
+                are downmixed by libopus when decoding to mono
             packet_size: Fixed packet size in bytes (0 for variable/auto-detect)
             dnn_blob_path: Ignored in Python fallback (C++ DRED only)
+            defer_init: Ignored in Python fallback (C++ only)
         """
         gr.sync_block.__init__(self, name="opus_decoder", in_sig=[np.uint8], out_sig=[np.float32])
 
@@ -49,6 +52,12 @@ class opus_decoder(gr.sync_block):
         # Buffer for accumulating encoded packets
         self.packet_buffer = bytearray()
 
+        # Auto mode locks onto a packet length after a run of equal packets
+        self.locked_packet_size = 0
+        self.lock_candidate = 0
+        self.lock_streak = 0
+        self.lock_toc = 0
+
         # Maximum buffer size (1MB) to prevent memory leaks
         self.max_buffer_size = 1024 * 1024
 
@@ -79,6 +88,199 @@ class opus_decoder(gr.sync_block):
             "decoder": self.decoder,
         }
 
+    @staticmethod
+    def make_custom(sample_rate, channels, frame_size, packet_size):
+        """Opus Custom mode (not available in Python fallback, C++ only)"""
+        raise RuntimeError("Opus Custom mode requires the C++ gr-opus blocks")
+
+    def set_overload_policy(self, policy):
+        """
+        Select the overload policy. The Python fallback validates the name but
+        always drops the oldest data (C++ only for the others).
+        """
+        if policy not in ("drop_oldest", "drop_newest", "backpressure"):
+            raise RuntimeError(f"Unknown overload policy: {policy}")
+        self.overload_policy_value = policy
+
+    def overload_policy(self):
+        return getattr(self, "overload_policy_value", "drop_oldest")
+
+    def set_complexity(self, complexity):
+        """Decoder complexity (-1 = libopus default, 0-10); stored only, C++ only"""
+        if complexity < -1 or complexity > 10:
+            raise RuntimeError("Decoder complexity must be -1 (libopus default) or 0-10")
+        self.complexity_value = complexity
+
+    def complexity(self):
+        return getattr(self, "complexity_value", -1)
+
+    def set_complexity_governor(self, enable, max_load=0.5):
+        """Complexity governor (ignored in Python fallback, C++ only)"""
+        if max_load <= 0:
+            raise RuntimeError("Governor max_load must be positive")
+        self.complexity_governor_value = (bool(enable), float(max_load))
+
+    def effective_complexity(self):
+        return self.complexity()
+
+    def set_packet_tags(self, enable):
+        """Frame packets at "packet_len" tags (ignored in Python fallback, C++ only)"""
+        if enable and self.packet_size > 0:
+            raise RuntimeError("Packet tag framing needs packet_size 0")
+        self.packet_tags_value = bool(enable)
+
+    def packet_tags(self):
+        return getattr(self, "packet_tags_value", False)
+
+    def set_loss_recovery(self, mode):
+        """Recovery of frames signalled lost (stored only in Python fallback, C++ only)"""
+        if mode not in ("plc", "fec", "dred"):
+            raise RuntimeError(f"Unknown loss recovery mode: {mode}")
+        self.loss_recovery_value = mode
+
+    def loss_recovery(self):
+        return getattr(self, "loss_recovery_value", "plc")
+
+    def set_output_gain(self, gain_db):
+        """Output gain in dB (stored only in Python fallback, C++ only)"""
+        if gain_db < -60.0 or gain_db > 40.0:
+            raise RuntimeError("Output gain must be -60 to +40 dB")
+        self.output_gain_value = float(gain_db)
+
+    def output_gain(self):
+        return getattr(self, "output_gain_value", 0.0)
+
+    def set_soft_limiter(self, enable):
+        """Soft limiter at full scale (ignored in Python fallback, C++ only)"""
+        self.soft_limiter_value = bool(enable)
+
+    def soft_limiter(self):
+        return getattr(self, "soft_limiter_value", False)
+
+    def set_squelch(self, enable, threshold_dbfs=-50.0, hang_ms=200):
+        """Squelch gate (ignored in Python fallback, C++ only)"""
+        if threshold_dbfs < -120.0 or threshold_dbfs > 0.0:
+            raise RuntimeError("Squelch threshold must be -120 to 0 dBFS")
+        if hang_ms < 0 or hang_ms > 10000:
+            raise RuntimeError("Squelch hang time must be 0-10000 ms")
+        self.squelch_value = bool(enable)
+
+    def squelch(self):
+        return getattr(self, "squelch_value", False)
+
+    def set_level_meter(self, enable):
+        """Peak/RMS level telemetry (ignored in Python fallback, C++ only)"""
+        self.level_meter_value = bool(enable)
+
+    def level_meter(self):
+        return getattr(self, "level_meter_value", False)
+
+    def detected_packet_size(self):
+        """Fixed packet_size, or the length auto mode has locked onto (0 while searching)"""
+        return self.packet_size if self.packet_size > 0 else self.locked_packet_size
+
+    def stream_channels(self):
+        """Channel count coded in the most recent packet (0 before the first)"""
+        return getattr(self, "stream_channels_value", 0)
+
+    def _note_stream_format(self, packet):
+        # TOC byte: bit 2 is the stereo flag
+        self.stream_channels_value = 2 if packet[0] & 0x04 else 1
+
+    @staticmethod
+    def _framed_at(data, length):
+        # The next two slices, as far as buffered, start with the same TOC
+        # configuration and stereo bits as the first
+        for k in (1, 2):
+            if k * length >= len(data):
+                break
+            if (data[k * length] & 0xFC) != (data[0] & 0xFC):
+                return False
+        return True
+
+    def _note_packet_length(self, data, length):
+        if not self._framed_at(data, length):
+            self.lock_streak = 0
+            return
+        if length == self.lock_candidate and (data[0] & 0xFC) == self.lock_toc and self.lock_streak > 0:
+            self.lock_streak += 1
+        else:
+            self.lock_candidate = length
+            self.lock_toc = data[0] & 0xFC
+            self.lock_streak = 1
+        if self.lock_streak >= 8:
+            self.locked_packet_size = length
+
+    def _reset_lock(self):
+        self.locked_packet_size = 0
+        self.lock_candidate = 0
+        self.lock_streak = 0
+
+    def set_realtime(self, enable, priority=0):
+        """Real-time mode (stored only in Python fallback, C++ only)"""
+        if priority < 0 or priority > 99:
+            raise RuntimeError("Real-time priority must be 0-99")
+        self.realtime_value = bool(enable)
+
+    def realtime(self):
+        return getattr(self, "realtime_value", False)
+
+    def set_load_priority(self, priority):
+        """
+        Priority class under the load governor. The Python fallback validates
+        the name but is never shed (C++ only).
+        """
+        if priority not in ("low", "normal", "high", "emergency"):
+            raise RuntimeError(f"Unknown load priority: {priority}")
+        self.load_priority_value = priority
+
+    def load_priority(self):
+        return getattr(self, "load_priority_value", "normal")
+
+    def load_shed_level(self):
+        return 0
+
+    def set_shared_pool(self, enable, queue_depth=4):
+        """Select the shared codec pool (ignored in Python fallback, C++ only)"""
+        self.use_shared_pool = bool(enable)
+        self.pool_queue_depth = max(1, min(64, int(queue_depth)))
+
+    def shared_pool(self):
+        """Return whether the shared codec pool was requested"""
+        return getattr(self, "use_shared_pool", False)
+
+    def set_max_frames_per_work(self, frames):
+        """Bound the number of frames processed per work() call (0 = unbounded)"""
+        self.max_frames_per_work_value = max(0, int(frames))
+
+    def max_frames_per_work(self):
+        return getattr(self, "max_frames_per_work_value", 0)
+
+    def set_min_frames_per_emit(self, frames):
+        """Output batching (ignored in Python fallback, C++ only)"""
+        self.min_frames_per_emit_value = max(1, int(frames))
+
+    def min_frames_per_emit(self):
+        return getattr(self, "min_frames_per_emit_value", 1)
+
+    def set_telemetry_interval(self, frames):
+        """Telemetry publishing (ignored in Python fallback, C++ only)"""
+        self.telemetry_interval = max(0, int(frames))
+
+    def set_format(self, sample_rate, channels):
+        """
+        Switch output format. The Python fallback recreates the decoder at
+        once; only the C++ block tags the change.
+        """
+        if sample_rate not in (8000, 12000, 16000, 24000, 48000) or channels not in (1, 2):
+            raise RuntimeError(f"Unsupported Opus format: {sample_rate} Hz, {channels} channel(s)")
+        self.decoder = opuslib.Decoder(sample_rate, channels)
+        self._refs["decoder"] = self.decoder
+        self.sample_rate = sample_rate
+        self.channels = channels
+        self.frame_size = int(sample_rate * 0.020)
+        self._reset_lock()
+
     # Do not override forecast - sync_blocks handle forecasting internally
     # The parent gr.sync_block.forecast method handles this automatically
     # Overriding it causes NoneType casting errors in GNU Radio's gateway code
@@ -95,24 +297,35 @@ class opus_decoder(gr.sync_block):
 
         # Prevent unbounded buffer growth (memory leak protection)
         if len(self.packet_buffer) > self.max_buffer_size:
-            # Keep only the most recent data (drop oldest)
+            # Keep only the most recent data (drop oldest whole packets, or
+            # everything but the new input when packets are not fixed size)
             excess = len(self.packet_buffer) - self.max_buffer_size
+            if self.packet_size > 0:
+                excess = -(-excess // self.packet_size) * self.packet_size
+            else:
+                excess = max(excess, len(self.packet_buffer) - len(in0))
             del self.packet_buffer[:excess]
 
         output_idx = 0
+        frames_decoded = 0
+        max_frames = self.max_frames_per_work()
 
         # Decode packets
         if self.packet_size > 0:
             # Fixed packet size mode
             while len(self.packet_buffer) >= self.packet_size and output_idx < len(out):
+                if max_frames and frames_decoded >= max_frames:
+                    break
                 packet = bytes(self.packet_buffer[: self.packet_size])
                 # Efficiently remove processed data from buffer
                 del self.packet_buffer[: self.packet_size]
 
                 try:
                     decoded_pcm = self.decoder.decode(packet, self.frame_size)
+                    self._note_stream_format(packet)
 
                     if decoded_pcm:
+                        frames_decoded += 1
                         # Convert int16 to float32
                         int16_samples = np.frombuffer(decoded_pcm, dtype=np.int16)
                         float_samples = int16_samples.astype(np.float32) / self.max_int16
@@ -166,16 +379,43 @@ class opus_decoder(gr.sync_block):
             packet_size_candidates = sorted(packet_size_candidates)
 
             while output_idx < len(out) and len(self.packet_buffer) > 0:
+                if max_frames and frames_decoded >= max_frames:
+                    break
                 decoded = False
 
-                # Try candidate packet sizes
-                for packet_size in packet_size_candidates:
+                # Locked onto a constant packet length: one decode per packet
+                if self.locked_packet_size:
+                    if len(self.packet_buffer) < self.locked_packet_size:
+                        break
+                    try:
+                        packet = bytes(self.packet_buffer[: self.locked_packet_size])
+                        if (packet[0] & 0xFC) != self.lock_toc:
+                            raise ValueError("framing slipped")
+                        decoded_pcm = self.decoder.decode(packet, self.frame_size)
+                        self._note_stream_format(packet)
+                        float_samples_flat = np.frombuffer(decoded_pcm, dtype=np.int16).astype(np.float32) / self.max_int16
+                        samples_to_write = min(len(float_samples_flat), len(out) - output_idx)
+                        out[output_idx : output_idx + samples_to_write] = float_samples_flat[:samples_to_write]
+                        output_idx += samples_to_write
+                        del self.packet_buffer[: self.locked_packet_size]
+                        frames_decoded += 1
+                        continue
+                    except Exception:
+                        # Stream changed; go back to searching
+                        self._reset_lock()
+
+                # Try candidate packet sizes, those after which the stream
+                # visibly continues first
+                framed = [size for size in packet_size_candidates if self._framed_at(self.packet_buffer, size)]
+                ordered = framed + [size for size in packet_size_candidates if size not in framed]
+                for packet_size in ordered:
                     if packet_size > len(self.packet_buffer):
                         continue
 
                     try:
                         packet = bytes(self.packet_buffer[:packet_size])
                         decoded_pcm = self.decoder.decode(packet, self.frame_size)
+                        self._note_stream_format(packet)
 
                         if decoded_pcm:
                             # Verify decoded data is not all zeros (silence detection)
@@ -199,8 +439,10 @@ class opus_decoder(gr.sync_block):
                                     ]
                                     output_idx += samples_to_write
 
+                                self._note_packet_length(self.packet_buffer, packet_size)
                                 # Efficiently remove consumed packet from buffer
                                 del self.packet_buffer[:packet_size]
+                                frames_decoded += 1
                                 decoded = True
                                 break
                     except Exception:
@@ -18,7 +18,7 @@ class opus_encoder(gr.sync_block):
     """
 
     def __init__(self, sample_rate=48000, channels=1, bitrate=64000, application="audio",
-                 enable_fargan_voice=False, dnn_blob_path=""):
+                 enable_fargan_voice=False, dnn_blob_path="", defer_init=False):
         """
         Initialize Opus encoder
 
@@ -29,6 +29,7 @@ class opus_encoder(gr.sync_block):
             application: Opus application type ('voip', 'audio', or 'lowdelay')
             enable_fargan_voice: Ignored in Python fallback (C++ DRED only)
             dnn_blob_path: Ignored in Python fallback (C++ DRED only)
+            defer_init: Ignored in Python fallback (C++ only)
         """
         gr.sync_block.__init__(self, name="opus_encoder", in_sig=[np.float32], out_sig=[np.uint8])
 
@@ -91,6 +92,135 @@ class opus_encoder(gr.sync_block):
             "encoder": self.encoder,
         }
 
+    @staticmethod
+    def make_custom(sample_rate, channels, bitrate, frame_size):
+        """Opus Custom mode (not available in Python fallback, C++ only)"""
+        raise RuntimeError("Opus Custom mode requires the C++ gr-opus blocks")
+
+    def set_overload_policy(self, policy):
+        """
+        Select the overload policy. The Python fallback validates the name but
+        always drops the oldest whole frames (C++ only for the others).
+        """
+        if policy not in ("drop_oldest", "drop_newest", "backpressure", "degrade_bitrate"):
+            raise RuntimeError(f"Unknown overload policy: {policy}")
+        self.overload_policy_value = policy
+
+    def overload_policy(self):
+        return getattr(self, "overload_policy_value", "drop_oldest")
+
+    def set_packet_tags(self, enable):
+        """Tag each packet with "packet_len" (ignored in Python fallback, C++ only)"""
+        self.packet_tags_value = bool(enable)
+
+    def packet_tags(self):
+        return getattr(self, "packet_tags_value", False)
+
+    def set_dtx(self, enable):
+        """Discontinuous transmission (ignored in Python fallback, C++ only)"""
+        self.dtx_value = bool(enable)
+
+    def dtx(self):
+        return getattr(self, "dtx_value", False)
+
+    def set_inband_fec(self, enable, expected_loss_percent=10):
+        """In-band FEC (ignored in Python fallback, C++ only)"""
+        if expected_loss_percent < 0 or expected_loss_percent > 100:
+            raise RuntimeError("Expected loss must be 0-100 %")
+        self.inband_fec_value = bool(enable)
+
+    def inband_fec(self):
+        return getattr(self, "inband_fec_value", False)
+
+    def set_signal_classifier(self, enable):
+        """Signal type and bandwidth classifier (ignored in Python fallback, C++ only)"""
+        self.signal_classifier_value = bool(enable)
+
+    def signal_classifier_enabled(self):
+        return getattr(self, "signal_classifier_value", False)
+
+    def set_mono_collapse(self, enable, threshold_db=30.0):
+        """Mono collapse of dual-mono stereo (ignored in Python fallback, C++ only)"""
+        if threshold_db < 12.0 or threshold_db > 90.0:
+            raise RuntimeError("Mono collapse threshold must be 12-90 dB")
+        self.mono_collapse_value = bool(enable)
+
+    def mono_collapse(self):
+        return getattr(self, "mono_collapse_value", False)
+
+    def collapsed_seconds(self):
+        return 0.0
+
+    def stereo_seconds(self):
+        return 0.0
+
+    def set_realtime(self, enable, priority=0):
+        """Real-time mode (stored only in Python fallback, C++ only)"""
+        if priority < 0 or priority > 99:
+            raise RuntimeError("Real-time priority must be 0-99")
+        self.realtime_value = bool(enable)
+
+    def realtime(self):
+        return getattr(self, "realtime_value", False)
+
+    def set_load_priority(self, priority):
+        """
+        Priority class under the load governor. The Python fallback validates
+        the name but is never shed (C++ only).
+        """
+        if priority not in ("low", "normal", "high", "emergency"):
+            raise RuntimeError(f"Unknown load priority: {priority}")
+        self.load_priority_value = priority
+
+    def load_priority(self):
+        return getattr(self, "load_priority_value", "normal")
+
+    def load_shed_level(self):
+        return 0
+
+    def set_shared_pool(self, enable, queue_depth=4):
+        """Select the shared codec pool (ignored in Python fallback, C++ only)"""
+        self.use_shared_pool = bool(enable)
+        self.pool_queue_depth = max(1, min(64, int(queue_depth)))
+
+    def shared_pool(self):
+        """Return whether the shared codec pool was requested"""
+        return getattr(self, "use_shared_pool", False)
+
+    def set_max_frames_per_work(self, frames):
+        """Bound the number of frames processed per work() call (0 = unbounded)"""
+        self.max_frames_per_work_value = max(0, int(frames))
+
+    def max_frames_per_work(self):
+        return getattr(self, "max_frames_per_work_value", 0)
+
+    def set_min_frames_per_emit(self, frames):
+        """Output batching (ignored in Python fallback, C++ only)"""
+        self.min_frames_per_emit_value = max(1, int(frames))
+
+    def min_frames_per_emit(self):
+        return getattr(self, "min_frames_per_emit_value", 1)
+
+    def set_telemetry_interval(self, frames):
+        """Telemetry publishing (ignored in Python fallback, C++ only)"""
+        self.telemetry_interval = max(0, int(frames))
+
+    def set_format(self, sample_rate, channels):
+        """
+        Switch input format. The Python fallback recreates the encoder at once
+        and drops any partial frame; only the C++ block tags the change.
+        """
+        if sample_rate not in (8000, 12000, 16000, 24000, 48000) or channels not in (1, 2):
+            raise RuntimeError(f"Unsupported Opus format: {sample_rate} Hz, {channels} channel(s)")
+        self.encoder = opuslib.Encoder(sample_rate, channels, self.application)
+        self.encoder.bitrate = self.bitrate
+        self._refs["encoder"] = self.encoder
+        self.sample_rate = sample_rate
+        self.channels = channels
+        self.frame_size = int(sample_rate * 0.020)
+        self.max_buffer_samples = sample_rate * channels * 10
+        self.sample_buffer = []
+
     # Do not override forecast - sync_blocks handle forecasting internally
     # The parent gr.sync_block.forecast method handles this automatically
     # Overriding it causes NoneType casting errors in GNU Radio's gateway code
@@ -109,8 +239,10 @@ class opus_encoder(gr.sync_block):
 
         # Prevent unbounded buffer growth (memory leak protection)
         if len(self.sample_buffer) > self.max_buffer_samples:
-            # Keep only the most recent samples (drop oldest)
+            # Keep only the most recent samples (drop oldest whole frames)
+            frame_size_samples = self.frame_size * self.channels
             excess = len(self.sample_buffer) - self.max_buffer_samples
+            excess = -(-excess // frame_size_samples) * frame_size_samples
             self.sample_buffer = self.sample_buffer[excess:]
 
         output_idx = 0
@@ -118,7 +250,10 @@ class opus_encoder(gr.sync_block):
         frames_encoded = 0
 
         # Process complete frames
+        max_frames = self.max_frames_per_work()
         while len(self.sample_buffer) >= frame_size_samples and output_idx < noutput:
+            if max_frames and frames_encoded >= max_frames:
+                break
             # Extract frame (convert list slice to numpy array)
             frame_samples = np.array(self.sample_buffer[:frame_size_samples], dtype=np.float32)
             # Remove processed samples (efficient list slicing)
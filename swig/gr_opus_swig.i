@@ -27,6 +27,17 @@
 %{
 #include "gnuradio/gr_opus/opus_encoder.h"
 #include "gnuradio/gr_opus/opus_decoder.h"
+#include "gnuradio/gr_opus/load_governor.h"
+#include "gnuradio/gr_opus/opus_replay_buffer.h"
+#include "gnuradio/gr_opus/opus_multi_recorder.h"
+#include "gnuradio/gr_opus/opus_spurt_source.h"
+#include "gnuradio/gr_opus/opus_shm_sink.h"
+#include "gnuradio/gr_opus/opus_trace_sink.h"
+#include "gnuradio/gr_opus/opus_trace_source.h"
+#include "gnuradio/gr_opus/opus_channel_sim.h"
+#include "gnuradio/gr_opus/opus_pdu_encoder.h"
+#include "gnuradio/gr_opus/opus_encoder_bank.h"
+#include "gnuradio/gr_opus/opus_ogg_demux.h"
 %}
 
 // Ignore direct instantiation of abstract classes
@@ -35,3 +46,14 @@
 
 %include "gnuradio/gr_opus/opus_encoder.h"
 %include "gnuradio/gr_opus/opus_decoder.h"
+%include "gnuradio/gr_opus/load_governor.h"
+%include "gnuradio/gr_opus/opus_replay_buffer.h"
+%include "gnuradio/gr_opus/opus_multi_recorder.h"
+%include "gnuradio/gr_opus/opus_spurt_source.h"
+%include "gnuradio/gr_opus/opus_shm_sink.h"
+%include "gnuradio/gr_opus/opus_trace_sink.h"
+%include "gnuradio/gr_opus/opus_trace_source.h"
+%include "gnuradio/gr_opus/opus_channel_sim.h"
+%include "gnuradio/gr_opus/opus_pdu_encoder.h"
+%include "gnuradio/gr_opus/opus_encoder_bank.h"
+%include "gnuradio/gr_opus/opus_ogg_demux.h"
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+Compare gr_opus_perf results against the committed baseline
+
+Fails when a kernel's ns/frame rises above baseline * (1 + ns_per_frame)
++ ns_per_frame_slack, when its allocations/frame rise above baseline +
+allocs_per_frame, or when a baselined kernel is missing. A null baseline
+value means nothing was measured for it: that limit is not checked, the
+kernel is reported as "unbaselined" with a warning, and
+--require-baselines turns it into a failure. --update rewrites the
+baseline from this run.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+DEFAULT_TOLERANCE = {"ns_per_frame": 0.5, "ns_per_frame_slack": 50.0, "allocs_per_frame": 0.01}
+
+
+def run_perf(perf, frames, repeat):
+    fd, path = tempfile.mkstemp(suffix=".json")
+    os.close(fd)
+    try:
+        proc = subprocess.run([perf, "--frames", str(frames), "--repeat", str(repeat), "--json", path])
+        if proc.returncode != 0:
+            return None
+        with open(path) as f:
+            return json.load(f)["kernels"]
+    finally:
+        os.unlink(path)
+
+
+def compare(baseline, measured, require_baselines=False):
+    tolerance = dict(DEFAULT_TOLERANCE)
+    tolerance.update(baseline.get("tolerance", {}))
+    kernels = {}
+    for name, base in sorted(baseline["kernels"].items()):
+        entry = {"baseline": base}
+        result = measured.get(name)
+        if result is None:
+            entry["status"] = "missing"
+            kernels[name] = entry
+            continue
+        entry["measured"] = result
+        failures = []
+        if base.get("ns_per_frame") is not None:
+            limit = base["ns_per_frame"] * (1.0 + tolerance["ns_per_frame"]) + tolerance["ns_per_frame_slack"]
+            entry["ns_per_frame_limit"] = limit
+            if result["ns_per_frame"] > limit:
+                failures.append("ns_per_frame")
+        if base.get("allocs_per_frame") is not None:
+            limit = base["allocs_per_frame"] + tolerance["allocs_per_frame"]
+            entry["allocs_per_frame_limit"] = limit
+            if result["allocs_per_frame"] > limit:
+                failures.append("allocs_per_frame")
+        unbaselined = [key for key in ("ns_per_frame", "allocs_per_frame") if base.get(key) is None]
+        if failures:
+            entry["status"] = "regressed"
+            entry["regressed"] = failures
+        elif unbaselined:
+            entry["status"] = "unbaselined"
+            entry["unbaselined"] = unbaselined
+        else:
+            entry["status"] = "ok"
+        kernels[name] = entry
+    for name in sorted(set(measured) - set(baseline["kernels"])):
+        kernels[name] = {"status": "new", "measured": measured[name]}
+    accepted = ("ok", "new") if require_baselines else ("ok", "new", "unbaselined")
+    passed = all(k["status"] in accepted for k in kernels.values())
+    return {"tolerance": tolerance, "kernels": kernels, "passed": passed}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--perf", required=True, help="path to the gr_opus_perf executable")
+    parser.add_argument("--baseline", required=True, help="baseline JSON file")
+    parser.add_argument("--report", help="write the comparison as JSON here")
+    parser.add_argument("--frames", type=int, default=2000)
+    parser.add_argument("--repeat", type=int, default=5)
+    parser.add_argument("--update", action="store_true", help="rewrite the baseline from this run")
+    parser.add_argument("--require-baselines", action="store_true", help="fail kernels with a null baseline value")
+    args = parser.parse_args()
+
+    measured = run_perf(args.perf, args.frames, args.repeat)
+    if measured is None:
+        print("%s failed" % args.perf, file=sys.stderr)
+        return 1
+
+    if args.update:
+        baseline = {"tolerance": dict(DEFAULT_TOLERANCE), "kernels": {}}
+        if os.path.exists(args.baseline):
+            with open(args.baseline) as f:
+                baseline["tolerance"].update(json.load(f).get("tolerance", {}))
+        for name, result in sorted(measured.items()):
+            baseline["kernels"][name] = {
+                "ns_per_frame": round(float(result["ns_per_frame"]), 1),
+                "allocs_per_frame": round(float(result["allocs_per_frame"]), 3),
+            }
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("Baseline written to %s" % args.baseline)
+        return 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    report = compare(baseline, measured, args.require_baselines)
+
+    for name, entry in report["kernels"].items():
+        base = entry.get("baseline", {})
+        result = entry.get("measured", {})
+        print(
+            "%-26s %-11s ns/frame %s (baseline %s)  allocs/frame %s (baseline %s)"
+            % (
+                name,
+                entry["status"],
+                "%.0f" % result["ns_per_frame"] if result else "-",
+                "%.0f" % base["ns_per_frame"] if base.get("ns_per_frame") is not None else "-",
+                "%.3f" % result["allocs_per_frame"] if result else "-",
+                "%.3f" % base["allocs_per_frame"] if base.get("allocs_per_frame") is not None else "-",
+            )
+        )
+
+    unbaselined = [name for name, entry in report["kernels"].items() if entry["status"] == "unbaselined"]
+    if unbaselined:
+        print(
+            "warning: no baseline for %s; run --update on the reference machine and commit the result"
+            % ", ".join(unbaselined),
+            file=sys.stderr,
+        )
+
+    if args.report:
+        with open(args.report, "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write("\n")
+
+    return 0 if report["passed"] else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,122 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#define BOOST_TEST_MODULE qa_batch_writer
+#include <boost/test/unit_test.hpp>
+
+#include "batch_writer.h"
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using gr::gr_opus::batch_writer;
+
+namespace {
+
+typedef std::vector<unsigned char> bytes;
+
+std::string temp_path(const char* test)
+{
+    return "/tmp/gr_opus_qa_batch_writer_" + std::string(test) + "_" + std::to_string(getpid());
+}
+
+bytes read_file(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return bytes(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(writes_every_file_in_order)
+{
+    const std::string a = temp_path("a"), b = temp_path("b");
+    bytes expect_a, expect_b;
+    {
+        batch_writer writer(1 << 20, 1000);
+        int ha = writer.open(a);
+        int hb = writer.open(b);
+        for (int i = 0; i < 100; ++i) {
+            bytes chunk(37, static_cast<unsigned char>(i));
+            expect_a.insert(expect_a.end(), chunk.begin(), chunk.end());
+            BOOST_CHECK(writer.write(ha, chunk));
+            bytes other(11, static_cast<unsigned char>(255 - i));
+            expect_b.insert(expect_b.end(), other.begin(), other.end());
+            BOOST_CHECK(writer.write(hb, other));
+        }
+        writer.close(ha, true);
+        // b is left open: the destructor drains and closes it.
+    }
+    BOOST_CHECK(read_file(a) == expect_a);
+    BOOST_CHECK(read_file(b) == expect_b);
+    unlink(a.c_str());
+    unlink(b.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(counts_bytes_written_and_errors)
+{
+    const std::string a = temp_path("count");
+    batch_writer writer(1 << 20);
+    int h = writer.open(a);
+    writer.write(h, bytes(5000, 1));
+    writer.close(h, false);
+    int bad = writer.open("/nonexistent-dir/gr_opus_qa");
+    writer.write(bad, bytes(10, 1));
+    writer.close(bad, false);
+    for (int i = 0; i < 500 && (writer.bytes_written() < 5000 || writer.write_errors() == 0); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    BOOST_CHECK_EQUAL(writer.bytes_written(), 5000u);
+    BOOST_CHECK_GE(writer.write_errors(), 1u);
+    unlink(a.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(refuses_writes_beyond_the_queue_limit)
+{
+    const std::string a = temp_path("limit");
+    batch_writer writer(100);
+    int h = writer.open(a);
+    BOOST_CHECK(!writer.write(h, bytes(101, 0)));
+    BOOST_CHECK(writer.write(h, bytes(100, 0)));
+    BOOST_CHECK_LE(writer.queued_bytes(), 100u);
+    writer.close(h, false);
+    unlink(a.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(partial_chunk_goes_out_once_old)
+{
+    const std::string a = temp_path("tail");
+    batch_writer writer(1 << 20, 64 * 1024);
+    int h = writer.open(a);
+    writer.write(h, bytes(100, 7));
+    // Well under a chunk, so only the age limit (a second) writes it.
+    for (int i = 0; i < 500 && writer.bytes_written() < 100; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    BOOST_CHECK_EQUAL(writer.bytes_written(), 100u);
+    BOOST_CHECK_EQUAL(read_file(a).size(), 100u);
+    writer.close(h, false);
+    unlink(a.c_str());
+}
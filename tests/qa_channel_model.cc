@@ -0,0 +1,202 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#define BOOST_TEST_MODULE qa_channel_model
+#include <boost/test/unit_test.hpp>
+
+#include "channel_model.h"
+#include <vector>
+
+using gr::gr_opus::channel_model;
+
+namespace {
+
+struct delivery {
+    std::vector<unsigned char> packet;
+    long lost;
+};
+
+// Sends count one-byte packets numbered 0, 1, ... through the model.
+std::vector<delivery> run(channel_model& model, const channel_model::params& p, int count)
+{
+    std::vector<delivery> out;
+    channel_model::deliver_t deliver = [&out](const unsigned char* packet, size_t len, long lost) {
+        out.push_back({ std::vector<unsigned char>(packet, packet + len), lost });
+    };
+    for (int i = 0; i < count; ++i) {
+        unsigned char b = static_cast<unsigned char>(i);
+        model.on_packet(p, &b, 1, deliver);
+    }
+    return out;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(clean_channel_passes_everything)
+{
+    channel_model model(1);
+    std::vector<delivery> out = run(model, channel_model::clean(), 100);
+    BOOST_REQUIRE_EQUAL(out.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK_EQUAL(out[i].packet[0], i);
+        BOOST_CHECK_EQUAL(out[i].lost, 0);
+    }
+    BOOST_CHECK_EQUAL(model.packets_in(), 100);
+    BOOST_CHECK_EQUAL(model.packets_delivered(), 100);
+}
+
+BOOST_AUTO_TEST_CASE(same_seed_same_channel)
+{
+    channel_model::params p = channel_model::clean();
+    p.loss_good = 0.3;
+    p.reorder = 0.1;
+    p.duplicate = 0.1;
+    channel_model a(42), b(42), c(43);
+    std::vector<delivery> ra = run(a, p, 500), rb = run(b, p, 500), rc = run(c, p, 500);
+    BOOST_REQUIRE_EQUAL(ra.size(), rb.size());
+    for (size_t i = 0; i < ra.size(); ++i) {
+        BOOST_CHECK(ra[i].packet == rb[i].packet);
+        BOOST_CHECK_EQUAL(ra[i].lost, rb[i].lost);
+    }
+    bool differs = ra.size() != rc.size();
+    for (size_t i = 0; !differs && i < ra.size(); ++i) {
+        differs = ra[i].packet != rc[i].packet;
+    }
+    BOOST_CHECK(differs);
+}
+
+BOOST_AUTO_TEST_CASE(losses_are_reported_with_the_next_delivery)
+{
+    channel_model::params p = channel_model::clean();
+    p.loss_good = 0.5;
+    channel_model model(7);
+    std::vector<delivery> out = run(model, p, 1000);
+    long lost = 0;
+    int expected = 0;
+    for (const delivery& d : out) {
+        expected += static_cast<int>(d.lost);
+        BOOST_CHECK_EQUAL(d.packet[0], static_cast<unsigned char>(expected));
+        expected++;
+        lost += d.lost;
+    }
+    // Losses after the last delivery have not been reported yet.
+    BOOST_CHECK_LE(lost + static_cast<long>(out.size()), 1000);
+    BOOST_CHECK_EQUAL(model.packets_lost() + model.packets_delivered(), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(gilbert_elliott_loss_rate)
+{
+    // Bad state probability p_gb / (p_gb + p_bg) = 0.25; only it loses.
+    channel_model::params p = channel_model::clean();
+    p.p_good_to_bad = 0.1;
+    p.p_bad_to_good = 0.3;
+    p.loss_bad = 1.0;
+    channel_model model(3);
+    run(model, p, 100000);
+    double rate = static_cast<double>(model.packets_lost()) / model.packets_in();
+    BOOST_CHECK_CLOSE(rate, 0.25, 4.0);
+}
+
+BOOST_AUTO_TEST_CASE(late_packets_count_as_lost)
+{
+    channel_model::params p = channel_model::clean();
+    p.jitter_ms = 20.0;
+    p.playout_delay_ms = 20.0;
+    channel_model model(5);
+    run(model, p, 20000);
+    // P(exponential delay > mean) = 1/e.
+    double rate = static_cast<double>(model.packets_late()) / model.packets_in();
+    BOOST_CHECK_CLOSE(rate, 0.3679, 5.0);
+    BOOST_CHECK_EQUAL(model.packets_late(), model.packets_lost());
+}
+
+BOOST_AUTO_TEST_CASE(reorder_swaps_adjacent_packets)
+{
+    channel_model::params p = channel_model::clean();
+    p.reorder = 1.0;
+    channel_model model(9);
+    std::vector<delivery> out = run(model, p, 10);
+    // Every odd packet overtakes the even one held before it.
+    BOOST_REQUIRE_EQUAL(out.size(), 10u);
+    for (int i = 0; i < 10; i += 2) {
+        BOOST_CHECK_EQUAL(out[i].packet[0], i + 1);
+        BOOST_CHECK_EQUAL(out[i + 1].packet[0], i);
+    }
+    BOOST_CHECK_EQUAL(model.packets_reordered(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(held_packet_is_flushed_at_end_of_stream)
+{
+    channel_model::params p = channel_model::clean();
+    p.reorder = 1.0;
+    channel_model model(9);
+    std::vector<delivery> out = run(model, p, 5);
+    BOOST_REQUIRE_EQUAL(out.size(), 4u);
+    BOOST_CHECK(model.holding());
+
+    model.flush([&out](const unsigned char* packet, size_t len, long lost) {
+        out.push_back({ std::vector<unsigned char>(packet, packet + len), lost });
+    });
+    BOOST_REQUIRE_EQUAL(out.size(), 5u);
+    BOOST_CHECK_EQUAL(out[4].packet[0], 4);
+    BOOST_CHECK(!model.holding());
+    BOOST_CHECK_EQUAL(model.packets_delivered(), 5);
+    BOOST_CHECK_EQUAL(model.packets_reordered(), 2);
+
+    // A second flush has nothing left to deliver.
+    model.flush([&out](const unsigned char*, size_t, long) { out.push_back({}); });
+    BOOST_CHECK_EQUAL(out.size(), 5u);
+}
+
+BOOST_AUTO_TEST_CASE(duplicates_follow_the_original)
+{
+    channel_model::params p = channel_model::clean();
+    p.duplicate = 1.0;
+    channel_model model(11);
+    std::vector<delivery> out = run(model, p, 5);
+    BOOST_REQUIRE_EQUAL(out.size(), 10u);
+    for (int i = 0; i < 5; ++i) {
+        BOOST_CHECK_EQUAL(out[2 * i].packet[0], i);
+        BOOST_CHECK_EQUAL(out[2 * i + 1].packet[0], i);
+    }
+    BOOST_CHECK_EQUAL(model.packets_duplicated(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(bit_errors)
+{
+    channel_model::params p = channel_model::clean();
+    p.ber = 1.0;
+    channel_model model(13);
+    unsigned char packet[4] = { 0x00, 0xFF, 0x0F, 0xF0 };
+    std::vector<unsigned char> got;
+    model.on_packet(p, packet, 4, [&got](const unsigned char* data, size_t len, long) { got.assign(data, data + len); });
+    BOOST_REQUIRE_EQUAL(got.size(), 4u);
+    BOOST_CHECK_EQUAL(got[0], 0xFF);
+    BOOST_CHECK_EQUAL(got[1], 0x00);
+    BOOST_CHECK_EQUAL(got[2], 0xF0);
+    BOOST_CHECK_EQUAL(got[3], 0x0F);
+    BOOST_CHECK_EQUAL(model.bits_flipped(), 32);
+
+    p.ber = 0.01;
+    std::vector<unsigned char> zeros(10000, 0);
+    long before = model.bits_flipped();
+    model.on_packet(p, zeros.data(), static_cast<int>(zeros.size()), [](const unsigned char*, size_t, long) {});
+    BOOST_CHECK_CLOSE(static_cast<double>(model.bits_flipped() - before), 800.0, 15.0);
+}
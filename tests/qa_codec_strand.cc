@@ -0,0 +1,249 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#define BOOST_TEST_MODULE qa_codec_strand
+#include <boost/test/unit_test.hpp>
+
+#include "codec_thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/capability.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace gr::gr_opus;
+
+#ifdef __linux__
+namespace {
+
+// CPU masks of the pool workers, by thread id.
+std::map<long, std::vector<int>> worker_affinity()
+{
+    std::map<long, std::vector<int>> masks;
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return masks;
+    }
+    while (dirent* entry = readdir(dir)) {
+        long tid = std::atol(entry->d_name);
+        std::string comm;
+        std::ifstream(std::string("/proc/self/task/") + entry->d_name + "/comm") >> comm;
+        cpu_set_t set;
+        if (tid <= 0 || comm != "gr_opus_codec" || sched_getaffinity(tid, sizeof(set), &set) != 0) {
+            continue;
+        }
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                masks[tid].push_back(cpu);
+            }
+        }
+    }
+    closedir(dir);
+    return masks;
+}
+
+// Makes SCHED_FIFO requests from this thread fail as for an unprivileged
+// user. Irreversible, so only the last test case calls it.
+void drop_realtime_privileges()
+{
+    __user_cap_header_struct header = { _LINUX_CAPABILITY_VERSION_3, 0 };
+    __user_cap_data_struct data[2];
+    if (syscall(SYS_capget, &header, data) == 0) {
+        data[CAP_SYS_NICE / 32].effective &= ~(1u << (CAP_SYS_NICE % 32));
+        syscall(SYS_capset, &header, data);
+    }
+    rlimit limit = { 0, 0 };
+    setrlimit(RLIMIT_RTPRIO, &limit);
+}
+
+} // namespace
+#endif
+
+BOOST_AUTO_TEST_CASE(jobs_run_in_submission_order)
+{
+    const int strands = 8, jobs = 2000;
+    std::vector<std::shared_ptr<codec_strand>> s;
+    std::vector<std::vector<int>> seen(strands);
+    for (int i = 0; i < strands; ++i) {
+        s.push_back(codec_thread_pool::instance().make_strand(jobs));
+    }
+    for (int j = 0; j < jobs; ++j) {
+        for (int i = 0; i < strands; ++i) {
+            std::vector<int>* out = &seen[i];
+            BOOST_REQUIRE(s[i]->try_submit([out, j] { out->push_back(j); }));
+        }
+    }
+    for (int i = 0; i < strands; ++i) {
+        s[i]->wait_idle();
+        BOOST_REQUIRE_EQUAL(seen[i].size(), static_cast<size_t>(jobs));
+        for (int j = 0; j < jobs; ++j) {
+            BOOST_CHECK_EQUAL(seen[i][j], j);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(submit_refuses_beyond_max_depth)
+{
+    std::shared_ptr<codec_strand> strand = codec_thread_pool::instance().make_strand(2);
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool release = false;
+    auto blocker = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return release; });
+    };
+    BOOST_CHECK(strand->try_submit(blocker));
+    BOOST_CHECK(strand->try_submit([] {}));
+    BOOST_CHECK(!strand->try_submit([] {}));
+    BOOST_CHECK_EQUAL(strand->pending(), 2u);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    cv.notify_all();
+    strand->wait_idle();
+    BOOST_CHECK_EQUAL(strand->pending(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(throwing_jobs_are_counted)
+{
+    std::shared_ptr<codec_strand> strand = codec_thread_pool::instance().make_strand(4);
+    const uint64_t failed = codec_thread_pool::instance().jobs_failed();
+    bool ran = false;
+    BOOST_CHECK(strand->try_submit([] { throw std::runtime_error("job failed"); }));
+    BOOST_CHECK(strand->try_submit([&ran] { ran = true; }));
+    strand->wait_idle();
+    BOOST_CHECK(ran);
+    BOOST_CHECK_EQUAL(codec_thread_pool::instance().jobs_failed(), failed + 1);
+    BOOST_CHECK_EQUAL(strand->pending(), 0u);
+}
+
+// The encoder and decoder pool path: a ring of slots filled by strand jobs
+// and drained from the head, waiting on the head slot rather than polling.
+BOOST_AUTO_TEST_CASE(slot_ring_drains_in_order)
+{
+    struct slot {
+        int value;
+        std::atomic<bool> done;
+    };
+    const size_t depth = 4;
+    const int total = 5000;
+    std::shared_ptr<codec_strand> strand = codec_thread_pool::instance().make_strand(depth);
+    std::vector<std::unique_ptr<slot>> slots;
+    for (size_t i = 0; i < depth; ++i) {
+        slots.emplace_back(new slot());
+    }
+    std::mutex slot_mutex;
+    std::condition_variable slot_cv;
+    size_t head = 0, count = 0;
+    int next = 0;
+    std::vector<int> drained;
+
+    while (static_cast<int>(drained.size()) < total) {
+        while (next < total && count < depth) {
+            slot* sl = slots[(head + count) % depth].get();
+            sl->done.store(false, std::memory_order_relaxed);
+            int value = next;
+            bool queued = strand->try_submit([&, sl, value] {
+                sl->value = value;
+                sl->done.store(true, std::memory_order_release);
+                {
+                    std::lock_guard<std::mutex> lock(slot_mutex);
+                }
+                slot_cv.notify_one();
+            });
+            // A job frees its place in the strand only after it returns, a
+            // little after its slot reads done; like the blocks, try later.
+            if (!queued) {
+                break;
+            }
+            next++;
+            count++;
+        }
+        if (count == 0) {
+            continue;
+        }
+        slot& h = *slots[head];
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex);
+            BOOST_REQUIRE(slot_cv.wait_for(lock, std::chrono::seconds(5),
+                                           [&h] { return h.done.load(std::memory_order_acquire); }));
+        }
+        drained.push_back(h.value);
+        head = (head + 1) % depth;
+        count--;
+    }
+    strand->wait_idle();
+    for (int i = 0; i < total; ++i) {
+        BOOST_CHECK_EQUAL(drained[i], i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(realtime_requests_are_released)
+{
+    codec_thread_pool& pool = codec_thread_pool::instance();
+    if (pool.set_realtime(10) == 0) {
+        // SCHED_FIFO refused (no CAP_SYS_NICE); nothing was applied.
+        pool.release_realtime(10);
+        BOOST_CHECK_EQUAL(pool.realtime_priority(), 0);
+        return;
+    }
+    pool.set_realtime(20);
+    BOOST_CHECK_EQUAL(pool.realtime_priority(), 20);
+    pool.release_realtime(20);
+    BOOST_CHECK_EQUAL(pool.realtime_priority(), 10);
+    // Releasing a priority nobody asked for changes nothing.
+    pool.release_realtime(30);
+    BOOST_CHECK_EQUAL(pool.realtime_priority(), 10);
+    pool.release_realtime(10);
+    BOOST_CHECK_EQUAL(pool.realtime_priority(), 0);
+}
+
+#ifdef __linux__
+BOOST_AUTO_TEST_CASE(refused_realtime_leaves_workers_unpinned)
+{
+    codec_thread_pool& pool = codec_thread_pool::instance();
+    drop_realtime_privileges();
+    const std::map<long, std::vector<int>> before = worker_affinity();
+    BOOST_REQUIRE(!before.empty());
+
+    BOOST_CHECK_EQUAL(pool.set_realtime(10), 0u);
+    BOOST_CHECK_EQUAL(pool.realtime_priority(), 0);
+    BOOST_CHECK(worker_affinity() == before);
+
+    pool.release_realtime(10);
+    BOOST_CHECK(worker_affinity() == before);
+}
+#endif
@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+#define BOOST_TEST_MODULE qa_load_governor
+#include <boost/test/unit_test.hpp>
+
+#include "load_registry.h"
+#include <gnuradio/gr_opus/load_governor.h>
+#include <chrono>
+#include <thread>
+
+using namespace gr::gr_opus;
+
+namespace {
+
+// Calls step every 20 ms until the channel reaches level, for at most 10 s.
+template <typename Step>
+bool drive_to(const load_channel& channel, int level, Step step)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (channel.level() != level && std::chrono::steady_clock::now() < deadline) {
+        step();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return channel.level() == level;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(muted_channel_is_restored_by_poll)
+{
+    std::shared_ptr<load_channel> channel = register_load_channel(load_priority_t::LOW);
+    load_governor::set_core_budget(1.0);
+
+    // Two cores of codec time per 20 ms tick sheds the channel to mute.
+    BOOST_REQUIRE(drive_to(*channel, SHED_MUTED, [&channel] { channel->add_busy(40000000); }));
+
+    // A muted block skips the codec and reports no time; work() still polls.
+    BOOST_CHECK(drive_to(*channel, SHED_NONE, [&channel] { channel->poll(); }));
+    BOOST_CHECK_LT(load_governor::codec_load(), 0.7);
+
+    load_governor::set_core_budget(0.0);
+}
+
+BOOST_AUTO_TEST_CASE(emergency_channels_are_never_shed)
+{
+    std::shared_ptr<load_channel> low = register_load_channel(load_priority_t::LOW);
+    std::shared_ptr<load_channel> emergency = register_load_channel(load_priority_t::EMERGENCY);
+    load_governor::set_core_budget(1.0);
+
+    BOOST_REQUIRE(drive_to(*low, SHED_MUTED, [&emergency] { emergency->add_busy(40000000); }));
+    BOOST_CHECK_EQUAL(emergency->level(), SHED_NONE);
+    BOOST_CHECK_EQUAL(load_governor::channels(), 2);
+
+    load_governor::set_core_budget(0.0);
+    BOOST_CHECK_EQUAL(low->level(), SHED_NONE);
+}
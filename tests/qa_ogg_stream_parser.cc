@@ -0,0 +1,173 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#define BOOST_TEST_MODULE qa_ogg_stream_parser
+#include <boost/test/unit_test.hpp>
+
+#include "ogg_opus.h"
+#include <cstdint>
+#include <vector>
+
+using namespace gr::gr_opus;
+
+namespace {
+
+typedef std::vector<unsigned char> bytes;
+
+// One page with the given lacing values and body, checksummed.
+bytes raw_page(unsigned char flags, uint32_t serial, uint32_t sequence, const bytes& lacing, const bytes& body)
+{
+    bytes page = { 'O', 'g', 'g', 'S', 0, flags };
+    for (int i = 0; i < 8; ++i) {
+        page.push_back(0);
+    }
+    for (int i = 0; i < 4; ++i) {
+        page.push_back(static_cast<unsigned char>(serial >> (8 * i)));
+    }
+    for (int i = 0; i < 4; ++i) {
+        page.push_back(static_cast<unsigned char>(sequence >> (8 * i)));
+    }
+    page.insert(page.end(), 4, 0);
+    page.push_back(static_cast<unsigned char>(lacing.size()));
+    page.insert(page.end(), lacing.begin(), lacing.end());
+    page.insert(page.end(), body.begin(), body.end());
+    uint32_t crc = ogg_crc(page.data(), page.size());
+    for (int i = 0; i < 4; ++i) {
+        page[22 + i] = static_cast<unsigned char>(crc >> (8 * i));
+    }
+    return page;
+}
+
+// count pages of one packet each, packet i being 40 + i bytes of value i.
+bytes stream(int count)
+{
+    ogg_page_builder builder(7);
+    bytes out;
+    for (int i = 0; i < count; ++i) {
+        bytes packet(40 + i, static_cast<unsigned char>(i));
+        builder.add_packet(packet.data(), packet.size(), (i + 1) * 960);
+        builder.flush(out, i == 0, i == count - 1);
+    }
+    return out;
+}
+
+std::vector<bytes> parse_all(ogg_stream_parser& parser)
+{
+    std::vector<bytes> packets;
+    ogg_page page;
+    while (parser.next(page)) {
+        for (bytes& packet : page.packets) {
+            packets.push_back(packet);
+        }
+    }
+    return packets;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(parses_pages_pushed_one_byte_at_a_time)
+{
+    const bytes data = stream(20);
+    ogg_stream_parser parser;
+    std::vector<bytes> packets;
+    for (unsigned char byte : data) {
+        parser.push(&byte, 1);
+        std::vector<bytes> got = parse_all(parser);
+        packets.insert(packets.end(), got.begin(), got.end());
+    }
+    BOOST_REQUIRE_EQUAL(packets.size(), 20u);
+    for (size_t i = 0; i < packets.size(); ++i) {
+        BOOST_CHECK_EQUAL(packets[i].size(), 40 + i);
+        BOOST_CHECK_EQUAL(packets[i][0], static_cast<unsigned char>(i));
+    }
+    BOOST_CHECK_EQUAL(parser.crc_errors(), 0u);
+    BOOST_CHECK_EQUAL(parser.bytes_skipped(), 0u);
+    BOOST_CHECK_EQUAL(parser.buffered(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(resyncs_after_garbage)
+{
+    bytes data = { 'x', 'O', 'g', 'g', 'y', 'O', 'g', 'g', 'S' };
+    const size_t garbage = data.size();
+    const bytes pages = stream(5);
+    data.insert(data.end(), pages.begin(), pages.end());
+
+    ogg_stream_parser parser;
+    parser.push(data.data(), data.size());
+    ogg_page page;
+    BOOST_REQUIRE(parser.next(page));
+    BOOST_CHECK_EQUAL(page.offset, garbage);
+    BOOST_CHECK_EQUAL(parse_all(parser).size(), 4u);
+    BOOST_CHECK_EQUAL(parser.bytes_skipped(), garbage);
+}
+
+BOOST_AUTO_TEST_CASE(skips_pages_with_a_bad_checksum)
+{
+    bytes data = stream(5);
+    // Corrupt the body of the third page (pages are 27 + 1 + 40 + i bytes).
+    const size_t third = (28 + 40) + (28 + 41);
+    data[third + 30] ^= 0x5A;
+
+    ogg_stream_parser parser;
+    parser.push(data.data(), data.size());
+    std::vector<bytes> packets = parse_all(parser);
+    BOOST_REQUIRE_EQUAL(packets.size(), 4u);
+    BOOST_CHECK_EQUAL(packets[1][0], 1);
+    BOOST_CHECK_EQUAL(packets[2][0], 3);
+    BOOST_CHECK_EQUAL(parser.crc_errors(), 1u);
+    BOOST_CHECK_EQUAL(parser.bytes_skipped(), 28u + 42);
+}
+
+BOOST_AUTO_TEST_CASE(reassembles_packets_across_pages)
+{
+    bytes head(255, 0x11), tail(10, 0x22);
+    bytes data = raw_page(0x02, 1, 0, { 255 }, head);
+    bytes second = raw_page(0x01, 1, 1, { 10 }, tail);
+    data.insert(data.end(), second.begin(), second.end());
+
+    ogg_stream_parser parser;
+    parser.push(data.data(), data.size());
+    ogg_page page;
+    BOOST_REQUIRE(parser.next(page));
+    BOOST_CHECK(page.packets.empty());
+    BOOST_REQUIRE(parser.next(page));
+    BOOST_REQUIRE_EQUAL(page.packets.size(), 1u);
+    BOOST_CHECK_EQUAL(page.packets[0].size(), 265u);
+    BOOST_CHECK_EQUAL(page.packets[0][0], 0x11);
+    BOOST_CHECK_EQUAL(page.packets[0][264], 0x22);
+}
+
+BOOST_AUTO_TEST_CASE(sequence_gap_drops_the_packet_in_progress)
+{
+    bytes head(255, 0x11), tail(10, 0x22), next(5, 0x33);
+    bytes data = raw_page(0x02, 1, 0, { 255 }, head);
+    // Page 1 is missing: the continuation on page 2 cannot be completed.
+    bytes body = tail;
+    body.insert(body.end(), next.begin(), next.end());
+    bytes second = raw_page(0x01, 1, 2, { 10, 5 }, body);
+    data.insert(data.end(), second.begin(), second.end());
+
+    ogg_stream_parser parser;
+    parser.push(data.data(), data.size());
+    std::vector<bytes> packets = parse_all(parser);
+    BOOST_REQUIRE_EQUAL(packets.size(), 1u);
+    BOOST_CHECK_EQUAL(packets[0].size(), 5u);
+    BOOST_CHECK_EQUAL(packets[0][0], 0x33);
+}
@@ -51,6 +51,22 @@ class qa_opus_decoder(unittest.TestCase):
         encoded = encoder.encode(int16_samples.tobytes(), frame_size)
         return encoded
 
+    def _generate_encoded_stream(self, num_frames, sample_rate=48000, channels=1, bitrate=64000,
+                                 application=opuslib.APPLICATION_AUDIO):
+        """Helper to generate distinct constant-size Opus packets of a rising tone"""
+        encoder = opuslib.Encoder(sample_rate, channels, application)
+        encoder.bitrate = bitrate
+        encoder.vbr = False
+
+        frame_size = int(sample_rate * 0.020)
+        packets = []
+        for i in range(num_frames):
+            t = np.linspace(0.020 * i, 0.020 * (i + 1), frame_size, False)
+            tone = np.sin(2 * np.pi * (220 + 20 * i) * t) * 0.5
+            int16_samples = (np.repeat(tone, channels) * 32767.0).astype(np.int16)
+            packets.append(encoder.encode(int16_samples.tobytes(), frame_size))
+        return packets
+
     def test_001_decoder_initialization(self):
         """Test decoder initialization with default parameters"""
         decoder = opus_decoder()
@@ -258,6 +274,291 @@ class qa_opus_decoder(unittest.TestCase):
         produced = decoder.work([input_data], [output_data])
         self.assertIsInstance(produced, int)
 
+    def test_018_decoder_shared_pool(self):
+        """Test decoder with fixed packet size decoding through the shared codec pool"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=self.sample_rate, channels=self.channels)
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+        if not hasattr(decoder, "set_shared_pool"):
+            self.skipTest("Shared codec pool not supported by this build")
+        decoder.set_shared_pool(True, 2)
+        self.assertTrue(decoder.shared_pool())
+        input_data = np.frombuffer(encoded_packet * 3, dtype=np.uint8)
+        output_data = np.zeros(self.frame_size * 4, dtype=np.float32)
+        produced = decoder.work([input_data], [output_data])
+        self.assertGreaterEqual(produced, 0)
+
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            self.skipTest("gnuradio.blocks not available")
+
+        # Pool output must match inline decoding sample for sample, in order.
+        packets = self._generate_encoded_stream(40, sample_rate=self.sample_rate, channels=self.channels)
+        outputs = []
+        for pool in (False, True):
+            tb = gr.top_block()
+            src = blocks.vector_source_b(list(b"".join(packets)), False)
+            decoder = opus_decoder(self.sample_rate, self.channels, len(packets[0]))
+            decoder.set_shared_pool(pool, 4)
+            sink = blocks.vector_sink_f()
+            tb.connect(src, decoder, sink)
+            tb.run()
+            outputs.append(list(sink.data()))
+
+        self.assertGreater(len(outputs[0]), 0)
+        np.testing.assert_array_equal(outputs[0], outputs[1])
+
+    def test_019_decoder_max_frames_per_work(self):
+        """Test that max_frames_per_work bounds the packets decoded per call"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=self.sample_rate, channels=self.channels)
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+        if not hasattr(decoder, "set_max_frames_per_work"):
+            self.skipTest("Work granularity controls not supported by this build")
+        decoder.set_max_frames_per_work(1)
+        self.assertEqual(decoder.max_frames_per_work(), 1)
+        input_data = np.frombuffer(encoded_packet * 3, dtype=np.uint8)
+        output_data = np.zeros(self.frame_size * 4, dtype=np.float32)
+        produced = decoder.work([input_data], [output_data])
+        self.assertEqual(produced, self.frame_size)
+
+    def test_020_decoder_defer_init(self):
+        """Test that a deferred decoder decodes the same as an eager one"""
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            self.skipTest("gnuradio.blocks not available")
+
+        encoded_packet = self._generate_encoded_packet(sample_rate=self.sample_rate, channels=self.channels)
+        packets = list(encoded_packet) * 3
+
+        outputs = []
+        for defer_init in (False, True):
+            tb = gr.top_block()
+            src = blocks.vector_source_b(packets, False)
+            decoder = opus_decoder(self.sample_rate, self.channels, len(encoded_packet), "", defer_init)
+            sink = blocks.vector_sink_f()
+            tb.connect(src, decoder, sink)
+            tb.run()
+            outputs.append(list(sink.data()))
+
+        self.assertGreater(len(outputs[0]), 0)
+        np.testing.assert_allclose(outputs[0], outputs[1])
+
+    def test_021_decoder_set_format(self):
+        """Test switching output sample rate at runtime"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=16000, channels=1)
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+        if not hasattr(decoder, "set_format"):
+            self.skipTest("Runtime reconfiguration not supported by this build")
+        with self.assertRaises(RuntimeError):
+            decoder.set_format(16000, 3)
+
+        decoder.set_format(16000, 1)
+        input_data = np.frombuffer(encoded_packet, dtype=np.uint8)
+        output_data = np.zeros(self.frame_size, dtype=np.float32)
+        produced = decoder.work([input_data], [output_data])
+        self.assertEqual(produced, int(16000 * 0.020))
+
+    def test_022_decoder_overload_policy(self):
+        """Test overload policy selection and packet-aligned shedding"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=self.sample_rate, channels=self.channels)
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+        if not hasattr(decoder, "set_overload_policy"):
+            self.skipTest("Overload policies not supported by this build")
+        self.assertEqual(decoder.overload_policy(), "drop_oldest")
+        for policy in ("drop_newest", "backpressure", "drop_oldest"):
+            decoder.set_overload_policy(policy)
+            self.assertEqual(decoder.overload_policy(), policy)
+        with self.assertRaises(RuntimeError):
+            decoder.set_overload_policy("degrade_bitrate")
+
+        if not hasattr(decoder, "packet_buffer"):
+            return
+        # Overflow the backlog without room to emit; the rest stays packet aligned
+        packets = decoder.max_buffer_size // len(encoded_packet) + 3
+        overflow = np.frombuffer(encoded_packet * packets, dtype=np.uint8)
+        decoder.work([overflow], [np.zeros(0, dtype=np.float32)])
+        self.assertLessEqual(len(decoder.packet_buffer), decoder.max_buffer_size)
+        self.assertEqual(len(decoder.packet_buffer) % len(encoded_packet), 0)
+
+    def test_023_decoder_auto_lock_in(self):
+        """Test auto mode locking onto a constant packet length"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=self.sample_rate, channels=self.channels)
+        fixed = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+        if not hasattr(fixed, "detected_packet_size"):
+            self.skipTest("Auto-mode lock-in not supported by this build")
+        self.assertEqual(fixed.detected_packet_size(), len(encoded_packet))
+
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=0)
+        self.assertEqual(decoder.detected_packet_size(), 0)
+
+        # 20 ms CBR packets: 120-byte CELT at 48 kb/s, then 60-byte voice
+        # mode at 24 kb/s
+        first = self._generate_encoded_stream(16, self.sample_rate, self.channels, bitrate=48000)
+        second = self._generate_encoded_stream(32, self.sample_rate, self.channels, bitrate=24000,
+                                               application=opuslib.APPLICATION_VOIP)
+        self.assertEqual({len(p) for p in first}, {120})
+        self.assertEqual({len(p) for p in second}, {60})
+        self.assertNotEqual(first[0][0] & 0xFC, second[0][0] & 0xFC)
+        output_data = np.zeros(self.frame_size * self.channels * 400, dtype=np.float32)
+
+        produced = decoder.work([np.frombuffer(b"".join(first), dtype=np.uint8)], [output_data])
+        self.assertGreater(produced, 0)
+        self.assertEqual(decoder.detected_packet_size(), 120)
+
+        # A 120-byte slice of the new stream still decodes, but its TOC does
+        # not continue the locked stream: the lock drops and search relocks.
+        produced = decoder.work([np.frombuffer(b"".join(second), dtype=np.uint8)], [output_data])
+        self.assertGreater(produced, 0)
+        self.assertEqual(decoder.detected_packet_size(), 60)
+
+    def test_024_decoder_reduced_output_profile(self):
+        """Test decoding a 48 kHz stereo stream straight to 16 kHz mono"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=48000, channels=2)
+        decoder = opus_decoder(sample_rate=16000, channels=1, packet_size=len(encoded_packet))
+
+        input_data = np.frombuffer(encoded_packet, dtype=np.uint8)
+        output_data = np.zeros(int(48000 * 0.020) * 2, dtype=np.float32)
+        produced = decoder.work([input_data], [output_data])
+
+        self.assertEqual(produced, int(16000 * 0.020))
+        self.assertTrue(np.all(np.abs(output_data[:produced]) <= 1.0))
+        if hasattr(decoder, "stream_channels"):
+            self.assertEqual(decoder.stream_channels(), 2)
+
+    def test_025_decoder_complexity_governor(self):
+        """Test decoder complexity and governor settings"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=self.sample_rate, channels=self.channels)
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+        if not hasattr(decoder, "set_complexity"):
+            self.skipTest("Decoder complexity not supported by this build")
+        self.assertEqual(decoder.complexity(), -1)
+        decoder.set_complexity(7)
+        self.assertEqual(decoder.complexity(), 7)
+        self.assertEqual(decoder.effective_complexity(), 7)
+        with self.assertRaises(RuntimeError):
+            decoder.set_complexity(11)
+        with self.assertRaises(RuntimeError):
+            decoder.set_complexity_governor(True, 0.0)
+
+        # An impossible budget forces the governor down; decoding continues
+        decoder.set_complexity_governor(True, 1e-9)
+        num_packets = 100
+        input_data = np.tile(np.frombuffer(encoded_packet, dtype=np.uint8), num_packets)
+        output_data = np.zeros(self.frame_size * self.channels * num_packets, dtype=np.float32)
+        produced = 0
+        for i in range(num_packets):
+            chunk = input_data[i * len(encoded_packet) : (i + 1) * len(encoded_packet)]
+            produced += decoder.work([chunk], [output_data[produced:]])
+        self.assertEqual(produced, len(output_data))
+        self.assertLessEqual(decoder.effective_complexity(), 7)
+
+        decoder.set_complexity_governor(False)
+        self.assertEqual(decoder.effective_complexity(), 7)
+
+    def test_026_decoder_load_priority(self):
+        """Test load governor priority classes on the decoder"""
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels)
+        if not hasattr(decoder, "set_load_priority"):
+            self.skipTest("Load governor not supported by this build")
+        self.assertEqual(decoder.load_priority(), "normal")
+        decoder.set_load_priority("emergency")
+        self.assertEqual(decoder.load_priority(), "emergency")
+        with self.assertRaises(RuntimeError):
+            decoder.set_load_priority("")
+        self.assertEqual(decoder.load_shed_level(), 0)
+
+    def test_027_decoder_output_stage(self):
+        """Test the fused gain, limiter, squelch and meter output stage"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=self.sample_rate, channels=self.channels)
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+        if not hasattr(decoder, "set_output_gain"):
+            self.skipTest("Decoder output stage not supported by this build")
+        self.assertEqual(decoder.output_gain(), 0.0)
+        self.assertFalse(decoder.soft_limiter())
+        self.assertFalse(decoder.squelch())
+        with self.assertRaises(RuntimeError):
+            decoder.set_output_gain(50.0)
+        with self.assertRaises(RuntimeError):
+            decoder.set_squelch(True, 10.0)
+
+        num_packets = 10
+        input_data = np.tile(np.frombuffer(encoded_packet, dtype=np.uint8), num_packets)
+
+        def decode(configure):
+            dec = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+            configure(dec)
+            out = np.zeros(self.frame_size * self.channels * num_packets, dtype=np.float32)
+            produced = dec.work([input_data], [out])
+            return out[:produced]
+
+        plain = decode(lambda dec: None)
+        quiet = decode(lambda dec: dec.set_output_gain(-20.0))
+        if np.array_equal(plain, quiet):
+            return  # Python fallback: output stage settings are not applied
+        self.assertAlmostEqual(float(np.max(np.abs(quiet))), float(np.max(np.abs(plain))) * 0.1, delta=1e-3)
+
+        def loud_limited(dec):
+            dec.set_output_gain(30.0)
+            dec.set_soft_limiter(True)
+            dec.set_level_meter(True)
+
+        loud = decode(loud_limited)
+        self.assertTrue(np.all(np.abs(loud) < 1.0))
+
+        # A threshold above full scale never opens: only the first frame,
+        # fading out, can be non-zero.
+        def gated(dec):
+            dec.set_squelch(True, 0.0, 0)
+            dec.set_output_gain(-20.0)
+
+        muted = decode(gated)
+        self.assertTrue(np.all(muted[self.frame_size * self.channels :] == 0.0))
+
+    def test_028_decoder_realtime_mode(self):
+        """Test real-time mode: decoding continues whatever the system permits"""
+        encoded_packet = self._generate_encoded_packet(sample_rate=self.sample_rate, channels=self.channels)
+        decoder = opus_decoder(sample_rate=self.sample_rate, channels=self.channels, packet_size=len(encoded_packet))
+        if not hasattr(decoder, "set_realtime"):
+            self.skipTest("Real-time mode not supported by this build")
+        self.assertFalse(decoder.realtime())
+        with self.assertRaises(RuntimeError):
+            decoder.set_realtime(True, -1)
+        decoder.set_realtime(True, 0)
+        self.assertTrue(decoder.realtime())
+
+        num_packets = 10
+        input_data = np.tile(np.frombuffer(encoded_packet, dtype=np.uint8), num_packets)
+        output_data = np.zeros(self.frame_size * self.channels * num_packets, dtype=np.float32)
+        self.assertEqual(decoder.work([input_data], [output_data]), len(output_data))
+
+    def test_029_decoder_batched_stream_end(self):
+        """Test that frames held for a batch come out when the input ends"""
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            self.skipTest("gnuradio.blocks not available")
+
+        # 10 packets in batches of 4: the last 2 only leave at end of stream.
+        packets = self._generate_encoded_stream(10, sample_rate=self.sample_rate, channels=self.channels)
+        outputs = {}
+        for pool, batch in ((False, 1), (False, 4), (True, 4)):
+            tb = gr.top_block()
+            src = blocks.vector_source_b(list(b"".join(packets)), False)
+            decoder = opus_decoder(self.sample_rate, self.channels, len(packets[0]))
+            if not hasattr(decoder, "set_min_frames_per_emit"):
+                self.skipTest("Work granularity controls not supported by this build")
+            decoder.set_min_frames_per_emit(batch)
+            decoder.set_shared_pool(pool, 4)
+            sink = blocks.vector_sink_f()
+            tb.connect(src, decoder, sink)
+            tb.run()
+            outputs[(pool, batch)] = list(sink.data())
+
+        self.assertEqual(len(outputs[(False, 1)]), 10 * self.frame_size * self.channels)
+        np.testing.assert_array_equal(outputs[(False, 4)], outputs[(False, 1)])
+        np.testing.assert_array_equal(outputs[(True, 4)], outputs[(False, 1)])
+
 
 if __name__ == "__main__":
     unittest.main()
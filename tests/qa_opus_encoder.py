@@ -5,6 +5,7 @@ Unit tests for Opus encoder block
 
 import os
 import sys
+import time
 import unittest
 
 import numpy as np
@@ -19,6 +20,14 @@ except ImportError:
     from opus_encoder import opus_encoder
 
 
+def has_message_port(block, name):
+    """Return whether block publishes on the named message port"""
+    import pmt
+
+    ports = block.message_ports_out()
+    return any(pmt.symbol_to_string(pmt.vector_ref(ports, i)) == name for i in range(pmt.length(ports)))
+
+
 class qa_opus_encoder(unittest.TestCase):
     """Test suite for opus_encoder block"""
 
@@ -241,6 +250,371 @@ class qa_opus_encoder(unittest.TestCase):
         self.assertIsInstance(produced, int)
         self.assertGreaterEqual(produced, 0)
 
+    def test_019_encoder_shared_pool(self):
+        """Test that frames encoded through the shared codec pool come back in order"""
+        encoder = opus_encoder(sample_rate=self.sample_rate, channels=self.channels)
+        if not hasattr(encoder, "set_shared_pool"):
+            self.skipTest("Shared codec pool not supported by this build")
+        encoder.set_shared_pool(True, 4)
+        self.assertTrue(encoder.shared_pool())
+
+        num_frames = 6
+        t = np.linspace(0, 0.020 * num_frames, self.frame_size * num_frames, False)
+        test_signal = np.sin(2 * np.pi * 440 * t, dtype=np.float32) * 0.5
+        output_data = np.zeros(10000, dtype=np.uint8)
+        produced = encoder.work([test_signal], [output_data])
+        self.assertGreaterEqual(produced, 0)
+
+        encoder.set_shared_pool(False)
+        self.assertFalse(encoder.shared_pool())
+
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            self.skipTest("gnuradio.blocks not available")
+
+        # Pool output must match inline encoding byte for byte, in order.
+        num_frames = 50
+        t = np.linspace(0, 0.020 * num_frames, self.frame_size * num_frames, False)
+        test_signal = (np.sin(2 * np.pi * 440 * t) * 0.5).astype(np.float32)
+        outputs = []
+        for pool in (False, True):
+            tb = gr.top_block()
+            src = blocks.vector_source_f(test_signal.tolist(), False)
+            encoder = opus_encoder(self.sample_rate, self.channels, 64000, "audio")
+            encoder.set_shared_pool(pool, 4)
+            sink = blocks.vector_sink_b()
+            tb.connect(src, encoder, sink)
+            tb.run()
+            outputs.append(list(sink.data()))
+
+        self.assertGreater(len(outputs[0]), 0)
+        self.assertEqual(outputs[0], outputs[1])
+
+    def test_020_encoder_max_frames_per_work(self):
+        """Test that max_frames_per_work bounds the frames encoded per call"""
+        encoder = opus_encoder(sample_rate=self.sample_rate, channels=self.channels)
+        if not hasattr(encoder, "set_max_frames_per_work"):
+            self.skipTest("Work granularity controls not supported by this build")
+        encoder.set_max_frames_per_work(1)
+        encoder.set_min_frames_per_emit(2)
+        self.assertEqual(encoder.max_frames_per_work(), 1)
+        self.assertEqual(encoder.min_frames_per_emit(), 2)
+        encoder.set_min_frames_per_emit(1)
+
+        num_frames = 3
+        t = np.linspace(0, 0.020 * num_frames, self.frame_size * num_frames, False)
+        test_signal = np.sin(2 * np.pi * 440 * t, dtype=np.float32) * 0.5
+        output_data = np.zeros(10000, dtype=np.uint8)
+        first = encoder.work([test_signal], [output_data])
+        self.assertGreater(first, 0)
+
+        # Remaining frames stay buffered and are encoded on later calls
+        second = encoder.work([np.array([], dtype=np.float32)], [np.zeros(10000, dtype=np.uint8)])
+        self.assertGreater(second, 0)
+
+    def test_021_encoder_defer_init(self):
+        """Test that a deferred encoder produces the same stream as an eager one"""
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            self.skipTest("gnuradio.blocks not available")
+
+        num_frames = 5
+        t = np.linspace(0, 0.020 * num_frames, self.frame_size * num_frames, False)
+        test_signal = (np.sin(2 * np.pi * 440 * t) * 0.5).astype(np.float32)
+
+        outputs = []
+        for defer_init in (False, True):
+            tb = gr.top_block()
+            src = blocks.vector_source_f(test_signal.tolist(), False)
+            encoder = opus_encoder(self.sample_rate, self.channels, 64000, "audio", False, "", defer_init)
+            sink = blocks.vector_sink_b()
+            tb.connect(src, encoder, sink)
+            tb.run()
+            outputs.append(list(sink.data()))
+
+        self.assertGreater(len(outputs[0]), 0)
+        self.assertEqual(outputs[0], outputs[1])
+
+    def test_022_encoder_set_format(self):
+        """Test switching sample rate and channel count at runtime"""
+        encoder = opus_encoder(sample_rate=self.sample_rate, channels=self.channels)
+        if not hasattr(encoder, "set_format"):
+            self.skipTest("Runtime reconfiguration not supported by this build")
+        with self.assertRaises(RuntimeError):
+            encoder.set_format(44100, 1)
+
+        encoder.set_format(16000, 2)
+        frame_size = int(16000 * 0.020)
+        t = np.linspace(0, 0.020, frame_size, False)
+        tone = (np.sin(2 * np.pi * 440 * t) * 0.5).astype(np.float32)
+        stereo = np.repeat(tone, 2)
+        output_data = np.zeros(4000, dtype=np.uint8)
+        produced = encoder.work([stereo], [output_data])
+        self.assertGreater(produced, 0)
+
+    def test_023_encoder_overload_policy(self):
+        """Test overload policy selection and frame-aligned shedding"""
+        encoder = opus_encoder(sample_rate=self.sample_rate, channels=self.channels)
+        if not hasattr(encoder, "set_overload_policy"):
+            self.skipTest("Overload policies not supported by this build")
+        self.assertEqual(encoder.overload_policy(), "drop_oldest")
+        for policy in ("drop_newest", "backpressure", "degrade_bitrate", "drop_oldest"):
+            encoder.set_overload_policy(policy)
+            self.assertEqual(encoder.overload_policy(), policy)
+        with self.assertRaises(RuntimeError):
+            encoder.set_overload_policy("drop_random")
+
+        if not hasattr(encoder, "sample_buffer"):
+            return
+        # Overflow the backlog without room to emit; whole frames are shed
+        frame_size_samples = self.frame_size * self.channels
+        overflow = np.zeros(encoder.max_buffer_samples + frame_size_samples // 2, dtype=np.float32)
+        encoder.work([overflow], [np.zeros(0, dtype=np.uint8)])
+        self.assertLessEqual(len(encoder.sample_buffer), encoder.max_buffer_samples)
+        self.assertEqual(len(encoder.sample_buffer) % frame_size_samples, frame_size_samples // 2)
+
+    def test_024_encoder_load_priority(self):
+        """Test load governor priority classes and the shared core budget"""
+        encoder = opus_encoder(sample_rate=self.sample_rate, channels=self.channels)
+        if not hasattr(encoder, "set_load_priority"):
+            self.skipTest("Load governor not supported by this build")
+        self.assertEqual(encoder.load_priority(), "normal")
+        for priority in ("emergency", "high", "low", "normal"):
+            encoder.set_load_priority(priority)
+            self.assertEqual(encoder.load_priority(), priority)
+        with self.assertRaises(RuntimeError):
+            encoder.set_load_priority("scanner")
+        self.assertEqual(encoder.load_shed_level(), 0)
+
+        try:
+            from gnuradio.gr_opus import load_governor
+        except ImportError:
+            load_governor = None
+        if load_governor is None:
+            return
+        self.assertGreaterEqual(load_governor.channels(), 1)
+        load_governor.set_core_budget(2.5)
+        self.assertEqual(load_governor.core_budget(), 2.5)
+        load_governor.set_core_budget(0)
+        self.assertEqual(encoder.load_shed_level(), 0)
+        with self.assertRaises(RuntimeError):
+            load_governor.set_core_budget(-1)
+
+    def test_025_encoder_dtx(self):
+        """Test that DTX sends silence as packets of 2 bytes or less"""
+        encoder = opus_encoder(self.sample_rate, self.channels, 24000, "voip")
+        if not hasattr(encoder, "set_dtx"):
+            self.skipTest("DTX not supported by this build")
+        self.assertFalse(encoder.dtx())
+        encoder.set_dtx(True)
+        self.assertTrue(encoder.dtx())
+        if not hasattr(encoder, "set_packet_tags"):
+            return
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            return
+
+        tb = gr.top_block()
+        src = blocks.vector_source_f([0.0] * (self.frame_size * 100), False)
+        encoder.set_packet_tags(True)
+        sink = blocks.vector_sink_b()
+        tb.connect(src, encoder, sink)
+        tb.run()
+        import pmt
+
+        lengths = [pmt.to_long(tag.value) for tag in sink.tags() if str(tag.key) == "packet_len"]
+        if not lengths:
+            return  # Python fallback: DTX setting is not applied
+        self.assertEqual(len(lengths), 100)
+        self.assertGreater(sum(1 for n in lengths if n <= 2), 50)
+
+    def test_026_encoder_inband_fec(self):
+        """Test the in-band FEC setting"""
+        encoder = opus_encoder(self.sample_rate, self.channels, 24000, "voip")
+        if not hasattr(encoder, "set_inband_fec"):
+            self.skipTest("In-band FEC not supported by this build")
+        self.assertFalse(encoder.inband_fec())
+        encoder.set_inband_fec(True, 20)
+        self.assertTrue(encoder.inband_fec())
+        with self.assertRaises(RuntimeError):
+            encoder.set_inband_fec(True, 101)
+
+        test_signal = (np.random.randn(self.frame_size * 5) * 0.3).astype(np.float32)
+        output_data = np.zeros(10000, dtype=np.uint8)
+        self.assertGreater(encoder.work([test_signal], [output_data]), 0)
+
+    def test_027_encoder_signal_classifier(self):
+        """Test that the signal classifier detects narrowband voice"""
+        encoder = opus_encoder(self.sample_rate, self.channels, 32000, "voip")
+        if not hasattr(encoder, "set_signal_classifier"):
+            self.skipTest("Signal classifier not supported by this build")
+        self.assertFalse(encoder.signal_classifier_enabled())
+        encoder.set_signal_classifier(True)
+        self.assertTrue(encoder.signal_classifier_enabled())
+        try:
+            import pmt
+            from gnuradio import blocks
+        except ImportError:
+            return
+
+        # Speech-like input band-limited to 3.4 kHz, as on a radio channel.
+        t = np.arange(self.sample_rate * 5) / self.sample_rate
+        f0 = 120 + 60 * np.sin(2 * np.pi * 0.5 * t)
+        phase = 2 * np.pi * np.cumsum(f0) / self.sample_rate
+        voiced = sum(np.sin(k * phase) / k * (k * f0 < 3400) for k in range(1, 29))
+        envelope = np.clip(np.sin(2 * np.pi * 3.7 * t), 0, None) ** 0.6
+        signal = (0.1 * voiced * envelope).astype(np.float32)
+
+        if not has_message_port(encoder, "telemetry"):
+            return  # Python fallback: no classifier, no telemetry
+        tb = gr.top_block()
+        debug = blocks.message_debug()
+        tb.connect(blocks.vector_source_f(signal.tolist(), False), encoder, blocks.null_sink(gr.sizeof_char))
+        tb.msg_connect(encoder, "telemetry", debug, "store")
+        tb.run()
+        self.assertGreater(debug.num_messages(), 0)
+        telemetry = debug.get_message(debug.num_messages() - 1)
+        signal_type = pmt.symbol_to_string(pmt.dict_ref(telemetry, pmt.intern("signal_type"), pmt.PMT_NIL))
+        max_bandwidth = pmt.to_long(pmt.dict_ref(telemetry, pmt.intern("max_bandwidth_hz"), pmt.PMT_NIL))
+        self.assertEqual(signal_type, "voice")
+        self.assertIn(max_bandwidth, (4000, 8000))
+
+    def test_028_encoder_realtime_mode(self):
+        """Test real-time mode: encoding continues whatever the system permits"""
+        encoder = opus_encoder(self.sample_rate, self.channels, 32000, "audio")
+        if not hasattr(encoder, "set_realtime"):
+            self.skipTest("Real-time mode not supported by this build")
+        self.assertFalse(encoder.realtime())
+        with self.assertRaises(RuntimeError):
+            encoder.set_realtime(True, 100)
+        # Priority 0: prefault and mlock only, no SCHED_FIFO.
+        encoder.set_realtime(True, 0)
+        self.assertTrue(encoder.realtime())
+
+        test_signal = (np.random.randn(self.frame_size * 10) * 0.3).astype(np.float32)
+        output_data = np.zeros(10000, dtype=np.uint8)
+        self.assertGreater(encoder.work([test_signal], [output_data]), 0)
+        encoder.set_realtime(False)
+        self.assertFalse(encoder.realtime())
+        self.assertGreater(encoder.work([test_signal], [output_data]), 0)
+
+    def test_029_encoder_mono_collapse(self):
+        """Test mono collapse on a dual-mono stereo feed"""
+        encoder = opus_encoder(self.sample_rate, 2, 64000, "audio")
+        if not hasattr(encoder, "set_mono_collapse"):
+            self.skipTest("Mono collapse not supported by this build")
+        self.assertFalse(encoder.mono_collapse())
+        encoder.set_mono_collapse(True, 40.0)
+        self.assertTrue(encoder.mono_collapse())
+        with self.assertRaises(RuntimeError):
+            encoder.set_mono_collapse(True, 5.0)
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            return
+
+        # Both channels from one demodulator, then 2 s of unrelated channels.
+        np.random.seed(42)
+        seconds = 6.0
+        n = int(self.sample_rate * seconds)
+        t = np.arange(n) / self.sample_rate
+        voice = 0.2 * np.sin(2 * np.pi * 220 * t) * np.clip(np.sin(2 * np.pi * 2.1 * t), 0, None)
+        left = voice + 1e-5 * np.random.randn(n)
+        right = voice + 1e-5 * np.random.randn(n)
+        split = int(self.sample_rate * 4.0)
+        right[split:] = 0.2 * np.random.randn(n - split)
+        stereo = np.empty(2 * n, dtype=np.float32)
+        stereo[0::2] = left
+        stereo[1::2] = right
+
+        tb = gr.top_block()
+        enc = opus_encoder(self.sample_rate, 2, 64000, "audio")
+        enc.set_mono_collapse(True)
+        tb.connect(blocks.vector_source_f(stereo.tolist(), False), enc, blocks.null_sink(gr.sizeof_char))
+        tb.run()
+        if enc.collapsed_seconds() + enc.stereo_seconds() == 0:
+            return  # Python fallback: mono collapse is not applied
+        # Collapses after half a second of the dual-mono part and expands
+        # on the first frame of the unrelated part.
+        self.assertAlmostEqual(enc.collapsed_seconds(), 3.5, delta=0.1)
+        self.assertAlmostEqual(enc.stereo_seconds(), 2.5, delta=0.1)
+
+    def test_030_encoder_batched_stream_end(self):
+        """Test that packets held for a batch come out when the input ends"""
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            self.skipTest("gnuradio.blocks not available")
+
+        # 10 frames in batches of 4: the last 2 only leave at end of stream.
+        num_frames = 10
+        t = np.linspace(0, 0.020 * num_frames, self.frame_size * num_frames, False)
+        test_signal = (np.sin(2 * np.pi * 440 * t) * 0.5).astype(np.float32)
+        outputs = {}
+        for pool, batch in ((False, 1), (False, 4), (True, 4)):
+            tb = gr.top_block()
+            src = blocks.vector_source_f(test_signal.tolist(), False)
+            encoder = opus_encoder(self.sample_rate, self.channels, 64000, "audio")
+            if not hasattr(encoder, "set_min_frames_per_emit"):
+                self.skipTest("Work granularity controls not supported by this build")
+            encoder.set_min_frames_per_emit(batch)
+            encoder.set_shared_pool(pool, 4)
+            sink = blocks.vector_sink_b()
+            tb.connect(src, encoder, sink)
+            tb.run()
+            outputs[(pool, batch)] = list(sink.data())
+
+        self.assertGreater(len(outputs[(False, 1)]), 0)
+        self.assertEqual(outputs[(False, 4)], outputs[(False, 1)])
+        self.assertEqual(outputs[(True, 4)], outputs[(False, 1)])
+
+    def test_031_encoder_pool_realtime_release(self):
+        """Test that leaving pool mode drops the pool's real-time request"""
+        try:
+            import pmt
+            from gnuradio import blocks
+        except ImportError:
+            self.skipTest("gnuradio.blocks not available")
+        encoder = opus_encoder(self.sample_rate, self.channels, 32000, "audio")
+        if not hasattr(encoder, "set_shared_pool") or not has_message_port(encoder, "telemetry"):
+            self.skipTest("Shared pool not supported by this build")
+
+        def pool_priority(debug):
+            n = debug.num_messages()
+            if n == 0:
+                return None
+            value = pmt.dict_ref(debug.get_message(n - 1), pmt.intern("pool_realtime_priority"), pmt.PMT_NIL)
+            return pmt.to_long(value)
+
+        def wait_for(debug, priority):
+            deadline = time.time() + 5.0
+            while pool_priority(debug) != priority and time.time() < deadline:
+                time.sleep(0.01)
+            return pool_priority(debug)
+
+        t = np.arange(self.frame_size * 50) / self.sample_rate
+        test_signal = (np.sin(2 * np.pi * 440 * t) * 0.5).astype(np.float32)
+        tb = gr.top_block()
+        src = blocks.vector_source_f(test_signal.tolist(), True)
+        encoder.set_realtime(True, 10)
+        encoder.set_shared_pool(True, 4)
+        encoder.set_telemetry_interval(5)
+        debug = blocks.message_debug()
+        tb.connect(src, blocks.throttle(gr.sizeof_float, self.sample_rate * 4), encoder, blocks.null_sink(1))
+        tb.msg_connect(encoder, "telemetry", debug, "store")
+        tb.start()
+        try:
+            if wait_for(debug, 10) != 10:
+                self.skipTest("SCHED_FIFO not permitted for the pool workers here")
+            encoder.set_shared_pool(False)
+            self.assertEqual(wait_for(debug, 0), 0)
+        finally:
+            tb.stop()
+            tb.wait()
+
 
 if __name__ == "__main__":
     unittest.main()
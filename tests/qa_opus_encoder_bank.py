@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""
+Unit tests for the Opus encoder bank
+"""
+
+import unittest
+
+import numpy as np
+from gnuradio import gr
+
+try:
+    from gnuradio import blocks, gr_opus
+except ImportError:
+    gr_opus = None
+
+
+class qa_opus_encoder_bank(unittest.TestCase):
+    """Test suite for opus_encoder_bank"""
+
+    def setUp(self):
+        if gr_opus is None or getattr(gr_opus, "opus_encoder_bank", None) is None:
+            self.skipTest("Encoder bank not supported by this build")
+        self.sample_rate = 16000
+        self.frame_size = self.sample_rate // 50
+
+    def _signal(self, channel, num_frames):
+        t = np.arange(self.frame_size * num_frames) / self.sample_rate
+        # Overdriven on some channels so the clamp is exercised.
+        level = 0.3 + 0.4 * (channel % 3)
+        return (np.sin(2 * np.pi * (200 + 50 * channel) * t) * level).astype(np.float32).tolist()
+
+    def test_001_matches_single_encoder(self):
+        """Test that each bank channel equals a separate opus_encoder"""
+        num_channels = 4
+        num_frames = 30
+        bank = gr_opus.opus_encoder_bank(num_channels, self.sample_rate, 16000, "voip")
+        tb = gr.top_block()
+        bank_sinks = []
+        single_sinks = []
+        for c in range(num_channels):
+            signal = self._signal(c, num_frames)
+            src = blocks.vector_source_f(signal, False)
+            sink = blocks.vector_sink_b()
+            tb.connect(src, (bank, c))
+            tb.connect((bank, c), sink)
+            bank_sinks.append(sink)
+
+            encoder = gr_opus.opus_encoder(self.sample_rate, 1, 16000, "voip")
+            single = blocks.vector_sink_b()
+            tb.connect(blocks.vector_source_f(signal, False), encoder, single)
+            single_sinks.append(single)
+        tb.run()
+
+        for c in range(num_channels):
+            self.assertEqual(list(bank_sinks[c].data()), list(single_sinks[c].data()))
+            lengths = [tag for tag in bank_sinks[c].tags() if str(tag.key) == "packet_len"]
+            self.assertEqual(len(lengths), num_frames)
+        self.assertEqual(bank.frames_encoded(), num_channels * num_frames)
+        self.assertEqual(bank.encode_errors(), 0)
+
+    def test_002_overhead(self):
+        """Test that work outside libopus stays a small share for a large bank"""
+        num_channels = 64
+        num_frames = 50
+        bank = gr_opus.opus_encoder_bank(num_channels, self.sample_rate, 12000, "voip")
+        bank.set_max_frames_per_work(10)
+        tb = gr.top_block()
+        for c in range(num_channels):
+            tb.connect(blocks.vector_source_f(self._signal(c, num_frames), False), (bank, c))
+            tb.connect((bank, c), blocks.null_sink(gr.sizeof_char))
+        tb.run()
+        self.assertEqual(bank.frames_encoded(), num_channels * num_frames)
+        self.assertLess(bank.overhead_fraction(), 0.25)
+
+    def test_003_settings(self):
+        """Test setting validation"""
+        bank = gr_opus.opus_encoder_bank(2, self.sample_rate, 16000, "voip")
+        bank.set_bitrate(24000)
+        self.assertEqual(bank.bitrate(), 24000)
+        self.assertEqual(bank.num_channels(), 2)
+        with self.assertRaises(RuntimeError):
+            bank.set_bitrate(100)
+        with self.assertRaises(RuntimeError):
+            bank.set_max_frames_per_work(0)
+        with self.assertRaises(RuntimeError):
+            gr_opus.opus_encoder_bank(0, self.sample_rate, 16000, "voip")
+        with self.assertRaises(RuntimeError):
+            gr_opus.opus_encoder_bank(2, 44100, 16000, "voip")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+Unit tests for the lossy channel simulator and a loss recovery benchmark.
+
+The benchmark sweeps loss models x recovery modes (PLC, in-band FEC, DRED)
+through opus_encoder -> opus_channel_sim -> opus_decoder and reports decode
+CPU per second of audio, the latency each mode adds and the segmental SNR
+against a decode of the same packets over a clean channel.
+"""
+
+import time
+import unittest
+
+import numpy as np
+from gnuradio import gr
+
+try:
+    import pmt
+    from gnuradio import blocks, gr_opus
+except ImportError:
+    gr_opus = None
+
+
+def speech_like(sample_rate, seconds):
+    """Voiced harmonics on a gliding pitch with a syllable-rate envelope"""
+    t = np.arange(int(sample_rate * seconds)) / sample_rate
+    pitch = 150 + 50 * np.sin(2 * np.pi * 0.7 * t)
+    phase = 2 * np.pi * np.cumsum(pitch) / sample_rate
+    voiced = sum(np.sin(k * phase) / k for k in range(1, 12))
+    envelope = np.clip(np.sin(2 * np.pi * 3.0 * t), 0, None) ** 0.5
+    return (0.3 * voiced * envelope).astype(np.float32)
+
+
+def segmental_snr(reference, test, segment):
+    """Mean per-segment SNR in dB, each segment clamped to [-10, 35] dB"""
+    n = min(len(reference), len(test)) // segment * segment
+    ref = np.asarray(reference[:n], dtype=np.float64).reshape(-1, segment)
+    err = ref - np.asarray(test[:n], dtype=np.float64).reshape(-1, segment)
+    ref_energy = np.sum(ref ** 2, axis=1)
+    active = ref_energy > 1e-6 * segment
+    snr = 10 * np.log10(ref_energy[active] / np.maximum(np.sum(err[active] ** 2, axis=1), 1e-12))
+    return float(np.mean(np.clip(snr, -10, 35)))
+
+
+class qa_opus_loss_recovery(unittest.TestCase):
+    """Test suite for opus_channel_sim and decoder loss recovery"""
+
+    def setUp(self):
+        if gr_opus is None or getattr(gr_opus, "opus_channel_sim", None) is None:
+            self.skipTest("Channel simulator not supported by this build")
+        self.sample_rate = 16000
+        self.frame_size = int(self.sample_rate * 0.020)
+
+    def _encode(self, signal, fec=False, dred=False):
+        """Encodes signal; returns the packet stream and its packet_len tags"""
+        tb = gr.top_block()
+        src = blocks.vector_source_f(signal.tolist(), False)
+        encoder = gr_opus.opus_encoder(self.sample_rate, 1, 24000, "voip", dred)
+        encoder.set_packet_tags(True)
+        encoder.set_inband_fec(fec, 10)
+        sink = blocks.vector_sink_b()
+        tb.connect(src, encoder, sink)
+        tb.run()
+        return list(sink.data()), list(sink.tags())
+
+    def _channel(self, packets, configure, seed=1):
+        """Runs packets through a channel simulator set up by configure(sim)"""
+        data, tags = packets
+        tb = gr.top_block()
+        src = blocks.vector_source_b(data, False, 1, tags)
+        sim = gr_opus.opus_channel_sim(seed)
+        configure(sim)
+        sink = blocks.vector_sink_b()
+        tb.connect(src, sim, sink)
+        tb.run()
+        return (list(sink.data()), list(sink.tags())), sim
+
+    def _decode(self, packets, mode="plc"):
+        """Decodes a tagged packet stream; returns (pcm, cpu seconds)"""
+        data, tags = packets
+        tb = gr.top_block()
+        src = blocks.vector_source_b(data, False, 1, tags)
+        decoder = gr_opus.opus_decoder(self.sample_rate, 1, 0)
+        decoder.set_packet_tags(True)
+        decoder.set_loss_recovery(mode)
+        sink = blocks.vector_sink_f()
+        tb.connect(src, decoder, sink)
+        start = time.process_time()
+        tb.run()
+        return np.array(sink.data(), dtype=np.float32), time.process_time() - start
+
+    @staticmethod
+    def _tag_sum(tags, key):
+        return sum(pmt.to_long(tag.value) for tag in tags if str(tag.key) == key)
+
+    def test_001_deterministic(self):
+        """Test that the same seed gives the same channel"""
+        packets = self._encode(speech_like(self.sample_rate, 4.0))
+
+        def impair(sim):
+            sim.set_burst_loss(0.05, 0.3)
+            sim.set_jitter(10.0, 40.0)
+            sim.set_reordering(0.02)
+            sim.set_duplication(0.02)
+            sim.set_bit_error_rate(1e-4)
+
+        (data_a, tags_a), _ = self._channel(packets, impair, seed=7)
+        (data_b, tags_b), _ = self._channel(packets, impair, seed=7)
+        (data_c, _), _ = self._channel(packets, impair, seed=8)
+        self.assertEqual(data_a, data_b)
+        self.assertEqual([(t.offset, str(t.key), pmt.to_long(t.value)) for t in tags_a],
+                         [(t.offset, str(t.key), pmt.to_long(t.value)) for t in tags_b])
+        self.assertNotEqual(data_a, data_c)
+
+    def test_002_burst_loss_rate(self):
+        """Test the Gilbert-Elliott loss rate and the packet_lost tags"""
+        packets = self._encode(speech_like(self.sample_rate, 40.0))
+        (data, tags), sim = self._channel(packets, lambda s: s.set_burst_loss(0.05, 0.5))
+        self.assertEqual(sim.packets_in(), 2000)
+        self.assertEqual(sim.packets_in(), sim.packets_delivered() + sim.packets_lost())
+        # Long-run loss rate 0.05 / (0.05 + 0.5)
+        self.assertAlmostEqual(sim.packets_lost() / sim.packets_in(), 0.0909, delta=0.025)
+        # Losses at the very end have no packet to carry their tag
+        lost_tagged = self._tag_sum(tags, "packet_lost")
+        self.assertLessEqual(lost_tagged, sim.packets_lost())
+        self.assertGreater(lost_tagged, sim.packets_lost() - 20)
+        self.assertEqual(self._tag_sum(tags, "packet_len"), len(data))
+
+    def test_003_impairment_counters(self):
+        """Test late loss, reordering, duplication and bit errors"""
+        packets = self._encode(speech_like(self.sample_rate, 20.0))
+
+        def impair(sim):
+            sim.set_jitter(20.0, 40.0)
+            sim.set_reordering(0.05)
+            sim.set_duplication(0.05)
+            sim.set_bit_error_rate(1e-3)
+
+        (data, _), sim = self._channel(packets, impair)
+        self.assertGreater(sim.packets_late(), 0)
+        self.assertEqual(sim.packets_late(), sim.packets_lost())
+        self.assertGreater(sim.packets_reordered(), 0)
+        self.assertGreater(sim.packets_duplicated(), 0)
+        self.assertGreater(sim.bits_flipped(), 0)
+        # A packet held for reordering at the very end is delivered too
+        self.assertEqual(sim.packets_in() - sim.packets_lost() + sim.packets_duplicated(), sim.packets_delivered())
+        with self.assertRaises(RuntimeError):
+            sim.set_reordering(1.5)
+
+    def test_004_recovery_keeps_timing(self):
+        """Test that every lost packet is replaced by one frame of audio"""
+        packets = self._encode(speech_like(self.sample_rate, 10.0), fec=True)
+        lossy, sim = self._channel(packets, lambda s: s.set_burst_loss(0.1, 0.9))
+        self.assertGreater(sim.packets_lost(), 0)
+        expected = (sim.packets_delivered() + self._tag_sum(lossy[1], "packet_lost")) * self.frame_size
+        for mode in ("plc", "fec", "dred"):
+            pcm, _ = self._decode(lossy, mode)
+            self.assertEqual(len(pcm), expected, mode)
+            self.assertTrue(np.all(np.isfinite(pcm)))
+        with self.assertRaises(RuntimeError):
+            gr_opus.opus_decoder(self.sample_rate, 1, 0).set_loss_recovery("magic")
+        with self.assertRaises(RuntimeError):
+            gr_opus.opus_decoder(self.sample_rate, 1, 60).set_packet_tags(True)
+
+    def test_005_recovery_benchmark(self):
+        """Sweep loss models x recovery modes: decode CPU, latency, quality"""
+        seconds = 20.0
+        signal = speech_like(self.sample_rate, seconds)
+        frame_ms = 20.0
+
+        # (name, burst loss parameters or None, jitter (mean, playout) or None)
+        models = [
+            ("random 5%", (0.05, 0.95), None),
+            ("random 15%", (0.15, 0.85), None),
+            ("bursty 5%", (0.0125, 0.25), None),
+            ("jitter 15/40 ms", None, (15.0, 40.0)),
+        ]
+        streams = {"plc": self._encode(signal), "fec": self._encode(signal, fec=True)}
+        try:
+            streams["dred"] = self._encode(signal, dred=True)
+        except RuntimeError:
+            pass
+
+        print("\nLoss recovery benchmark ({:.0f} s of {} Hz speech-like audio, 24 kb/s voip)".format(
+            seconds, self.sample_rate))
+        print("  {:<16} {:<5} {:>6} {:>13} {:>12} {:>10}".format(
+            "channel", "mode", "loss", "cpu ms/s", "latency ms", "segSNR dB"))
+        results = {}
+        for name, burst, jitter in models:
+            for mode, packets in streams.items():
+                clean, _ = self._decode(packets, mode)
+
+                def impair(sim, burst=burst, jitter=jitter):
+                    if burst is not None:
+                        sim.set_burst_loss(*burst)
+                    if jitter is not None:
+                        sim.set_jitter(*jitter)
+
+                lossy, sim = self._channel(packets, impair, seed=1234)
+                pcm, cpu = self._decode(lossy, mode)
+                # Rebuilding from the next packet needs it in the jitter
+                # buffer: one more frame of delay than concealment.
+                latency = (jitter[1] if jitter else 0.0) + (frame_ms if mode != "plc" else 0.0)
+                snr = segmental_snr(clean, pcm, self.frame_size)
+                loss = sim.packets_lost() / sim.packets_in()
+                results[(name, mode)] = snr
+                print("  {:<16} {:<5} {:>5.1f}% {:>13.2f} {:>12.1f} {:>10.2f}".format(
+                    name, mode, 100 * loss, 1000 * cpu / seconds, latency, snr))
+                self.assertGreater(sim.packets_lost(), 0)
+                self.assertLess(snr, 35.0)
+
+        # Recovery never makes things much worse than plain concealment.
+        for name, _, _ in models:
+            self.assertGreater(results[(name, "fec")], results[(name, "plc")] - 3.0, name)
+
+    def test_006_held_packet_at_end(self):
+        """Test that a packet held for reordering is delivered when the input ends"""
+        # 51 packets: every pair swaps and the last one waits for a successor
+        packets = self._encode(speech_like(self.sample_rate, 1.02))
+        (data, tags), sim = self._channel(packets, lambda s: s.set_reordering(1.0))
+        self.assertEqual(sim.packets_in(), 51)
+        self.assertEqual(sim.packets_delivered(), 51)
+        self.assertEqual(sim.packets_reordered(), 25)
+        self.assertEqual(len([t for t in tags if str(t.key) == "packet_len"]), 51)
+        self.assertEqual(len(data), len(packets[0]))
+
+
+if __name__ == "__main__":
+    unittest.main()
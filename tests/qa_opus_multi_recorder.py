@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+Unit tests for the Opus multi-channel recorder
+"""
+
+import os
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+from gnuradio import gr
+
+try:
+    from gnuradio import blocks, gr_opus
+except ImportError:
+    gr_opus = None
+
+
+def _ogg_crc(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def _read_pages(path):
+    """Parse an Ogg file into (header_type, granule, [packets]) after checking every CRC"""
+    with open(path, "rb") as f:
+        data = f.read()
+    pages = []
+    pos = 0
+    while pos < len(data):
+        assert data[pos:pos + 4] == b"OggS", "bad capture pattern at %d" % pos
+        header_type = data[pos + 5]
+        granule, _, _, crc = struct.unpack_from("<qIII", data, pos + 6)
+        nseg = data[pos + 26]
+        lacing = data[pos + 27:pos + 27 + nseg]
+        size = 27 + nseg + sum(lacing)
+        page = bytearray(data[pos:pos + size])
+        page[22:26] = b"\0\0\0\0"
+        assert _ogg_crc(page) == crc, "bad CRC at %d" % pos
+        packets, body, current = [], pos + 27 + nseg, 0
+        for value in lacing:
+            current += value
+            if value < 255:
+                packets.append(data[body:body + current])
+                body += current
+                current = 0
+        pages.append((header_type, granule, packets))
+        pos += size
+    return pages
+
+
+class qa_opus_multi_recorder(unittest.TestCase):
+    """Test suite for opus_multi_recorder"""
+
+    def setUp(self):
+        if gr_opus is None or getattr(gr_opus, "opus_multi_recorder", None) is None:
+            self.skipTest("Multi recorder not supported by this build")
+        self.sample_rate = 48000
+        self.frame_size = int(self.sample_rate * 0.020)
+        self.tmpdir = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.tmpdir.cleanup()
+
+    def _record(self, num_inputs, num_frames, **kwargs):
+        t = np.arange(self.frame_size * num_frames) / self.sample_rate
+        tb = gr.top_block()
+        recorder = gr_opus.opus_multi_recorder(num_inputs, self.tmpdir.name, "rec", self.sample_rate, 1, **kwargs)
+        for i in range(num_inputs):
+            signal = (np.sin(2 * np.pi * (300 + 100 * i) * t) * 0.5).astype(np.float32)
+            src = blocks.vector_source_f(signal.tolist(), False)
+            encoder = gr_opus.opus_encoder(self.sample_rate, 1, 24000)
+            encoder.set_packet_tags(True)
+            tb.connect(src, encoder, (recorder, i))
+        tb.run()
+        return recorder
+
+    def _files(self, suffix):
+        return sorted(f for f in os.listdir(self.tmpdir.name) if f.endswith(suffix))
+
+    def test_001_valid_ogg_opus(self):
+        """Test that each input is written as a valid Ogg Opus file"""
+        recorder = self._record(2, 150)
+        del recorder  # closes the segments and drains the writer
+        files = self._files(".opus")
+        self.assertEqual(files, ["rec_ch000_000000.opus", "rec_ch001_000000.opus"])
+        for name in files:
+            pages = _read_pages(os.path.join(self.tmpdir.name, name))
+            self.assertEqual(pages[0][0], 0x02)
+            self.assertEqual(pages[0][2][0][:8], b"OpusHead")
+            self.assertEqual(pages[1][2][0][:8], b"OpusTags")
+            self.assertEqual(pages[-1][0], 0x04)
+            packets = [p for page in pages[2:] for p in page[2]]
+            self.assertEqual(len(packets), 150)
+            self.assertEqual(pages[-1][1], 150 * self.frame_size)
+
+    def test_002_time_rotation_and_index(self):
+        """Test rotation by audio time and the per-page seek index"""
+        recorder = self._record(1, 250, segment_seconds=1.0)
+        self.assertGreaterEqual(recorder.segments_completed(), 4)
+        del recorder
+        segments = self._files(".opus")
+        self.assertEqual(len(segments), 5)
+        self.assertEqual(len(self._files(".idx")), 5)
+
+        first = os.path.join(self.tmpdir.name, segments[0])
+        pages = _read_pages(first)
+        self.assertEqual(pages[-1][1], 48000)
+        with open(first[:-5] + ".idx") as f:
+            entries = [tuple(int(v) for v in line.split()) for line in f]
+        with open(first, "rb") as f:
+            data = f.read()
+        for granule, offset in entries:
+            self.assertEqual(data[offset:offset + 4], b"OggS")
+            self.assertEqual(struct.unpack_from("<q", data, offset + 6)[0], granule)
+
+    def test_003_size_rotation(self):
+        """Test rotation by segment size"""
+        recorder = self._record(1, 200, segment_seconds=0, segment_bytes=4000)
+        del recorder
+        self.assertGreater(len(self._files(".opus")), 1)
+
+    def test_004_talk_spurt_index(self):
+        """Test the talk-spurt sidecar and spurt-only playback"""
+        # Three 1 s tone bursts separated by 2 s of digital silence
+        t = np.arange(self.sample_rate) / self.sample_rate
+        burst = (np.sin(2 * np.pi * 440 * t) * 0.5).astype(np.float32)
+        gap = np.zeros(2 * self.sample_rate, dtype=np.float32)
+        signal = np.concatenate([gap, burst, gap, burst, gap, burst, gap])
+
+        tb = gr.top_block()
+        src = blocks.vector_source_f(signal.tolist(), False)
+        encoder = gr_opus.opus_encoder(self.sample_rate, 1, 24000, "voip")
+        encoder.set_packet_tags(True)
+        encoder.set_dtx(True)
+        recorder = gr_opus.opus_multi_recorder(1, self.tmpdir.name, "rec", self.sample_rate, 1)
+        tb.connect(src, encoder, recorder)
+        tb.run()
+        self.assertEqual(recorder.spurts_indexed(), 3)
+        del tb, recorder
+
+        base = os.path.join(self.tmpdir.name, "rec_ch000_000000")
+        with open(base + ".spurts") as f:
+            spurts = [tuple(int(v) for v in line.split()) for line in f]
+        self.assertEqual(len(spurts), 3)
+        for start, end in spurts:
+            self.assertGreater(end - start, 0.8 * 48000)
+            self.assertLess(end - start, 1.6 * 48000)
+
+        source = gr_opus.opus_spurt_source(base + ".opus", self.sample_rate, 1)
+        self.assertEqual(source.num_spurts(), 3)
+        sink = blocks.vector_sink_f()
+        tb = gr.top_block()
+        tb.connect(source, sink)
+        tb.run()
+        self.assertEqual(source.spurts_played(), 3)
+        self.assertEqual(len(sink.data()), int(round(source.spurt_seconds() * self.sample_rate)))
+        tags = [tag for tag in sink.tags() if str(tag.key) == "spurt_start"]
+        self.assertEqual(len(tags), 3)
+        self.assertLess(len(sink.data()), len(signal) / 2)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""
+Unit tests for the Ogg Opus stream demuxer
+"""
+
+import struct
+import unittest
+
+import numpy as np
+from gnuradio import gr
+
+try:
+    import pmt
+    from gnuradio import blocks, gr_opus
+except ImportError:
+    gr_opus = None
+
+
+def _ogg_crc(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x04C11DB7) if crc & 0x80000000 else (crc << 1)
+            crc &= 0xFFFFFFFF
+    return crc
+
+
+def _ogg_page(header_type, granule, serial, sequence, packets):
+    lacing = bytearray()
+    for packet in packets:
+        lacing += b"\xff" * (len(packet) // 255) + bytes([len(packet) % 255])
+    page = bytearray(b"OggS\0" + bytes([header_type]))
+    page += struct.pack("<qIII", granule, serial, sequence, 0)
+    page += bytes([len(lacing)]) + lacing + b"".join(packets)
+    page[22:26] = struct.pack("<I", _ogg_crc(page))
+    return bytes(page)
+
+
+class qa_opus_ogg_demux(unittest.TestCase):
+    """Test suite for opus_ogg_demux"""
+
+    def setUp(self):
+        if gr_opus is None or getattr(gr_opus, "opus_ogg_demux", None) is None:
+            self.skipTest("Ogg demuxer not supported by this build")
+        self.sample_rate = 48000
+        self.frame_size = int(self.sample_rate * 0.020)
+        self.pre_skip = 312
+
+    def _packets(self, num_frames):
+        t = np.arange(self.frame_size * num_frames) / self.sample_rate
+        signal = (np.sin(2 * np.pi * 440 * t) * 0.5).astype(np.float32)
+        encoder = gr_opus.opus_encoder(self.sample_rate, 1, 32000, "audio")
+        encoder.set_packet_tags(True)
+        sink = blocks.vector_sink_b()
+        tb = gr.top_block()
+        tb.connect(blocks.vector_source_f(signal.tolist(), False), encoder, sink)
+        tb.run()
+        data = bytes(sink.data())
+        lengths = [pmt.to_long(tag.value) for tag in sink.tags() if str(tag.key) == "packet_len"]
+        packets, pos = [], 0
+        for length in lengths:
+            packets.append(data[pos:pos + length])
+            pos += length
+        return packets
+
+    def _ogg_pages(self, packets, per_page=10, serial=7):
+        head = b"OpusHead" + struct.pack("<BBHIhB", 1, 1, self.pre_skip, self.sample_rate, 0, 0)
+        tags = b"OpusTags" + struct.pack("<I", 4) + b"test" + struct.pack("<I", 0)
+        pages = [_ogg_page(0x02, 0, serial, 0, [head]), _ogg_page(0, 0, serial, 1, [tags])]
+        for i in range(0, len(packets), per_page):
+            chunk = packets[i:i + per_page]
+            granule = (i + len(chunk)) * self.frame_size
+            pages.append(_ogg_page(0x04 if i + per_page >= len(packets) else 0, granule, serial, len(pages), chunk))
+        return pages
+
+    def _demux(self, data):
+        demux = gr_opus.opus_ogg_demux()
+        sink = blocks.vector_sink_b()
+        tb = gr.top_block()
+        tb.connect(blocks.vector_source_b(list(data), False), demux, sink)
+        tb.run()
+        return demux, sink
+
+    def test_001_exact_framing(self):
+        """Test that packets and their times come out exactly"""
+        packets = self._packets(50)
+        demux, sink = self._demux(b"".join(self._ogg_pages(packets)))
+        self.assertEqual(bytes(sink.data()), b"".join(packets))
+        lengths = [pmt.to_long(tag.value) for tag in sink.tags() if str(tag.key) == "packet_len"]
+        self.assertEqual(lengths, [len(p) for p in packets])
+        times = [pmt.to_double(tag.value) for tag in sink.tags() if str(tag.key) == "packet_time"]
+        expected = [(i * self.frame_size - self.pre_skip) / 48000.0 for i in range(len(packets))]
+        np.testing.assert_allclose(times, expected)
+        self.assertEqual(demux.channels(), 1)
+        self.assertEqual(demux.pre_skip(), self.pre_skip)
+        self.assertEqual(demux.streams(), 1)
+        self.assertEqual(demux.crc_errors(), 0)
+
+    def test_002_resync(self):
+        """Test recovery from garbage and a damaged page"""
+        packets = self._packets(50)
+        pages = self._ogg_pages(packets)
+        damaged = bytearray(pages[3])
+        damaged[len(damaged) // 2] ^= 0x5A
+        data = b"noise OggS junk" + b"".join(pages[:3]) + bytes(damaged) + b"\x00" * 100 + b"".join(pages[4:])
+        demux, sink = self._demux(data)
+        self.assertEqual(demux.crc_errors(), 1)
+        self.assertEqual(demux.pages_lost(), 1)
+        self.assertGreater(demux.bytes_skipped(), 100)
+        lengths = [pmt.to_long(tag.value) for tag in sink.tags() if str(tag.key) == "packet_len"]
+        self.assertEqual(len(lengths), 40)
+        lost = [pmt.to_long(tag.value) for tag in sink.tags() if str(tag.key) == "packet_lost"]
+        self.assertEqual(lost, [10])
+        self.assertEqual(bytes(sink.data()), b"".join(packets[:10] + packets[20:]))
+
+    def test_003_decode_live_stream(self):
+        """Test decoding through the demuxer with packet_len framing"""
+        packets = self._packets(50)
+        pages = self._ogg_pages(packets)
+        # A second chained stream follows the first.
+        pages += self._ogg_pages(packets, serial=8)
+        demux = gr_opus.opus_ogg_demux()
+        decoder = gr_opus.opus_decoder(self.sample_rate, 1, 0)
+        decoder.set_packet_tags(True)
+        sink = blocks.vector_sink_f()
+        tb = gr.top_block()
+        tb.connect(blocks.vector_source_b(list(b"".join(pages)), False), demux, decoder, sink)
+        tb.run()
+        self.assertEqual(demux.streams(), 2)
+        self.assertEqual(demux.packets(), 100)
+        self.assertEqual(len(sink.data()), 100 * self.frame_size)
+
+
+if __name__ == "__main__":
+    unittest.main()
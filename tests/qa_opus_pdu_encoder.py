@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+Unit tests for the Opus PDU encoder
+"""
+
+import time
+import unittest
+
+import numpy as np
+from gnuradio import gr
+
+try:
+    from gnuradio import blocks, gr_opus
+except ImportError:
+    gr_opus = None
+
+
+class qa_opus_pdu_encoder(unittest.TestCase):
+    """Test suite for opus_pdu_encoder"""
+
+    def setUp(self):
+        if gr_opus is None or getattr(gr_opus, "opus_pdu_encoder", None) is None:
+            self.skipTest("PDU encoder not supported by this build")
+        self.sample_rate = 48000
+        self.channels = 1
+        self.frame_size = int(self.sample_rate * 0.020)
+
+    def _tone(self, num_samples):
+        t = np.arange(num_samples) / self.sample_rate
+        return (np.sin(2 * np.pi * 440 * t) * 0.5).astype(np.float32).tolist()
+
+    def test_001_flush_pads_trailing_frame(self):
+        """Test that a burst end encodes the partial frame padded with silence"""
+        encoder = gr_opus.opus_pdu_encoder(self.sample_rate, self.channels, 32000)
+        packets = encoder.encode_burst(self._tone(self.frame_size * 3 + 100))
+        lengths = list(encoder.last_packet_lengths())
+        self.assertEqual(len(lengths), 4)
+        self.assertEqual(sum(lengths), len(packets))
+        self.assertEqual(encoder.padded_samples(), self.frame_size - 100)
+        self.assertEqual(encoder.bursts(), 1)
+        self.assertEqual(encoder.packets(), 4)
+
+    def test_002_alignment_across_pdus(self):
+        """Test that frames straddling PDUs are encoded once whole"""
+        encoder = gr_opus.opus_pdu_encoder(self.sample_rate, self.channels, 32000)
+        signal = self._tone(self.frame_size * 5)
+        cut = [0, 333, 1700, 2900, len(signal)]
+        for i in range(len(cut) - 2):
+            self.assertEqual(len(encoder.encode_burst(signal[cut[i]:cut[i + 1]], False)), 0)
+        encoder.encode_burst(signal[cut[-2]:], True)
+        self.assertEqual(len(encoder.last_packet_lengths()), 5)
+        self.assertEqual(encoder.padded_samples(), 0)
+        self.assertEqual(encoder.bursts(), 1)
+
+    def test_003_no_flush_carries_remainder(self):
+        """Test that without flush the partial frame leads the next burst"""
+        encoder = gr_opus.opus_pdu_encoder(self.sample_rate, self.channels, 32000)
+        encoder.set_flush(False)
+        encoder.encode_burst(self._tone(self.frame_size + 400))
+        self.assertEqual(len(encoder.last_packet_lengths()), 1)
+        encoder.encode_burst(self._tone(self.frame_size - 400))
+        self.assertEqual(len(encoder.last_packet_lengths()), 1)
+        self.assertEqual(encoder.padded_samples(), 0)
+
+    def test_004_packet_padding(self):
+        """Test fixed-size packets and the oversize count"""
+        encoder = gr_opus.opus_pdu_encoder(self.sample_rate, self.channels, 16000)
+        encoder.set_packet_padding(120)
+        packets = encoder.encode_burst(self._tone(self.frame_size * 10))
+        self.assertEqual(list(encoder.last_packet_lengths()), [120] * 10)
+        self.assertEqual(len(packets), 1200)
+        self.assertEqual(encoder.oversize_packets(), 0)
+
+        decoder = gr_opus.opus_decoder(self.sample_rate, self.channels, 120)
+        src = blocks.vector_source_b(list(packets), False)
+        sink = blocks.vector_sink_f()
+        tb = gr.top_block()
+        tb.connect(src, decoder, sink)
+        tb.run()
+        self.assertEqual(len(sink.data()), self.frame_size * 10)
+
+        encoder.set_packet_padding(10)
+        encoder.encode_burst(self._tone(self.frame_size))
+        self.assertEqual(encoder.oversize_packets(), 1)
+        with self.assertRaises(RuntimeError):
+            encoder.set_packet_padding(-1)
+
+    def test_005_pdu_ports(self):
+        """Test that each burst of input PDUs yields one output PDU"""
+        import pmt
+
+        encoder = gr_opus.opus_pdu_encoder(self.sample_rate, self.channels, 32000)
+        sink = blocks.message_debug()
+        tb = gr.top_block()
+        tb.msg_connect(encoder, "out", sink, "store")
+        tb.start()
+        signal = self._tone(self.frame_size * 4)
+        more = pmt.dict_add(pmt.make_dict(), pmt.intern("burst_end"), pmt.PMT_F)
+        encoder.to_basic_block()._post(pmt.intern("in"), pmt.cons(more, pmt.init_f32vector(1000, signal[:1000])))
+        encoder.to_basic_block()._post(pmt.intern("in"), pmt.cons(pmt.make_dict(), pmt.init_f32vector(len(signal) - 1000, signal[1000:])))
+        encoder.to_basic_block()._post(pmt.intern("in"), pmt.cons(pmt.make_dict(), pmt.init_u8vector(4, [0, 1, 2, 3])))
+        deadline = time.time() + 5.0
+        while (sink.num_messages() == 0 or encoder.invalid_pdus() == 0) and time.time() < deadline:
+            time.sleep(0.01)
+        tb.stop()
+        tb.wait()
+        self.assertEqual(sink.num_messages(), 1)
+        self.assertEqual(encoder.invalid_pdus(), 1)
+
+        pdu = sink.get_message(0)
+        meta = pmt.car(pdu)
+        lengths = pmt.s32vector_elements(pmt.dict_ref(meta, pmt.intern("packet_lengths"), pmt.PMT_NIL))
+        self.assertEqual(len(lengths), 4)
+        self.assertEqual(sum(lengths), pmt.length(pmt.cdr(pdu)))
+        self.assertEqual(pmt.to_long(pmt.dict_ref(meta, pmt.intern("burst"), pmt.PMT_NIL)), 0)
+
+    def test_006_invalid_arguments(self):
+        """Test that unsupported settings are rejected"""
+        with self.assertRaises(RuntimeError):
+            gr_opus.opus_pdu_encoder(44100, 1, 32000)
+        with self.assertRaises(RuntimeError):
+            gr_opus.opus_pdu_encoder(self.sample_rate, 1, 32000, "audio", 30.0)
+        with self.assertRaises(RuntimeError):
+            gr_opus.opus_pdu_encoder(self.sample_rate, 1, 32000, "speech")
+        encoder = gr_opus.opus_pdu_encoder(self.sample_rate, 2, 32000)
+        with self.assertRaises(RuntimeError):
+            encoder.encode_burst([0.0] * 3)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -5,6 +5,9 @@ Verifies:
 - <10μs mean latency requirement
 - <0.02ms latency and 40ms budget for real-time voice
 - 100% stability
+- Flowgraph construction/start time against block count
+- Decode cost of reduced output profiles
+- Encode cost with the signal classifier and with mono collapse
 """
 
 import gc
@@ -351,6 +354,161 @@ class qa_opus_performance(unittest.TestCase):
             max_buffer, decoder.max_buffer_size, f"Buffer size {max_buffer} exceeds limit {decoder.max_buffer_size}"
         )
 
+    def test_009_flowgraph_startup_time(self):
+        """Benchmark top_block construction and start time against instance count"""
+        try:
+            from gnuradio import blocks, gr, gr_opus
+        except ImportError:
+            self.skipTest("gr_opus C++ blocks not available")
+
+        counts = [1, 16, 64, 256]
+        results = {}
+        for defer_init in (False, True):
+            for count in counts:
+                start = time.perf_counter()
+                tb = gr.top_block()
+                for _ in range(count):
+                    src = blocks.null_source(gr.sizeof_float)
+                    head = blocks.head(gr.sizeof_float, self.frame_size)
+                    encoder = gr_opus.opus_encoder(self.sample_rate, self.channels, 64000, "voip", False, "", defer_init)
+                    decoder = gr_opus.opus_decoder(self.sample_rate, self.channels, 0, "", defer_init)
+                    sink = blocks.null_sink(gr.sizeof_float)
+                    tb.connect(src, head, encoder, decoder, sink)
+                constructed = time.perf_counter()
+                tb.start()
+                started = time.perf_counter()
+                tb.wait()
+                tb.stop()
+                results[(defer_init, count)] = ((constructed - start) * 1e3, (started - constructed) * 1e3)
+                del tb
+                gc.collect()
+
+        print("\nFlowgraph Startup Time (encoder+decoder pairs):")
+        print(f"  {'pairs':>6} {'eager build':>12} {'eager start':>12} {'defer build':>12} {'defer start':>12}")
+        for count in counts:
+            eager = results[(False, count)]
+            defer = results[(True, count)]
+            print(f"  {count:>6} {eager[0]:>10.1f}ms {eager[1]:>10.1f}ms {defer[0]:>10.1f}ms {defer[1]:>10.1f}ms")
+
+        largest = counts[-1]
+        eager_total = sum(results[(False, largest)])
+        defer_total = sum(results[(True, largest)])
+        self.assertLess(defer_total, eager_total * 1.5, "Deferred initialisation slowed flowgraph startup")
+
+    def test_010_decode_profile_cost(self):
+        """Benchmark decoding a 48 kHz stereo stream to reduced output profiles"""
+        import opuslib
+
+        stream_rate, stream_channels = 48000, 2
+        stream_frame = int(stream_rate * 0.020)
+        test_encoder = opuslib.Encoder(stream_rate, stream_channels, opuslib.APPLICATION_AUDIO)
+        test_encoder.bitrate = 128000
+        t = np.arange(stream_frame * 50) / stream_rate
+        signal = np.stack([np.sin(2 * np.pi * 440 * t), np.sin(2 * np.pi * 660 * t)], axis=1) * 0.5
+        pcm = (signal * 32767.0).astype(np.int16)
+        packets = [
+            test_encoder.encode(pcm[i : i + stream_frame].tobytes(), stream_frame)
+            for i in range(0, len(pcm), stream_frame)
+        ]
+        packet_size = len(packets[0])
+        if any(len(p) != packet_size for p in packets):
+            self.skipTest("Encoder produced variable packet sizes")
+        stream = np.frombuffer(b"".join(packets), dtype=np.uint8)
+
+        profiles = [(48000, 2), (48000, 1), (24000, 1), (16000, 1), (8000, 1)]
+        results = {}
+        for rate, channels in profiles:
+            output = np.zeros(int(rate * 0.020) * channels * len(packets), dtype=np.float32)
+            timings = []
+            for _ in range(20):
+                decoder = opus_decoder(sample_rate=rate, channels=channels, packet_size=packet_size)
+                start = time.perf_counter()
+                produced = decoder.work([stream], [output])
+                timings.append((time.perf_counter() - start) * 1e6 / len(packets))
+            results[(rate, channels)] = (mean(timings), produced)
+            self.assertEqual(produced, len(output))
+
+        print("\nDecode Profile Cost (48 kHz stereo stream):")
+        print(f"  {'profile':>12} {'us/packet':>10} {'samples/packet':>15}")
+        for rate, channels in profiles:
+            cost, produced = results[(rate, channels)]
+            print(f"  {rate:>7}/{channels}ch {cost:>10.1f} {produced // len(packets):>15}")
+
+        # Output buffers shrink with the profile: 16 kHz mono is 1/6 of 48 kHz stereo
+        self.assertEqual(results[(16000, 1)][1] * 6, results[(48000, 2)][1])
+
+
+    def test_011_signal_classifier_cost(self):
+        """Benchmark encoding narrowband voice with and without the signal classifier"""
+        try:
+            from gnuradio import blocks, gr, gr_opus
+        except ImportError:
+            self.skipTest("gr_opus C++ blocks not available")
+
+        # Speech-like input band-limited to 3.4 kHz, as on a radio channel.
+        seconds = 10.0
+        t = np.arange(int(self.sample_rate * seconds)) / self.sample_rate
+        f0 = 120 + 60 * np.sin(2 * np.pi * 0.5 * t)
+        phase = 2 * np.pi * np.cumsum(f0) / self.sample_rate
+        voiced = sum(np.sin(k * phase) / k * (k * f0 < 3400) for k in range(1, 29))
+        envelope = np.clip(np.sin(2 * np.pi * 3.7 * t), 0, None) ** 0.6
+        signal = (0.1 * voiced * envelope).astype(np.float32).tolist()
+
+        results = {}
+        for classify in (False, True):
+            tb = gr.top_block()
+            encoder = gr_opus.opus_encoder(self.sample_rate, self.channels, 32000, "voip")
+            encoder.set_signal_classifier(classify)
+            sink = blocks.vector_sink_b()
+            tb.connect(blocks.vector_source_f(signal, False), encoder, sink)
+            start = time.process_time()
+            tb.run()
+            results[classify] = (time.process_time() - start, len(sink.data()))
+            self.assertGreater(len(sink.data()), 0)
+
+        print(f"\nSignal Classifier Cost ({seconds:.0f} s of 3.4 kHz voice, 32 kb/s voip):")
+        for classify, (cpu, size) in results.items():
+            print(f"  classifier {'on' if classify else 'off':<3}: {1000 * cpu / seconds:7.2f} cpu ms/s, {size:6d} bytes")
+
+        self.assertLess(results[True][0], results[False][0] * 1.5, "The signal classifier slowed encoding")
+
+
+    def test_012_mono_collapse_cost(self):
+        """Benchmark encoding a dual-mono stereo feed with and without mono collapse"""
+        try:
+            from gnuradio import blocks, gr, gr_opus
+        except ImportError:
+            self.skipTest("gr_opus C++ blocks not available")
+
+        # Both channels from one demodulator.
+        np.random.seed(42)
+        seconds = 4.0
+        n = int(self.sample_rate * seconds)
+        t = np.arange(n) / self.sample_rate
+        voice = 0.2 * np.sin(2 * np.pi * 220 * t) * np.clip(np.sin(2 * np.pi * 2.1 * t), 0, None)
+        dual_mono = np.repeat(voice + 1e-5 * np.random.randn(n), 2).astype(np.float32).tolist()
+
+        results = {}
+        for collapse in (False, True):
+            tb = gr.top_block()
+            encoder = gr_opus.opus_encoder(self.sample_rate, 2, 64000, "audio")
+            encoder.set_mono_collapse(collapse)
+            sink = blocks.vector_sink_b()
+            tb.connect(blocks.vector_source_f(dual_mono, False), encoder, sink)
+            start = time.process_time()
+            tb.run()
+            results[collapse] = (time.process_time() - start, len(sink.data()), encoder.collapsed_seconds())
+            self.assertGreater(len(sink.data()), 0)
+
+        print(f"\nMono Collapse Cost ({seconds:.0f} s of dual-mono stereo, 64 kb/s audio):")
+        for collapse, (cpu, size, collapsed) in results.items():
+            print(
+                f"  collapse {'on' if collapse else 'off':<3}: {1000 * cpu / seconds:7.2f} cpu ms/s, {size:6d} bytes, "
+                f"{collapsed:.1f} s coded as mono"
+            )
+
+        self.assertLess(results[True][0], results[False][0] * 1.5, "Mono collapse slowed encoding")
+
 
 if __name__ == "__main__":
     unittest.main(verbosity=2)
@@ -241,6 +241,36 @@ class qa_opus_roundtrip(unittest.TestCase):
             produced_dec = decoder.work([enc_data], [dec_out])
             self.assertGreater(produced_dec, 0, f"Failed to decode with {app}")
 
+    def test_014_roundtrip_custom_mode(self):
+        """Test Opus Custom round-trip at 44.1 kHz with 64-sample frames"""
+        try:
+            from gnuradio import blocks
+        except ImportError:
+            self.skipTest("gnuradio.blocks not available")
+        if not hasattr(opus_encoder, "make_custom"):
+            self.skipTest("Opus Custom mode not supported by this build")
+
+        sample_rate, frame_size, bitrate = 44100, 64, 128000
+        packet_size = bitrate * frame_size // (8 * sample_rate)
+        try:
+            encoder = opus_encoder.make_custom(sample_rate, 1, bitrate, frame_size)
+            decoder = opus_decoder.make_custom(sample_rate, 1, frame_size, packet_size)
+        except RuntimeError as e:
+            self.skipTest(str(e))
+
+        num_frames = 50
+        t = np.arange(frame_size * num_frames) / sample_rate
+        test_signal = (np.sin(2 * np.pi * 1000 * t) * 0.5).astype(np.float32)
+
+        src = blocks.vector_source_f(test_signal.tolist(), False)
+        sink = blocks.vector_sink_f()
+        self.tb.connect(src, encoder, decoder, sink)
+        self.tb.run()
+
+        output = np.array(sink.data(), dtype=np.float32)
+        self.assertEqual(len(output), frame_size * num_frames)
+        self.assertGreater(np.sqrt(np.mean(output[frame_size * 4:] ** 2)), 0.1)
+
 
 if __name__ == "__main__":
     unittest.main()
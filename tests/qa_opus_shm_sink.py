@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""
+Unit tests for the shared-memory PCM ring sink
+"""
+
+import mmap
+import os
+import struct
+import unittest
+
+import numpy as np
+from gnuradio import gr
+
+try:
+    from gnuradio import blocks, gr_opus
+except ImportError:
+    gr_opus = None
+
+HEADER = struct.Struct("<8sIIIIIIIIQI")
+HEADER_SIZE = 80
+READER_SIZE = 16
+SLOT = struct.Struct("<QQQIIQ")
+
+
+class qa_opus_shm_sink(unittest.TestCase):
+    """Test suite for opus_shm_sink, read the way an outside process would"""
+
+    def setUp(self):
+        if gr_opus is None or getattr(gr_opus, "opus_shm_sink", None) is None:
+            self.skipTest("Shared-memory sink not supported by this build")
+        if not os.path.isdir("/dev/shm"):
+            self.skipTest("/dev/shm not available")
+        self.name = "gr_opus_qa_%d" % os.getpid()
+
+    def _map(self):
+        with open("/dev/shm/" + self.name, "rb") as f:
+            return mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+    def _slot(self, ring, header, seq):
+        max_readers, slot_count, slot_bytes = header[7], header[5], header[6]
+        base = HEADER_SIZE + READER_SIZE * max_readers + (seq % slot_count) * slot_bytes
+        seq_begin, offset, timestamp, samples, _, seq_end = SLOT.unpack_from(ring, base)
+        data = np.frombuffer(ring, dtype=np.float32, count=samples * header[3], offset=base + SLOT.size)
+        return seq_begin, seq_end, offset, timestamp, samples, data
+
+    def test_001_frames_and_sequence(self):
+        """Test that frames appear in order with sequence numbers and positions"""
+        signal = np.arange(960 * 10 + 100, dtype=np.float32)
+        sink = gr_opus.opus_shm_sink(self.name, 48000, 1, 960, 16)
+        tb = gr.top_block()
+        tb.connect(blocks.vector_source_f(signal.tolist(), False), sink)
+        tb.run()
+        self.assertEqual(sink.frames_published(), 11)
+
+        ring = self._map()
+        header = HEADER.unpack_from(ring, 0)
+        self.assertEqual(header[0], b"GROPUSPR")
+        self.assertEqual(header[2:6], (48000, 1, 960, 16))
+        self.assertEqual(header[9], 11)  # write_seq
+        self.assertEqual(header[10], 1)  # closed
+
+        for seq in range(1, 12):
+            seq_begin, seq_end, offset, timestamp, samples, data = self._slot(ring, header, seq)
+            self.assertEqual((seq_begin, seq_end), (seq, seq))
+            self.assertEqual(offset, (seq - 1) * 960)
+            self.assertGreater(timestamp, 0)
+            self.assertEqual(samples, 960 if seq < 11 else 100)
+            np.testing.assert_array_equal(data, signal[offset:offset + samples])
+        ring.close()
+
+        del tb, sink
+        self.assertFalse(os.path.exists("/dev/shm/" + self.name))
+
+    def test_002_ring_wraps_without_readers_blocking(self):
+        """Test that the writer laps the ring instead of waiting"""
+        sink = gr_opus.opus_shm_sink(self.name, 48000, 2, 480, 4)
+        tb = gr.top_block()
+        tb.connect(blocks.vector_source_f([0.25] * (480 * 2 * 20), False), sink)
+        tb.run()
+        self.assertEqual(sink.frames_published(), 20)
+        self.assertEqual(sink.readers(), 0)
+        ring = self._map()
+        header = HEADER.unpack_from(ring, 0)
+        seq_begin, seq_end, _, _, samples, data = self._slot(ring, header, 20)
+        self.assertEqual((seq_begin, seq_end, samples), (20, 20, 480))
+        self.assertTrue(np.all(data == 0.25))
+        ring.close()
+
+    def test_003_invalid_name(self):
+        """Test that names with a slash are rejected"""
+        with self.assertRaises(RuntimeError):
+            gr_opus.opus_shm_sink("a/b", 48000, 1)
+
+
+if __name__ == "__main__":
+    unittest.main()
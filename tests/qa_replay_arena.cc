@@ -0,0 +1,118 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#define BOOST_TEST_MODULE qa_replay_arena
+#include <boost/test/unit_test.hpp>
+
+#include "replay_arena.h"
+#include <vector>
+
+using gr::gr_opus::replay_arena;
+
+namespace {
+
+std::vector<unsigned char> packet(int len, unsigned char fill) { return std::vector<unsigned char>(len, fill); }
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(stores_and_collects_in_order)
+{
+    replay_arena arena(1000);
+    for (int i = 0; i < 5; ++i) {
+        std::vector<unsigned char> p = packet(100, static_cast<unsigned char>(i));
+        BOOST_CHECK(arena.store(p.data(), 100, 960));
+    }
+    BOOST_CHECK_EQUAL(arena.packets(), 5u);
+    BOOST_CHECK_EQUAL(arena.total_samples(), 5u * 960);
+    BOOST_CHECK_EQUAL(arena.oldest_sample(), 0u);
+
+    std::vector<unsigned char> bytes;
+    std::vector<replay_arena::entry> picked;
+    arena.collect(960, 3 * 960, bytes, picked);
+    BOOST_REQUIRE_EQUAL(picked.size(), 2u);
+    BOOST_CHECK_EQUAL(picked[0].sample_pos, 960u);
+    BOOST_CHECK_EQUAL(picked[1].sample_pos, 2u * 960);
+    BOOST_CHECK_EQUAL(bytes.size(), 200u);
+    BOOST_CHECK_EQUAL(bytes[picked[0].offset], 1);
+    BOOST_CHECK_EQUAL(bytes[picked[1].offset], 2);
+}
+
+BOOST_AUTO_TEST_CASE(wrap_evicts_oldest_overlapping_packets)
+{
+    replay_arena arena(1000);
+    for (int i = 0; i < 9; ++i) {
+        std::vector<unsigned char> p = packet(100, static_cast<unsigned char>(i));
+        arena.store(p.data(), 100, 960);
+    }
+    // 300 bytes do not fit after the ninth packet: the write wraps to 0 and
+    // evicts the three oldest packets.
+    std::vector<unsigned char> big = packet(300, 0xAA);
+    BOOST_CHECK(arena.store(big.data(), 300, 960));
+    BOOST_CHECK_EQUAL(arena.packets(), 7u);
+    BOOST_CHECK_EQUAL(arena.oldest_sample(), 3u * 960);
+
+    std::vector<unsigned char> bytes;
+    std::vector<replay_arena::entry> picked;
+    arena.collect(0, arena.total_samples(), bytes, picked);
+    BOOST_REQUIRE_EQUAL(picked.size(), 7u);
+    for (size_t i = 0; i + 1 < picked.size(); ++i) {
+        BOOST_CHECK_EQUAL(bytes[picked[i].offset], static_cast<unsigned char>(i + 3));
+        BOOST_CHECK_EQUAL(picked[i + 1].sample_pos, picked[i].sample_pos + 960);
+    }
+    BOOST_CHECK_EQUAL(bytes[picked.back().offset], 0xAA);
+}
+
+BOOST_AUTO_TEST_CASE(wrap_drops_packets_stranded_in_the_tail)
+{
+    replay_arena arena(1000);
+    std::vector<unsigned char> p = packet(100, 0);
+    for (int i = 0; i < 18; ++i) {
+        arena.store(p.data(), 100, 960); // one full lap, then 0-799 again
+    }
+    BOOST_CHECK_EQUAL(arena.packets(), 10u);
+    BOOST_CHECK_EQUAL(arena.oldest_sample(), 8u * 960);
+
+    // 300 bytes do not fit at 800: the two first-lap packets at 800-999
+    // are dropped with the wrap, and the first three of the second lap are
+    // overwritten.
+    std::vector<unsigned char> big = packet(300, 0xAA);
+    BOOST_CHECK(arena.store(big.data(), 300, 960));
+    BOOST_CHECK_EQUAL(arena.packets(), 6u);
+    BOOST_CHECK_EQUAL(arena.oldest_sample(), 13u * 960);
+
+    std::vector<unsigned char> bytes;
+    std::vector<replay_arena::entry> picked;
+    arena.collect(0, arena.total_samples(), bytes, picked);
+    BOOST_REQUIRE_EQUAL(picked.size(), 6u);
+    for (size_t i = 0; i + 1 < picked.size(); ++i) {
+        BOOST_CHECK_EQUAL(picked[i + 1].sample_pos, picked[i].sample_pos + 960);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rejects_oversize_and_empty_packets)
+{
+    replay_arena arena(100);
+    std::vector<unsigned char> p = packet(101, 0);
+    BOOST_CHECK(!arena.store(p.data(), 101, 960));
+    BOOST_CHECK(!arena.store(p.data(), 0, 960));
+    BOOST_CHECK_EQUAL(arena.packets(), 0u);
+    BOOST_CHECK(arena.store(p.data(), 100, 960));
+    BOOST_CHECK_EQUAL(arena.packets(), 1u);
+}
@@ -0,0 +1,160 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2025 gr-opus author.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#define BOOST_TEST_MODULE qa_shm_ring
+#include <boost/test/unit_test.hpp>
+
+#include "shm_ring_writer.h"
+#include <gnuradio/gr_opus/shm_ring.h>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace gr::gr_opus;
+
+namespace {
+
+std::string ring_name(const char* test) { return std::string("gr_opus_qa_") + test + "_" + std::to_string(getpid()); }
+
+// frames frames of frame_samples stereo samples; sample k of frame f holds f.
+void write_frames(shm_ring_writer& writer, int first, int frames, int frame_samples)
+{
+    for (int f = first; f < first + frames; ++f) {
+        std::vector<float> pcm(2 * frame_samples, static_cast<float>(f));
+        writer.write(pcm.data(), pcm.size());
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(reader_sees_frames_in_order)
+{
+    const std::string name = ring_name("order");
+    shm_ring_writer writer(name, 48000, 2, 480, 8);
+    shm_ring_reader reader(name);
+    BOOST_CHECK_EQUAL(reader.info().sample_rate, 48000u);
+    BOOST_CHECK_EQUAL(reader.info().channels, 2u);
+
+    const shm_ring_slot* slot;
+    const float* samples;
+    BOOST_CHECK_EQUAL(reader.next(slot, samples), shm_ring_reader::NO_FRAME);
+
+    write_frames(writer, 0, 5, 480);
+    BOOST_CHECK_EQUAL(writer.frames_published(), 5);
+    BOOST_CHECK_EQUAL(writer.readers(), 1);
+    for (int f = 0; f < 5; ++f) {
+        BOOST_REQUIRE_EQUAL(reader.next(slot, samples), shm_ring_reader::FRAME);
+        BOOST_CHECK_EQUAL(slot->samples, 480u);
+        BOOST_CHECK_EQUAL(slot->sample_offset, 480u * f);
+        BOOST_CHECK_EQUAL(samples[0], static_cast<float>(f));
+        BOOST_CHECK_EQUAL(samples[2 * 480 - 1], static_cast<float>(f));
+        BOOST_CHECK(reader.release());
+    }
+    BOOST_CHECK_EQUAL(reader.next(slot, samples), shm_ring_reader::NO_FRAME);
+    BOOST_CHECK_EQUAL(reader.lost_frames(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(partial_writes_fill_one_frame)
+{
+    const std::string name = ring_name("partial");
+    shm_ring_writer writer(name, 48000, 2, 480, 4);
+    shm_ring_reader reader(name);
+
+    std::vector<float> pcm(2 * 480);
+    for (size_t i = 0; i < pcm.size(); ++i) {
+        pcm[i] = static_cast<float>(i);
+    }
+    writer.write(pcm.data(), 100);
+    writer.write(pcm.data() + 100, 2 * 480 - 100);
+    BOOST_CHECK_EQUAL(writer.frames_published(), 1);
+
+    const shm_ring_slot* slot;
+    const float* samples;
+    BOOST_REQUIRE_EQUAL(reader.next(slot, samples), shm_ring_reader::FRAME);
+    BOOST_CHECK_EQUAL_COLLECTIONS(samples, samples + pcm.size(), pcm.begin(), pcm.end());
+}
+
+BOOST_AUTO_TEST_CASE(flush_publishes_a_short_frame_and_close_is_seen)
+{
+    const std::string name = ring_name("flush");
+    shm_ring_writer writer(name, 48000, 2, 480, 4);
+    shm_ring_reader reader(name);
+
+    std::vector<float> pcm(2 * 100, 1.0f);
+    writer.write(pcm.data(), pcm.size());
+    BOOST_CHECK_EQUAL(writer.frames_published(), 0);
+    writer.flush();
+    writer.set_closed(true);
+    BOOST_CHECK_EQUAL(writer.frames_published(), 1);
+
+    const shm_ring_slot* slot;
+    const float* samples;
+    BOOST_REQUIRE_EQUAL(reader.next(slot, samples), shm_ring_reader::FRAME);
+    BOOST_CHECK_EQUAL(slot->samples, 100u);
+    BOOST_CHECK(reader.release());
+    BOOST_CHECK_EQUAL(reader.next(slot, samples), shm_ring_reader::WRITER_CLOSED);
+}
+
+BOOST_AUTO_TEST_CASE(lapped_reader_skips_ahead)
+{
+    const std::string name = ring_name("lapped");
+    shm_ring_writer writer(name, 48000, 2, 48, 8);
+    shm_ring_reader reader(name);
+
+    write_frames(writer, 0, 20, 48);
+    BOOST_CHECK_EQUAL(writer.reader_overruns(), 1);
+
+    const shm_ring_slot* slot;
+    const float* samples;
+    BOOST_CHECK_EQUAL(reader.next(slot, samples), shm_ring_reader::LAPPED);
+    // Resumes half a ring behind the writer.
+    BOOST_CHECK_EQUAL(reader.lost_frames(), 16u);
+    BOOST_REQUIRE_EQUAL(reader.next(slot, samples), shm_ring_reader::FRAME);
+    BOOST_CHECK_EQUAL(samples[0], 16.0f);
+    BOOST_CHECK(reader.release());
+}
+
+BOOST_AUTO_TEST_CASE(release_detects_a_frame_overwritten_while_held)
+{
+    const std::string name = ring_name("torn");
+    shm_ring_writer writer(name, 48000, 2, 48, 4);
+    shm_ring_reader reader(name);
+
+    write_frames(writer, 0, 1, 48);
+    const shm_ring_slot* slot;
+    const float* samples;
+    BOOST_REQUIRE_EQUAL(reader.next(slot, samples), shm_ring_reader::FRAME);
+    // A full lap while the reader still holds frame 1.
+    write_frames(writer, 1, 4, 48);
+    BOOST_CHECK(!reader.release());
+    BOOST_CHECK_GT(reader.lost_frames(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(ring_is_removed_with_the_writer)
+{
+    const std::string name = ring_name("removed");
+    {
+        shm_ring_writer writer(name, 48000, 1, 48, 4);
+    }
+    BOOST_CHECK_THROW(shm_ring_reader reader(name), std::runtime_error);
+    BOOST_CHECK_THROW(shm_ring_writer(name, 48000, 1, 0, 4), std::runtime_error);
+    BOOST_CHECK_THROW(shm_ring_writer("a/b", 48000, 1, 48, 4), std::runtime_error);
+}